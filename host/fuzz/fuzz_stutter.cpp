@@ -0,0 +1,272 @@
+/**
+ * fuzz_stutter.cpp - Fuzz harness for the AudioEffectStutter state machine
+ *
+ * PURPOSE:
+ * The stutter effect is driven from two contexts: the app thread calls the
+ * control API (startCapture, scheduleCaptureEnd, stopPlayback, ...) while the
+ * audio ISR fires scheduled transitions and moves the read/write positions.
+ * This harness interleaves arbitrary control calls with audio blocks at
+ * arbitrary sample positions and checks the state machine's invariants after
+ * every step.
+ *
+ * INPUT FORMAT (bytes, consumed left to right):
+ *   byte 0          Start position in blocks (0 = transport at rest, sample 0)
+ *   then ops:       <op byte> [args]   op = byte % NUM_OPS
+ *     RUN_BLOCKS    <n>       (n & 31) + 1 blocks, x64 if n & 0x80
+ *     START_CAPTURE / CANCEL_CAPTURE_START / START_PLAYBACK / STOP_PLAYBACK /
+ *     ENABLE / DISABLE
+ *     END_CAPTURE   <held>
+ *     SCHEDULE_*    <lo> <hi> target = now + int16(hi:lo), clamped at 0
+ *                   (SCHEDULE_CAPTURE_END takes a trailing <held> byte)
+ *
+ * INVARIANTS (abort() with the op trace on violation):
+ * - Positions inside the buffer; the loop never longer than what was written
+ * - PLAYING/WAIT_PLAYBACK_LENGTH: loop exists and read position < loop length
+ * - IDLE_WITH_LOOP / WAIT_PLAYBACK_ONSET have a loop, IDLE_NO_LOOP has none
+ * - Each WAIT state has exactly its own schedule pending, other states none
+ * - After a block, nothing pending is due (no stuck WAIT states)
+ * - Every audio block is returned to the pool
+ *
+ * BUILD:
+ *   clang:  -DMICROLOOP_LIBFUZZER=ON builds fuzz_stutter with -fsanitize=fuzzer
+ *           (coverage-guided). Minimize the seed corpus after a long run:
+ *             fuzz_stutter -merge=1 host/fuzz/corpus/stutter <new_corpus_dir>
+ *   gcc:    fuzz_stutter links fuzz_driver.cpp (corpus replay + random inputs)
+ */
+
+#include <Audio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "audio_stutter.h"
+#include "timekeeper.h"
+
+// Loop buffers (defined in stutter_controller.cpp in the firmware build)
+int16_t AudioEffectStutter::m_stutterBufferL[AudioEffectStutter::STUTTER_BUFFER_SAMPLES];
+int16_t AudioEffectStutter::m_stutterBufferR[AudioEffectStutter::STUTTER_BUFFER_SAMPLES];
+int16_t AudioEffectStutter::m_historyPoolL[AudioEffectStutter::History::POOL_SAMPLES];
+int16_t AudioEffectStutter::m_historyPoolR[AudioEffectStutter::History::POOL_SAMPLES];
+int16_t AudioEffectStutter::m_preRollL[AudioEffectStutter::PREROLL_SAMPLES];
+int16_t AudioEffectStutter::m_preRollR[AudioEffectStutter::PREROLL_SAMPLES];
+
+namespace {
+
+// ========== AUDIO GRAPH ==========
+
+// Ramp input (never silent, so captured data differs from the zeroed buffer)
+class FuzzSource : public AudioStream {
+public:
+    FuzzSource() : AudioStream(0, nullptr) {}
+
+    void update() override {
+        audio_block_t* left = allocate();
+        audio_block_t* right = allocate();
+        if (left && right) {
+            for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+                left->data[i] = static_cast<int16_t>(m_counter | 1);
+                right->data[i] = static_cast<int16_t>(~m_counter | 1);
+                m_counter++;
+            }
+            transmit(left, 0);
+            transmit(right, 1);
+        }
+        if (left) release(left);
+        if (right) release(right);
+    }
+
+private:
+    uint16_t m_counter = 0;
+};
+
+class FuzzSink : public AudioStream {
+public:
+    FuzzSink() : AudioStream(2, m_inputQueue) {}
+
+    void update() override {
+        for (int ch = 0; ch < 2; ch++) {
+            audio_block_t* block = receiveReadOnly(ch);
+            if (block) release(block);
+        }
+    }
+
+private:
+    audio_block_t* m_inputQueue[2];
+};
+
+FuzzSource s_source;
+AudioEffectStutter s_stutter;
+FuzzSink s_sink;
+AudioConnection s_patch1(s_source, 0, s_stutter, 0);
+AudioConnection s_patch2(s_source, 1, s_stutter, 1);
+AudioConnection s_patch3(s_stutter, 0, s_sink, 0);
+AudioConnection s_patch4(s_stutter, 1, s_sink, 1);
+
+constexpr unsigned AUDIO_MEMORY_BLOCKS = 8;
+
+// ========== OPS ==========
+
+enum Op : uint8_t {
+    RUN_BLOCKS,
+    START_CAPTURE,
+    SCHEDULE_CAPTURE_START,
+    CANCEL_CAPTURE_START,
+    END_CAPTURE,
+    SCHEDULE_CAPTURE_END,
+    START_PLAYBACK,
+    SCHEDULE_PLAYBACK_ONSET,
+    STOP_PLAYBACK,
+    SCHEDULE_PLAYBACK_LENGTH,
+    ENABLE,
+    DISABLE,
+    NUM_OPS
+};
+
+const char* const OP_NAMES[NUM_OPS] = {
+    "run", "startCapture", "scheduleCaptureStart", "cancelCaptureStart", "endCapture",
+    "scheduleCaptureEnd", "startPlayback", "schedulePlaybackOnset", "stopPlayback",
+    "schedulePlaybackLength", "enable", "disable"
+};
+
+class Input {
+public:
+    Input(const uint8_t* data, size_t size) : m_data(data), m_size(size), m_pos(0) {}
+
+    bool empty() const { return m_pos >= m_size; }
+    uint8_t byte() { return m_pos < m_size ? m_data[m_pos++] : 0; }
+
+    // Schedule target relative to the current position
+    uint64_t target() {
+        int16_t delta = static_cast<int16_t>(byte() | (byte() << 8));
+        int64_t t = static_cast<int64_t>(TimeKeeper::getSamplePosition()) + delta;
+        return t < 0 ? 0 : static_cast<uint64_t>(t);
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_pos;
+};
+
+std::string s_trace;  // Ops of the current input (printed on violation)
+
+// ========== INVARIANTS ==========
+
+[[noreturn]] void fail(const char* what) {
+    fprintf(stderr, "INVARIANT VIOLATION: %s\n", what);
+    fprintf(stderr, "  state=%u captureLength=%zu writePos=%zu readPos=%zu sample=%llu\n",
+            s_stutter.getStateCode(), s_stutter.getCaptureLength(), s_stutter.getWritePosition(),
+            s_stutter.getReadPosition(), static_cast<unsigned long long>(TimeKeeper::getSamplePosition()));
+    fprintf(stderr, "  ops: %s\n", s_trace.c_str());
+    abort();
+}
+
+const char* expectedSchedule(StutterState state) {
+    switch (state) {
+        case StutterState::WAIT_CAPTURE_START:   return "captureStart";
+        case StutterState::WAIT_CAPTURE_END:     return "captureEnd";
+        case StutterState::WAIT_PLAYBACK_ONSET:  return "playbackOnset";
+        case StutterState::WAIT_PLAYBACK_LENGTH: return "playbackStop";
+        default:                                 return nullptr;
+    }
+}
+
+void checkInvariants(bool afterBlock) {
+    const StutterState state = s_stutter.getState();
+    const size_t length = s_stutter.getCaptureLength();
+    const size_t writePos = s_stutter.getWritePosition();
+    const size_t readPos = s_stutter.getReadPosition();
+
+    if (writePos > AudioEffectStutter::getBufferSamples()) fail("write position beyond buffer");
+    if (length > writePos) fail("loop longer than captured data");
+
+    const bool playing = (state == StutterState::PLAYING || state == StutterState::WAIT_PLAYBACK_LENGTH);
+    if (playing && length == 0) fail("playing without a loop");
+    if (playing && readPos >= length) fail("read position beyond loop");
+
+    if ((state == StutterState::IDLE_WITH_LOOP || state == StutterState::WAIT_PLAYBACK_ONSET) && length == 0) {
+        fail("loop state without a loop");
+    }
+    if (state == StutterState::IDLE_NO_LOOP && length != 0) fail("IDLE_NO_LOOP with a loop");
+
+    ScheduledEvent events[4];
+    uint8_t count = s_stutter.getScheduledEvents(events, 4);
+    const char* expected = expectedSchedule(state);
+    if (expected == nullptr && count != 0) fail("schedule pending outside its WAIT state");
+    if (expected != nullptr && (count != 1 || std::string(events[0].label) != expected)) {
+        fail("WAIT state without its schedule");
+    }
+
+    if (afterBlock) {
+        if (count == 1 && events[0].atSample <= TimeKeeper::getSamplePosition()) {
+            fail("scheduled transition overdue (stuck WAIT state)");
+        }
+        if (AudioStream::memory_used != 0) fail("audio block leaked");
+        if (AudioStream::simAllocateFailures() != 0) fail("audio pool exhausted");
+    }
+}
+
+void runBlock() {
+    // Same order as the firmware: AudioTimeKeeper advances first, then the effects
+    TimeKeeper::incrementSamples(AUDIO_BLOCK_SAMPLES);
+    AudioStream::simUpdateAll();
+    checkInvariants(true);
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static bool initialized = false;
+    if (!initialized) {
+        AudioMemory(AUDIO_MEMORY_BLOCKS);
+        initialized = true;
+    }
+
+    Input in(data, size);
+    s_trace.clear();
+
+    TimeKeeper::reset();
+    TimeKeeper::incrementSamples(static_cast<uint32_t>(in.byte()) * AUDIO_BLOCK_SAMPLES);
+    s_stutter.disable();
+    checkInvariants(false);
+
+    while (!in.empty()) {
+        const Op op = static_cast<Op>(in.byte() % NUM_OPS);
+        s_trace += OP_NAMES[op];
+        s_trace += ' ';
+
+        switch (op) {
+            case RUN_BLOCKS: {
+                uint8_t n = in.byte();
+                uint32_t blocks = ((n & 31u) + 1u) * ((n & 0x80u) ? 64u : 1u);
+                s_trace += std::to_string(blocks) + " ";
+                for (uint32_t i = 0; i < blocks; i++) {
+                    runBlock();
+                }
+                break;
+            }
+            case START_CAPTURE:            s_stutter.startCapture(); break;
+            case SCHEDULE_CAPTURE_START:   s_stutter.scheduleCaptureStart(in.target()); break;
+            case CANCEL_CAPTURE_START:     s_stutter.cancelCaptureStart(); break;
+            case END_CAPTURE:              s_stutter.endCapture(in.byte() & 1); break;
+            case SCHEDULE_CAPTURE_END: {
+                uint64_t target = in.target();
+                s_stutter.scheduleCaptureEnd(target, in.byte() & 1);
+                break;
+            }
+            case START_PLAYBACK:           s_stutter.startPlayback(); break;
+            case SCHEDULE_PLAYBACK_ONSET:  s_stutter.schedulePlaybackOnset(in.target()); break;
+            case STOP_PLAYBACK:            s_stutter.stopPlayback(); break;
+            case SCHEDULE_PLAYBACK_LENGTH: s_stutter.schedulePlaybackLength(in.target()); break;
+            case ENABLE:                   s_stutter.enable(); break;
+            case DISABLE:                  s_stutter.disable(); break;
+            case NUM_OPS:                  break;
+        }
+        checkInvariants(false);
+    }
+
+    // Let anything still scheduled fire (targets are at most 32767 samples ahead)
+    for (uint32_t i = 0; i < 32768 / AUDIO_BLOCK_SAMPLES + 1; i++) {
+        runBlock();
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+/**
+ * clock_gen.cpp - Synthetic MIDI clock source for the host simulator
+ */
+
+#include "clock_gen.h"
+#include "timekeeper.h"
+#include <math.h>
+
+// ========== CONTROL ==========
+
+void MidiClockGenerator::start(double bpm, uint64_t nowUs) {
+    m_bpm = bpm;
+    m_ramping = false;
+    if (!running()) {
+        m_nextEmitUs = UINT64_MAX;
+        return;
+    }
+    resetSegment(static_cast<double>(nowUs));
+    scheduleNext();
+}
+
+void MidiClockGenerator::rampTo(double bpm, uint64_t durationUs, uint64_t nowUs) {
+    if (!running() || bpm <= 0.0) {
+        return;
+    }
+    if (durationUs == 0) {
+        m_bpm = bpm;
+        m_ramping = false;
+        resetSegment(idealTickUs(m_nextTick));
+        scheduleNext();
+        return;
+    }
+
+    // The pending tick keeps its time; later ticks follow the ramp
+    const double pendingUs = idealTickUs(m_nextTick);
+
+    m_rampFromBpm = tempoAtUs(static_cast<double>(nowUs));
+    m_rampToBpm = bpm;
+    m_rampStartUs = static_cast<double>(nowUs);
+    m_rampEndUs = static_cast<double>(nowUs + durationUs);
+    m_ramping = true;
+
+    resetSegment(pendingUs);
+}
+
+void MidiClockGenerator::setJitter(ClockJitter shape, double amountUs, uint32_t seed) {
+    m_jitter = shape;
+    m_jitterUs = amountUs;
+    m_rng = seed != 0 ? seed : 1;
+}
+
+void MidiClockGenerator::setDropout(double probability, uint32_t seed) {
+    m_dropout = probability;
+    m_rng = seed != 0 ? seed : 1;
+}
+
+void MidiClockGenerator::setDrift(double ppm) {
+    // Takes effect from the next tick
+    double nextUs = idealTickUs(m_nextTick);
+    m_driftPpm = ppm;
+    if (running()) {
+        resetSegment(nextUs);
+    }
+}
+
+bool MidiClockGenerator::advance() {
+    const bool dropped = (m_dropout > 0.0) && (uniform() <= m_dropout);
+
+    m_ideal.push_back(idealTickUs(m_nextTick));
+    m_nextTick++;
+
+    if (dropped) {
+        m_dropped++;
+    } else {
+        m_sent++;
+        m_lastEmitUs = m_nextEmitUs;
+        m_hasEmitted = true;
+    }
+
+    // A ramp changes the interval every tick; the end of a ramp starts a
+    // new constant segment at the target tempo
+    if (m_ramping) {
+        double at = m_ideal.back();
+        if (at >= m_rampEndUs) {
+            m_bpm = m_rampToBpm;
+            m_ramping = false;
+        }
+        m_segmentStartUs = at;
+        m_segmentStartTick = m_nextTick - 1;
+        m_segmentIntervalUs = intervalUs(tempoAtUs(at));
+    }
+
+    scheduleNext();
+    return !dropped;
+}
+
+// ========== GROUND TRUTH ==========
+
+double MidiClockGenerator::idealTickUs(uint64_t n) const {
+    if (n < m_ideal.size()) {
+        return m_ideal[n];
+    }
+    if (!m_ramping) {
+        return m_segmentStartUs + static_cast<double>(n - m_segmentStartTick) * m_segmentIntervalUs;
+    }
+
+    // Project through the ramp tick by tick
+    double at = m_segmentStartUs;
+    double interval = m_segmentIntervalUs;
+    for (uint64_t i = m_segmentStartTick; i < n; i++) {
+        at += interval;
+        interval = intervalUs(tempoAtUs(at));
+    }
+    return at;
+}
+
+double MidiClockGenerator::audioBpm() const {
+    if (!running()) {
+        return 0.0;
+    }
+    double now = m_ideal.empty() ? m_segmentStartUs : m_ideal.back();
+    return tempoAtUs(now) * (1.0 + m_driftPpm * 1e-6);
+}
+
+// ========== INTERNALS ==========
+
+double MidiClockGenerator::tempoAtUs(double us) const {
+    if (!m_ramping || us <= m_rampStartUs) {
+        return m_ramping ? m_rampFromBpm : m_bpm;
+    }
+    if (us >= m_rampEndUs) {
+        return m_rampToBpm;
+    }
+    double t = (us - m_rampStartUs) / (m_rampEndUs - m_rampStartUs);
+    return m_rampFromBpm + (m_rampToBpm - m_rampFromBpm) * t;
+}
+
+double MidiClockGenerator::intervalUs(double bpm) const {
+    return 60000000.0 / (bpm * TimeKeeper::MIDI_PPQN) / (1.0 + m_driftPpm * 1e-6);
+}
+
+void MidiClockGenerator::resetSegment(double atUs) {
+    m_segmentStartUs = atUs;
+    m_segmentStartTick = m_nextTick;
+    m_segmentIntervalUs = intervalUs(tempoAtUs(atUs));
+}
+
+void MidiClockGenerator::scheduleNext() {
+    double at = idealTickUs(m_nextTick);
+    if (m_jitter != ClockJitter::NONE) {
+        at += jitterUs();
+    }
+    uint64_t emit = at > 0.0 ? static_cast<uint64_t>(at + 0.5) : 0;
+
+    // Bytes leave the UART in order, one byte time apart
+    if (m_hasEmitted && emit < m_lastEmitUs + MIDI_BYTE_US) {
+        emit = m_lastEmitUs + MIDI_BYTE_US;
+    }
+    m_nextEmitUs = emit;
+}
+
+double MidiClockGenerator::jitterUs() {
+    switch (m_jitter) {
+        case ClockJitter::UNIFORM:
+            return (2.0 * uniform() - 1.0) * m_jitterUs;
+        case ClockJitter::GAUSSIAN:
+            // Box-Muller (one of the pair)
+            return m_jitterUs * sqrt(-2.0 * log(uniform())) * cos(2.0 * M_PI * uniform());
+        case ClockJitter::LATE:
+            return -m_jitterUs * log(uniform());
+        case ClockJitter::NONE:
+            break;
+    }
+    return 0.0;
+}
+
+uint32_t MidiClockGenerator::random() {
+    // xorshift32
+    m_rng ^= m_rng << 13;
+    m_rng ^= m_rng >> 17;
+    m_rng ^= m_rng << 5;
+    return m_rng;
+}
+
+double MidiClockGenerator::uniform() {
+    return (static_cast<double>(random()) + 1.0) / 4294967296.0;
+}
@@ -0,0 +1,136 @@
+/**
+ * clock_gen.h - Synthetic MIDI clock source for the host simulator
+ *
+ * PURPOSE:
+ * Real clock sources are not a perfect 24 PPQN grid: USB-MIDI bridges and
+ * DAWs add jitter, tempo changes arrive as ramps, bytes get lost on noisy
+ * DIN cables, and the sender's crystal drifts against the codec's. The
+ * generator produces such tick streams deterministically (seeded), and keeps
+ * the sender's ideal timeline as ground truth for GridMeter.
+ *
+ * MODEL:
+ * - Ideal timeline: tick n at idealTickUs(n). Constant tempo segments are
+ *   computed as start + n * interval (no accumulated rounding); during a
+ *   ramp each tick takes the tempo at its own start time
+ * - Drift: the sender's clock runs `ppm` fast (+) or slow (-) against the
+ *   audio clock, so every interval is divided by (1 + ppm * 1e-6)
+ * - Jitter: added to the ideal time when the byte goes out
+ *     UNIFORM   +/- amount
+ *     GAUSSIAN  sigma = amount
+ *     LATE      one-sided exponential delay, mean = amount (USB bursts)
+ *   Bytes never overtake each other or get closer than one MIDI byte time
+ * - Dropout: each tick is lost with the given probability; the ideal
+ *   timeline still advances (the receiver falls a tick behind)
+ *
+ * USAGE:
+ *   MidiClockGenerator clock;
+ *   clock.start(120.0, now);
+ *   while (clock.nextEmitUs() <= now) {
+ *       if (clock.advance()) Serial8.simInject(0xF8);
+ *   }
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+enum class ClockJitter : uint8_t {
+    NONE,
+    UNIFORM,
+    GAUSSIAN,
+    LATE
+};
+
+class MidiClockGenerator {
+public:
+    static constexpr uint32_t MIDI_BYTE_US = 320;  // 10 bits at 31250 baud
+
+    /**
+     * Start (or retempo) the clock: tick 0 of the new segment goes out at nowUs
+     *
+     * @param bpm Tempo in sender time, 0 = clock off
+     */
+    void start(double bpm, uint64_t nowUs);
+
+    /**
+     * Ramp the tempo linearly from the current tempo to bpm over durationUs
+     */
+    void rampTo(double bpm, uint64_t durationUs, uint64_t nowUs);
+
+    void setJitter(ClockJitter shape, double amountUs, uint32_t seed);
+    void setDropout(double probability, uint32_t seed);
+    void setDrift(double ppm);
+
+    bool running() const { return m_bpm > 0.0; }
+
+    /**
+     * Time the next tick byte goes out (UINT64_MAX when off)
+     */
+    uint64_t nextEmitUs() const { return running() ? m_nextEmitUs : UINT64_MAX; }
+
+    /**
+     * Move past the tick due at nextEmitUs()
+     *
+     * @return true if the byte is sent, false if it is dropped
+     */
+    bool advance();
+
+    // ========== GROUND TRUTH ==========
+
+    /**
+     * Ideal time of tick n (past ticks are recorded, future ticks projected
+     * from the current tempo/ramp)
+     */
+    double idealTickUs(uint64_t n) const;
+
+    /**
+     * Index of the next tick to go out (= ticks generated so far)
+     */
+    uint64_t nextTickIndex() const { return m_nextTick; }
+
+    /**
+     * Sender tempo as heard by the receiver (drift applied)
+     */
+    double audioBpm() const;
+
+    uint64_t ticksSent() const { return m_sent; }
+    uint64_t ticksDropped() const { return m_dropped; }
+
+private:
+    double tempoAtUs(double us) const;
+    double intervalUs(double bpm) const;
+    void scheduleNext();
+    void resetSegment(double atUs);
+    double jitterUs();
+    uint32_t random();
+    double uniform();  // (0, 1]
+
+    double m_bpm = 0.0;
+    double m_driftPpm = 0.0;
+
+    // Ramp (linear in time)
+    double m_rampFromBpm = 0.0;
+    double m_rampToBpm = 0.0;
+    double m_rampStartUs = 0.0;
+    double m_rampEndUs = 0.0;
+    bool m_ramping = false;
+
+    // Constant-tempo segment: tick n ideal = start + (n - startTick) * interval
+    double m_segmentStartUs = 0.0;
+    uint64_t m_segmentStartTick = 0;
+    double m_segmentIntervalUs = 0.0;
+
+    ClockJitter m_jitter = ClockJitter::NONE;
+    double m_jitterUs = 0.0;
+    double m_dropout = 0.0;
+    uint32_t m_rng = 1;
+
+    std::vector<double> m_ideal;  // Ideal time of every tick generated
+    uint64_t m_nextTick = 0;
+    uint64_t m_nextEmitUs = UINT64_MAX;
+    uint64_t m_lastEmitUs = 0;
+    bool m_hasEmitted = false;
+    uint64_t m_sent = 0;
+    uint64_t m_dropped = 0;
+};
@@ -0,0 +1,55 @@
+/**
+ * golden.cpp - Golden-reference transcript for the host simulator
+ */
+
+#include "golden.h"
+#include <fstream>
+#include <stdio.h>
+#include <string.h>
+
+bool Golden::compare(const char* path) const {
+    std::ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "ERROR: Golden::compare() - cannot open %s (create it with --update-golden)\n", path);
+        return false;
+    }
+
+    std::vector<std::string> expected;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        expected.push_back(line);
+    }
+
+    const size_t count = expected.size() > m_lines.size() ? expected.size() : m_lines.size();
+    for (size_t i = 0; i < count; i++) {
+        const std::string want = i < expected.size() ? expected[i] : "<end>";
+        const std::string got = i < m_lines.size() ? m_lines[i] : "<end>";
+        if (want != got) {
+            fprintf(stderr, "GOLDEN MISMATCH (%s, entry %zu)\n  expected: %s\n  actual:   %s\n",
+                    path, i + 1, want.c_str(), got.c_str());
+            return false;
+        }
+    }
+
+    printf("Golden: %zu entries match %s\n", m_lines.size(), path);
+    return true;
+}
+
+bool Golden::write(const char* path, const char* scenarioPath) const {
+    FILE* f = fopen(path, "w");
+    if (f == nullptr) {
+        fprintf(stderr, "ERROR: Golden::write() - cannot create %s\n", path);
+        return false;
+    }
+    const char* slash = strrchr(scenarioPath, '/');
+    fprintf(f, "# Golden reference for %s\n", slash ? slash + 1 : scenarioPath);
+    fprintf(f, "# Regenerate: microloop_sim <scenario> --golden <this file> --update-golden\n");
+    for (const std::string& line : m_lines) {
+        fprintf(f, "%s\n", line.c_str());
+    }
+    fclose(f);
+    printf("Golden: wrote %zu entries to %s\n", m_lines.size(), path);
+    return true;
+}
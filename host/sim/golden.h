@@ -0,0 +1,49 @@
+/**
+ * golden.h - Golden-reference transcript for the host simulator
+ *
+ * PURPOSE:
+ * Turns a simulator run into a short text transcript - every effect state
+ * change and scheduled action with its sample position, then the output
+ * length and hash - and checks it against a reference checked in next to
+ * the scenario. Any DSP or timing change that alters a single output
+ * sample or moves a transition by one block shows up as a diff.
+ *
+ * FORMAT (one entry per line, '#' lines are comments):
+ *   <sample> <effect> state <from> -> <to>
+ *   <sample> <effect> schedule <label> @<target sample>
+ *   samples <count>
+ *   hash 0x<FNV-1a of the output>
+ *
+ * <sample> is the TimeKeeper position at which the change became visible:
+ * a change made by the audio ISR shows at the position of the block that
+ * applied it, a change made by a controller thread at the next block.
+ *
+ * Intentional changes: rerun with --update-golden and commit the result.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+class Golden {
+public:
+    void add(const std::string& line) { m_lines.push_back(line); }
+
+    /**
+     * Compare with a reference file, print the first difference
+     *
+     * @return true if identical (comments ignored)
+     */
+    bool compare(const char* path) const;
+
+    /**
+     * Write the transcript as the new reference
+     *
+     * @return false if the file cannot be written
+     */
+    bool write(const char* path, const char* scenarioPath) const;
+
+private:
+    std::vector<std::string> m_lines;
+};
@@ -0,0 +1,159 @@
+/**
+ * grid_meter.cpp - Beat grid error of the firmware's tempo tracking (host simulator)
+ */
+
+#include "grid_meter.h"
+#include "effect_quantization.h"
+#include "timekeeper.h"
+#include <algorithm>
+#include <math.h>
+
+static constexpr uint32_t TICKS_PER_BEAT = TimeKeeper::MIDI_PPQN;
+static constexpr uint32_t TICKS_PER_16TH = TimeKeeper::MIDI_PPQN / 4;
+
+static double usToSamples(double us) {
+    return us * TimeKeeper::SAMPLE_RATE / 1e6;
+}
+
+// ========== MEASUREMENT ==========
+
+void GridMeter::onStart(uint64_t nowUs, const MidiClockGenerator& clock) {
+    m_started = true;
+    m_startUs = static_cast<double>(nowUs);
+    m_startTick = clock.nextTickIndex();
+}
+
+void GridMeter::onStop() {
+    m_started = false;
+}
+
+void GridMeter::sample(uint64_t nowUs, const MidiClockGenerator& clock) {
+    if (!m_started || !clock.running() || !TimeKeeper::isRunning() || TimeKeeper::getSamplesPerBeat() == 0) {
+        return;
+    }
+
+    const double now = static_cast<double>(nowUs);
+    const double sampleUs = 1e6 / TimeKeeper::SAMPLE_RATE;
+
+    // Where a quantized action pressed now would land
+    const double beatAt = now + EffectQuantization::samplesToNextQuantizedBoundary(Quantization::QUANT_4) * sampleUs;
+    const double subAt = now + EffectQuantization::samplesToNextQuantizedBoundary(Quantization::QUANT_16) * sampleUs;
+
+    const double beatError = usToSamples(nearestBoundaryError(clock, beatAt, TICKS_PER_BEAT));
+    const double subError = usToSamples(nearestBoundaryError(clock, subAt, TICKS_PER_16TH));
+    m_beatErrors.push_back(beatError);
+    m_subErrors.push_back(subError);
+
+    // One row per true beat
+    const uint32_t beat = static_cast<uint32_t>(ticksAfterStart(clock, now) / TICKS_PER_BEAT);
+    if (m_rows.empty() || m_rows.back().beat != beat) {
+        m_rows.push_back(BeatRow{ beat, now, 0.0, 0.0, 0, 0.0, 0.0, 0.0 });
+    }
+    BeatRow& row = m_rows.back();
+    row.trueBpm = clock.audioBpm();
+    row.estimatedBpm = TimeKeeper::getBPM();
+    row.samples++;
+    row.beatErrorSum += beatError;
+    row.beatErrorMaxAbs = std::max(row.beatErrorMaxAbs, fabs(beatError));
+    row.subErrorMaxAbs = std::max(row.subErrorMaxAbs, fabs(subError));
+}
+
+double GridMeter::boundaryUs(const MidiClockGenerator& clock, uint64_t k, uint32_t ticksPerStep) const {
+    if (k == 0) {
+        return m_startUs;
+    }
+    return clock.idealTickUs(m_startTick + k * ticksPerStep - 1);
+}
+
+uint64_t GridMeter::ticksAfterStart(const MidiClockGenerator& clock, double us) const {
+    // Ideal ticks after START at or before `us` (exponential + binary search)
+    uint64_t lo = 0;
+    uint64_t hi = 1;
+    while (clock.idealTickUs(m_startTick + hi - 1) <= us) {
+        lo = hi;
+        hi *= 2;
+    }
+    while (hi - lo > 1) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (clock.idealTickUs(m_startTick + mid - 1) <= us) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+double GridMeter::nearestBoundaryError(const MidiClockGenerator& clock, double predictedUs, uint32_t ticksPerStep) const {
+    // Step index at or before the prediction, then compare with its neighbour
+    uint64_t k = ticksAfterStart(clock, predictedUs) / ticksPerStep;
+    while (boundaryUs(clock, k + 1, ticksPerStep) <= predictedUs) {
+        k++;
+    }
+    const double before = predictedUs - boundaryUs(clock, k, ticksPerStep);
+    const double after = predictedUs - boundaryUs(clock, k + 1, ticksPerStep);
+    return (fabs(before) <= fabs(after)) ? before : after;
+}
+
+double GridMeter::maxBeatError(uint32_t settleBeats) const {
+    double worst = 0.0;
+    for (const BeatRow& row : m_rows) {
+        if (row.beat >= settleBeats) {
+            worst = std::max(worst, row.beatErrorMaxAbs);
+        }
+    }
+    return worst;
+}
+
+// ========== REPORT ==========
+
+static void printStats(const char* label, std::vector<double> errors) {
+    double sum = 0.0;
+    double sumSq = 0.0;
+    for (double& e : errors) {
+        sum += e;
+        sumSq += e * e;
+        e = fabs(e);
+    }
+    std::sort(errors.begin(), errors.end());
+    const double n = static_cast<double>(errors.size());
+    const double p95 = errors[static_cast<size_t>(0.95 * (errors.size() - 1))];
+    printf("  %-10s mean %+8.1f  rms %8.1f  p95 %8.1f  max %8.1f samples (max %.2f ms)\n", label, sum / n,
+           sqrt(sumSq / n), p95, errors.back(), errors.back() * 1000.0 / TimeKeeper::SAMPLE_RATE);
+}
+
+void GridMeter::printSummary() const {
+    if (!measured()) {
+        return;
+    }
+
+    printf("Grid error vs sender timeline (%zu measurements, %zu beats):\n", m_beatErrors.size(), m_rows.size());
+    printStats("1/4 grid", m_beatErrors);
+    printStats("1/16 grid", m_subErrors);
+
+    const BeatRow* worst = &m_rows.front();
+    for (const BeatRow& row : m_rows) {
+        if (row.beatErrorMaxAbs > worst->beatErrorMaxAbs) {
+            worst = &row;
+        }
+    }
+    const BeatRow& last = m_rows.back();
+    printf("  worst beat %u at %.3f ms: |err| %.1f samples\n", worst->beat, worst->atUs / 1000.0, worst->beatErrorMaxAbs);
+    printf("  tempo at end: sender %.3f BPM, estimated %.3f BPM (%+.3f)\n", last.trueBpm, last.estimatedBpm,
+           last.estimatedBpm - last.trueBpm);
+}
+
+bool GridMeter::writeCsv(const char* path) const {
+    FILE* f = fopen(path, "w");
+    if (f == nullptr) {
+        fprintf(stderr, "ERROR: GridMeter::writeCsv() - cannot create %s\n", path);
+        return false;
+    }
+    fprintf(f, "beat,time_ms,sender_bpm,estimated_bpm,beat_err_mean,beat_err_max,sub_err_max\n");
+    for (const BeatRow& row : m_rows) {
+        fprintf(f, "%u,%.3f,%.3f,%.3f,%.1f,%.1f,%.1f\n", row.beat, row.atUs / 1000.0, row.trueBpm, row.estimatedBpm,
+                row.beatErrorSum / row.samples, row.beatErrorMaxAbs, row.subErrorMaxAbs);
+    }
+    fclose(f);
+    return true;
+}
@@ -0,0 +1,79 @@
+/**
+ * grid_meter.h - Beat grid error of the firmware's tempo tracking (host simulator)
+ *
+ * PURPOSE:
+ * Scores how well AppLogic's clock handling (processClockTicks() ->
+ * TimeKeeper) follows the sender's beat grid under the jitter, ramps,
+ * dropouts and drift produced by MidiClockGenerator. This is the benchmark
+ * for tempo-tracking changes: run the clock_*.txt scenarios before and after.
+ *
+ * MEASUREMENT (after every audio block while the transport runs):
+ * - Predicted boundary: now + samplesToNextQuantizedBoundary(), i.e. where a
+ *   quantized action pressed now would land, converted to time at the audio
+ *   rate
+ * - True boundary: the sender's ideal tick timeline. Counting like the
+ *   firmware, beat k ends on the 24k-th tick after START (16th m on the 6m-th)
+ * - Grid error: predicted minus the nearest true boundary, in samples
+ *   (positive = late)
+ *
+ * REPORT:
+ *   Summary (printSummary): beat and 16th grid error (mean, RMS, p95, max),
+ *   tempo estimate error, worst beat
+ *   Time series (writeCsv): one row per true beat
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include "clock_gen.h"
+
+class GridMeter {
+public:
+    /**
+     * MIDI START went out at nowUs (the next clock tick is tick 1)
+     */
+    void onStart(uint64_t nowUs, const MidiClockGenerator& clock);
+
+    void onStop();
+
+    /**
+     * Measure after an audio block (no-op unless started and the transport runs)
+     */
+    void sample(uint64_t nowUs, const MidiClockGenerator& clock);
+
+    bool measured() const { return !m_beatErrors.empty(); }
+
+    /**
+     * Largest |beat grid error| in samples, ignoring the first `settleBeats`
+     */
+    double maxBeatError(uint32_t settleBeats) const;
+
+    void printSummary() const;
+    bool writeCsv(const char* path) const;
+
+private:
+    struct BeatRow {
+        uint32_t beat;
+        double atUs;
+        double trueBpm;
+        double estimatedBpm;
+        uint32_t samples;
+        double beatErrorSum;       // Signed
+        double beatErrorMaxAbs;
+        double subErrorMaxAbs;
+    };
+
+    double boundaryUs(const MidiClockGenerator& clock, uint64_t k, uint32_t ticksPerStep) const;
+    double nearestBoundaryError(const MidiClockGenerator& clock, double predictedUs, uint32_t ticksPerStep) const;
+    uint64_t ticksAfterStart(const MidiClockGenerator& clock, double us) const;
+
+    bool m_started = false;
+    double m_startUs = 0.0;
+    uint64_t m_startTick = 0;  // Generator index of tick 1 after START
+
+    std::vector<BeatRow> m_rows;
+    std::vector<double> m_beatErrors;  // Signed, samples, one per measurement
+    std::vector<double> m_subErrors;
+};
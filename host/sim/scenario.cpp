@@ -0,0 +1,256 @@
+/**
+ * scenario.cpp - Scripted performance parser for the host simulator
+ */
+
+#include "scenario.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+static void printError(uint32_t lineNumber, const char* reason, const std::string& detail = "") {
+    fprintf(stderr, "ERROR: Scenario::load() - line %u: %s%s%s\n", lineNumber, reason,
+            detail.empty() ? "" : ": ", detail.c_str());
+}
+
+static bool parseNumber(const std::string& token, double& out) {
+    char* end = nullptr;
+    out = strtod(token.c_str(), &end);
+    return end != token.c_str() && *end == '\0';
+}
+
+static bool parseInt(const std::string& token, int32_t& out) {
+    char* end = nullptr;
+    long v = strtol(token.c_str(), &end, 10);
+    if (end == token.c_str() || *end != '\0') {
+        return false;
+    }
+    out = static_cast<int32_t>(v);
+    return true;
+}
+
+bool Scenario::load(const char* path) {
+    std::ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "ERROR: Scenario::load() - cannot open %s\n", path);
+        return false;
+    }
+
+    m_events.clear();
+    m_tempoBpm = DEFAULT_TEMPO_BPM;
+    m_endUs = 0;
+    m_hasEnd = false;
+
+    std::string line;
+    uint32_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.erase(hash);
+        }
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        if (!parseLine(line, lineNumber)) {
+            return false;
+        }
+    }
+
+    // Stable: events at the same time keep file order
+    std::stable_sort(m_events.begin(), m_events.end(),
+                     [](const ScenarioEvent& a, const ScenarioEvent& b) { return a.atUs < b.atUs; });
+
+    if (!m_hasEnd) {
+        m_endUs = m_events.empty() ? 0 : m_events.back().atUs;
+    }
+    return true;
+}
+
+bool Scenario::parseTime(const std::string& token, uint64_t& outUs) const {
+    size_t split = token.find_first_not_of("0123456789.");
+    std::string number = token.substr(0, split);
+    std::string unit = (split == std::string::npos) ? "ms" : token.substr(split);
+
+    double value;
+    if (!parseNumber(number, value) || value < 0) {
+        return false;
+    }
+
+    double us;
+    if (unit == "us") {
+        us = value;
+    } else if (unit == "ms") {
+        us = value * 1000.0;
+    } else if (unit == "s") {
+        us = value * 1000000.0;
+    } else if (unit == "b") {
+        us = value * 60000000.0 / m_tempoBpm;
+    } else {
+        return false;
+    }
+
+    outUs = static_cast<uint64_t>(us + 0.5);
+    return true;
+}
+
+bool Scenario::parseLine(const std::string& line, uint32_t lineNumber) {
+    std::istringstream in(line);
+    std::vector<std::string> tokens;
+    std::string token;
+    while (in >> token) {
+        tokens.push_back(token);
+    }
+
+    // ========== DIRECTIVES ==========
+    if (tokens[0] == "tempo") {
+        double bpm;
+        if (tokens.size() != 2 || !parseNumber(tokens[1], bpm) || bpm <= 0) {
+            printError(lineNumber, "usage: tempo <bpm>");
+            return false;
+        }
+        m_tempoBpm = bpm;
+        return true;
+    }
+
+    // ========== TIMED COMMANDS ==========
+    ScenarioEvent event = {};
+    event.line = lineNumber;
+
+    if (tokens.size() < 2 || !parseTime(tokens[0], event.atUs)) {
+        printError(lineNumber, "expected '<time> <command>'", tokens[0]);
+        return false;
+    }
+
+    const std::string& command = tokens[1];
+    const size_t numArgs = tokens.size() - 2;
+    auto arg = [&](size_t i) -> const std::string& { return tokens[i + 2]; };
+
+    if (command == "input") {
+        event.action = ScenarioAction::AUDIO_INPUT;
+        const std::string kind = numArgs > 0 ? arg(0) : "";
+        bool ok = false;
+        if (kind == "silence") {
+            event.signal = InputSignal::SILENCE;
+            ok = (numArgs == 1);
+        } else if (kind == "sine" || kind == "saw") {
+            event.signal = (kind == "sine") ? InputSignal::SINE : InputSignal::SAW;
+            ok = (numArgs == 3) && parseNumber(arg(1), event.value) && parseNumber(arg(2), event.value2) &&
+                 event.value > 0;
+        } else if (kind == "noise") {
+            event.signal = InputSignal::NOISE;
+            int32_t seed = 1;
+            ok = (numArgs == 2 || numArgs == 3) && parseNumber(arg(1), event.value2) &&
+                 (numArgs == 2 || parseInt(arg(2), seed));
+            event.seed = static_cast<uint32_t>(seed);
+        } else if (kind == "clicks") {
+            event.signal = InputSignal::CLICKS;
+            ok = (numArgs == 3) && parseNumber(arg(1), event.value) && parseNumber(arg(2), event.value2) &&
+                 event.value > 0;
+        }
+        if (!ok || event.value2 < 0.0 || event.value2 > 1.0) {
+            printError(lineNumber, "usage: input silence | sine|saw <hz> <amp> | noise <amp> [seed] | clicks <ms> <amp>");
+            return false;
+        }
+    } else if (command == "clock") {
+        const std::string kind = numArgs > 0 ? arg(0) : "";
+        int32_t seed = 1;
+        bool ok = false;
+        if (kind == "ramp") {
+            event.action = ScenarioAction::CLOCK_RAMP;
+            ok = (numArgs == 3) && parseNumber(arg(1), event.value) && event.value > 0 &&
+                 parseTime(arg(2), event.durationUs);
+        } else if (kind == "jitter") {
+            event.action = ScenarioAction::CLOCK_JITTER;
+            const std::string shape = numArgs > 1 ? arg(1) : "";
+            ok = true;
+            if (shape == "none") {
+                event.jitter = ClockJitter::NONE;
+            } else if (shape == "uniform") {
+                event.jitter = ClockJitter::UNIFORM;
+            } else if (shape == "gauss") {
+                event.jitter = ClockJitter::GAUSSIAN;
+            } else if (shape == "late") {
+                event.jitter = ClockJitter::LATE;
+            } else {
+                ok = false;
+            }
+            ok = ok && (numArgs == 3 || numArgs == 4) && parseNumber(arg(2), event.value) && event.value >= 0 &&
+                 (numArgs == 3 || parseInt(arg(3), seed));
+        } else if (kind == "dropout") {
+            event.action = ScenarioAction::CLOCK_DROPOUT;
+            ok = (numArgs == 2 || numArgs == 3) && parseNumber(arg(1), event.value) && event.value >= 0 &&
+                 event.value <= 1 && (numArgs == 2 || parseInt(arg(2), seed));
+        } else if (kind == "drift") {
+            event.action = ScenarioAction::CLOCK_DRIFT;
+            ok = (numArgs == 2) && parseNumber(arg(1), event.value) && event.value > -1e6;
+        } else {
+            event.action = ScenarioAction::MIDI_CLOCK;
+            ok = (numArgs == 1) && parseNumber(arg(0), event.value) && event.value >= 0;
+        }
+        event.seed = static_cast<uint32_t>(seed);
+        if (!ok) {
+            printError(lineNumber, "usage: clock <bpm> | ramp <bpm> <time> | jitter none|uniform|gauss|late <us> [seed] | "
+                                   "dropout <p> [seed] | drift <ppm>");
+            return false;
+        }
+    } else if (command == "start" || command == "stop" || command == "continue") {
+        event.action = ScenarioAction::MIDI_BYTES;
+        event.text.push_back(static_cast<char>(command == "start" ? 0xFA : (command == "stop" ? 0xFC : 0xFB)));
+    } else if (command == "midi") {
+        event.action = ScenarioAction::MIDI_BYTES;
+        for (size_t i = 0; i < numArgs; i++) {
+            char* end = nullptr;
+            unsigned long b = strtoul(arg(i).c_str(), &end, 16);
+            if (*end != '\0' || b > 0xFF) {
+                printError(lineNumber, "bad MIDI byte", arg(i));
+                return false;
+            }
+            event.text.push_back(static_cast<char>(b));
+        }
+        if (event.text.empty()) {
+            printError(lineNumber, "usage: midi <hex> [hex...]");
+            return false;
+        }
+    } else if (command == "press" || command == "release") {
+        event.action = (command == "press") ? ScenarioAction::KEY_PRESS : ScenarioAction::KEY_RELEASE;
+        if (numArgs != 1 || !parseInt(arg(0), event.arg) || event.arg < 0 || event.arg > 3) {
+            printError(lineNumber, "usage: press|release <key 0-3>");
+            return false;
+        }
+    } else if (command == "turn") {
+        event.action = ScenarioAction::ENCODER_TURN;
+        if (numArgs != 2 || !parseInt(arg(0), event.arg) || event.arg < 1 || event.arg > 4 ||
+            !parseInt(arg(1), event.amount) || event.amount == 0) {
+            printError(lineNumber, "usage: turn <encoder 1-4> <detents>");
+            return false;
+        }
+    } else if (command == "click") {
+        event.action = ScenarioAction::ENCODER_CLICK;
+        if (numArgs != 1 || !parseInt(arg(0), event.arg) || event.arg < 1 || event.arg > 4) {
+            printError(lineNumber, "usage: click <encoder 1-4>");
+            return false;
+        }
+    } else if (command == "serial") {
+        event.action = ScenarioAction::CONSOLE;
+        if (numArgs == 0) {
+            printError(lineNumber, "usage: serial <text>");
+            return false;
+        }
+        // Everything after the command, inner spaces kept
+        size_t start = line.find_first_not_of(" \t", line.find("serial") + 6);
+        size_t last = line.find_last_not_of(" \t\r");
+        event.text = line.substr(start, last + 1 - start);
+    } else if (command == "end") {
+        event.action = ScenarioAction::END;
+        m_endUs = event.atUs;
+        m_hasEnd = true;
+    } else {
+        printError(lineNumber, "unknown command", command);
+        return false;
+    }
+
+    m_events.push_back(event);
+    return true;
+}
@@ -0,0 +1,120 @@
+/**
+ * scenario.h - Scripted performance for the host simulator
+ *
+ * FORMAT (one event per line, '#' starts a comment):
+ *   <time> <command> [args...]
+ *
+ *   Time: number with unit suffix - us, ms (default), s, or b (beats at the
+ *   tempo set by the last 'tempo' directive, default 120 BPM). Events may
+ *   appear in any order; they are sorted by time (file order breaks ties).
+ *
+ *   Directives (no time):
+ *     tempo <bpm>             Beat length for 'b' times
+ *
+ *   Commands:
+ *     input silence           Audio input generator (both channels)
+ *     input sine <hz> <amp>   amp is 0.0-1.0 of full scale
+ *     input saw <hz> <amp>    Integer phase, bit-exact across platforms
+ *     input noise <amp> [seed]
+ *     input clicks <ms> <amp> One-sample impulse every <ms>
+ *     clock <bpm>             MIDI clock generator on (24 PPQN), 0 = off
+ *     clock ramp <bpm> <time> Linear tempo ramp to <bpm> over <time>
+ *     clock jitter <shape> <us> [seed]
+ *                             Tick timing error: none, uniform (+/- us),
+ *                             gauss (sigma us) or late (mean us, one-sided)
+ *     clock dropout <p> [seed] Lose each tick with probability p
+ *     clock drift <ppm>       Sender clock fast (+) / slow (-) vs the codec
+ *     start | stop | continue MIDI transport message
+ *     midi <hex> [hex...]     Raw MIDI bytes into the DIN port
+ *     press <key>             NeoKey key 0-3 down (0=STUTTER 1=FREEZE 2=CHOKE 3=FUNC)
+ *     release <key>           NeoKey key up
+ *     turn <enc> <detents>    Encoder 1-4, signed detents (2 detents = 1 menu step)
+ *     click <enc>             Encoder 1-4 push button (press + release)
+ *     serial <text>           Characters into the USB console
+ *     end                     Stop the simulation
+ *
+ * EXAMPLE:
+ *   tempo 128
+ *   0     input saw 110 0.5
+ *   0     clock 128
+ *   10ms  start
+ *   4b    press 0
+ *   5b    release 0
+ *   8b    end
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "clock_gen.h"
+
+// Names avoid Arduino.h macros (INPUT, ...)
+enum class ScenarioAction : uint8_t {
+    AUDIO_INPUT,
+    MIDI_CLOCK,
+    CLOCK_RAMP,
+    CLOCK_JITTER,
+    CLOCK_DROPOUT,
+    CLOCK_DRIFT,
+    MIDI_BYTES,
+    KEY_PRESS,
+    KEY_RELEASE,
+    ENCODER_TURN,
+    ENCODER_CLICK,
+    CONSOLE,
+    END
+};
+
+enum class InputSignal : uint8_t {
+    SILENCE,
+    SINE,
+    SAW,
+    NOISE,
+    CLICKS
+};
+
+struct ScenarioEvent {
+    uint64_t atUs;
+    ScenarioAction action;
+    uint32_t line;          // Source line (for reports)
+    int32_t arg;            // Key (0-3) or encoder (1-4)
+    int32_t amount;         // ENCODER_TURN: signed detents
+    InputSignal signal;     // AUDIO_INPUT only
+    double value;           // AUDIO_INPUT: frequency / period (ms) / amplitude, MIDI_CLOCK/CLOCK_RAMP: BPM,
+                            // CLOCK_JITTER: us, CLOCK_DROPOUT: probability, CLOCK_DRIFT: ppm
+    double value2;          // AUDIO_INPUT: amplitude
+    uint64_t durationUs;    // CLOCK_RAMP only
+    ClockJitter jitter;     // CLOCK_JITTER only
+    uint32_t seed;          // AUDIO_INPUT noise, CLOCK_JITTER, CLOCK_DROPOUT
+    std::string text;       // MIDI_BYTES: raw bytes, CONSOLE: characters
+};
+
+class Scenario {
+public:
+    static constexpr double DEFAULT_TEMPO_BPM = 120.0;
+
+    /**
+     * Parse a scenario file
+     *
+     * @return true on success (errors are printed with the line number)
+     */
+    bool load(const char* path);
+
+    const std::vector<ScenarioEvent>& events() const { return m_events; }
+
+    /**
+     * Time of the 'end' command (or the last event if there is none)
+     */
+    uint64_t endUs() const { return m_endUs; }
+
+private:
+    bool parseLine(const std::string& line, uint32_t lineNumber);
+    bool parseTime(const std::string& token, uint64_t& outUs) const;
+
+    std::vector<ScenarioEvent> m_events;
+    double m_tempoBpm = DEFAULT_TEMPO_BPM;
+    uint64_t m_endUs = 0;
+    bool m_hasEnd = false;
+};
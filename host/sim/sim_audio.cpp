@@ -0,0 +1,151 @@
+/**
+ * sim_audio.cpp - Audio input generator and output recorder for the host simulator
+ */
+
+#include "sim_audio.h"
+#include "timekeeper.h"
+#include <math.h>
+
+// ========== INPUT ==========
+
+void SimAudioInput::setSignal(const ScenarioEvent& event) {
+    m_signal = event.signal;
+    m_amplitude = static_cast<int16_t>(event.value2 * 32767.0 + 0.5);
+
+    switch (m_signal) {
+        case InputSignal::SINE:
+            m_phase = 0.0;
+            m_phaseStep = 2.0 * M_PI * event.value / TimeKeeper::SAMPLE_RATE;
+            break;
+        case InputSignal::SAW:
+            m_phaseFixed = 0;
+            m_phaseStepFixed = static_cast<uint32_t>(event.value * 4294967296.0 / TimeKeeper::SAMPLE_RATE);
+            break;
+        case InputSignal::NOISE:
+            m_noiseState = event.seed != 0 ? event.seed : 1;
+            break;
+        case InputSignal::CLICKS:
+            m_clickPeriod = static_cast<uint32_t>(event.value * TimeKeeper::SAMPLE_RATE / 1000.0 + 0.5);
+            if (m_clickPeriod == 0) m_clickPeriod = 1;
+            m_clickCounter = 0;
+            break;
+        case InputSignal::SILENCE:
+            break;
+    }
+}
+
+void SimAudioInput::generate(int16_t* left, int16_t* right, size_t samples) {
+    for (size_t i = 0; i < samples; i++) {
+        int16_t l = 0;
+        int16_t r = 0;
+
+        switch (m_signal) {
+            case InputSignal::SILENCE:
+                break;
+
+            case InputSignal::SINE:
+                l = r = static_cast<int16_t>(lrint(m_amplitude * sin(m_phase)));
+                m_phase += m_phaseStep;
+                if (m_phase >= 2.0 * M_PI) m_phase -= 2.0 * M_PI;
+                break;
+
+            case InputSignal::SAW:
+                // Top 16 bits of the phase as a signed ramp, scaled by amplitude
+                l = r = static_cast<int16_t>((static_cast<int32_t>(static_cast<int16_t>(m_phaseFixed >> 16)) * m_amplitude) >> 15);
+                m_phaseFixed += m_phaseStepFixed;
+                break;
+
+            case InputSignal::NOISE:
+                // Two LCG draws per frame: decorrelated channels
+                m_noiseState = m_noiseState * 1664525u + 1013904223u;
+                l = static_cast<int16_t>((static_cast<int32_t>(static_cast<int16_t>(m_noiseState >> 16)) * m_amplitude) >> 15);
+                m_noiseState = m_noiseState * 1664525u + 1013904223u;
+                r = static_cast<int16_t>((static_cast<int32_t>(static_cast<int16_t>(m_noiseState >> 16)) * m_amplitude) >> 15);
+                break;
+
+            case InputSignal::CLICKS:
+                if (m_clickCounter == 0) {
+                    l = r = m_amplitude;
+                }
+                m_clickCounter++;
+                if (m_clickCounter >= m_clickPeriod) m_clickCounter = 0;
+                break;
+        }
+
+        left[i] = l;
+        right[i] = r;
+    }
+}
+
+// ========== OUTPUT ==========
+
+static void writeLe32(FILE* f, uint32_t v) {
+    uint8_t b[4] = { static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8),
+                     static_cast<uint8_t>(v >> 16), static_cast<uint8_t>(v >> 24) };
+    fwrite(b, 1, 4, f);
+}
+
+static void writeLe16(FILE* f, uint16_t v) {
+    uint8_t b[2] = { static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8) };
+    fwrite(b, 1, 2, f);
+}
+
+static void writeWavHeader(FILE* f, uint32_t dataBytes) {
+    fwrite("RIFF", 1, 4, f);
+    writeLe32(f, 36 + dataBytes);
+    fwrite("WAVEfmt ", 1, 8, f);
+    writeLe32(f, 16);                               // fmt chunk size
+    writeLe16(f, 1);                                // PCM
+    writeLe16(f, 2);                                // Stereo
+    writeLe32(f, TimeKeeper::SAMPLE_RATE);
+    writeLe32(f, TimeKeeper::SAMPLE_RATE * 4);      // Byte rate
+    writeLe16(f, 4);                                // Block align
+    writeLe16(f, 16);                               // Bits per sample
+    fwrite("data", 1, 4, f);
+    writeLe32(f, dataBytes);
+}
+
+SimAudioOutput::~SimAudioOutput() {
+    close();
+}
+
+bool SimAudioOutput::openWav(const char* path) {
+    m_wav = fopen(path, "wb");
+    if (m_wav == nullptr) {
+        fprintf(stderr, "ERROR: SimAudioOutput::openWav() - cannot create %s\n", path);
+        return false;
+    }
+    writeWavHeader(m_wav, 0);  // Patched in close()
+    return true;
+}
+
+void SimAudioOutput::record(const int16_t* left, const int16_t* right, size_t samples) {
+    for (size_t i = 0; i < samples; i++) {
+        const int16_t frame[2] = { left[i], right[i] };
+        for (int16_t s : frame) {
+            m_hash = (m_hash ^ static_cast<uint8_t>(s)) * FNV_PRIME;
+            m_hash = (m_hash ^ static_cast<uint8_t>(static_cast<uint16_t>(s) >> 8)) * FNV_PRIME;
+        }
+
+        int16_t absL = static_cast<int16_t>(left[i] == -32768 ? 32767 : (left[i] < 0 ? -left[i] : left[i]));
+        int16_t absR = static_cast<int16_t>(right[i] == -32768 ? 32767 : (right[i] < 0 ? -right[i] : right[i]));
+        if (absL > m_peakLeft) m_peakLeft = absL;
+        if (absR > m_peakRight) m_peakRight = absR;
+
+        if (m_wav != nullptr) {
+            writeLe16(m_wav, static_cast<uint16_t>(left[i]));
+            writeLe16(m_wav, static_cast<uint16_t>(right[i]));
+        }
+    }
+    m_samples += samples;
+}
+
+void SimAudioOutput::close() {
+    if (m_wav == nullptr) {
+        return;
+    }
+    fseek(m_wav, 0, SEEK_SET);
+    writeWavHeader(m_wav, static_cast<uint32_t>(m_samples * 4));
+    fclose(m_wav);
+    m_wav = nullptr;
+}
@@ -0,0 +1,82 @@
+/**
+ * sim_audio.h - Audio input generator and output recorder for the host simulator
+ *
+ * PURPOSE:
+ * Feeds AudioInputI2S with a scripted test signal and captures everything
+ * AudioOutputI2S plays, so a run can be compared against a known-good one
+ * (hash) or listened to (WAV).
+ *
+ * DESIGN:
+ * - Generator: silence, sine, saw (integer phase), LCG noise, click train;
+ *   sample-counted so signals are identical run to run
+ * - Recorder: FNV-1a hash over interleaved L/R samples, per-channel peak,
+ *   optional 16-bit stereo WAV file
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "scenario.h"
+
+class SimAudioInput {
+public:
+    /**
+     * Switch the generated signal (takes effect at the next block)
+     */
+    void setSignal(const ScenarioEvent& event);
+
+    /**
+     * Fill one block per channel (called from AudioInputI2S::update)
+     */
+    void generate(int16_t* left, int16_t* right, size_t samples);
+
+private:
+    InputSignal m_signal = InputSignal::SILENCE;
+    int16_t m_amplitude = 0;
+    double m_phase = 0.0;          // SINE: radians
+    double m_phaseStep = 0.0;
+    uint32_t m_phaseFixed = 0;     // SAW: Q32 phase
+    uint32_t m_phaseStepFixed = 0;
+    uint32_t m_noiseState = 1;
+    uint32_t m_clickPeriod = 0;    // CLICKS: samples between impulses
+    uint32_t m_clickCounter = 0;
+};
+
+class SimAudioOutput {
+public:
+    ~SimAudioOutput();
+
+    /**
+     * Also write the output to a WAV file
+     *
+     * @return false if the file cannot be created
+     */
+    bool openWav(const char* path);
+
+    /**
+     * Record one block per channel (called from AudioOutputI2S::update)
+     */
+    void record(const int16_t* left, const int16_t* right, size_t samples);
+
+    uint32_t hash() const { return m_hash; }
+    uint64_t samples() const { return m_samples; }
+    int16_t peakLeft() const { return m_peakLeft; }
+    int16_t peakRight() const { return m_peakRight; }
+
+    /**
+     * Patch the WAV header and close the file
+     */
+    void close();
+
+private:
+    static constexpr uint32_t FNV_OFFSET = 2166136261u;
+    static constexpr uint32_t FNV_PRIME = 16777619u;
+
+    uint32_t m_hash = FNV_OFFSET;
+    uint64_t m_samples = 0;
+    int16_t m_peakLeft = 0;
+    int16_t m_peakRight = 0;
+    FILE* m_wav = nullptr;
+};
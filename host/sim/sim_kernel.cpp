@@ -0,0 +1,133 @@
+/**
+ * sim_kernel.cpp - Virtual clock and cooperative scheduler for the host simulator
+ */
+
+#include "sim_kernel.h"
+#include <ucontext.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace SimKernel {
+
+struct SimThread {
+    const char* name;
+    ThreadFn fn;
+    void* arg;
+    ucontext_t context;
+    uint8_t* stack;
+    uint64_t wakeUs;
+    bool finished;
+};
+
+static uint64_t s_nowUs = 0;
+static uint64_t s_watchdogUs = UINT64_MAX;
+
+static SimThread s_threads[MAX_THREADS];
+static int s_numThreads = 0;
+static int s_current = -1;
+static ucontext_t s_schedulerContext;
+
+static void threadTrampoline(unsigned int hi, unsigned int lo) {
+    uintptr_t index = (static_cast<uintptr_t>(hi) << 32) | lo;
+    SimThread& thread = s_threads[index];
+    thread.fn(thread.arg);
+
+    // Firmware thread functions never return; if one does, retire it
+    thread.finished = true;
+    swapcontext(&thread.context, &s_schedulerContext);
+}
+
+uint64_t nowUs() {
+    return s_nowUs;
+}
+
+uint32_t cycleCount() {
+    return static_cast<uint32_t>(s_nowUs * CYCLES_PER_US);
+}
+
+void advanceTo(uint64_t us) {
+    if (us > s_nowUs) {
+        s_nowUs = us;
+    }
+}
+
+int createThread(const char* name, ThreadFn fn, void* arg) {
+    if (s_numThreads >= static_cast<int>(MAX_THREADS)) {
+        fprintf(stderr, "ERROR: SimKernel::createThread() - table full (max %zu threads)\n", MAX_THREADS);
+        return -1;
+    }
+
+    int id = s_numThreads;
+    SimThread& thread = s_threads[id];
+    thread.name = name;
+    thread.fn = fn;
+    thread.arg = arg;
+    thread.stack = static_cast<uint8_t*>(malloc(HOST_STACK_SIZE));
+    thread.wakeUs = s_nowUs;
+    thread.finished = false;
+
+    getcontext(&thread.context);
+    thread.context.uc_stack.ss_sp = thread.stack;
+    thread.context.uc_stack.ss_size = HOST_STACK_SIZE;
+    thread.context.uc_link = &s_schedulerContext;
+
+    uintptr_t index = static_cast<uintptr_t>(id);
+    makecontext(&thread.context, reinterpret_cast<void (*)()>(threadTrampoline), 2,
+                static_cast<unsigned int>(index >> 32), static_cast<unsigned int>(index & 0xFFFFFFFF));
+
+    s_numThreads++;
+    return id;
+}
+
+void runReadyThreads() {
+    for (int i = 0; i < s_numThreads; i++) {
+        SimThread& thread = s_threads[i];
+        if (thread.finished || thread.wakeUs > s_nowUs) {
+            continue;
+        }
+        s_current = i;
+        swapcontext(&s_schedulerContext, &thread.context);
+        s_current = -1;
+    }
+}
+
+uint64_t nextWakeUs() {
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < s_numThreads; i++) {
+        if (!s_threads[i].finished && s_threads[i].wakeUs < next) {
+            next = s_threads[i].wakeUs;
+        }
+    }
+    return next;
+}
+
+void sleepFor(uint64_t durationUs) {
+    if (s_current < 0) {
+        // Not inside a thread (setup()): nothing else can run, just move time
+        s_nowUs += durationUs;
+        if (s_nowUs > s_watchdogUs) {
+            fprintf(stderr, "ERROR: firmware stalled outside a thread (halted in setup()?)\n");
+            exit(2);
+        }
+        return;
+    }
+
+    SimThread& thread = s_threads[s_current];
+    // A zero-length sleep still has to give the other threads a turn
+    thread.wakeUs = s_nowUs + (durationUs > 0 ? durationUs : YIELD_QUANTUM_US);
+    swapcontext(&thread.context, &s_schedulerContext);
+}
+
+void yieldThread() {
+    sleepFor(YIELD_QUANTUM_US);
+}
+
+int currentThread() {
+    return s_current;
+}
+
+void setWatchdogUs(uint64_t us) {
+    s_watchdogUs = us;
+}
+
+}
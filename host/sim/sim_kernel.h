@@ -0,0 +1,96 @@
+/**
+ * sim_kernel.h - Virtual clock and cooperative scheduler for the host simulator
+ *
+ * PURPOSE:
+ * Replaces wall-clock time and TeensyThreads' preemptive scheduler with a
+ * discrete-event kernel. Nothing runs "in real time": the kernel jumps the
+ * clock straight to the next thing that needs to happen (a thread waking,
+ * an audio block, a scenario event), so a 60s performance simulates in a
+ * fraction of a second and every run produces identical results.
+ *
+ * DESIGN:
+ * - Clock: 64-bit microsecond counter, only advanced by the simulator loop
+ * - Threads: ucontext coroutines. threads.delay(ms) and Arduino delay()
+ *   park the caller until now + ms, threads.yield() parks it for
+ *   YIELD_QUANTUM_US (stands in for the rest of a TeensyThreads time slice)
+ * - Ready threads run in creation order (deterministic round-robin)
+ * - Host stacks are allocated here (HOST_STACK_SIZE): x86-64 frames and
+ *   stdio are far deeper than the Teensy stacks passed to addThread(), so
+ *   those caller stacks stay painted and StackMonitor reports 0 bytes used
+ *
+ * USAGE (simulator main only):
+ *   SimKernel::createThread("loop", loopThreadEntry, nullptr);
+ *   while (running) {
+ *       SimKernel::advanceTo(nextEventTime);
+ *       ...fire audio blocks / scenario events due now...
+ *       SimKernel::runReadyThreads();
+ *   }
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace SimKernel {
+    static constexpr size_t MAX_THREADS = 8;
+    static constexpr size_t HOST_STACK_SIZE = 256 * 1024;
+    static constexpr uint64_t YIELD_QUANTUM_US = 100;
+    static constexpr uint32_t CYCLES_PER_US = 600;  // Matches F_CPU_ACTUAL
+
+    using ThreadFn = void (*)(void* arg);
+
+    /**
+     * Current virtual time in microseconds since simulation start
+     */
+    uint64_t nowUs();
+
+    /**
+     * Emulated DWT cycle counter (wraps like the hardware register)
+     */
+    uint32_t cycleCount();
+
+    /**
+     * Move the clock forward (never backwards)
+     */
+    void advanceTo(uint64_t us);
+
+    /**
+     * Create a cooperative thread (runs on the next runReadyThreads())
+     *
+     * @return Thread ID (>= 0), or -1 if the table is full
+     */
+    int createThread(const char* name, ThreadFn fn, void* arg);
+
+    /**
+     * Run every thread whose wake time has been reached until it parks again
+     */
+    void runReadyThreads();
+
+    /**
+     * Earliest wake time of any live thread (UINT64_MAX if none)
+     */
+    uint64_t nextWakeUs();
+
+    /**
+     * Park the calling thread for durationUs. Called outside any thread
+     * (e.g. during setup()), the clock is advanced directly instead.
+     */
+    void sleepFor(uint64_t durationUs);
+
+    /**
+     * Park the calling thread for one yield quantum
+     */
+    void yieldThread();
+
+    /**
+     * ID of the running thread (-1 when called from the simulator itself)
+     */
+    int currentThread();
+
+    /**
+     * Abort the run if the clock passes this time outside any thread
+     * (catches firmware halting in a setup() error loop)
+     */
+    void setWatchdogUs(uint64_t us);
+}
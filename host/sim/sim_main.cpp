@@ -0,0 +1,712 @@
+/**
+ * sim_main.cpp - Deterministic whole-device simulator (host build)
+ *
+ * PURPOSE:
+ * Runs the complete firmware - setup(), loop(), the MIDI/input/display/app
+ * threads, AppLogic, the controllers, EffectManager, TimeKeeper and the
+ * audio chain from src/main.cpp - on Linux against modelled hardware,
+ * driven by a scenario file. Used to regression-test whole performances
+ * and to measure control-path latency without a Teensy on the desk.
+ *
+ * DESIGN:
+ * - Virtual time (SimKernel): the loop jumps to the next due item - a
+ *   scenario event, a MIDI clock byte, an audio block or a thread wake-up.
+ *   Items due at the same microsecond run as: hardware events, audio ISR,
+ *   then threads (in creation order)
+ * - Audio ISR: one AudioStream::simUpdateAll() every AUDIO_BLOCK_SAMPLES at
+ *   TimeKeeper::SAMPLE_RATE, input from SimAudioInput, output hashed by
+ *   SimAudioOutput
+ * - Hardware: NeoKey keys and MCP23017 pins change in the stand-in drivers,
+ *   then the Teensy pin wired to the device's INT line fires its ISR;
+ *   MIDI bytes go into Serial8's RX buffer for the DIN parser; clock ticks
+ *   come from MidiClockGenerator (jitter, ramps, dropouts, drift)
+ * - Observation: after every step the effect state codes, the display
+ *   bitmap and the NeoKey LEDs are compared with the previous step; every
+ *   change is logged with its time and sample position
+ * - Control-path latency: each key/encoder input is answered by the first
+ *   observable change after it (LED, display or effect state)
+ * - Grid error: after every audio block GridMeter compares the firmware's
+ *   next quantized boundary with the sender's ideal beat grid
+ *
+ * USAGE:
+ *   microloop_sim <scenario> [--serial] [--quiet] [--wav <file>]
+ *                 [--golden <file> [--update-golden]]
+ *                 [--grid-csv <file>] [--max-grid-error <samples>] [--remote]
+ *     --serial         Echo firmware Serial output
+ *     --remote         USB console on stdin/stdout for a host tool
+ *                      (host/tools/microloop_remote): stdin bytes go to
+ *                      Serial RX, Serial TX goes raw to stdout, everything
+ *                      else the simulator prints moves to stderr. Virtual
+ *                      time is paced to the wall clock and the run lasts
+ *                      until stdin closes (the scenario's 'end' is ignored)
+ *     --quiet          Summary only (no change log)
+ *     --wav            Write the audio output as 16-bit stereo WAV
+ *     --golden         Compare the run with a reference transcript (golden.h)
+ *     --update-golden  Rewrite the reference instead of comparing
+ *     --grid-csv       Write the per-beat grid error (grid_meter.h)
+ *     --max-grid-error Fail if the 1/4 grid error exceeds this after the
+ *                      first GRID_SETTLE_BEATS beats
+ *
+ * EXIT CODES: 0 = ran to the end (--remote: to stdin EOF), 1 = bad arguments/scenario,
+ *             2 = firmware stalled outside a thread (e.g. setup() error loop),
+ *             3 = golden reference mismatch, 4 = grid error over the limit
+ */
+
+#include <Arduino.h>
+#include <Audio.h>
+#include <Adafruit_NeoKey_1x4.h>
+#include <Adafruit_MCP23X17.h>
+#include <chrono>
+#include <errno.h>
+#include <poll.h>
+#include <queue>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "sim_kernel.h"
+#include "sim_audio.h"
+#include "golden.h"
+#include "grid_meter.h"
+#include "clock_gen.h"
+#include "scenario.h"
+#include "effect_manager.h"
+#include "display_io.h"
+#include "timekeeper.h"
+
+// Firmware entry points (src/main.cpp)
+void setup();
+void loop();
+
+namespace {
+
+// ========== BOARD WIRING (must match the firmware drivers) ==========
+constexpr uint8_t NEOKEY_INT_PIN = 33;  // input_io.cpp
+constexpr uint8_t MCP_INT_PIN = 36;     // encoder_io.cpp
+
+struct EncoderWiring {
+    uint8_t pinA;
+    uint8_t pinB;
+    uint8_t pinSW;
+};
+
+// MCP23017 pin numbers per encoder (encoder_io.cpp encoderPins[])
+constexpr EncoderWiring ENCODER_WIRING[4] = {
+    {4, 3, 2},
+    {8, 9, 10},
+    {11, 12, 13},
+    {7, 6, 5}
+};
+
+constexpr uint64_t ENCODER_STEP_US = 2000;  // Gap between quadrature edges (brisk turn)
+constexpr uint8_t STEPS_PER_DETENT = 4;
+constexpr uint64_t CLICK_HOLD_US = 50000;
+constexpr uint64_t SETUP_WATCHDOG_US = 10000000;
+constexpr uint32_t GRID_SETTLE_BEATS = 2;  // Tempo estimate converging after START
+
+constexpr EffectID OBSERVED_EFFECTS[] = { EffectID::STUTTER, EffectID::FREEZE, EffectID::CHOKE };
+constexpr size_t NUM_OBSERVED = sizeof(OBSERVED_EFFECTS) / sizeof(OBSERVED_EFFECTS[0]);
+constexpr uint8_t NUM_KEYS = 4;
+constexpr uint8_t MAX_SCHEDULED = 4;
+
+// ========== PENDING HARDWARE EVENTS ==========
+enum class PendingKind : uint8_t {
+    SCENARIO,        // index = scenario event
+    ENCODER_STEP,    // index = encoder, direction = +1/-1
+    ENCODER_BUTTON   // index = encoder, level = pin level
+};
+
+struct PendingEvent {
+    uint64_t atUs;
+    uint64_t seq;  // FIFO among events at the same time
+    PendingKind kind;
+    size_t index;
+    int8_t direction;
+    uint8_t level;
+
+    bool operator>(const PendingEvent& other) const {
+        return atUs != other.atUs ? atUs > other.atUs : seq > other.seq;
+    }
+};
+
+// ========== LATENCY TRACKING ==========
+struct InputRecord {
+    uint64_t atUs;
+    std::string label;
+    bool answered;
+    uint64_t latencyUs;
+    std::string response;
+};
+
+// ========== SIMULATOR STATE ==========
+struct SimState {
+    Scenario scenario;
+    SimAudioInput input;
+    SimAudioOutput output;
+    bool quiet = false;
+
+    std::priority_queue<PendingEvent, std::vector<PendingEvent>, std::greater<PendingEvent>> pending;
+    uint64_t nextSeq = 0;
+
+    uint64_t audioStartUs = 0;
+    uint64_t blocks = 0;
+    double isrNsTotal = 0.0;  // Host wall time in simUpdateAll() (cost per rate)
+    double isrNsMax = 0.0;
+
+    MidiClockGenerator clock;
+    GridMeter grid;
+
+    uint8_t keys = 0;
+    uint16_t mcpPins = 0xFFFF;
+
+    uint8_t lastState[NUM_OBSERVED] = {};
+    ScheduledEvent lastScheduled[NUM_OBSERVED][MAX_SCHEDULED] = {};
+    uint8_t lastScheduledCount[NUM_OBSERVED] = {};
+    BitmapID lastBitmap = BitmapID::DEFAULT;
+    uint32_t lastLed[NUM_KEYS] = {};
+    uint32_t changes = 0;
+
+    std::vector<InputRecord> inputs;
+    size_t nextUnanswered = 0;
+
+    Golden golden;
+};
+
+SimState s_sim;
+
+// ========== SCHEDULING HELPERS ==========
+
+void schedule(uint64_t atUs, PendingKind kind, size_t index, int8_t direction = 0, uint8_t level = 0) {
+    s_sim.pending.push(PendingEvent{ atUs, s_sim.nextSeq++, kind, index, direction, level });
+}
+
+uint64_t nextBlockUs() {
+    return s_sim.audioStartUs +
+           (s_sim.blocks * AUDIO_BLOCK_SAMPLES * 1000000ULL) / TimeKeeper::SAMPLE_RATE;
+}
+
+void recordInput(const std::string& label) {
+    s_sim.inputs.push_back(InputRecord{ SimKernel::nowUs(), label, false, 0, "" });
+}
+
+// ========== DEVICE MODELS ==========
+
+void setKeys(uint8_t keys) {
+    s_sim.keys = keys;
+    Adafruit_NeoKey_1x4::simSetKeys(keys);
+    simTriggerInterrupt(NEOKEY_INT_PIN);
+}
+
+void setMcpPins(uint16_t pins) {
+    s_sim.mcpPins = pins;
+    Adafruit_MCP23X17::simSetPins(pins);
+    simTriggerInterrupt(MCP_INT_PIN);
+}
+
+void stepEncoder(size_t encoder, int8_t direction) {
+    const EncoderWiring& w = ENCODER_WIRING[encoder];
+    uint8_t a = (s_sim.mcpPins >> w.pinA) & 1;
+    uint8_t b = (s_sim.mcpPins >> w.pinB) & 1;
+    uint8_t state = static_cast<uint8_t>((b << 1) | a);
+
+    // Gray-code order for +1 (matches the firmware's QUADRATURE_TABLE): 00 -> 01 -> 11 -> 10 -> 00
+    static const uint8_t NEXT_CW[4] = { 1, 3, 0, 2 };
+    static const uint8_t NEXT_CCW[4] = { 2, 0, 3, 1 };
+    uint8_t next = (direction > 0) ? NEXT_CW[state] : NEXT_CCW[state];
+
+    uint16_t pins = s_sim.mcpPins;
+    pins = static_cast<uint16_t>((pins & ~(1u << w.pinA)) | ((next & 1u) << w.pinA));
+    pins = static_cast<uint16_t>((pins & ~(1u << w.pinB)) | (((next >> 1) & 1u) << w.pinB));
+    setMcpPins(pins);
+}
+
+void setEncoderButton(size_t encoder, uint8_t level) {
+    const uint8_t pin = ENCODER_WIRING[encoder].pinSW;
+    setMcpPins(static_cast<uint16_t>((s_sim.mcpPins & ~(1u << pin)) | (static_cast<uint16_t>(level) << pin)));
+}
+
+// ========== SCENARIO DISPATCH ==========
+
+// Returns false on 'end'
+bool applyScenarioEvent(const ScenarioEvent& event) {
+    const uint64_t now = SimKernel::nowUs();
+
+    switch (event.action) {
+        case ScenarioAction::AUDIO_INPUT:
+            s_sim.input.setSignal(event);
+            break;
+
+        case ScenarioAction::MIDI_CLOCK:
+            s_sim.clock.start(event.value, now);
+            break;
+
+        case ScenarioAction::CLOCK_RAMP:
+            s_sim.clock.rampTo(event.value, event.durationUs, now);
+            break;
+
+        case ScenarioAction::CLOCK_JITTER:
+            s_sim.clock.setJitter(event.jitter, event.value, event.seed);
+            break;
+
+        case ScenarioAction::CLOCK_DROPOUT:
+            s_sim.clock.setDropout(event.value, event.seed);
+            break;
+
+        case ScenarioAction::CLOCK_DRIFT:
+            s_sim.clock.setDrift(event.value);
+            break;
+
+        case ScenarioAction::MIDI_BYTES:
+            for (char c : event.text) {
+                const uint8_t b = static_cast<uint8_t>(c);
+                Serial8.simInject(b);
+                if (b == 0xFA) {
+                    s_sim.grid.onStart(now, s_sim.clock);  // START: the grid restarts at beat 0
+                } else if (b == 0xFC) {
+                    s_sim.grid.onStop();
+                }
+            }
+            break;
+
+        case ScenarioAction::KEY_PRESS:
+            recordInput("press " + std::to_string(event.arg));
+            setKeys(static_cast<uint8_t>(s_sim.keys | (1u << event.arg)));
+            break;
+
+        case ScenarioAction::KEY_RELEASE:
+            recordInput("release " + std::to_string(event.arg));
+            setKeys(static_cast<uint8_t>(s_sim.keys & ~(1u << event.arg)));
+            break;
+
+        case ScenarioAction::ENCODER_TURN: {
+            recordInput("turn " + std::to_string(event.arg) + " " + std::to_string(event.amount));
+            const size_t encoder = static_cast<size_t>(event.arg - 1);
+            const int8_t direction = (event.amount > 0) ? 1 : -1;
+            const uint32_t steps = static_cast<uint32_t>(event.amount > 0 ? event.amount : -event.amount) * STEPS_PER_DETENT;
+            for (uint32_t i = 0; i < steps; i++) {
+                schedule(now + i * ENCODER_STEP_US, PendingKind::ENCODER_STEP, encoder, direction);
+            }
+            break;
+        }
+
+        case ScenarioAction::ENCODER_CLICK: {
+            recordInput("click " + std::to_string(event.arg));
+            const size_t encoder = static_cast<size_t>(event.arg - 1);
+            setEncoderButton(encoder, LOW);
+            schedule(now + CLICK_HOLD_US, PendingKind::ENCODER_BUTTON, encoder, 0, HIGH);
+            break;
+        }
+
+        case ScenarioAction::CONSOLE:
+            for (char c : event.text) {
+                Serial.simInject(static_cast<uint8_t>(c));
+            }
+            break;
+
+        case ScenarioAction::END:
+            return false;
+    }
+    return true;
+}
+
+// Returns false on 'end'
+bool firePendingEvents() {
+    const uint64_t now = SimKernel::nowUs();
+    while (!s_sim.pending.empty() && s_sim.pending.top().atUs <= now) {
+        PendingEvent event = s_sim.pending.top();
+        s_sim.pending.pop();
+
+        switch (event.kind) {
+            case PendingKind::SCENARIO:
+                if (!applyScenarioEvent(s_sim.scenario.events()[event.index])) {
+                    return false;
+                }
+                break;
+            case PendingKind::ENCODER_STEP:
+                stepEncoder(event.index, event.direction);
+                break;
+            case PendingKind::ENCODER_BUTTON:
+                setEncoderButton(event.index, event.level);
+                break;
+        }
+    }
+    return true;
+}
+
+void fireMidiClock() {
+    while (SimKernel::nowUs() >= s_sim.clock.nextEmitUs()) {
+        if (s_sim.clock.advance()) {
+            Serial8.simInject(0xF8);
+        }
+    }
+}
+
+// Returns true if a block ran
+bool fireAudioBlock() {
+    if (SimKernel::nowUs() < nextBlockUs()) {
+        return false;
+    }
+    const auto t0 = std::chrono::steady_clock::now();
+    AudioStream::simUpdateAll();
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    s_sim.isrNsTotal += ns;
+    if (ns > s_sim.isrNsMax) s_sim.isrNsMax = ns;
+    s_sim.blocks++;
+    return true;
+}
+
+// ========== OBSERVATION ==========
+
+void logChange(const char* subject, const std::string& detail) {
+    const uint64_t now = SimKernel::nowUs();
+    s_sim.changes++;
+
+    // The change answers the latest pending input; earlier pending inputs
+    // (e.g. FUNC pressed on its own) had no visible effect of their own
+    std::string suffix;
+    for (size_t i = s_sim.nextUnanswered; i < s_sim.inputs.size(); i++) {
+        InputRecord& input = s_sim.inputs[i];
+        if (input.atUs > now) {
+            break;
+        }
+        if (i + 1 < s_sim.inputs.size() && s_sim.inputs[i + 1].atUs <= now) {
+            continue;
+        }
+        input.answered = true;
+        input.latencyUs = now - input.atUs;
+        input.response = std::string(subject) + " " + detail;
+        char buf[64];
+        snprintf(buf, sizeof(buf), "  (+%.3f ms after %s)", input.latencyUs / 1000.0, input.label.c_str());
+        suffix = buf;
+        s_sim.nextUnanswered = i + 1;
+    }
+
+    if (!s_sim.quiet) {
+        printf("%12.3f ms  sample %9llu  %-8s %s%s\n", now / 1000.0,
+               static_cast<unsigned long long>(TimeKeeper::getSamplePosition()), subject, detail.c_str(), suffix.c_str());
+    }
+}
+
+bool isScheduled(const ScheduledEvent* list, uint8_t count, const ScheduledEvent& event) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (list[i].atSample == event.atSample && strcmp(list[i].label, event.label) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void logEffectChange(AudioEffectBase* effect, const std::string& detail) {
+    logChange(effect->getName(), detail);
+    s_sim.golden.add(std::to_string(TimeKeeper::getSamplePosition()) + " " + effect->getName() + " " + detail);
+}
+
+void observe(bool initial) {
+    for (size_t i = 0; i < NUM_OBSERVED; i++) {
+        AudioEffectBase* effect = EffectManager::getEffect(OBSERVED_EFFECTS[i]);
+        if (effect == nullptr) {
+            continue;
+        }
+
+        uint8_t state = effect->getStateCode();
+        if (!initial && state != s_sim.lastState[i]) {
+            logEffectChange(effect, "state " + std::to_string(s_sim.lastState[i]) + " -> " + std::to_string(state));
+        }
+        s_sim.lastState[i] = state;
+
+        // New scheduled actions (fired/cancelled ones show up as state changes)
+        ScheduledEvent scheduled[MAX_SCHEDULED];
+        uint8_t count = effect->getScheduledEvents(scheduled, MAX_SCHEDULED);
+        for (uint8_t j = 0; j < count; j++) {
+            if (!initial && !isScheduled(s_sim.lastScheduled[i], s_sim.lastScheduledCount[i], scheduled[j])) {
+                logEffectChange(effect, std::string("schedule ") + scheduled[j].label + " @" +
+                                std::to_string(scheduled[j].atSample));
+            }
+            s_sim.lastScheduled[i][j] = scheduled[j];
+        }
+        s_sim.lastScheduledCount[i] = count;
+    }
+
+    BitmapID bitmap = DisplayIO::getCurrentBitmap();
+    if (!initial && bitmap != s_sim.lastBitmap) {
+        logChange("display", "bitmap " + std::to_string(static_cast<int>(s_sim.lastBitmap)) + " -> " +
+                  std::to_string(static_cast<int>(bitmap)));
+    }
+    s_sim.lastBitmap = bitmap;
+
+    for (uint8_t key = 0; key < NUM_KEYS; key++) {
+        uint32_t color = Adafruit_NeoKey_1x4::pixels.simShownColor(key);
+        if (!initial && color != s_sim.lastLed[key]) {
+            char buf[48];
+            snprintf(buf, sizeof(buf), "key %u %06X -> %06X", key, s_sim.lastLed[key], color);
+            logChange("led", buf);
+        }
+        s_sim.lastLed[key] = color;
+    }
+}
+
+// ========== REPORT ==========
+
+void printSummary() {
+    const uint64_t now = SimKernel::nowUs();
+    printf("\n=== SIMULATION SUMMARY ===\n");
+    printf("Simulated: %.3f ms (%llu blocks, %llu samples)\n", now / 1000.0,
+           static_cast<unsigned long long>(s_sim.blocks), static_cast<unsigned long long>(s_sim.output.samples()));
+    printf("Output hash: 0x%08X\n", s_sim.output.hash());
+    printf("Output peak: L %d, R %d\n", s_sim.output.peakLeft(), s_sim.output.peakRight());
+    printf("Audio blocks: max used %u, allocation failures %u\n",
+           AudioMemoryUsageMax(), AudioStream::simAllocateFailures());
+    // Block period and I/O buffering (one block in the input DMA, one in the
+    // output DMA) shrink with the rate; the ISR cost per block stays
+    const double blockUs = AUDIO_BLOCK_SAMPLES * 1e6 / TimeKeeper::SAMPLE_RATE;
+    const double isrMeanUs = s_sim.blocks > 0 ? s_sim.isrNsTotal / s_sim.blocks / 1000.0 : 0.0;
+    printf("Audio rate: %u Hz, block %.3f ms, I/O buffering %.3f ms\n", TimeKeeper::SAMPLE_RATE, blockUs / 1000.0,
+           2.0 * blockUs / 1000.0);
+    printf("Audio ISR (host): mean %.2f us = %.3f%% of the block period, max %.2f us\n", isrMeanUs,
+           100.0 * isrMeanUs / blockUs, s_sim.isrNsMax / 1000.0);
+    printf("MIDI clock: %llu ticks sent, %llu dropped\n", static_cast<unsigned long long>(s_sim.clock.ticksSent()),
+           static_cast<unsigned long long>(s_sim.clock.ticksDropped()));
+    printf("TimeKeeper: bar %u beat %u tick %u, %.2f BPM\n", TimeKeeper::getBarNumber(), TimeKeeper::getBeatInBar(),
+           TimeKeeper::getTickInBeat(), TimeKeeper::getBPM());
+    printf("Observed changes: %u\n", s_sim.changes);
+    s_sim.grid.printSummary();
+
+    printf("Control-path latency:\n");
+    uint64_t minUs = UINT64_MAX;
+    uint64_t maxUs = 0;
+    uint64_t sumUs = 0;
+    uint32_t answered = 0;
+    for (const InputRecord& input : s_sim.inputs) {
+        if (input.answered) {
+            printf("  %12.3f ms  %-12s %8.3f ms  -> %s\n", input.atUs / 1000.0, input.label.c_str(),
+                   input.latencyUs / 1000.0, input.response.c_str());
+            minUs = input.latencyUs < minUs ? input.latencyUs : minUs;
+            maxUs = input.latencyUs > maxUs ? input.latencyUs : maxUs;
+            sumUs += input.latencyUs;
+            answered++;
+        } else {
+            printf("  %12.3f ms  %-12s no response\n", input.atUs / 1000.0, input.label.c_str());
+        }
+    }
+    if (answered > 0) {
+        printf("  min %.3f ms, avg %.3f ms, max %.3f ms (%u of %zu inputs answered)\n", minUs / 1000.0,
+               sumUs / 1000.0 / answered, maxUs / 1000.0, answered, s_sim.inputs.size());
+    }
+    printf("=== END SIMULATION SUMMARY ===\n");
+}
+
+// ========== REMOTE MODE (--remote) ==========
+
+int s_remoteOutFd = -1;  // The original stdout: protocol bytes only
+
+void remoteTx(const uint8_t* data, size_t size) {
+    while (size > 0) {
+        const ssize_t n = ::write(s_remoteOutFd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;  // Host went away: stdin EOF ends the run
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+// Sleeps until the wall clock reaches virtual time atUs or stdin has data
+// (injected into Serial RX). Returns false once stdin is closed
+bool remoteWait(uint64_t atUs, std::chrono::steady_clock::time_point wallStart) {
+    const auto wallUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - wallStart).count();
+    const int64_t waitUs = static_cast<int64_t>(atUs - s_sim.audioStartUs) - static_cast<int64_t>(wallUs);
+
+    struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+    struct timespec timeout = { 0, 0 };
+    if (waitUs > 0) {
+        timeout.tv_sec = waitUs / 1000000;
+        timeout.tv_nsec = (waitUs % 1000000) * 1000;
+    }
+    const int ready = ppoll(&pfd, 1, &timeout, nullptr);
+    if (ready <= 0) {
+        return true;  // Timed out (or a signal): virtual time may advance
+    }
+
+    uint8_t buf[512];
+    const ssize_t n = ::read(STDIN_FILENO, buf, sizeof(buf));
+    if (n == 0 || (n < 0 && errno != EINTR && errno != EAGAIN)) {
+        return false;
+    }
+    for (ssize_t i = 0; i < n; i++) {
+        Serial.simInject(buf[i]);
+    }
+    return true;
+}
+
+void loopThreadEntry(void*) {
+    for (;;) {
+        loop();
+    }
+}
+
+void printUsage(const char* argv0) {
+    fprintf(stderr, "Usage: %s <scenario> [--serial] [--quiet] [--wav <file>] [--golden <file> [--update-golden]]\n"
+                    "       [--grid-csv <file>] [--max-grid-error <samples>] [--remote]\n", argv0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const char* scenarioPath = nullptr;
+    const char* wavPath = nullptr;
+    const char* goldenPath = nullptr;
+    const char* gridCsvPath = nullptr;
+    double maxGridError = -1.0;
+    bool updateGolden = false;
+    bool echoSerial = false;
+    bool remote = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--serial") {
+            echoSerial = true;
+        } else if (arg == "--remote") {
+            remote = true;
+        } else if (arg == "--quiet") {
+            s_sim.quiet = true;
+        } else if (arg == "--wav" && i + 1 < argc) {
+            wavPath = argv[++i];
+        } else if (arg == "--golden" && i + 1 < argc) {
+            goldenPath = argv[++i];
+        } else if (arg == "--update-golden") {
+            updateGolden = true;
+        } else if (arg == "--grid-csv" && i + 1 < argc) {
+            gridCsvPath = argv[++i];
+        } else if (arg == "--max-grid-error" && i + 1 < argc) {
+            maxGridError = atof(argv[++i]);
+        } else if (scenarioPath == nullptr && arg[0] != '-') {
+            scenarioPath = argv[i];
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (scenarioPath == nullptr || (updateGolden && goldenPath == nullptr)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!s_sim.scenario.load(scenarioPath)) {
+        return 1;
+    }
+    if (wavPath != nullptr && !s_sim.output.openWav(wavPath)) {
+        return 1;
+    }
+
+    if (remote) {
+        // Keep the real stdout for protocol bytes; the rest goes to stderr
+        fflush(stdout);
+        s_remoteOutFd = dup(STDOUT_FILENO);
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+        signal(SIGPIPE, SIG_IGN);
+        Serial.simSetTxSink(remoteTx);
+    }
+    Serial.simSetEcho(echoSerial);
+    AudioInputI2S::simSetSource([](int16_t* l, int16_t* r, size_t n) { s_sim.input.generate(l, r, n); });
+    AudioOutputI2S::simSetSink([](const int16_t* l, const int16_t* r, size_t n) { s_sim.output.record(l, r, n); });
+
+    const std::vector<ScenarioEvent>& events = s_sim.scenario.events();
+    for (size_t i = 0; i < events.size(); i++) {
+        schedule(events[i].atUs, PendingKind::SCENARIO, i);
+    }
+    const uint64_t endUs = s_sim.scenario.endUs();
+
+    const auto wallStart = std::chrono::steady_clock::now();
+
+    // ========== BOOT ==========
+    SimKernel::setWatchdogUs(SETUP_WATCHDOG_US);
+    setup();
+    SimKernel::setWatchdogUs(UINT64_MAX);
+    SimKernel::createThread("loop", loopThreadEntry, nullptr);
+
+    // Scenario times are relative to the end of setup()
+    s_sim.audioStartUs = SimKernel::nowUs();
+    if (s_sim.audioStartUs > 0) {
+        std::vector<PendingEvent> shifted;
+        while (!s_sim.pending.empty()) {
+            PendingEvent e = s_sim.pending.top();
+            s_sim.pending.pop();
+            e.atUs += s_sim.audioStartUs;
+            shifted.push_back(e);
+        }
+        for (const PendingEvent& e : shifted) {
+            s_sim.pending.push(e);
+        }
+    }
+    const uint64_t stopUs = remote ? UINT64_MAX : s_sim.audioStartUs + endUs;
+    const auto remoteWallStart = std::chrono::steady_clock::now();
+
+    observe(true);
+
+    // ========== RUN ==========
+    bool running = true;
+    while (running) {
+        uint64_t next = nextBlockUs();
+        if (!s_sim.pending.empty() && s_sim.pending.top().atUs < next) next = s_sim.pending.top().atUs;
+        if (s_sim.clock.nextEmitUs() < next) next = s_sim.clock.nextEmitUs();
+        uint64_t wake = SimKernel::nextWakeUs();
+        if (wake < next) next = wake;
+
+        if (next > stopUs) {
+            SimKernel::advanceTo(stopUs);
+            break;
+        }
+        if (remote && !remoteWait(next, remoteWallStart)) {
+            break;
+        }
+        SimKernel::advanceTo(next);
+
+        running = firePendingEvents() || remote;
+        fireMidiClock();
+        const bool block = fireAudioBlock();
+        SimKernel::runReadyThreads();
+        observe(false);
+        if (block) {
+            s_sim.grid.sample(SimKernel::nowUs(), s_sim.clock);
+        }
+    }
+
+    s_sim.output.close();
+    printSummary();
+
+    int status = 0;
+    if (goldenPath != nullptr) {
+        char hash[16];
+        snprintf(hash, sizeof(hash), "0x%08X", s_sim.output.hash());
+        s_sim.golden.add("samples " + std::to_string(s_sim.output.samples()));
+        s_sim.golden.add(std::string("hash ") + hash);
+
+        if (updateGolden) {
+            status = s_sim.golden.write(goldenPath, scenarioPath) ? 0 : 1;
+        } else {
+            status = s_sim.golden.compare(goldenPath) ? 0 : 3;
+        }
+    }
+
+    if (gridCsvPath != nullptr && !s_sim.grid.writeCsv(gridCsvPath)) {
+        status = 1;
+    }
+    if (maxGridError >= 0.0 && status == 0) {
+        const double worst = s_sim.grid.maxBeatError(GRID_SETTLE_BEATS);
+        if (!s_sim.grid.measured() || worst > maxGridError) {
+            printf("GRID ERROR OVER LIMIT: %.1f samples (limit %.1f)\n", worst, maxGridError);
+            status = 4;
+        }
+    }
+
+    fflush(stdout);
+    const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    const double simSeconds = SimKernel::nowUs() / 1e6;
+    fprintf(stderr, "Simulated %.3f s in %.3f s (%.1fx real time)\n", simSeconds, wallSeconds,
+            wallSeconds > 0 ? simSeconds / wallSeconds : 0.0);
+    return status;
+}
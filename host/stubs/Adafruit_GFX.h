@@ -0,0 +1,23 @@
+/**
+ * Adafruit_GFX.h - Host stand-in for Adafruit GFX (simulator build only)
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define BLACK 0
+#define WHITE 1
+
+class Adafruit_GFX {
+public:
+    Adafruit_GFX(int16_t w, int16_t h) : m_width(w), m_height(h) {}
+    virtual ~Adafruit_GFX() = default;
+
+    int16_t width() const { return m_width; }
+    int16_t height() const { return m_height; }
+
+protected:
+    int16_t m_width;
+    int16_t m_height;
+};
@@ -0,0 +1,73 @@
+/**
+ * Adafruit_MCP23X17.h - Host stand-in for the MCP23017 GPIO expander (simulator build only)
+ *
+ * Models the part of the chip the encoder driver depends on: 16 pulled-up
+ * inputs, INTCAP latching on change and the register file reachable over
+ * raw Wire transactions (encoder_io.cpp reads INTCAPA/B directly in its ISR).
+ * The simulator changes pin levels with simSetPins() and then fires the
+ * Teensy pin wired to INTA.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+
+class Adafruit_MCP23X17 {
+public:
+    static constexpr uint8_t REG_INTCAPA = 0x10;
+    static constexpr uint8_t REG_GPIOA = 0x12;
+
+    bool begin_I2C(uint8_t address = 0x20, TwoWire* wire = &Wire) {
+        wire->simAttach(address, &s_target);
+        return true;
+    }
+
+    void pinMode(uint8_t, uint8_t) {}
+    uint8_t digitalRead(uint8_t pin) { return (s_pins >> (pin & 15)) & 1; }
+    void setupInterrupts(bool, bool, uint8_t) {}
+    void setupInterruptPin(uint8_t, uint8_t = CHANGE) {}
+    uint8_t getLastInterruptPin() { return 255; }
+    uint16_t getCapturedInterrupt() { return s_intcap; }
+
+    // ========== HOST SIMULATION HOOKS ==========
+    static void simSetPins(uint16_t pins) {
+        s_pins = pins;
+        s_intcap = pins;  // INTCAP freezes the port state at the change
+    }
+    static uint16_t simGetPins() { return s_pins; }
+
+private:
+    class RegisterFile : public I2CTarget {
+    public:
+        RegisterFile() : m_pointer(0) {}
+
+        void i2cWrite(const uint8_t* data, size_t length) override {
+            if (length > 0) m_pointer = data[0];  // Register pointer (writes ignored)
+        }
+
+        size_t i2cRead(uint8_t* data, size_t length) override {
+            for (size_t i = 0; i < length; i++) {
+                data[i] = readRegister(static_cast<uint8_t>(m_pointer + i));
+            }
+            return length;
+        }
+
+    private:
+        static uint8_t readRegister(uint8_t reg) {
+            switch (reg) {
+                case REG_INTCAPA:     return static_cast<uint8_t>(s_intcap);
+                case REG_INTCAPA + 1: return static_cast<uint8_t>(s_intcap >> 8);
+                case REG_GPIOA:       return static_cast<uint8_t>(s_pins);
+                case REG_GPIOA + 1:   return static_cast<uint8_t>(s_pins >> 8);
+                default:              return 0;
+            }
+        }
+
+        uint8_t m_pointer;
+    };
+
+    static inline uint16_t s_pins = 0xFFFF;    // All inputs pulled up
+    static inline uint16_t s_intcap = 0xFFFF;
+    static inline RegisterFile s_target;
+};
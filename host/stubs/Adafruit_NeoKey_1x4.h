@@ -0,0 +1,42 @@
+/**
+ * Adafruit_NeoKey_1x4.h - Host stand-in for the NeoKey 1x4 (simulator build only)
+ *
+ * One board per process (the firmware has one): key state and pixels are
+ * static so the simulator can press keys and read LEDs without access to
+ * the driver instance inside input_io.cpp. After simSetKeys() the simulator
+ * fires the Teensy pin wired to the board's INT line.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "seesaw_neopixel.h"
+
+class Adafruit_NeoKey_1x4 {
+public:
+    Adafruit_NeoKey_1x4(uint8_t address = 0x30, TwoWire* wire = &Wire) {
+        (void)address;
+        (void)wire;
+    }
+
+    bool begin(uint8_t address = 0x30) {
+        (void)address;
+        return true;
+    }
+
+    void pinMode(uint8_t, uint8_t) {}
+    void enableKeypadInterrupt() {}
+
+    // Bit N set = key N pressed
+    uint8_t read() { return s_keys; }
+
+    static inline seesaw_NeoPixel pixels;
+
+    // ========== HOST SIMULATION HOOKS ==========
+    static void simSetKeys(uint8_t mask) { s_keys = mask & 0x0F; }
+    static uint8_t simGetKeys() { return s_keys; }
+
+private:
+    static inline uint8_t s_keys = 0;
+};
@@ -0,0 +1,47 @@
+/**
+ * Adafruit_SSD1306.h - Host stand-in for the SSD1306 OLED driver (simulator build only)
+ *
+ * Frames are not rasterised: the driver remembers which bitmap was drawn
+ * and counts display() pushes, which is what a regression run compares.
+ * The simulator observes the screen through DisplayIO::getCurrentBitmap().
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "Adafruit_GFX.h"
+
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_EXTERNALVCC 0x01
+
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+    Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* wire = &Wire, int8_t resetPin = -1)
+        : Adafruit_GFX(w, h) {
+        (void)wire;
+        (void)resetPin;
+    }
+
+    bool begin(uint8_t vcs = SSD1306_SWITCHCAPVCC, uint8_t address = 0x3C) {
+        (void)vcs;
+        (void)address;
+        return true;
+    }
+
+    void clearDisplay() { m_bitmap = nullptr; }
+
+    void drawBitmap(int16_t, int16_t, const uint8_t* bitmap, int16_t, int16_t, uint16_t) {
+        m_bitmap = bitmap;
+    }
+
+    void display() { m_frames++; }
+
+    // ========== HOST SIMULATION HOOKS ==========
+    const uint8_t* simBitmap() const { return m_bitmap; }
+    uint32_t simFrames() const { return m_frames; }
+
+private:
+    const uint8_t* m_bitmap = nullptr;
+    uint32_t m_frames = 0;
+};
@@ -0,0 +1,185 @@
+/**
+ * Arduino.h - Host stand-in for the Teensy 4.1 core (simulator build only)
+ *
+ * PURPOSE:
+ * Lets the unmodified firmware sources compile and run on Linux. Every
+ * time source (micros, millis, delay, ARM_DWT_CYCCNT) reads the simulator's
+ * virtual clock, so a run is deterministic and faster than real time.
+ *
+ * DESIGN:
+ * - Time: SimKernel virtual microsecond clock (see sim_kernel.h)
+ * - delay(): sleeps the calling cooperative thread (TeensyThreads stand-in)
+ * - Pins: digital levels kept in a table, attachInterrupt() records the ISR
+ *   so the simulator can fire it when a modelled device pulls its INT line
+ * - Serial: console input injected by the scenario, output echoed to stdout
+ *   only when enabled (keeps reports clean)
+ * - Interrupt masking is a no-op: the audio "ISR" never preempts a thread
+ *   in the middle of a statement
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <deque>
+
+// ========== MEMORY PLACEMENT (no-ops on host) ==========
+#define EXTMEM
+#define DMAMEM
+#define FASTRUN
+#define FLASHMEM
+#define PROGMEM
+
+// ========== PIN CONSTANTS ==========
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define INPUT_PULLDOWN 3
+#define RISING 3
+#define FALLING 2
+#define CHANGE 4
+#define LED_BUILTIN 13
+#define NUM_DIGITAL_PINS 64
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+// ========== CPU / CYCLE COUNTER ==========
+#define F_CPU_ACTUAL 600000000UL
+
+namespace SimKernel {
+    uint64_t nowUs();
+    uint32_t cycleCount();
+}
+
+#define ARM_DWT_CYCCNT (SimKernel::cycleCount())
+
+// ========== TIME ==========
+inline uint32_t micros() { return static_cast<uint32_t>(SimKernel::nowUs()); }
+inline uint32_t millis() { return static_cast<uint32_t>(SimKernel::nowUs() / 1000); }
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// ========== INTERRUPTS ==========
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline void __disable_irq() {}
+inline void __enable_irq() {}
+
+// ========== GPIO ==========
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+uint8_t digitalRead(uint8_t pin);
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void detachInterrupt(uint8_t pin);
+
+// Host-only: fire the ISR attached to a pin (no-op if none attached)
+void simTriggerInterrupt(uint8_t pin);
+
+// ========== CACHE MAINTENANCE (no-ops on host) ==========
+inline void arm_dcache_flush(void*, uint32_t) {}
+inline void arm_dcache_delete(void*, uint32_t) {}
+inline void arm_dcache_flush_delete(void*, uint32_t) {}
+
+// ========== PRINT ==========
+class Print;
+
+class Printable {
+public:
+    virtual ~Printable() = default;
+    virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return write(reinterpret_cast<const uint8_t*>(str), strlen(str)); }
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+    size_t print(unsigned char v, int base = DEC) { return printUnsigned(v, base); }
+    size_t print(int v, int base = DEC) { return printSigned(v, base); }
+    size_t print(unsigned int v, int base = DEC) { return printUnsigned(v, base); }
+    size_t print(long v, int base = DEC) { return printSigned(v, base); }
+    size_t print(unsigned long v, int base = DEC) { return printUnsigned(v, base); }
+    size_t print(long long v, int base = DEC) { return printSigned(v, base); }
+    size_t print(unsigned long long v, int base = DEC) { return printUnsigned(v, base); }
+    size_t print(double v, int digits = 2);
+    size_t print(const Printable& p) { return p.printTo(*this); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(T v) { size_t n = print(v); return n + println(); }
+    template <typename T>
+    size_t println(T v, int format) { size_t n = print(v, format); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+    size_t printSigned(long long v, int base);
+    size_t printUnsigned(unsigned long long v, int base);
+};
+
+// ========== SERIAL PORTS ==========
+class HardwareSerial : public Print {
+public:
+    explicit HardwareSerial(const char* name) : m_name(name) {}
+
+    void begin(uint32_t) {}
+    void end() {}
+    explicit operator bool() const { return true; }
+
+    int available() { return static_cast<int>(m_rx.size()); }
+    int peek() { return m_rx.empty() ? -1 : m_rx.front(); }
+    int read() {
+        if (m_rx.empty()) return -1;
+        int c = m_rx.front();
+        m_rx.pop_front();
+        return c;
+    }
+    int availableForWrite() { return 4096; }
+    void flush() { if (m_echo) fflush(stdout); }
+
+    using Print::write;
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+
+    // ========== HOST SIMULATION HOOKS ==========
+    void simInject(uint8_t b) { m_rx.push_back(b); }
+    void simSetEcho(bool echo) { m_echo = echo; }
+    // Raw TX bytes (no '\r' stripping), e.g. to a pipe for a remote host tool
+    void simSetTxSink(void (*sink)(const uint8_t* data, size_t size)) { m_txSink = sink; }
+    size_t simBytesWritten() const { return m_bytesWritten; }
+
+private:
+    const char* m_name;
+    std::deque<uint8_t> m_rx;
+    bool m_echo = false;
+    void (*m_txSink)(const uint8_t* data, size_t size) = nullptr;
+    size_t m_bytesWritten = 0;
+};
+
+typedef HardwareSerial usb_serial_class;
+
+extern HardwareSerial Serial;   // USB console
+extern HardwareSerial Serial8;  // MIDI DIN (RX8)
+
+// ========== CRASH REPORT ==========
+class CrashReportClass : public Printable {
+public:
+    explicit operator bool() const { return false; }  // Host never "crashed" on a previous boot
+    size_t printTo(Print& p) const override { return p.print("No crash report (host)\n"); }
+};
+
+extern CrashReportClass CrashReport;
@@ -0,0 +1,77 @@
+/**
+ * Audio.h - Host stand-in for the Teensy Audio Library (simulator build only)
+ *
+ * Only the objects the firmware instantiates: I2S input/output (fed and
+ * drained by the simulator instead of DMA) and the SGTL5000 control object
+ * (accepts every setting, no codec behind it).
+ */
+
+#pragma once
+
+#include <functional>
+#include "AudioStream.h"
+
+#define AUDIO_INPUT_LINEIN 0
+#define AUDIO_INPUT_MIC 1
+
+/**
+ * Allocate the audio block pool (a macro with static storage on hardware)
+ */
+inline void AudioMemory(unsigned int num) {
+    AudioStream::initialize_memory(num);
+}
+
+inline unsigned int AudioMemoryUsage() { return AudioStream::memory_used; }
+inline unsigned int AudioMemoryUsageMax() { return AudioStream::memory_used_max; }
+
+class AudioInputI2S : public AudioStream {
+public:
+    using Source = std::function<void(int16_t* left, int16_t* right, size_t samples)>;
+
+    AudioInputI2S() : AudioStream(0, nullptr) {}
+
+    // ========== HOST SIMULATION HOOKS ==========
+    static void simSetSource(Source source) { s_source = source; }
+
+protected:
+    void update() override;
+
+private:
+    static inline Source s_source;
+};
+
+class AudioOutputI2S : public AudioStream {
+public:
+    using Sink = std::function<void(const int16_t* left, const int16_t* right, size_t samples)>;
+
+    AudioOutputI2S() : AudioStream(2, inputQueueArray) {}
+
+    // ========== HOST SIMULATION HOOKS ==========
+    static void simSetSink(Sink sink) { s_sink = sink; }
+
+protected:
+    void update() override;
+
+private:
+    audio_block_t* inputQueueArray[2];
+    static inline Sink s_sink;
+};
+
+class AudioControlSGTL5000 {
+public:
+    bool enable() { return true; }
+    bool disable() { return true; }
+    bool inputSelect(int) { return true; }
+    bool lineInLevel(uint8_t) { return true; }
+    bool lineInLevel(uint8_t, uint8_t) { return true; }
+    unsigned short lineOutLevel(uint8_t) { return 0; }
+    unsigned short lineOutLevel(uint8_t, uint8_t) { return 0; }
+    bool unmuteLineout() { return true; }
+    bool muteLineout() { return true; }
+    bool unmuteHeadphone() { return true; }
+    bool muteHeadphone() { return true; }
+    bool volume(float) { return true; }
+
+protected:
+    bool write(unsigned int, unsigned int) { return true; }
+};
@@ -0,0 +1,85 @@
+/**
+ * AudioStream.h - Host stand-in for the Teensy Audio Library core (simulator build only)
+ *
+ * Keeps the semantics the firmware relies on:
+ * - Objects update in construction order (simUpdateAll() == one audio ISR)
+ * - Fixed block pool sized by AudioMemory(); allocate() returns nullptr
+ *   when it runs dry, exactly like the hardware
+ * - transmit() fans a block out to every connected input with ref counting,
+ *   receiveWritable() copies only when the block is shared
+ * CPU usage counters stay at 0 (no cycle-accurate model on the host).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define AUDIO_BLOCK_SAMPLES 128
+#ifndef AUDIO_SAMPLE_RATE_EXACT
+#define AUDIO_SAMPLE_RATE_EXACT 44117.64706f
+#endif
+#define AUDIO_SAMPLE_RATE AUDIO_SAMPLE_RATE_EXACT
+
+typedef struct audio_block_struct {
+    uint8_t ref_count;
+    uint8_t reserved1;
+    uint16_t memory_pool_index;
+    int16_t data[AUDIO_BLOCK_SAMPLES];
+} audio_block_t;
+
+class AudioStream;
+
+class AudioConnection {
+public:
+    AudioConnection(AudioStream& source, AudioStream& destination);
+    AudioConnection(AudioStream& source, unsigned char sourceOutput,
+                    AudioStream& destination, unsigned char destinationInput);
+
+private:
+    friend class AudioStream;
+    AudioStream& src;
+    AudioStream& dst;
+    unsigned char src_index;
+    unsigned char dest_index;
+    AudioConnection* next_dest;
+};
+
+class AudioStream {
+public:
+    AudioStream(unsigned char ninput, audio_block_t** iqueue);
+    virtual ~AudioStream() = default;
+
+    bool isActive() const { return active; }
+
+    static void initialize_memory(unsigned int num);
+    static uint16_t memory_used;
+    static uint16_t memory_used_max;
+    static uint16_t cpu_cycles_total;
+    static uint16_t cpu_cycles_total_max;
+
+    // ========== HOST SIMULATION HOOKS ==========
+    static void simUpdateAll();                     // One audio interrupt
+    static uint32_t simAllocateFailures() { return s_allocateFailures; }
+
+protected:
+    bool active;
+    unsigned char num_inputs;
+
+    static audio_block_t* allocate();
+    static void release(audio_block_t* block);
+    void transmit(audio_block_t* block, unsigned char index = 0);
+    audio_block_t* receiveReadOnly(unsigned int index = 0);
+    audio_block_t* receiveWritable(unsigned int index = 0);
+
+    virtual void update() = 0;
+
+private:
+    friend class AudioConnection;
+
+    audio_block_t** inputQueue;
+    AudioConnection* destination_list;
+    AudioStream* next_update;
+
+    static AudioStream* first_update;
+    static uint32_t s_allocateFailures;
+};
@@ -0,0 +1,79 @@
+/**
+ * MIDI.h - Host stand-in for the Arduino MIDI Library (simulator build only)
+ *
+ * Parses System Real-Time messages (clock, start, continue, stop) from the
+ * serial port the instance is bound to; the simulator injects bytes into
+ * that port's RX buffer (Serial8 for the DIN input). Every other byte is
+ * consumed and ignored - the firmware registers no other handlers.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define MIDI_CHANNEL_OMNI 0
+#define MIDI_CHANNEL_OFF 17
+
+namespace midi {
+
+enum MidiType : uint8_t {
+    Clock = 0xF8,
+    Start = 0xFA,
+    Continue = 0xFB,
+    Stop = 0xFC,
+    ActiveSensing = 0xFE,
+    SystemReset = 0xFF
+};
+
+template <class SerialPort>
+class MidiInterface {
+public:
+    using Handler = void (*)();
+
+    explicit MidiInterface(SerialPort& port) : m_port(port) {}
+
+    void begin(int inputChannel = 1) {
+        (void)inputChannel;
+        m_port.begin(31250);
+    }
+
+    void setHandleClock(Handler fn) { m_onClock = fn; }
+    void setHandleStart(Handler fn) { m_onStart = fn; }
+    void setHandleContinue(Handler fn) { m_onContinue = fn; }
+    void setHandleStop(Handler fn) { m_onStop = fn; }
+
+    /**
+     * Parse bytes until one message is dispatched or the RX buffer is empty
+     *
+     * @return true if a message was parsed
+     */
+    bool read() {
+        while (m_port.available() > 0) {
+            uint8_t b = static_cast<uint8_t>(m_port.read());
+            switch (b) {
+                case Clock:    dispatch(m_onClock);    return true;
+                case Start:    dispatch(m_onStart);    return true;
+                case Continue: dispatch(m_onContinue); return true;
+                case Stop:     dispatch(m_onStop);     return true;
+                default:       break;
+            }
+        }
+        return false;
+    }
+
+private:
+    static void dispatch(Handler fn) {
+        if (fn != nullptr) fn();
+    }
+
+    SerialPort& m_port;
+    Handler m_onClock = nullptr;
+    Handler m_onStart = nullptr;
+    Handler m_onContinue = nullptr;
+    Handler m_onStop = nullptr;
+};
+
+}
+
+#define MIDI_CREATE_INSTANCE(Type, SerialPort, Name) \
+    midi::MidiInterface<Type> Name(SerialPort);
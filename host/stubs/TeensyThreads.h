@@ -0,0 +1,43 @@
+/**
+ * TeensyThreads.h - Host stand-in for TeensyThreads (simulator build only)
+ *
+ * Maps the subset the firmware uses onto SimKernel's cooperative threads.
+ * Caller-provided stacks are ignored (see sim_kernel.h), time slices are
+ * accepted and ignored: every firmware thread parks itself via delay()/yield().
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "sim_kernel.h"
+
+class Threads {
+public:
+    typedef void (*ThreadFunction)(void*);
+    typedef void (*ThreadFunctionNone)();
+
+    int addThread(ThreadFunction p, void* arg = 0, int stack_size = -1, void* stack = 0) {
+        (void)stack_size;
+        (void)stack;
+        return SimKernel::createThread("thread", p, arg);
+    }
+
+    int addThread(ThreadFunctionNone p, int arg = 0, int stack_size = -1, void* stack = 0) {
+        (void)arg;
+        (void)stack_size;
+        (void)stack;
+        return SimKernel::createThread("thread", callNone, reinterpret_cast<void*>(p));
+    }
+
+    void delay(int ms) { SimKernel::sleepFor(static_cast<uint64_t>(ms) * 1000); }
+    void delay_us(int us) { SimKernel::sleepFor(static_cast<uint64_t>(us)); }
+    void yield() { SimKernel::yieldThread(); }
+    int id() { return SimKernel::currentThread(); }
+    int setTimeSlice(int, unsigned) { return 1; }
+    int setMicroTimer(int) { return 1; }
+
+private:
+    static void callNone(void* fn) { reinterpret_cast<ThreadFunctionNone>(fn)(); }
+};
+
+extern Threads threads;
@@ -0,0 +1,75 @@
+/**
+ * Wire.h - Host stand-in for the Teensy I2C library (simulator build only)
+ *
+ * Each bus routes transactions to modelled devices (I2CTarget) attached at
+ * a 7-bit address. Writes are delivered on endTransmission(), reads are
+ * served by requestFrom(). An address with no device NAKs like real I2C.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class I2CTarget {
+public:
+    virtual ~I2CTarget() = default;
+    virtual void i2cWrite(const uint8_t* data, size_t length) = 0;
+    virtual size_t i2cRead(uint8_t* data, size_t length) = 0;
+};
+
+class TwoWire {
+public:
+    static constexpr size_t BUFFER_LENGTH = 32;
+
+    void begin() {}
+    void setClock(uint32_t) {}
+
+    void beginTransmission(uint8_t address) {
+        m_address = address;
+        m_txLength = 0;
+    }
+
+    size_t write(uint8_t b) {
+        if (m_txLength >= BUFFER_LENGTH) return 0;
+        m_tx[m_txLength++] = b;
+        return 1;
+    }
+
+    uint8_t endTransmission(bool sendStop = true) {
+        (void)sendStop;
+        I2CTarget* target = m_targets[m_address & 0x7F];
+        if (target == nullptr) return 2;  // Address NAK
+        target->i2cWrite(m_tx, m_txLength);
+        return 0;
+    }
+
+    uint8_t requestFrom(int address, int quantity, bool sendStop = true) {
+        (void)sendStop;
+        m_rxLength = 0;
+        m_rxIndex = 0;
+        I2CTarget* target = m_targets[address & 0x7F];
+        if (target == nullptr) return 0;
+        size_t n = quantity > static_cast<int>(BUFFER_LENGTH) ? BUFFER_LENGTH : static_cast<size_t>(quantity);
+        m_rxLength = target->i2cRead(m_rx, n);
+        return static_cast<uint8_t>(m_rxLength);
+    }
+
+    int available() { return static_cast<int>(m_rxLength - m_rxIndex); }
+    int read() { return (m_rxIndex < m_rxLength) ? m_rx[m_rxIndex++] : -1; }
+
+    // ========== HOST SIMULATION HOOKS ==========
+    void simAttach(uint8_t address, I2CTarget* target) { m_targets[address & 0x7F] = target; }
+
+private:
+    I2CTarget* m_targets[128] = {};
+    uint8_t m_address = 0;
+    uint8_t m_tx[BUFFER_LENGTH] = {};
+    size_t m_txLength = 0;
+    uint8_t m_rx[BUFFER_LENGTH] = {};
+    size_t m_rxLength = 0;
+    size_t m_rxIndex = 0;
+};
+
+extern TwoWire Wire;   // Audio shield + MCP23017
+extern TwoWire Wire1;  // SSD1306
+extern TwoWire Wire2;  // NeoKey
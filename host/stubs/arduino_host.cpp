@@ -0,0 +1,146 @@
+/**
+ * arduino_host.cpp - Host stand-in for the Teensy core (simulator build only)
+ */
+
+#include <Arduino.h>
+#include <TeensyThreads.h>
+#include <Wire.h>
+#include <stdarg.h>
+#include "sim_kernel.h"
+
+HardwareSerial Serial("Serial");
+HardwareSerial Serial8("Serial8");
+CrashReportClass CrashReport;
+Threads threads;
+
+TwoWire Wire;
+TwoWire Wire1;
+TwoWire Wire2;
+
+// ========== TIME ==========
+
+void delay(uint32_t ms) {
+    SimKernel::sleepFor(static_cast<uint64_t>(ms) * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+    // Busy-waits on hardware: time passes but nothing else gets to run
+    SimKernel::advanceTo(SimKernel::nowUs() + us);
+}
+
+void yield() {
+    SimKernel::yieldThread();
+}
+
+// ========== GPIO ==========
+
+static uint8_t s_pinLevel[NUM_DIGITAL_PINS] = {};
+static void (*s_pinIsr[NUM_DIGITAL_PINS])() = {};
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < NUM_DIGITAL_PINS && mode == INPUT_PULLUP) {
+        s_pinLevel[pin] = HIGH;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < NUM_DIGITAL_PINS) {
+        s_pinLevel[pin] = value ? HIGH : LOW;
+    }
+}
+
+uint8_t digitalRead(uint8_t pin) {
+    return (pin < NUM_DIGITAL_PINS) ? s_pinLevel[pin] : LOW;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int) {
+    if (pin < NUM_DIGITAL_PINS) {
+        s_pinIsr[pin] = isr;
+    }
+}
+
+void detachInterrupt(uint8_t pin) {
+    if (pin < NUM_DIGITAL_PINS) {
+        s_pinIsr[pin] = nullptr;
+    }
+}
+
+void simTriggerInterrupt(uint8_t pin) {
+    if (pin < NUM_DIGITAL_PINS && s_pinIsr[pin] != nullptr) {
+        s_pinIsr[pin]();
+    }
+}
+
+// ========== PRINT ==========
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::print(double v, int digits) {
+    char buf[64];
+    int len = snprintf(buf, sizeof(buf), "%.*f", digits, v);
+    return write(reinterpret_cast<const uint8_t*>(buf), static_cast<size_t>(len));
+}
+
+size_t Print::printSigned(long long v, int base) {
+    if (base == DEC) {
+        char buf[24];
+        int len = snprintf(buf, sizeof(buf), "%lld", v);
+        return write(reinterpret_cast<const uint8_t*>(buf), static_cast<size_t>(len));
+    }
+    return printUnsigned(static_cast<unsigned long long>(v), base);
+}
+
+size_t Print::printUnsigned(unsigned long long v, int base) {
+    if (base < 2 || base > 16) {
+        base = DEC;
+    }
+    char buf[66];
+    char* p = &buf[sizeof(buf)];
+    do {
+        unsigned digit = static_cast<unsigned>(v % base);
+        *--p = static_cast<char>(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        v /= base;
+    } while (v != 0);
+    return write(reinterpret_cast<const uint8_t*>(p), static_cast<size_t>(&buf[sizeof(buf)] - p));
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len < 0) {
+        return 0;
+    }
+    size_t n = static_cast<size_t>(len) < sizeof(buf) ? static_cast<size_t>(len) : sizeof(buf) - 1;
+    return write(reinterpret_cast<const uint8_t*>(buf), n);
+}
+
+// ========== SERIAL PORTS ==========
+
+size_t HardwareSerial::write(uint8_t b) {
+    return write(&b, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    m_bytesWritten += size;
+    if (m_txSink != nullptr) {
+        m_txSink(buffer, size);
+    }
+    if (m_echo) {
+        // Drop the '\r' of Arduino's "\r\n" line endings
+        for (size_t i = 0; i < size; i++) {
+            if (buffer[i] != '\r') {
+                fputc(buffer[i], stdout);
+            }
+        }
+    }
+    return size;
+}
@@ -0,0 +1,172 @@
+/**
+ * audio_host.cpp - Host stand-in for the Teensy Audio Library (simulator build only)
+ */
+
+#include <Audio.h>
+#include <vector>
+
+AudioStream* AudioStream::first_update = nullptr;
+uint32_t AudioStream::s_allocateFailures = 0;
+uint16_t AudioStream::memory_used = 0;
+uint16_t AudioStream::memory_used_max = 0;
+uint16_t AudioStream::cpu_cycles_total = 0;
+uint16_t AudioStream::cpu_cycles_total_max = 0;
+
+static std::vector<audio_block_t> s_pool;
+static std::vector<audio_block_t*> s_freeList;
+
+// ========== CONNECTIONS ==========
+
+AudioConnection::AudioConnection(AudioStream& source, AudioStream& destination)
+    : AudioConnection(source, 0, destination, 0) {
+}
+
+AudioConnection::AudioConnection(AudioStream& source, unsigned char sourceOutput,
+                                 AudioStream& destination, unsigned char destinationInput)
+    : src(source), dst(destination), src_index(sourceOutput), dest_index(destinationInput), next_dest(nullptr) {
+    // Append to the source's fan-out list (keeps transmit order = declaration order)
+    if (src.destination_list == nullptr) {
+        src.destination_list = this;
+    } else {
+        AudioConnection* p = src.destination_list;
+        while (p->next_dest != nullptr) {
+            p = p->next_dest;
+        }
+        p->next_dest = this;
+    }
+    src.active = true;
+    dst.active = true;
+}
+
+// ========== STREAM ==========
+
+AudioStream::AudioStream(unsigned char ninput, audio_block_t** iqueue)
+    : active(false), num_inputs(ninput), inputQueue(iqueue), destination_list(nullptr), next_update(nullptr) {
+    for (unsigned char i = 0; i < num_inputs; i++) {
+        inputQueue[i] = nullptr;
+    }
+
+    // Update order = construction order
+    if (first_update == nullptr) {
+        first_update = this;
+    } else {
+        AudioStream* p = first_update;
+        while (p->next_update != nullptr) {
+            p = p->next_update;
+        }
+        p->next_update = this;
+    }
+}
+
+void AudioStream::initialize_memory(unsigned int num) {
+    s_pool.assign(num, audio_block_t{});
+    s_freeList.clear();
+    for (unsigned int i = num; i > 0; i--) {
+        s_pool[i - 1].memory_pool_index = static_cast<uint16_t>(i - 1);
+        s_freeList.push_back(&s_pool[i - 1]);
+    }
+    memory_used = 0;
+    memory_used_max = 0;
+}
+
+audio_block_t* AudioStream::allocate() {
+    if (s_freeList.empty()) {
+        s_allocateFailures++;
+        return nullptr;
+    }
+    audio_block_t* block = s_freeList.back();
+    s_freeList.pop_back();
+    block->ref_count = 1;
+    memory_used++;
+    if (memory_used > memory_used_max) {
+        memory_used_max = memory_used;
+    }
+    return block;
+}
+
+void AudioStream::release(audio_block_t* block) {
+    if (block->ref_count > 1) {
+        block->ref_count--;
+        return;
+    }
+    block->ref_count = 0;
+    s_freeList.push_back(block);
+    memory_used--;
+}
+
+void AudioStream::transmit(audio_block_t* block, unsigned char index) {
+    for (AudioConnection* c = destination_list; c != nullptr; c = c->next_dest) {
+        if (c->src_index == index && c->dst.inputQueue[c->dest_index] == nullptr) {
+            c->dst.inputQueue[c->dest_index] = block;
+            block->ref_count++;
+        }
+    }
+}
+
+audio_block_t* AudioStream::receiveReadOnly(unsigned int index) {
+    if (index >= num_inputs) {
+        return nullptr;
+    }
+    audio_block_t* block = inputQueue[index];
+    inputQueue[index] = nullptr;
+    return block;
+}
+
+audio_block_t* AudioStream::receiveWritable(unsigned int index) {
+    audio_block_t* block = receiveReadOnly(index);
+    if (block != nullptr && block->ref_count > 1) {
+        audio_block_t* copy = allocate();
+        if (copy != nullptr) {
+            memcpy(copy->data, block->data, sizeof(copy->data));
+        }
+        block->ref_count--;
+        block = copy;
+    }
+    return block;
+}
+
+void AudioStream::simUpdateAll() {
+    for (AudioStream* p = first_update; p != nullptr; p = p->next_update) {
+        if (p->active) {
+            p->update();
+        }
+    }
+}
+
+// ========== I2S ==========
+
+void AudioInputI2S::update() {
+    audio_block_t* left = allocate();
+    audio_block_t* right = allocate();
+
+    if (left != nullptr && right != nullptr) {
+        if (s_source) {
+            s_source(left->data, right->data, AUDIO_BLOCK_SAMPLES);
+        } else {
+            memset(left->data, 0, sizeof(left->data));
+            memset(right->data, 0, sizeof(right->data));
+        }
+        transmit(left, 0);
+        transmit(right, 1);
+    }
+
+    if (left != nullptr) release(left);
+    if (right != nullptr) release(right);
+}
+
+void AudioOutputI2S::update() {
+    // A missing block plays as silence on hardware
+    static const int16_t silence[AUDIO_BLOCK_SAMPLES] = {};
+
+    audio_block_t* left = receiveReadOnly(0);
+    audio_block_t* right = receiveReadOnly(1);
+
+    if (s_sink) {
+        s_sink(left != nullptr ? left->data : silence,
+               right != nullptr ? right->data : silence,
+               AUDIO_BLOCK_SAMPLES);
+    }
+
+    if (left != nullptr) release(left);
+    if (right != nullptr) release(right);
+}
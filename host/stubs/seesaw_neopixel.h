@@ -0,0 +1,38 @@
+/**
+ * seesaw_neopixel.h - Host stand-in for the seesaw NeoPixel driver (simulator build only)
+ *
+ * Keeps the committed colour of each pixel so the simulator can log LED
+ * changes. setPixelColor() only stages a colour; show() commits it.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class seesaw_NeoPixel {
+public:
+    static constexpr uint8_t NUM_PIXELS = 4;
+
+    void setBrightness(uint8_t brightness) { m_brightness = brightness; }
+
+    void setPixelColor(uint16_t n, uint32_t color) {
+        if (n < NUM_PIXELS) m_staged[n] = color;
+    }
+
+    uint32_t getPixelColor(uint16_t n) const { return (n < NUM_PIXELS) ? m_staged[n] : 0; }
+
+    void show() {
+        for (uint8_t i = 0; i < NUM_PIXELS; i++) m_shown[i] = m_staged[i];
+        m_showCount++;
+    }
+
+    // ========== HOST SIMULATION HOOKS ==========
+    uint32_t simShownColor(uint16_t n) const { return (n < NUM_PIXELS) ? m_shown[n] : 0; }
+    uint32_t simShowCount() const { return m_showCount; }
+
+private:
+    uint8_t m_brightness = 255;
+    uint32_t m_staged[NUM_PIXELS] = {};
+    uint32_t m_shown[NUM_PIXELS] = {};
+    uint32_t m_showCount = 0;
+};
@@ -0,0 +1,48 @@
+/**
+ * dspinst.h - Portable versions of the Audio Library's DSP intrinsics (simulator build only)
+ *
+ * Bit-exact C equivalents of the Cortex-M7 instructions (SSAT, QADD16,
+ * SMULWB/SMULWT, PKHBT/PKHTB) so host output matches the hardware.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// SSAT: arithmetic shift right, then saturate to a signed 'bits'-wide value
+static inline int32_t signed_saturate_rshift(int32_t val, int bits, int rshift) {
+    int32_t out = val >> rshift;
+    int32_t max = (1 << (bits - 1)) - 1;
+    int32_t min = -(1 << (bits - 1));
+    return out > max ? max : (out < min ? min : out);
+}
+
+static inline int16_t saturate16(int32_t val) {
+    return static_cast<int16_t>(val > 32767 ? 32767 : (val < -32768 ? -32768 : val));
+}
+
+// QADD16: two saturating 16-bit adds
+static inline uint32_t signed_add_16_and_16(uint32_t a, uint32_t b) {
+    int32_t lo = static_cast<int16_t>(a) + static_cast<int16_t>(b);
+    int32_t hi = static_cast<int16_t>(a >> 16) + static_cast<int16_t>(b >> 16);
+    return (static_cast<uint32_t>(static_cast<uint16_t>(saturate16(hi))) << 16) |
+           static_cast<uint16_t>(saturate16(lo));
+}
+
+// SMULWB / SMULWT: 32x16 multiply keeping the top 32 bits of the 48-bit product
+static inline int32_t signed_multiply_32x16b(int32_t a, uint32_t b) {
+    return static_cast<int32_t>((static_cast<int64_t>(a) * static_cast<int16_t>(b)) >> 16);
+}
+
+static inline int32_t signed_multiply_32x16t(int32_t a, uint32_t b) {
+    return static_cast<int32_t>((static_cast<int64_t>(a) * static_cast<int16_t>(b >> 16)) >> 16);
+}
+
+// PKHBT / PKHTB: pack two halfwords
+static inline uint32_t pack_16b_16b(int32_t a, int32_t b) {
+    return (static_cast<uint32_t>(a) << 16) | (static_cast<uint32_t>(b) & 0xFFFF);
+}
+
+static inline uint32_t pack_16t_16b(int32_t a, int32_t b) {
+    return (static_cast<uint32_t>(a) & 0xFFFF0000) | (static_cast<uint32_t>(b) & 0xFFFF);
+}
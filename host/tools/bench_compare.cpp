@@ -0,0 +1,330 @@
+/**
+ * bench_compare.cpp - Benchmark regression comparator (host tool)
+ *
+ * PURPOSE:
+ * Compares two benchmark result files and flags regressions beyond a noise
+ * threshold, so a performance change can be checked before it is merged:
+ *
+ *   microloop_tests --json before.jsonl      (or a device serial capture)
+ *   ... change ...
+ *   microloop_tests --json after.jsonl
+ *   bench_compare before.jsonl after.jsonl
+ *
+ * INPUT:
+ * JSON Lines as written by TestRunner (tests/test_runner.h) and
+ * tests/bench_memory_main.cpp. Lines that are not a flat JSON object
+ * (test output, '#' comments, ANSI colour) are skipped, so raw serial
+ * captures work as-is. A record's identity is its string fields
+ * ("micro SPSCQueue_PushPop ns_per_op", "mem PSRAM seq_read cold"); if a
+ * result appears more than once (reruns in one capture) the last one wins.
+ * "bench":"build" records describe the build and are compared separately.
+ *
+ * METRICS:
+ *   median         ns/op, lower is better; noise range min..max
+ *   ns_per_access  lower is better
+ *   mb_per_s       higher is better
+ *
+ * REGRESSION RULE:
+ * Worse by more than --threshold percent (default 10) AND, where the record
+ * has a min/max range, the ranges do not overlap (new min above old max).
+ * Improvements use the mirrored rule.
+ *
+ * Exit code: 0 = no regressions, 1 = regressions, 2 = bad arguments/input.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+struct BenchRecord {
+    std::string key;
+    std::map<std::string, std::string> strings;
+    std::map<std::string, double> numbers;
+};
+
+struct BenchFile {
+    std::vector<BenchRecord> results;  // First-seen order
+    std::map<std::string, size_t> index;
+    BenchRecord build;
+    bool hasBuild = false;
+};
+
+struct Metric {
+    const char* field;
+    bool higherIsBetter;
+    const char* minField;  // Noise range (nullptr = none)
+    const char* maxField;
+};
+
+static const Metric METRICS[] = {
+    { "median", false, "min", "max" },
+    { "ns_per_access", false, nullptr, nullptr },
+    { "mb_per_s", true, nullptr, nullptr },
+};
+
+// ========== PARSER (flat JSON objects only) ==========
+
+static void skipSpace(const char*& p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+}
+
+static bool parseString(const char*& p, std::string& out) {
+    if (*p != '"') return false;
+    p++;
+    out.clear();
+    while (*p != '"') {
+        if (*p == '\0') return false;
+        if (*p == '\\') {
+            p++;
+            switch (*p) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'u':
+                    // Identity strings are ASCII: keep the escape verbatim
+                    out += "\\u";
+                    break;
+                case '\0': return false;
+                default: out += *p; break;
+            }
+            p++;
+            continue;
+        }
+        out += *p++;
+    }
+    p++;
+    return true;
+}
+
+static bool parseRecord(const std::string& line, BenchRecord& record) {
+    const char* p = line.c_str();
+    skipSpace(p);
+    if (*p != '{') return false;
+    p++;
+
+    record = BenchRecord();
+    skipSpace(p);
+    if (*p == '}') return false;
+
+    while (true) {
+        std::string name;
+        skipSpace(p);
+        if (!parseString(p, name)) return false;
+        skipSpace(p);
+        if (*p != ':') return false;
+        p++;
+        skipSpace(p);
+
+        if (*p == '"') {
+            std::string value;
+            if (!parseString(p, value)) return false;
+            record.strings[name] = value;
+            if (!record.key.empty()) record.key += ' ';
+            record.key += value;
+        } else if (strncmp(p, "true", 4) == 0 || strncmp(p, "null", 4) == 0) {
+            p += 4;
+        } else if (strncmp(p, "false", 5) == 0) {
+            p += 5;
+        } else {
+            char* end = nullptr;
+            double value = strtod(p, &end);
+            if (end == p) return false;  // Nested object/array or garbage
+            record.numbers[name] = value;
+            p = end;
+        }
+
+        skipSpace(p);
+        if (*p == ',') {
+            p++;
+            continue;
+        }
+        if (*p == '}') return true;
+        return false;
+    }
+}
+
+static bool loadFile(const char* path, BenchFile& file) {
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "ERROR: bench_compare - cannot open %s\n", path);
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        BenchRecord record;
+        if (!parseRecord(line, record)) {
+            continue;
+        }
+        if (record.strings["bench"] == "build") {
+            file.build = record;
+            file.hasBuild = true;
+            continue;
+        }
+        auto it = file.index.find(record.key);
+        if (it != file.index.end()) {
+            file.results[it->second] = record;
+        } else {
+            file.index[record.key] = file.results.size();
+            file.results.push_back(record);
+        }
+    }
+
+    if (file.results.empty()) {
+        fprintf(stderr, "ERROR: bench_compare - no benchmark records in %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+// ========== COMPARISON ==========
+
+enum class Verdict { UNCHANGED, IMPROVED, REGRESSED };
+
+static const char* verdictName(Verdict v) {
+    switch (v) {
+        case Verdict::IMPROVED: return "improved";
+        case Verdict::REGRESSED: return "REGRESSED";
+        case Verdict::UNCHANGED: break;
+    }
+    return "ok";
+}
+
+static bool lookup(const BenchRecord& record, const char* field, double& value) {
+    if (field == nullptr) return false;
+    auto it = record.numbers.find(field);
+    if (it == record.numbers.end()) return false;
+    value = it->second;
+    return true;
+}
+
+static Verdict judge(const Metric& metric, const BenchRecord& base, const BenchRecord& head, double thresholdPct,
+                     double baseValue, double headValue) {
+    if (baseValue <= 0.0) {
+        return Verdict::UNCHANGED;  // Below timer resolution: no ratio
+    }
+
+    // Positive = worse, in percent
+    double change = (headValue - baseValue) / baseValue * 100.0;
+    double worse = metric.higherIsBetter ? -change : change;
+    if (fabs(worse) <= thresholdPct) {
+        return Verdict::UNCHANGED;
+    }
+
+    // Overlapping noise ranges: not distinguishable from run-to-run spread
+    double baseMin, baseMax, headMin, headMax;
+    if (lookup(base, metric.minField, baseMin) && lookup(base, metric.maxField, baseMax) &&
+        lookup(head, metric.minField, headMin) && lookup(head, metric.maxField, headMax)) {
+        bool headAbove = headMin > baseMax;
+        bool headBelow = headMax < baseMin;
+        bool worseSide = metric.higherIsBetter ? headBelow : headAbove;
+        bool betterSide = metric.higherIsBetter ? headAbove : headBelow;
+        if (worse > 0.0 && !worseSide) return Verdict::UNCHANGED;
+        if (worse < 0.0 && !betterSide) return Verdict::UNCHANGED;
+    }
+
+    return worse > 0.0 ? Verdict::REGRESSED : Verdict::IMPROVED;
+}
+
+static void compareBuilds(const BenchFile& base, const BenchFile& head) {
+    if (!base.hasBuild || !head.hasBuild) {
+        return;
+    }
+
+    std::map<std::string, std::string> before;
+    std::map<std::string, std::string> after;
+    for (const auto& kv : base.build.strings) before[kv.first] = kv.second;
+    for (const auto& kv : base.build.numbers) before[kv.first] = std::to_string(static_cast<long long>(kv.second));
+    for (const auto& kv : head.build.strings) after[kv.first] = kv.second;
+    for (const auto& kv : head.build.numbers) after[kv.first] = std::to_string(static_cast<long long>(kv.second));
+
+    for (const auto& kv : after) {
+        auto it = before.find(kv.first);
+        const std::string old = (it != before.end()) ? it->second : "-";
+        if (old != kv.second) {
+            printf("WARNING: build %s differs: %s -> %s (results may not be comparable)\n", kv.first.c_str(),
+                   old.c_str(), kv.second.c_str());
+        }
+    }
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s <base.jsonl> <new.jsonl> [--threshold PERCENT]\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    const char* paths[2] = { nullptr, nullptr };
+    int numPaths = 0;
+    double thresholdPct = 10.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            thresholdPct = atof(argv[++i]);
+        } else if (argv[i][0] != '-' && numPaths < 2) {
+            paths[numPaths++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (numPaths != 2 || thresholdPct < 0.0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    BenchFile base;
+    BenchFile head;
+    if (!loadFile(paths[0], base) || !loadFile(paths[1], head)) {
+        return 2;
+    }
+
+    printf("bench_compare: %s (%zu results) -> %s (%zu results), threshold %.1f%%\n", paths[0],
+           base.results.size(), paths[1], head.results.size(), thresholdPct);
+    compareBuilds(base, head);
+
+    int regressed = 0;
+    int improved = 0;
+    int unchanged = 0;
+    int missing = 0;
+
+    for (const BenchRecord& before : base.results) {
+        auto it = head.index.find(before.key);
+        if (it == head.index.end()) {
+            printf("  %-9s  %s\n", "missing", before.key.c_str());
+            missing++;
+            continue;
+        }
+        const BenchRecord& after = head.results[it->second];
+
+        for (const Metric& metric : METRICS) {
+            double b, a;
+            if (!lookup(before, metric.field, b) || !lookup(after, metric.field, a)) {
+                continue;
+            }
+            Verdict v = judge(metric, before, after, thresholdPct, b, a);
+            double change = (b > 0.0) ? (a - b) / b * 100.0 : 0.0;
+            printf("  %-9s  %-48s %-13s %12.3f -> %12.3f  (%+6.1f%%)\n", verdictName(v), before.key.c_str(),
+                   metric.field, b, a, change);
+
+            if (v == Verdict::REGRESSED) regressed++;
+            else if (v == Verdict::IMPROVED) improved++;
+            else unchanged++;
+        }
+    }
+
+    int added = 0;
+    for (const BenchRecord& after : head.results) {
+        if (base.index.find(after.key) == base.index.end()) {
+            printf("  %-9s  %s\n", "new", after.key.c_str());
+            added++;
+        }
+    }
+
+    printf("%d regressed, %d improved, %d unchanged, %d missing, %d new\n", regressed, improved, unchanged,
+           missing, added);
+    return regressed > 0 ? 1 : 0;
+}
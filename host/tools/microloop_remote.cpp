@@ -0,0 +1,706 @@
+/**
+ * microloop_remote.cpp - Binary remote-protocol client (host tool, Linux)
+ *
+ * PURPOSE:
+ * Drives a device (or the simulator) through RemoteProtocol
+ * (include/remote_protocol.h): reads and sets effect parameters, injects
+ * commands, streams telemetry, pulls the trace ring, and measures the
+ * link itself - request/reply latency and bulk throughput - so transport
+ * changes can be checked with numbers rather than by feel.
+ *
+ * TRANSPORTS:
+ *   --port <tty>        USB serial device (/dev/ttyACM0), raw mode
+ *   --sim <scenario>    Starts microloop_sim <scenario> --remote --quiet on
+ *                       pipes (--sim-bin <path>, default: next to this tool)
+ *
+ * COMMANDS:
+ *   info                            HELLO: protocol version, rate, block size
+ *   ping [count] [bytes]            Round trips: min/median/p99/max latency
+ *   get <effect> <param>            Read a parameter
+ *   set <effect> <param> <value>    Set a parameter (prints the read-back)
+ *   cmd <type> <effect> [value] [param1] [param2]
+ *                                   Post a Command to the app thread
+ *   telemetry [period ms] [count]   Stream snapshots (default 100 ms, 10)
+ *   trace                           Pull and print the trace ring
+ *   bulk [bytes]                    Read a generated stream: throughput, check
+ *   selftest                        All of the above with checks (ctest)
+ *
+ * <effect> is a number or stutter/freeze/choke/limiter. Device log
+ * messages arriving during the session are printed to stderr.
+ *
+ * Exit code: 0 = OK, 1 = request failed or a selftest check failed,
+ *            2 = bad arguments or no link.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+#include "cobs.h"
+#include "remote_messages.h"
+
+using namespace RemoteMsg;
+using Clock = std::chrono::steady_clock;
+
+static constexpr int REPLY_TIMEOUT_MS = 2000;
+static constexpr int HELLO_ATTEMPTS = 5;
+static constexpr int HELLO_RETRY_MS = 500;
+static constexpr int KEEPALIVE_MS = 1000;  // Well inside IDLE_TIMEOUT_MS
+
+struct Packet {
+    uint8_t type;
+    uint8_t seq;
+    std::vector<uint8_t> body;
+};
+
+// ========== LINK (serial port or simulator pipes) ==========
+
+class Link {
+public:
+    ~Link() { close(); }
+
+    bool openPort(const char* path) {
+        m_rx = m_tx = ::open(path, O_RDWR | O_NOCTTY);
+        if (m_rx < 0) {
+            fprintf(stderr, "ERROR: cannot open %s: %s\n", path, strerror(errno));
+            return false;
+        }
+        struct termios tio;
+        if (tcgetattr(m_rx, &tio) == 0) {
+            cfmakeraw(&tio);
+            tio.c_cc[VMIN] = 0;
+            tio.c_cc[VTIME] = 0;
+            tcsetattr(m_rx, TCSANOW, &tio);
+        }
+        tcflush(m_rx, TCIOFLUSH);
+        return true;
+    }
+
+    bool openSim(const std::string& simBin, const char* scenario) {
+        int toSim[2];
+        int fromSim[2];
+        if (pipe(toSim) != 0 || pipe(fromSim) != 0) {
+            fprintf(stderr, "ERROR: pipe: %s\n", strerror(errno));
+            return false;
+        }
+        m_child = fork();
+        if (m_child < 0) {
+            fprintf(stderr, "ERROR: fork: %s\n", strerror(errno));
+            return false;
+        }
+        if (m_child == 0) {
+            dup2(toSim[0], STDIN_FILENO);
+            dup2(fromSim[1], STDOUT_FILENO);
+            ::close(toSim[0]);
+            ::close(toSim[1]);
+            ::close(fromSim[0]);
+            ::close(fromSim[1]);
+            execl(simBin.c_str(), simBin.c_str(), scenario, "--remote", "--quiet", static_cast<char*>(nullptr));
+            fprintf(stderr, "ERROR: cannot run %s: %s\n", simBin.c_str(), strerror(errno));
+            _exit(127);
+        }
+        ::close(toSim[0]);
+        ::close(fromSim[1]);
+        m_tx = toSim[1];
+        m_rx = fromSim[0];
+        return true;
+    }
+
+    void close() {
+        if (m_tx >= 0 && m_tx != m_rx) ::close(m_tx);
+        if (m_rx >= 0) ::close(m_rx);
+        m_tx = m_rx = -1;
+        if (m_child > 0) {
+            int status;
+            waitpid(m_child, &status, 0);  // stdin EOF ends the simulator
+            m_child = -1;
+        }
+    }
+
+    bool writeAll(const uint8_t* data, size_t size) {
+        while (size > 0) {
+            const ssize_t n = ::write(m_tx, data, size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool sendPacket(uint8_t type, uint8_t seq, const uint8_t* body, size_t length) {
+        uint8_t packet[MAX_PACKET];
+        packet[0] = type;
+        packet[1] = seq;
+        if (length > 0) memcpy(packet + HEADER_BYTES, body, length);
+        uint8_t wire[Cobs::maxFrameSize(MAX_PACKET)];
+        const size_t n = Cobs::encodeFrame(packet, HEADER_BYTES + length, wire);
+        return writeAll(wire, n);
+    }
+
+    /**
+     * Next packet (queued or read within timeoutMs); false on timeout or EOF
+     */
+    bool receive(Packet& out, int timeoutMs) {
+        const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (m_queue.empty()) {
+            const int left = static_cast<int>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count());
+            if (left < 0 || m_eof) {
+                return false;
+            }
+            struct pollfd pfd = { m_rx, POLLIN, 0 };
+            if (poll(&pfd, 1, left) <= 0) {
+                continue;
+            }
+            uint8_t buf[4096];
+            const ssize_t n = ::read(m_rx, buf, sizeof(buf));
+            if (n <= 0) {
+                if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+                m_eof = true;
+                continue;
+            }
+            for (ssize_t i = 0; i < n; i++) {
+                // Bad frames here are console text from before the session
+                if (m_decoder.feed(buf[i]) == FrameDecoder<MAX_PACKET>::FRAME &&
+                    m_decoder.packetLength() >= HEADER_BYTES) {
+                    const uint8_t* p = m_decoder.packet();
+                    m_queue.push_back(Packet{ p[0], p[1],
+                        std::vector<uint8_t>(p + HEADER_BYTES, p + m_decoder.packetLength()) });
+                }
+            }
+        }
+        out = std::move(m_queue.front());
+        m_queue.pop_front();
+        return true;
+    }
+
+private:
+    int m_rx = -1;
+    int m_tx = -1;
+    pid_t m_child = -1;
+    bool m_eof = false;
+    FrameDecoder<MAX_PACKET> m_decoder;
+    std::deque<Packet> m_queue;
+};
+
+// ========== SESSION ==========
+
+class Session {
+public:
+    explicit Session(Link& link) : m_link(link) {}
+
+    uint32_t sampleRate = 0;
+    uint16_t blockSamples = 0;
+
+    bool open() {
+        for (int attempt = 0; attempt < HELLO_ATTEMPTS; attempt++) {
+            const uint8_t sync = Cobs::DELIMITER;
+            m_link.writeAll(&sync, 1);  // Console -> binary mode (an empty frame once active)
+            const uint8_t seq = nextSeq();
+            m_link.sendPacket(HELLO, seq, nullptr, 0);
+            Packet reply;
+            if (await(seq, reply, HELLO_RETRY_MS) && reply.type == HELLO_REPLY && reply.body.size() >= 9) {
+                if (reply.body[0] != VERSION) {
+                    fprintf(stderr, "ERROR: device speaks protocol %u, tool speaks %u\n", reply.body[0], VERSION);
+                    return false;
+                }
+                sampleRate = get32(&reply.body[1]);
+                blockSamples = get16(&reply.body[5]);
+                return true;
+            }
+        }
+        fprintf(stderr, "ERROR: no HELLO_REPLY after %d attempts\n", HELLO_ATTEMPTS);
+        return false;
+    }
+
+    void close() {
+        Packet reply;
+        request(BYE, nullptr, 0, reply);
+    }
+
+    uint8_t nextSeq() {
+        m_seq = static_cast<uint8_t>(m_seq + 1);
+        if (m_seq == 0) m_seq = 1;  // 0 marks unsolicited packets
+        return m_seq;
+    }
+
+    bool send(uint8_t type, uint8_t seq, const uint8_t* body, size_t length) {
+        return m_link.sendPacket(type, seq, body, length);
+    }
+
+    /**
+     * Wait for the reply carrying seq; unsolicited packets are handled on the way
+     */
+    bool await(uint8_t seq, Packet& reply, int timeoutMs = REPLY_TIMEOUT_MS) {
+        const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        for (;;) {
+            const int left = static_cast<int>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count());
+            if (left < 0 || !m_link.receive(reply, left)) {
+                return false;
+            }
+            if (reply.seq == seq && reply.type != LOG) {
+                return true;
+            }
+            unsolicited(reply);
+        }
+    }
+
+    bool request(uint8_t type, const uint8_t* body, size_t length, Packet& reply) {
+        const uint8_t seq = nextSeq();
+        return send(type, seq, body, length) && await(seq, reply);
+    }
+
+    /**
+     * Next unsolicited packet of `type` (LOG is printed, others dropped)
+     */
+    bool awaitUnsolicited(uint8_t type, Packet& out, int timeoutMs) {
+        const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        for (;;) {
+            const int left = static_cast<int>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count());
+            if (left < 0 || !m_link.receive(out, left)) {
+                return false;
+            }
+            if (out.type == type && out.seq == 0) {
+                return true;
+            }
+            unsolicited(out);
+        }
+    }
+
+    uint32_t logLines = 0;
+
+private:
+    void unsolicited(const Packet& p) {
+        if (p.type == LOG) {
+            fprintf(stderr, "device: %.*s\n", static_cast<int>(p.body.size()), reinterpret_cast<const char*>(p.body.data()));
+            logLines++;
+        }
+    }
+
+    Link& m_link;
+    uint8_t m_seq = 0;
+};
+
+// ========== HELPERS ==========
+
+static const char* statusName(uint8_t code) {
+    switch (code) {
+        case OK: return "OK";
+        case ERR_BAD_FRAME: return "bad frame";
+        case ERR_UNKNOWN_TYPE: return "unknown type";
+        case ERR_BAD_LENGTH: return "bad length";
+        case ERR_NO_EFFECT: return "no such effect";
+        case ERR_QUEUE_FULL: return "command queue full";
+        case ERR_BUSY: return "transfer busy";
+        default: return "?";
+    }
+}
+
+static bool parseEffect(const char* s, uint8_t& out) {
+    if (strcmp(s, "stutter") == 0) out = 1;
+    else if (strcmp(s, "freeze") == 0) out = 2;
+    else if (strcmp(s, "choke") == 0) out = 3;
+    else if (strcmp(s, "limiter") == 0) out = EFFECT_LIMITER;
+    else {
+        char* end = nullptr;
+        const long v = strtol(s, &end, 0);
+        if (end == s || *end != '\0' || v < 0 || v > 255) return false;
+        out = static_cast<uint8_t>(v);
+    }
+    return true;
+}
+
+static bool reportError(const char* what, bool ok, const Packet& reply) {
+    if (!ok) {
+        fprintf(stderr, "ERROR: %s - no reply\n", what);
+        return false;
+    }
+    if (reply.type == ERROR || (reply.type == ACK && !reply.body.empty() && reply.body[0] != OK)) {
+        fprintf(stderr, "ERROR: %s - %s\n", what, reply.body.empty() ? "?" : statusName(reply.body[0]));
+        return false;
+    }
+    return true;
+}
+
+static double percentile(std::vector<double> sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    std::sort(sorted.begin(), sorted.end());
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static void printTelemetry(const RemoteTelemetry& t) {
+    printf("t=%8.3f s  sample %10u  %6.2f BPM  transport %u  cpu %4u/%4u permille  governor %u  "
+           "limiter %5u  blocks %u/%u  queues cmd %u event %u log %u  overruns %u  log drops %u\n",
+           t.uptimeMs / 1000.0, t.samplePosition, t.bpmX100 / 100.0, t.transport, t.cpuLoadPermille,
+           t.cpuLoadMaxPermille, t.governorSteps, t.limiterGainQ15, t.audioBlocksUsed, t.audioBlocksMax,
+           t.commandQueueDepth, t.eventQueueDepth, t.logPending, t.overruns, t.logDropped);
+    printf("            effects:");
+    for (uint8_t i = 0; i < t.effectCount && i < MAX_TELEMETRY_EFFECTS; i++) {
+        printf("  #%u state %u %s", t.effects[i].id, t.effects[i].state, t.effects[i].enabled ? "on" : "off");
+    }
+    printf("\n");
+}
+
+// ========== COMMANDS ==========
+
+struct PingStats {
+    std::vector<double> ms;
+    uint32_t failures = 0;
+};
+
+static PingStats runPing(Session& session, uint32_t count, size_t bytes) {
+    PingStats stats;
+    std::vector<uint8_t> payload(std::min(bytes, MAX_BODY));
+    for (uint32_t i = 0; i < count; i++) {
+        for (size_t j = 0; j < payload.size(); j++) payload[j] = static_cast<uint8_t>(i + j);  // Includes zeros
+        const uint8_t seq = session.nextSeq();
+        const Clock::time_point t0 = Clock::now();
+        Packet reply;
+        const bool ok = session.send(PING, seq, payload.data(), payload.size()) && session.await(seq, reply);
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        if (!ok || reply.type != PONG || reply.body != payload) {
+            stats.failures++;
+            continue;
+        }
+        stats.ms.push_back(ms);
+    }
+    return stats;
+}
+
+static void printPing(const PingStats& stats, size_t bytes) {
+    printf("ping: %zu replies, %u failed, %zu byte payload\n", stats.ms.size(), stats.failures, bytes);
+    if (!stats.ms.empty()) {
+        printf("  latency ms: min %.3f  median %.3f  p99 %.3f  max %.3f\n", percentile(stats.ms, 0.0),
+               percentile(stats.ms, 0.5), percentile(stats.ms, 0.99), percentile(stats.ms, 1.0));
+    }
+}
+
+static bool runParam(Session& session, bool set, uint8_t effect, uint8_t param, float value, float& readBack) {
+    uint8_t body[6] = { effect, param };
+    putFloat(body + 2, value);
+    Packet reply;
+    const bool ok = session.request(set ? SET_PARAM : GET_PARAM, body, set ? 6 : 2, reply);
+    if (!reportError(set ? "set" : "get", ok, reply)) {
+        return false;
+    }
+    if (reply.type != PARAM || reply.body.size() != 6) {
+        fprintf(stderr, "ERROR: %s - unexpected reply 0x%02X\n", set ? "set" : "get", reply.type);
+        return false;
+    }
+    readBack = getFloat(&reply.body[2]);
+    return true;
+}
+
+static bool runCommand(Session& session, uint8_t type, uint8_t effect, uint32_t value, uint8_t p1, uint8_t p2) {
+    uint8_t body[8] = { type, effect, p1, p2 };
+    put32(body + 4, value);
+    Packet reply;
+    return reportError("cmd", session.request(COMMAND, body, sizeof(body), reply), reply);
+}
+
+static bool runTelemetry(Session& session, uint16_t periodMs, uint32_t count, std::vector<RemoteTelemetry>* out) {
+    uint8_t body[2];
+    put16(body, periodMs);
+    Packet reply;
+    if (!reportError("telemetry", session.request(TELEMETRY, body, sizeof(body), reply), reply)) {
+        return false;
+    }
+
+    bool ok = true;
+    Clock::time_point lastKeepalive = Clock::now();
+    for (uint32_t i = 0; i < count; i++) {
+        if (reply.type != TELEMETRY_DATA || reply.body.size() != TELEMETRY_BYTES) {
+            fprintf(stderr, "ERROR: telemetry - bad snapshot\n");
+            ok = false;
+            break;
+        }
+        RemoteTelemetry t;
+        unpackTelemetry(reply.body.data(), t);
+        if (out != nullptr) out->push_back(t);
+        else printTelemetry(t);
+
+        if (i + 1 == count) break;
+        // The stream does not count as host activity: keep the session open
+        if (Clock::now() - lastKeepalive > std::chrono::milliseconds(KEEPALIVE_MS)) {
+            session.send(PING, session.nextSeq(), nullptr, 0);
+            lastKeepalive = Clock::now();
+        }
+        if (!session.awaitUnsolicited(TELEMETRY_DATA, reply, periodMs + REPLY_TIMEOUT_MS)) {
+            fprintf(stderr, "ERROR: telemetry - stream stopped after %u snapshot(s)\n", i + 1);
+            ok = false;
+            break;
+        }
+    }
+
+    put16(body, 0);  // Stop streaming (answered by one last snapshot)
+    session.request(TELEMETRY, body, sizeof(body), reply);
+    return ok;
+}
+
+struct TraceRecord {
+    uint32_t timestamp;
+    uint16_t id;
+    uint16_t value;
+};
+
+static bool runTrace(Session& session, std::vector<TraceRecord>& events) {
+    const uint8_t seq = session.nextSeq();
+    session.send(TRACE, seq, nullptr, 0);
+    for (;;) {
+        Packet chunk;
+        if (!reportError("trace", session.await(seq, chunk), chunk)) {
+            return false;
+        }
+        if (chunk.type != TRACE_DATA || chunk.body.size() < 4 || (chunk.body.size() - 4) % TRACE_EVENT_BYTES != 0) {
+            fprintf(stderr, "ERROR: trace - bad chunk\n");
+            return false;
+        }
+        const uint16_t first = get16(&chunk.body[0]);
+        const uint16_t total = get16(&chunk.body[2]);
+        if (first != events.size()) {
+            fprintf(stderr, "ERROR: trace - chunk at %u, expected %zu\n", first, events.size());
+            return false;
+        }
+        const size_t count = (chunk.body.size() - 4) / TRACE_EVENT_BYTES;
+        for (size_t i = 0; i < count; i++) {
+            const uint8_t* p = &chunk.body[4 + i * TRACE_EVENT_BYTES];
+            events.push_back(TraceRecord{ get32(p), get16(p + 4), get16(p + 6) });
+        }
+        if (events.size() >= total) {
+            return true;
+        }
+    }
+}
+
+static bool runBulk(Session& session, uint32_t length, double& bytesPerSecond) {
+    uint8_t body[4];
+    put32(body, length);
+    const uint8_t seq = session.nextSeq();
+    const Clock::time_point t0 = Clock::now();
+    session.send(BULK_READ, seq, body, sizeof(body));
+
+    uint32_t received = 0;
+    for (;;) {
+        Packet chunk;
+        if (!reportError("bulk", session.await(seq, chunk), chunk)) {
+            return false;
+        }
+        if (chunk.type != BULK_DATA || chunk.body.size() < 4 || get32(&chunk.body[0]) != received) {
+            fprintf(stderr, "ERROR: bulk - chunk out of order at %u\n", received);
+            return false;
+        }
+        for (size_t i = 4; i < chunk.body.size(); i++, received++) {
+            if (chunk.body[i] != static_cast<uint8_t>(received)) {
+                fprintf(stderr, "ERROR: bulk - byte %u corrupted\n", received);
+                return false;
+            }
+        }
+        if (received >= length) {
+            break;
+        }
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    bytesPerSecond = seconds > 0.0 ? length / seconds : 0.0;
+    return true;
+}
+
+// ========== SELFTEST ==========
+
+static int s_checks = 0;
+static int s_failures = 0;
+
+static void check(bool ok, const char* what) {
+    s_checks++;
+    if (!ok) s_failures++;
+    printf("  [%s] %s\n", ok ? "PASS" : "FAIL", what);
+}
+
+static int runSelftest(Session& session, Link& link) {
+    printf("selftest: protocol %u, %u Hz, %u-sample blocks\n", VERSION, session.sampleRate, session.blockSamples);
+
+    PingStats ping = runPing(session, 200, 32);
+    check(ping.failures == 0 && ping.ms.size() == 200, "200 pings echoed intact");
+    PingStats big = runPing(session, 20, MAX_BODY);
+    check(big.failures == 0, "max-size ping echoed intact");
+    printPing(ping, 32);
+
+    float value = 0.0f;
+    float original = 0.0f;
+    check(runParam(session, false, EFFECT_LIMITER, 0, 0.0f, original), "get limiter threshold");
+    check(runParam(session, true, EFFECT_LIMITER, 0, 0.5f, value) && value > 0.49f && value < 0.51f,
+          "set limiter threshold reads back");
+    runParam(session, true, EFFECT_LIMITER, 0, original, value);
+
+    uint8_t body[8] = { 200, 0 };
+    Packet reply;
+    check(session.request(GET_PARAM, body, 2, reply) && reply.type == ERROR && reply.body[0] == ERR_NO_EFFECT,
+          "unknown effect rejected");
+    check(session.request(0x7E, nullptr, 0, reply) && reply.type == ERROR && reply.body[0] == ERR_UNKNOWN_TYPE,
+          "unknown request type rejected");
+    check(session.request(GET_PARAM, body, 1, reply) && reply.type == ERROR && reply.body[0] == ERR_BAD_LENGTH,
+          "short body rejected");
+
+    // A frame with a broken CRC is answered with ERROR seq 0, then the link resyncs
+    const uint8_t corrupt[] = { 0x03, 0x02, 0x11, 0x00 };
+    link.writeAll(corrupt, sizeof(corrupt));
+    check(session.await(0, reply) && reply.type == ERROR && reply.body[0] == ERR_BAD_FRAME, "bad frame reported");
+    check(runPing(session, 1, 8).failures == 0, "link resyncs after a bad frame");
+
+    check(runCommand(session, 0, 0, 0, 0, 0), "command posted (NONE)");
+
+    std::vector<RemoteTelemetry> snapshots;
+    check(runTelemetry(session, 50, 5, &snapshots) && snapshots.size() == 5, "5 telemetry snapshots streamed");
+    if (snapshots.size() == 5) {
+        const RemoteTelemetry& last = snapshots.back();
+        check(last.effectCount == 4, "telemetry lists 4 exposed effects");
+        check(last.samplePosition > snapshots.front().samplePosition, "sample position advances");
+        check(last.uptimeMs - snapshots.front().uptimeMs >= 150, "snapshots follow the period");
+        printTelemetry(last);
+    }
+
+    std::vector<TraceRecord> events;
+    check(runTrace(session, events), "trace ring transferred");
+    printf("  trace: %zu events\n", events.size());
+
+    double rate = 0.0;
+    check(runBulk(session, 256 * 1024, rate), "256 KB bulk read verified");
+    printf("  bulk: %.1f KB/s\n", rate / 1024.0);
+
+    Packet bye;
+    check(session.request(BYE, nullptr, 0, bye) && bye.type == ACK && bye.body[0] == OK, "session closed");
+
+    printf("selftest: %d/%d checks passed\n", s_checks - s_failures, s_checks);
+    return s_failures == 0 ? 0 : 1;
+}
+
+// ========== MAIN ==========
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s (--port <tty> | --sim <scenario> [--sim-bin <path>]) <command> [args]\n"
+            "  info | ping [count] [bytes] | get <effect> <param> | set <effect> <param> <value>\n"
+            "  cmd <type> <effect> [value] [param1] [param2] | telemetry [period ms] [count]\n"
+            "  trace | bulk [bytes] | selftest\n",
+            argv0);
+}
+
+int main(int argc, char** argv) {
+    const char* port = nullptr;
+    const char* scenario = nullptr;
+    std::string simBin;
+    std::vector<const char*> args;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = argv[++i];
+        } else if (strcmp(argv[i], "--sim") == 0 && i + 1 < argc) {
+            scenario = argv[++i];
+        } else if (strcmp(argv[i], "--sim-bin") == 0 && i + 1 < argc) {
+            simBin = argv[++i];
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    if ((port == nullptr) == (scenario == nullptr) || args.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (simBin.empty()) {
+        const std::string self = argv[0];
+        const size_t slash = self.rfind('/');
+        simBin = (slash == std::string::npos ? std::string(".") : self.substr(0, slash)) + "/microloop_sim";
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    Link link;
+    if (port != nullptr ? !link.openPort(port) : !link.openSim(simBin, scenario)) {
+        return 2;
+    }
+    Session session(link);
+    if (!session.open()) {
+        return 2;
+    }
+
+    const std::string command = args[0];
+    const size_t n = args.size();
+    auto argU = [&](size_t i, unsigned long def) { return i < n ? strtoul(args[i], nullptr, 0) : def; };
+    int status = 0;
+
+    if (command == "selftest") {
+        return runSelftest(session, link);  // Ends with BYE
+    } else if (command == "info") {
+        printf("protocol %u, %u Hz, %u-sample blocks, max body %zu\n", VERSION, session.sampleRate,
+               session.blockSamples, MAX_BODY);
+    } else if (command == "ping") {
+        const size_t bytes = argU(2, 32);
+        PingStats stats = runPing(session, static_cast<uint32_t>(argU(1, 100)), bytes);
+        printPing(stats, bytes);
+        status = stats.failures == 0 ? 0 : 1;
+    } else if ((command == "get" && n == 3) || (command == "set" && n == 4)) {
+        uint8_t effect;
+        if (!parseEffect(args[1], effect)) {
+            usage(argv[0]);
+            return 2;
+        }
+        const bool set = command == "set";
+        float value = 0.0f;
+        if (runParam(session, set, effect, static_cast<uint8_t>(argU(2, 0)), set ? strtof(args[3], nullptr) : 0.0f,
+                     value)) {
+            printf("effect %u param %lu = %g\n", effect, argU(2, 0), value);
+        } else {
+            status = 1;
+        }
+    } else if (command == "cmd" && n >= 3) {
+        uint8_t effect;
+        if (!parseEffect(args[2], effect)) {
+            usage(argv[0]);
+            return 2;
+        }
+        status = runCommand(session, static_cast<uint8_t>(argU(1, 0)), effect, static_cast<uint32_t>(argU(3, 0)),
+                            static_cast<uint8_t>(argU(4, 0)), static_cast<uint8_t>(argU(5, 0))) ? 0 : 1;
+    } else if (command == "telemetry") {
+        status = runTelemetry(session, static_cast<uint16_t>(argU(1, 100)), static_cast<uint32_t>(argU(2, 10)),
+                              nullptr) ? 0 : 1;
+    } else if (command == "trace") {
+        std::vector<TraceRecord> events;
+        if (runTrace(session, events)) {
+            for (const TraceRecord& e : events) {
+                printf("%10u us  event %5u  value %5u\n", e.timestamp, e.id, e.value);
+            }
+            printf("%zu events\n", events.size());
+        } else {
+            status = 1;
+        }
+    } else if (command == "bulk") {
+        const uint32_t length = static_cast<uint32_t>(argU(1, 1024 * 1024));
+        double rate = 0.0;
+        if (runBulk(session, length, rate)) {
+            printf("bulk: %u bytes verified, %.1f KB/s\n", length, rate / 1024.0);
+        } else {
+            status = 1;
+        }
+    } else {
+        usage(argv[0]);
+        return 2;
+    }
+
+    session.close();
+    return status;
+}
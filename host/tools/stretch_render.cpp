@@ -0,0 +1,263 @@
+/**
+ * stretch_render.cpp - Quality and cost report for the WSOLA loop stretch (host tool)
+ *
+ * PURPOSE:
+ * Renders test loops through WsolaStretch (include/wsola_stretch.h) the
+ * way the stutter effect plays them - one audio block per call, loop
+ * captured at one tempo, played at another - and measures what a listener
+ * would notice:
+ *
+ *   pitch    Sine loop: output frequency from zero crossings, error in cents
+ *            (a stretch must not change pitch)
+ *   level    Sine loop: RMS per 1024 samples, worst deviation in dB from
+ *            the input (crossfades between badly matched grains dip)
+ *   timing   Click per beat: onset positions against the beat grid of the
+ *            new tempo, worst error in ms (the loop must stay on the beat)
+ *   cpu      ns per process() call of one block, mean and worst
+ *
+ * The CPU numbers are host numbers: compare runs on the same machine, or
+ * use microloop_tests DspKernels_WsolaBlock on the device.
+ *
+ * USAGE:
+ *   stretch_render [--wav-dir <dir>] [--check]
+ *     --wav-dir  write each render as <dir>/stretch_<from>_<to>_<signal>.wav
+ *     --check    exit 1 if a metric is outside its limit (ctest)
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "timekeeper.h"
+#include "wsola_stretch.h"
+
+static constexpr double SAMPLE_RATE = TimeKeeper::SAMPLE_RATE;  // Build's rate (grains are in samples)
+static constexpr uint32_t LOOP_BEATS = 8;  // Two bars
+
+// Limits for --check
+static constexpr double MAX_PITCH_CENTS = 3.0;
+static constexpr double MAX_LEVEL_DB = 1.0;
+static constexpr double MAX_TIMING_MS = 12.0;  // SEEK (5.8 ms @ 44.1 kHz) + a click caught mid-crossfade
+
+struct StretchCase {
+    double fromBpm;
+    double toBpm;
+};
+
+static const StretchCase CASES[] = {
+    { 124.0, 128.0 },  // DJ rides the tempo up
+    { 124.0, 120.0 },
+    { 128.0, 124.0 },
+    { 100.0, 140.0 },  // Extremes
+    { 140.0, 100.0 },
+};
+
+static uint32_t spbFor(double bpm) {
+    return static_cast<uint32_t>(SAMPLE_RATE * 60.0 / bpm);
+}
+
+// ========== SIGNALS ==========
+
+static std::vector<int16_t> makeSine(size_t length, double hz) {
+    std::vector<int16_t> out(length);
+    for (size_t i = 0; i < length; i++) {
+        out[i] = static_cast<int16_t>(12000.0 * sin(2.0 * M_PI * hz * i / SAMPLE_RATE));
+    }
+    return out;
+}
+
+static std::vector<int16_t> makeClicks(size_t length, uint32_t spb) {
+    // Decaying 2 kHz burst on every beat, silence in between
+    std::vector<int16_t> out(length, 0);
+    for (size_t beat = 0; beat * spb < length; beat++) {
+        for (size_t i = 0; i < 400 && beat * spb + i < length; i++) {
+            double env = exp(-static_cast<double>(i) / 60.0);
+            out[beat * spb + i] = static_cast<int16_t>(20000.0 * env * sin(2.0 * M_PI * 2000.0 * i / SAMPLE_RATE));
+        }
+    }
+    return out;
+}
+
+// ========== RENDER ==========
+
+struct Render {
+    std::vector<int16_t> out;
+    double meanNs = 0.0;
+    double worstNs = 0.0;
+};
+
+static Render render(const std::vector<int16_t>& loop, uint32_t fromSpb, uint32_t toSpb, size_t samples) {
+    Render r;
+    r.out.resize(samples);
+
+    static WsolaStretch stretch;
+    const WsolaStretch::Source src = { loop.data(), loop.data(), 0, loop.size(), loop.size() };
+    stretch.reset(0, loop.size());
+    stretch.setSpeed(fromSpb, toSpb);
+
+    int16_t right[AUDIO_BLOCK_SAMPLES];
+    double total = 0.0;
+    size_t blocks = 0;
+    for (size_t pos = 0; pos + AUDIO_BLOCK_SAMPLES <= samples; pos += AUDIO_BLOCK_SAMPLES) {
+        auto t0 = std::chrono::steady_clock::now();
+        stretch.process(src, &r.out[pos], right, AUDIO_BLOCK_SAMPLES);
+        auto t1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        total += ns;
+        if (ns > r.worstNs) r.worstNs = ns;
+        blocks++;
+    }
+    r.meanNs = blocks > 0 ? total / blocks : 0.0;
+    return r;
+}
+
+// ========== METRICS ==========
+
+static double pitchCents(const std::vector<int16_t>& out, double hz) {
+    // Mean period from the first to the last rising zero crossing (interpolated)
+    double first = -1.0;
+    double last = -1.0;
+    size_t crossings = 0;
+    for (size_t i = 1; i < out.size(); i++) {
+        if (out[i - 1] < 0 && out[i] >= 0) {
+            double at = (i - 1) + static_cast<double>(-out[i - 1]) / (out[i] - out[i - 1]);
+            if (first < 0.0) first = at;
+            last = at;
+            crossings++;
+        }
+    }
+    if (crossings < 2) {
+        return 1e9;
+    }
+    double measured = SAMPLE_RATE * (crossings - 1) / (last - first);
+    return 1200.0 * log2(measured / hz);
+}
+
+static double rms(const int16_t* x, size_t n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) sum += static_cast<double>(x[i]) * x[i];
+    return sqrt(sum / n);
+}
+
+static double worstLevelDb(const std::vector<int16_t>& out, const std::vector<int16_t>& loop) {
+    const size_t window = 1024;
+    const double ref = rms(loop.data(), loop.size());
+    double worst = 0.0;
+    for (size_t pos = 0; pos + window <= out.size(); pos += window) {
+        double db = fabs(20.0 * log10(rms(&out[pos], window) / ref));
+        if (db > worst) worst = db;
+    }
+    return worst;
+}
+
+static double worstTimingMs(const std::vector<int16_t>& out, uint32_t toSpb) {
+    // Onset = first sample above threshold after 1000 quiet samples
+    std::vector<size_t> onsets;
+    size_t quiet = 1000;
+    for (size_t i = 0; i < out.size(); i++) {
+        if (abs(out[i]) > 4000) {
+            if (quiet >= 1000) onsets.push_back(i);
+            quiet = 0;
+        } else {
+            quiet++;
+        }
+    }
+    if (onsets.size() < 2) {
+        return 1e9;
+    }
+    double worst = 0.0;
+    for (size_t k = 0; k < onsets.size(); k++) {
+        // Beat k of the new tempo; the first onset is on the grid (position 0)
+        double expected = static_cast<double>(onsets[0]) + static_cast<double>(k) * toSpb;
+        double err = fabs(static_cast<double>(onsets[k]) - expected) * 1000.0 / SAMPLE_RATE;
+        if (err > worst) worst = err;
+    }
+    return worst;
+}
+
+static bool writeWav(const std::string& path, const std::vector<int16_t>& samples) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (f == nullptr) {
+        fprintf(stderr, "ERROR: writeWav() - cannot create %s\n", path.c_str());
+        return false;
+    }
+    const uint32_t rate = static_cast<uint32_t>(SAMPLE_RATE);
+    const uint32_t dataBytes = static_cast<uint32_t>(samples.size() * 2);
+    const uint32_t riffBytes = 36 + dataBytes;
+    const uint32_t fmtBytes = 16;
+    const uint16_t format = 1, channels = 1, align = 2, bits = 16;
+    const uint32_t byteRate = rate * 2;
+    fwrite("RIFF", 1, 4, f); fwrite(&riffBytes, 4, 1, f); fwrite("WAVE", 1, 4, f);
+    fwrite("fmt ", 1, 4, f); fwrite(&fmtBytes, 4, 1, f); fwrite(&format, 2, 1, f);
+    fwrite(&channels, 2, 1, f); fwrite(&rate, 4, 1, f); fwrite(&byteRate, 4, 1, f);
+    fwrite(&align, 2, 1, f); fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f); fwrite(&dataBytes, 4, 1, f);
+    fwrite(samples.data(), 2, samples.size(), f);
+    fclose(f);
+    return true;
+}
+
+// ========== MAIN ==========
+
+int main(int argc, char** argv) {
+    const char* wavDir = nullptr;
+    bool check = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--wav-dir") == 0 && i + 1 < argc) {
+            wavDir = argv[++i];
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--wav-dir <dir>] [--check]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("WSOLA loop stretch @ %.0f Hz: grain %zu, hop %zu, seek +/-%zu, search decimation %zu\n", SAMPLE_RATE,
+           WsolaStretch::GRAIN, WsolaStretch::HOP, WsolaStretch::SEEK, WsolaStretch::DECIMATE);
+    printf("%-15s %7s %12s %10s %11s %14s\n", "tempo", "speed", "pitch cents", "level dB", "timing ms", "cpu ns/block");
+
+    bool ok = true;
+    for (const StretchCase& c : CASES) {
+        const uint32_t fromSpb = spbFor(c.fromBpm);
+        const uint32_t toSpb = spbFor(c.toBpm);
+        const size_t loopLength = static_cast<size_t>(fromSpb) * LOOP_BEATS;
+        const size_t renderLength = static_cast<size_t>(toSpb) * LOOP_BEATS * 2;  // Loop twice at the new tempo
+
+        const std::vector<int16_t> sine = makeSine(loopLength, 440.0);
+        const std::vector<int16_t> clicks = makeClicks(loopLength, fromSpb);
+        const Render sineOut = render(sine, fromSpb, toSpb, renderLength);
+        const Render clickOut = render(clicks, fromSpb, toSpb, renderLength);
+
+        const double cents = pitchCents(sineOut.out, 440.0);
+        const double level = worstLevelDb(sineOut.out, sine);
+        const double timing = worstTimingMs(clickOut.out, toSpb);
+        const double speed = static_cast<double>(fromSpb) / toSpb;
+
+        char label[32];
+        snprintf(label, sizeof(label), "%.0f -> %.0f", c.fromBpm, c.toBpm);
+        printf("%-15s %7.4f %+12.2f %10.2f %11.2f %7.0f / %5.0f\n", label, speed, cents, level, timing,
+               sineOut.meanNs, sineOut.worstNs);
+
+        if (fabs(cents) > MAX_PITCH_CENTS || level > MAX_LEVEL_DB || timing > MAX_TIMING_MS) {
+            ok = false;
+        }
+
+        if (wavDir != nullptr) {
+            char name[64];
+            snprintf(name, sizeof(name), "/stretch_%.0f_%.0f_", c.fromBpm, c.toBpm);
+            writeWav(std::string(wavDir) + name + "sine.wav", sineOut.out);
+            writeWav(std::string(wavDir) + name + "clicks.wav", clickOut.out);
+        }
+    }
+
+    if (check && !ok) {
+        printf("FAIL: a metric is outside its limit (pitch %.1f cents, level %.1f dB, timing %.1f ms)\n",
+               MAX_PITCH_CENTS, MAX_LEVEL_DB, MAX_TIMING_MS);
+        return 1;
+    }
+    return 0;
+}
@@ -2,12 +2,41 @@
 
 #include <Arduino.h>
 #include "effect_quantization.h"  // For Quantization enum
+#include "command.h"
+#include "audio_effect_base.h"
 
 namespace AppLogic {
     void begin();
 
     void threadLoop();
 
+    /**
+     * Queue a command for the app thread, handled like a button command
+     * (USB console; one producer thread only)
+     *
+     * @return false if the queue is full
+     */
+    bool postCommand(const Command& cmd);
+
+    /**
+     * Posted commands not yet handled (approximate, monitoring only)
+     */
+    size_t pendingCommands();
+
+    /**
+     * Queue an effect parameter write for the app thread, which owns the
+     * effects' control side (remote protocol; one producer thread only)
+     *
+     * @return false if the queue is full
+     */
+    bool postParameter(AudioEffectBase* effect, uint8_t paramIndex, float value);
+
+    /**
+     * Every posted parameter write has been applied (producer thread only:
+     * after this, getParameter() reads the written value back)
+     */
+    bool parametersApplied();
+
     Quantization getGlobalQuantization();
 
     void setGlobalQuantization(Quantization quant);
@@ -31,10 +31,10 @@
 enum class AppMode : uint8_t {
     NORMAL = 0,        // Default mode: effects active, display shows last effect
     EDITING_PARAM = 1, // Encoder touched: display shows parameter being adjusted
+    PATTERN_EDIT = 4,  // Encoders edit the step sequencer pattern (encoder 4 click)
     // Future modes:
     // MENU_NAVIGATION = 2,  // Navigating menu system
     // RECORDING = 3,        // Recording a loop
-    // PATTERN_EDIT = 4,     // Editing step pattern
 };
 
 /**
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "audio_effect_base.h"
+#include "choke_curves.h"
+#include "gain_ramp.h"
 #include "timekeeper.h"
+#include "trace.h"
 #include <atomic>
 
 enum class ChokeLength : uint8_t {
@@ -16,24 +19,29 @@ enum class ChokeOnset : uint8_t {
 
 class AudioEffectChoke : public AudioEffectBase {
 public:
+    /**
+     * Parameter indices for setParameter()/getParameter() (EFFECT_SET_PARAM)
+     */
+    static constexpr uint8_t PARAM_CURVE = 0;         // Fade curve (ChokeCurve as float)
+    static constexpr uint8_t PARAM_FADE_SAMPLES = 1;  // Fade length in samples
+
     AudioEffectChoke() : AudioEffectBase(2) {  // Call base with 2 inputs (stereo)
-        m_targetGain = 1.0f;      // Start unmuted
-        m_currentGain = 1.0f;
+        m_fadePos = FADE_POS_OPEN;  // Start unmuted
+        m_curve = ChokeCurve::LINEAR;
+        setFadeSamples(DEFAULT_FADE_SAMPLES);
         m_isEnabled.store(false, std::memory_order_relaxed);  // Start disabled (unmuted)
         m_lengthMode = ChokeLength::FREE;  // Default: free mode
         m_onsetMode = ChokeOnset::FREE;    // Default: free mode
-        m_releaseAtSample = 0;  // No scheduled release
-        m_onsetAtSample = 0;    // No scheduled onset
+        m_releaseAtSample = NOT_SCHEDULED;  // No scheduled release
+        m_onsetAtSample = NOT_SCHEDULED;    // No scheduled onset
     }
 
     void enable() override {
-        m_targetGain = 0.0f;  // Mute
-        m_isEnabled.store(true, std::memory_order_release);
+        m_isEnabled.store(true, std::memory_order_release);  // Fade towards mute
     }
 
     void disable() override {
-        m_targetGain = 1.0f;  // Unmute
-        m_isEnabled.store(false, std::memory_order_release);
+        m_isEnabled.store(false, std::memory_order_release);  // Fade towards unity
     }
 
     void toggle() override {
@@ -52,6 +60,61 @@ public:
         return "Choke";
     }
 
+    void setParameter(uint8_t paramIndex, float value) override {
+        if (paramIndex == PARAM_CURVE) {
+            uint8_t curve = static_cast<uint8_t>(value);
+            if (curve < CHOKE_CURVE_COUNT) {
+                setCurve(static_cast<ChokeCurve>(curve));
+            }
+        } else if (paramIndex == PARAM_FADE_SAMPLES) {
+            setFadeSamples(static_cast<uint32_t>(value));
+        }
+    }
+
+    float getParameter(uint8_t paramIndex) const override {
+        if (paramIndex == PARAM_CURVE) {
+            return static_cast<float>(m_curve);
+        } else if (paramIndex == PARAM_FADE_SAMPLES) {
+            return static_cast<float>(m_fadeSamples);
+        }
+        return 0.0f;
+    }
+
+    uint8_t getScheduledEvents(ScheduledEvent* out, uint8_t maxEvents) const override {
+        uint8_t count = 0;
+        if (m_onsetAtSample != NOT_SCHEDULED && count < maxEvents) out[count++] = {"onset", m_onsetAtSample};
+        if (m_releaseAtSample != NOT_SCHEDULED && count < maxEvents) out[count++] = {"release", m_releaseAtSample};
+        return count;
+    }
+
+    /**
+     * Select fade curve (takes effect on the next audio block, mid-fade safe)
+     */
+    void setCurve(ChokeCurve curve) {
+        m_curve = curve;
+    }
+
+    ChokeCurve getCurve() const {
+        return m_curve;
+    }
+
+    /**
+     * Set fade length in samples (clamped to 1..MAX_FADE_SAMPLES)
+     *
+     * Musical lengths are converted by the caller (see ChokeController),
+     * so the ISR only ever sees a per-sample step.
+     */
+    void setFadeSamples(uint32_t samples) {
+        if (samples < 1) samples = 1;
+        if (samples > MAX_FADE_SAMPLES) samples = MAX_FADE_SAMPLES;
+        m_fadeSamples = samples;
+        m_fadeStep = FADE_POS_OPEN / samples;
+    }
+
+    uint32_t getFadeSamples() const {
+        return m_fadeSamples;
+    }
+
     void setLengthMode(ChokeLength mode) {
         m_lengthMode = mode;
     }
@@ -65,7 +128,7 @@ public:
     }
 
     void cancelScheduledRelease() {
-        m_releaseAtSample = 0;
+        m_releaseAtSample = NOT_SCHEDULED;
     }
 
     void scheduleOnset(uint64_t onsetSample) {
@@ -73,7 +136,11 @@ public:
     }
 
     void cancelScheduledOnset() {
-        m_onsetAtSample = 0;
+        m_onsetAtSample = NOT_SCHEDULED;
+    }
+
+    bool isOnsetPending() const {
+        return m_onsetAtSample != NOT_SCHEDULED;
     }
 
     void setOnsetMode(ChokeOnset mode) {
@@ -102,86 +169,98 @@ public:
 
         // Check for scheduled onset (ISR-accurate quantized onset)
         // Fire if the scheduled sample falls within this audio block [currentSample, blockEndSample)
-        if (m_onsetAtSample > 0 && m_onsetAtSample >= currentSample && m_onsetAtSample < blockEndSample) {
+        if (m_onsetAtSample != NOT_SCHEDULED && m_onsetAtSample >= currentSample && m_onsetAtSample < blockEndSample) {
             // Time to engage choke (block-accurate - best we can do in ISR)
-            m_targetGain = 0.0f;  // Mute
             m_isEnabled.store(true, std::memory_order_release);
-            m_onsetAtSample = 0;  // Clear scheduled onset
+            m_onsetAtSample = NOT_SCHEDULED;  // Clear scheduled onset
         }
 
         // Check for scheduled release (ISR-accurate quantized length)
         // Fire if the scheduled sample falls within this audio block [currentSample, blockEndSample)
-        if (m_releaseAtSample > 0 && m_releaseAtSample >= currentSample && m_releaseAtSample < blockEndSample) {
+        if (m_releaseAtSample != NOT_SCHEDULED && m_releaseAtSample >= currentSample && m_releaseAtSample < blockEndSample) {
             // Time to auto-release (block-accurate)
-            m_targetGain = 1.0f;  // Unmute
             m_isEnabled.store(false, std::memory_order_release);
-            m_releaseAtSample = 0;  // Clear scheduled release
+            m_releaseAtSample = NOT_SCHEDULED;  // Clear scheduled release
         }
 
+        // Advance fade position by one block (control rate)
+        // Curve is evaluated only at block edges; samples in between are
+        // linearly interpolated in fixed point (no per-sample table lookups)
+        const bool muted = m_isEnabled.load(std::memory_order_acquire);
+        const uint32_t startPos = m_fadePos;
+        const uint32_t endPos = advanceFade(startPos, muted);
+        m_fadePos = endPos;
+
         // Receive input blocks (left and right channels)
         audio_block_t* blockL = receiveWritable(0);
         audio_block_t* blockR = receiveWritable(1);
 
-        // Calculate gain increment per sample for smooth fade
-        // Fade time: 10ms = 441 samples @ 44.1kHz
-        // Over 128-sample block, we traverse: 128/441 of the fade
-        const float gainIncrement = (m_targetGain - m_currentGain) / FADE_SAMPLES;
+        if (startPos == endPos) {
+            // Settled: fully open passes through untouched, fully closed is silence
+            if (endPos == 0) {
+                if (blockL) memset(blockL->data, 0, sizeof(blockL->data));
+                if (blockR) memset(blockR->data, 0, sizeof(blockR->data));
+            }
+        } else {
+            const int32_t gainStart = ChokeCurves::gainAt(m_curve, startPos);
+            const int32_t gainEnd = ChokeCurves::gainAt(m_curve, endPos);
+            if (blockL) GainRamp::apply(blockL->data, gainStart, gainEnd);
+            if (blockR) GainRamp::apply(blockR->data, gainStart, gainEnd);
+
+            if (endPos == 0 || endPos == FADE_POS_OPEN) {
+                TRACE(TRACE_CHOKE_FADE_COMPLETE, endPos == 0 ? 0 : 100);
+            }
+        }
 
         // Process left channel
         if (blockL) {
-            applyGainRamp(blockL->data, AUDIO_BLOCK_SAMPLES, gainIncrement);
             transmit(blockL, 0);
             release(blockL);
         }
 
         // Process right channel
         if (blockR) {
-            applyGainRamp(blockR->data, AUDIO_BLOCK_SAMPLES, gainIncrement);
             transmit(blockR, 1);
             release(blockR);
         }
     }
 
 private:
-    inline void applyGainRamp(int16_t* data, size_t numSamples, float gainIncrement) {
-        for (size_t i = 0; i < numSamples; i++) {
-            // Update current gain (linear interpolation)
-            m_currentGain += gainIncrement;
-
-            // Clamp gain to [0.0, 1.0] to prevent overshoot
-            if (m_currentGain < 0.0f) m_currentGain = 0.0f;
-            if (m_currentGain > 1.0f) m_currentGain = 1.0f;
-
-            // Apply gain to sample
-            // Note: int16_t range is -32768 to 32767
-            // We multiply by gain, then clamp to prevent overflow
-            int32_t sample = static_cast<int32_t>(data[i]) * m_currentGain;
-
-            // Clamp to int16_t range (shouldn't overflow with gain ≤ 1.0, but safe practice)
-            if (sample > 32767) sample = 32767;
-            if (sample < -32768) sample = -32768;
-
-            data[i] = static_cast<int16_t>(sample);
+    /**
+     * Move fade position one block towards its target (0 = muted, OPEN = unity)
+     */
+    inline uint32_t advanceFade(uint32_t pos, bool muted) const {
+        const uint32_t span = m_fadeStep * AUDIO_BLOCK_SAMPLES;
+        if (muted) {
+            return (pos > span) ? (pos - span) : 0;
         }
+        return (FADE_POS_OPEN - pos > span) ? (pos + span) : FADE_POS_OPEN;
     }
 
     // Fade parameters
-    static constexpr float FADE_TIME_MS = 3.0f;  // 3ms crossfade (tighter feel for quantization)
-    static constexpr float FADE_SAMPLES = (FADE_TIME_MS / 1000.0f) * 44100.0f;  // 132 samples
+    static constexpr uint32_t FADE_TIME_MS = 3;  // 3ms default crossfade (tighter feel for quantization)
+    static constexpr uint32_t DEFAULT_FADE_SAMPLES = (FADE_TIME_MS * TimeKeeper::SAMPLE_RATE) / 1000;  // 132 samples @ 44.1 kHz
+    static constexpr uint32_t FADE_POS_OPEN = ChokeCurves::POS_ONE;  // Fade position at unity gain (Q24)
+    static constexpr uint32_t MAX_FADE_SAMPLES = TimeKeeper::SAMPLE_RATE * 2;  // 2s (keeps step >= 1)
 
-    // Gain state (modified in audio ISR)
-    float m_currentGain;  // Current gain (ramped smoothly)
-    float m_targetGain;   // Target gain (0.0 = mute, 1.0 = full volume)
+    // Fade state (position modified in audio ISR, curve/step set from app thread)
+    uint32_t m_fadePos;       // Fade position, Q24 (0 = muted, FADE_POS_OPEN = unity)
+    uint32_t m_fadeStep;      // Position increment per sample (FADE_POS_OPEN / fade samples)
+    uint32_t m_fadeSamples;   // Fade length in samples
+    ChokeCurve m_curve;       // Fade curve shape
 
     // Effect state (atomic for lock-free cross-thread access)
     // Note: For choke, enabled=true means muted, enabled=false means unmuted
     std::atomic<bool> m_isEnabled;
 
+    // Not 0: a downbeat right after START is sample 0
+    static constexpr uint64_t NOT_SCHEDULED = UINT64_MAX;
+
     // Choke length mode state
     ChokeLength m_lengthMode;     // FREE or QUANTIZED
-    uint64_t m_releaseAtSample;   // Sample position when choke should auto-release (0 = no scheduled release)
+    uint64_t m_releaseAtSample;   // Sample position when choke should auto-release (NOT_SCHEDULED = none)
 
     // Choke onset mode state
     ChokeOnset m_onsetMode;       // FREE or QUANTIZED
-    uint64_t m_onsetAtSample;     // Sample position when choke should engage (0 = no scheduled onset)
+    uint64_t m_onsetAtSample;     // Sample position when choke should engage (NOT_SCHEDULED = none)
 };
@@ -0,0 +1,56 @@
+/**
+ * audio_codec.h - SGTL5000 control with the sample rate of the build
+ *
+ * PURPOSE:
+ * AudioControlSGTL5000::enable() always programs the codec for 44.1 kHz.
+ * AudioCodec re-programs the codec clock (CHIP_CLK_CTRL) for
+ * TimeKeeper::SAMPLE_RATE, so the codec's converters run at the rate of
+ * the I2S clocks the Teensy Audio Library derives from
+ * AUDIO_SAMPLE_RATE_EXACT (set by the build to the same rate).
+ *
+ * DESIGN:
+ * - Teensy 4 is I2S master with MCLK = 256 * Fs, so MCLK_FREQ stays 256*Fs
+ *   and only SYS_FS changes; RATE_MODE stays "SYS_FS" (no internal rate
+ *   divider)
+ * - Call after enable() and before routing audio: the register write is a
+ *   plain I2C access (not ISR safe)
+ *
+ * USAGE:
+ *   AudioCodec codec;
+ *   codec.enable();
+ *   codec.setSampleRate(TimeKeeper::SAMPLE_RATE);
+ */
+
+#pragma once
+
+#include <Audio.h>
+#include <stdint.h>
+
+class AudioCodec : public AudioControlSGTL5000 {
+public:
+    /**
+     * Program SYS_FS for `hz` (32000, 44100, 48000 or 96000)
+     *
+     * @return false for an unsupported rate or a failed register write
+     */
+    bool setSampleRate(uint32_t hz) {
+        uint16_t sysFs;
+        switch (hz) {
+            case 32000: sysFs = SYS_FS_32K; break;
+            case 44100: sysFs = SYS_FS_44K1; break;
+            case 48000: sysFs = SYS_FS_48K; break;
+            case 96000: sysFs = SYS_FS_96K; break;
+            default: return false;
+        }
+        return write(CHIP_CLK_CTRL, (sysFs << 2) | MCLK_256FS);
+    }
+
+private:
+    // CHIP_CLK_CTRL: RATE_MODE [5:4] = 0 (SYS_FS), SYS_FS [3:2], MCLK_FREQ [1:0]
+    static constexpr unsigned int CHIP_CLK_CTRL = 0x0004;
+    static constexpr uint16_t SYS_FS_32K = 0;
+    static constexpr uint16_t SYS_FS_44K1 = 1;
+    static constexpr uint16_t SYS_FS_48K = 2;
+    static constexpr uint16_t SYS_FS_96K = 3;
+    static constexpr uint16_t MCLK_256FS = 0;
+};
@@ -0,0 +1,49 @@
+/**
+ * audio_cycle_markers.h - First/last objects of the audio update cycle
+ *
+ * PURPOSE:
+ * Bracket the whole AudioStream update cycle (I2S input and output
+ * included) for DeadlineMonitor, without a DSP stage doing the timing.
+ *
+ * DESIGN:
+ * - The library updates objects in construction order: declare
+ *   AudioCycleStart before every other AudioStream and AudioCycleEnd after
+ *   every other one
+ * - No inputs, no outputs, no connections: they mark themselves active
+ *   (the library only updates objects that are connected otherwise)
+ * - update() is one DeadlineMonitor call each (CYCCNT read + compare)
+ *
+ * USAGE:
+ *   AudioCycleStart cycleStart;  // First AudioStream declared
+ *   AudioInputI2S i2s_in;
+ *   ...
+ *   AudioOutputI2S i2s_out;
+ *   AudioCycleEnd cycleEnd;      // Last AudioStream declared
+ */
+
+#pragma once
+
+#include <Audio.h>
+#include "deadline_monitor.h"
+
+class AudioCycleStart : public AudioStream {
+public:
+    AudioCycleStart() : AudioStream(0, nullptr) {
+        active = true;  // Never connected
+    }
+
+    virtual void update() override {
+        DeadlineMonitor::beginCycle();
+    }
+};
+
+class AudioCycleEnd : public AudioStream {
+public:
+    AudioCycleEnd() : AudioStream(0, nullptr) {
+        active = true;  // Never connected
+    }
+
+    virtual void update() override {
+        DeadlineMonitor::endCycle();
+    }
+};
@@ -2,6 +2,14 @@
 
 #include <Audio.h>
 
+/**
+ * Pending sample-scheduled action (diagnostics only, see DeadlineMonitor)
+ */
+struct ScheduledEvent {
+    const char* label;  // Static string naming the action (e.g. "onset")
+    uint64_t atSample;  // Absolute sample position it will fire at
+};
+
 class AudioEffectBase : public AudioStream {
 public:
     AudioEffectBase(uint8_t numInputs)
@@ -31,6 +39,64 @@ public:
         return 0.0f;
     }
 
+    /**
+     * Quality levels for CPU governor (0 = full quality, higher = cheaper)
+     *
+     * Effects with a degradable knob (grain count, interpolation order,
+     * oversampling...) override these and register with CpuGovernor.
+     * setQualityLevel() is called from the app thread; implementations must
+     * make the switch glitch-free at the next block boundary.
+     */
+    virtual uint8_t getQualityLevelCount() const {
+        // Default: single level (not degradable)
+        return 1;
+    }
+
+    virtual void setQualityLevel(uint8_t level) {
+        // Default: no quality knobs
+        (void)level;  // Suppress unused warning
+    }
+
+    virtual uint8_t getQualityLevel() const {
+        return 0;
+    }
+
+    /**
+     * Diagnostic state for overrun snapshots (called from audio ISR - read only!)
+     *
+     * getStateCode(): effect-specific state (default: 1 = enabled, 0 = disabled)
+     * getScheduledEvents(): pending scheduled actions, returns count written
+     */
+    virtual uint8_t getStateCode() const {
+        return isEnabled() ? 1 : 0;
+    }
+
+    virtual uint8_t getScheduledEvents(ScheduledEvent* out, uint8_t maxEvents) const {
+        // Default: nothing scheduled
+        (void)out;  // Suppress unused warning
+        (void)maxEvents;
+        return 0;
+    }
+
+    /**
+     * No scheduled action fires at or before `sample`, so the state seen now
+     * is the state at that sample. Journal replay hands a press over early
+     * (stamped ahead) only then: the controllers apply a future stamp as
+     * actions scheduled on it.
+     */
+    bool isSettledUntil(uint64_t sample) const {
+        ScheduledEvent events[MAX_SCHEDULED_EVENTS];
+        const uint8_t count = getScheduledEvents(events, MAX_SCHEDULED_EVENTS);
+        for (uint8_t i = 0; i < count; i++) {
+            if (events[i].atSample <= sample) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static constexpr uint8_t MAX_SCHEDULED_EVENTS = 8;  // Most schedule slots of any effect (stutter: 6)
+
 protected:
     audio_block_t* inputQueueArray[2];
 };
@@ -0,0 +1,75 @@
+/**
+ * audio_event_queue.h - Sample-timed commands executed by the audio ISR
+ *
+ * PURPOSE:
+ * Lets a producer schedule effect commands ahead of time and have them take
+ * effect in the audio block that contains their target sample, independent
+ * of when the app thread next runs (sequencers; journal replay goes through
+ * the controllers instead, so the quantize modes apply).
+ *
+ * DESIGN:
+ * - SPSC queue of Commands, cmd.sampleTime = absolute target sample
+ * - Producer: app thread only, posting in time order (the ISR only looks at
+ *   the oldest entry; an out-of-order post waits behind a later one)
+ * - Consumer: AudioTimeKeeper::update() (first of our objects in the cycle)
+ *   calls dispatch() right after advancing the sample counter, so every
+ *   effect updated later in the same cycle sees the new state
+ * - Block-accurate, the same resolution as scheduleOnset()/scheduleRelease()
+ * - Executes ENABLE/DISABLE/TOGGLE on the registered effect directly (atomic
+ *   flag stores in every effect); SET_PARAM and unknown targets are dropped
+ *   and counted - parameter setters are not all ISR-safe
+ * - Commands already in the past fire in the next block (counted as late)
+ * - flush() drops everything still queued (transport START rebases the
+ *   sample position, so old targets would otherwise block the queue); the
+ *   ISR does the draining, keeping the queue single-consumer
+ *
+ * USAGE:
+ *   AudioEventQueue::post(cmd.at(targetSample));    // App thread
+ *   AudioEventQueue::dispatch(blockStartSample);    // Audio ISR
+ */
+
+#pragma once
+
+#include "command.h"
+#include "spsc_queue.h"
+#include <stdint.h>
+
+class AudioEventQueue {
+public:
+    static constexpr size_t QUEUE_SIZE = 64;
+
+    /**
+     * Schedule a command at cmd.sampleTime (app thread)
+     *
+     * @return false if the queue is full or cmd is not stamped (not scheduled)
+     */
+    static bool post(const Command& cmd);
+
+    /**
+     * Execute every command due before blockStart + AUDIO_BLOCK_SAMPLES (audio ISR)
+     */
+    static void dispatch(uint64_t blockStart);
+
+    /**
+     * Drop all pending commands at the next dispatch() (app thread)
+     */
+    static void flush() { s_flushRequested = true; }
+
+    /**
+     * Commands waiting (approximate, monitoring only)
+     */
+    static size_t pending() { return s_queue.size(); }
+
+    static uint32_t getDispatchedCount() { return s_dispatched; }
+    static uint32_t getLateCount() { return s_late; }
+    static uint32_t getRejectedCount() { return s_rejected; }
+
+private:
+    static bool execute(const Command& cmd);
+
+    static SPSCQueue<Command, QUEUE_SIZE> s_queue;
+    static volatile bool s_flushRequested;
+    static volatile uint32_t s_dispatched;  // Executed by the ISR
+    static volatile uint32_t s_late;        // Executed after their target block
+    static volatile uint32_t s_rejected;    // Dropped: queue full, unsupported type or target
+};
@@ -23,8 +23,8 @@ public:
         m_isEnabled.store(false, std::memory_order_relaxed);  // Start disabled (passthrough)
         m_lengthMode = FreezeLength::FREE;  // Default: free mode
         m_onsetMode = FreezeOnset::FREE;    // Default: free mode
-        m_releaseAtSample = 0;  // No scheduled release
-        m_onsetAtSample = 0;    // No scheduled onset
+        m_releaseAtSample = NOT_SCHEDULED;  // No scheduled release
+        m_onsetAtSample = NOT_SCHEDULED;    // No scheduled onset
 
         // Initialize buffers to silence
         memset(m_freezeBufferL, 0, sizeof(m_freezeBufferL));
@@ -58,6 +58,13 @@ public:
         return "Freeze";
     }
 
+    uint8_t getScheduledEvents(ScheduledEvent* out, uint8_t maxEvents) const override {
+        uint8_t count = 0;
+        if (m_onsetAtSample != NOT_SCHEDULED && count < maxEvents) out[count++] = {"onset", m_onsetAtSample};
+        if (m_releaseAtSample != NOT_SCHEDULED && count < maxEvents) out[count++] = {"release", m_releaseAtSample};
+        return count;
+    }
+
     void setLengthMode(FreezeLength mode) {
         m_lengthMode = mode;
     }
@@ -71,7 +78,7 @@ public:
     }
 
     // void cancelScheduledRelease() {
-    //     m_releaseAtSample = 0;
+    //     m_releaseAtSample = NOT_SCHEDULED;
     // }
 
     void scheduleOnset(uint64_t onsetSample) {
@@ -79,7 +86,11 @@ public:
     }
 
     void cancelScheduledOnset() {
-        m_onsetAtSample = 0;
+        m_onsetAtSample = NOT_SCHEDULED;
+    }
+
+    bool isOnsetPending() const {
+        return m_onsetAtSample != NOT_SCHEDULED;
     }
 
     void setOnsetMode(FreezeOnset mode) {
@@ -96,19 +107,19 @@ public:
 
         // Check for scheduled onset (ISR-accurate quantized onset)
         // Fire if the scheduled sample falls within this audio block [currentSample, blockEndSample)
-        if (m_onsetAtSample > 0 && m_onsetAtSample >= currentSample && m_onsetAtSample < blockEndSample) {
+        if (m_onsetAtSample != NOT_SCHEDULED && m_onsetAtSample >= currentSample && m_onsetAtSample < blockEndSample) {
             // Time to engage freeze (block-accurate - best we can do in ISR)
             m_readPos = m_writePos;  // Capture current buffer position
             m_isEnabled.store(true, std::memory_order_release);
-            m_onsetAtSample = 0;  // Clear scheduled onset
+            m_onsetAtSample = NOT_SCHEDULED;  // Clear scheduled onset
         }
 
         // Check for scheduled release (ISR-accurate quantized length)
         // Fire if the scheduled sample falls within this audio block [currentSample, blockEndSample)
-        if (m_releaseAtSample > 0 && m_releaseAtSample >= currentSample && m_releaseAtSample < blockEndSample) {
+        if (m_releaseAtSample != NOT_SCHEDULED && m_releaseAtSample >= currentSample && m_releaseAtSample < blockEndSample) {
             // Time to auto-release (block-accurate)
             m_isEnabled.store(false, std::memory_order_release);
-            m_releaseAtSample = 0;  // Clear scheduled release
+            m_releaseAtSample = NOT_SCHEDULED;  // Clear scheduled release
         }
 
         // Check freeze state
@@ -190,8 +201,8 @@ private:
     /**
      * Calculate buffer size in samples (compile-time constant)
      *
-     * Formula: (milliseconds × 44100 samples/sec) / 1000
-     * Example: 50ms = (50 × 44100) / 1000 = 2205 samples
+     * Formula: (milliseconds × SAMPLE_RATE) / 1000
+     * Example: 50ms = (50 × 44100) / 1000 = 2205 samples (@ 44.1 kHz)
      */
     static constexpr size_t FREEZE_BUFFER_SAMPLES = (FREEZE_BUFFER_MS * TimeKeeper::SAMPLE_RATE) / 1000;
 
@@ -203,11 +214,14 @@ private:
 
     std::atomic<bool> m_isEnabled;
 
+    // Not 0: a downbeat right after START is sample 0
+    static constexpr uint64_t NOT_SCHEDULED = UINT64_MAX;
+
     // Freeze length mode state
     FreezeLength m_lengthMode;        // FREE or QUANTIZED
-    uint64_t m_releaseAtSample;       // Sample position when freeze should auto-release (0 = no scheduled release)
+    uint64_t m_releaseAtSample;       // Sample position when freeze should auto-release (NOT_SCHEDULED = none)
 
     // Freeze onset mode state
     FreezeOnset m_onsetMode;          // FREE or QUANTIZED
-    uint64_t m_onsetAtSample;         // Sample position when freeze should engage (0 = no scheduled onset)
+    uint64_t m_onsetAtSample;         // Sample position when freeze should engage (NOT_SCHEDULED = none)
 };
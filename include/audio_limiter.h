@@ -0,0 +1,256 @@
+/**
+ * audio_limiter.h - Output safety limiter (soft-knee, no lookahead)
+ *
+ * PURPOSE:
+ * Last stage before the codec. Tames full-scale peaks (stutter loops captured
+ * at a transient, summed/feedback paths) so the int16 output never slams
+ * into hard digital clipping.
+ *
+ * DESIGN:
+ * - Stereo-linked: one gain for both channels (no image shift)
+ * - Gain computer runs once per block on the block peak (no per-sample math
+ *   beyond one multiply + saturate)
+ * - Soft knee above threshold: y = T + over * R / (over + R)
+ *   (over = peak - T, R = ceiling - T), so output approaches the ceiling
+ *   asymptotically instead of folding over
+ * - Attack is instant: a lower gain applies flat from the first sample of
+ *   the block, so a transient at sample 0 is already limited. Release is a
+ *   one-pole glide per block, ramped across the block by GainRamp (shared
+ *   with choke); the product is saturated with SSAT so nothing can wrap
+ * - Threshold changes glide per block (SmoothedParam, THRESHOLD_GLIDE_MS)
+ *   instead of stepping the gain
+ * - Bypass (disable()) forwards block pointers untouched: no copy, no scan
+ * - Fast path: at unity gain with peak <= threshold the block is passed
+ *   through unchanged (the common case costs one peak scan)
+ *
+ * QUALITY LEVELS (CpuGovernor):
+ * - 0 (full):  Every sample scanned for the peak, release ramped per sample
+ * - 1 (light): Peak estimated from every 4th sample, gain applied flat per
+ *              block - SSAT still catches any inter-sample peak it misses
+ *
+ * TELEMETRY:
+ * - TELEM_LIMITER_GAIN:          gain at the end of the last block (Q15)
+ * - TELEM_LIMITER_GAIN_MIN:      deepest gain since last reset (Q15)
+ * - TELEM_LIMITER_ACTIVE_BLOCKS: number of blocks with gain reduction
+ *
+ * Not registered with EffectManager (it is a safety stage, not a
+ * performance effect) - controlled directly from main.cpp.
+ */
+
+#pragma once
+
+#include "audio_effect_base.h"
+#include "telemetry.h"
+#include "timekeeper.h"
+#include "smoothed_param.h"
+#include "gain_ramp.h"
+#include <atomic>
+
+class AudioEffectLimiter : public AudioEffectBase {
+public:
+    /**
+     * Parameter indices for setParameter()/getParameter()
+     */
+    static constexpr uint8_t PARAM_THRESHOLD = 0;  // Knee start, linear 0.0-1.0 of full scale
+
+    static constexpr int32_t GAIN_UNITY = 32767;   // Q15
+
+    static constexpr uint8_t QUALITY_FULL = 0;
+    static constexpr uint8_t QUALITY_LIGHT = 1;
+
+    AudioEffectLimiter() : AudioEffectBase(2), m_threshold(DEFAULT_THRESHOLD) {  // Call base with 2 inputs (stereo)
+        m_threshold.setTimeConstantMs(THRESHOLD_GLIDE_MS);
+        m_gain = GAIN_UNITY;
+        m_quality = QUALITY_FULL;
+        m_isEnabled.store(true, std::memory_order_relaxed);  // Safety stage: on by default
+    }
+
+    void enable() override {
+        m_isEnabled.store(true, std::memory_order_release);
+    }
+
+    void disable() override {
+        m_isEnabled.store(false, std::memory_order_release);  // Zero-cost bypass
+    }
+
+    void toggle() override {
+        if (isEnabled()) {
+            disable();
+        } else {
+            enable();
+        }
+    }
+
+    bool isEnabled() const override {
+        return m_isEnabled.load(std::memory_order_acquire);
+    }
+
+    const char* getName() const override {
+        return "Limiter";
+    }
+
+    void setParameter(uint8_t paramIndex, float value) override {
+        if (paramIndex == PARAM_THRESHOLD) {
+            if (value < 0.0f) value = 0.0f;
+            if (value > 1.0f) value = 1.0f;
+            setThreshold(static_cast<int32_t>(value * GAIN_UNITY));
+        }
+    }
+
+    float getParameter(uint8_t paramIndex) const override {
+        if (paramIndex == PARAM_THRESHOLD) {
+            return static_cast<float>(m_threshold.getTarget()) / GAIN_UNITY;
+        }
+        return 0.0f;
+    }
+
+    uint8_t getQualityLevelCount() const override {
+        return 2;
+    }
+
+    void setQualityLevel(uint8_t level) override {
+        m_quality = (level > QUALITY_LIGHT) ? QUALITY_LIGHT : level;
+    }
+
+    uint8_t getQualityLevel() const override {
+        return m_quality;
+    }
+
+    /**
+     * Set knee threshold in int16 units (clamped to MIN_THRESHOLD..CEILING-1).
+     * The ISR glides to it (THRESHOLD_GLIDE_MS), so turning it does not step the gain.
+     */
+    void setThreshold(int32_t threshold) {
+        if (threshold < MIN_THRESHOLD) threshold = MIN_THRESHOLD;
+        if (threshold > CEILING - 1) threshold = CEILING - 1;
+        m_threshold.setTarget(threshold);
+    }
+
+    int32_t getThreshold() const {
+        return m_threshold.getTarget();
+    }
+
+    /**
+     * Current gain (Q15, GAIN_UNITY = no reduction)
+     */
+    int32_t getGain() const {
+        return m_gain;
+    }
+
+    /**
+     * Compute target gain for a block peak (Q15)
+     *
+     * Pure function of (peak, threshold) - public so it can be unit tested.
+     */
+    static inline int32_t computeGain(int32_t peak, int32_t threshold) {
+        if (peak <= threshold) {
+            return GAIN_UNITY;
+        }
+        const int32_t range = CEILING - threshold;
+        const int32_t over = peak - threshold;
+        const int32_t target = threshold + (over * range) / (over + range);
+        return (target << 15) / peak;
+    }
+
+    virtual void update() override {
+        if (!m_isEnabled.load(std::memory_order_acquire)) {
+            // Bypass: forward blocks by reference (no copy, no scan)
+            passThrough(0);
+            passThrough(1);
+            m_gain = GAIN_UNITY;
+            return;
+        }
+
+        audio_block_t* blockL = receiveWritable(0);
+        audio_block_t* blockR = receiveWritable(1);
+
+        // Stereo-linked peak (decimated scan at reduced quality)
+        const bool light = (m_quality != QUALITY_FULL);
+        const size_t stride = light ? LIGHT_SCAN_STRIDE : 1;
+        int32_t peak = 0;
+        if (blockL) peak = blockPeak(blockL->data, peak, stride);
+        if (blockR) peak = blockPeak(blockR->data, peak, stride);
+
+        const int32_t threshold = m_threshold.nextBlock();
+        const int32_t gainStart = m_gain;
+
+        if (gainStart == GAIN_UNITY && peak <= threshold) {
+            // Fast path: nothing to do
+            transmitAndRelease(blockL, 0);
+            transmitAndRelease(blockR, 1);
+            return;
+        }
+
+        // Instant attack, one-pole release (per block)
+        const int32_t target = computeGain(peak, threshold);
+        int32_t gainEnd;
+        if (target < gainStart) {
+            gainEnd = target;
+        } else {
+            const int32_t step = (target - gainStart) >> RELEASE_SHIFT;
+            gainEnd = (step == 0) ? target : gainStart + step;
+        }
+        m_gain = gainEnd;
+
+        // Attack: the new gain from sample 0 (a ramp from the old gain would
+        // let an early transient through and clip it). Release: ramp up, or
+        // hold the old gain flat at reduced quality
+        const int32_t gainLow = (gainEnd < gainStart) ? gainEnd : gainStart;
+        const int32_t rampEnd = light ? gainLow : gainEnd;
+        if (blockL) GainRamp::apply(blockL->data, gainLow, rampEnd);
+        if (blockR) GainRamp::apply(blockR->data, gainLow, rampEnd);
+
+        transmitAndRelease(blockL, 0);
+        transmitAndRelease(blockR, 1);
+
+        Telemetry::set(TELEM_LIMITER_GAIN, static_cast<uint32_t>(gainEnd));
+        Telemetry::updateMin(TELEM_LIMITER_GAIN_MIN, static_cast<uint32_t>(gainEnd));
+        if (gainEnd < GAIN_UNITY) {
+            Telemetry::add(TELEM_LIMITER_ACTIVE_BLOCKS, 1);
+        }
+    }
+
+private:
+    inline void passThrough(uint8_t channel) {
+        audio_block_t* block = receiveReadOnly(channel);
+        if (block) {
+            transmit(block, channel);
+            release(block);
+        }
+    }
+
+    inline void transmitAndRelease(audio_block_t* block, uint8_t channel) {
+        if (block) {
+            transmit(block, channel);
+            release(block);
+        }
+    }
+
+    static inline int32_t blockPeak(const int16_t* data, int32_t peak, size_t stride) {
+        for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES; i += stride) {
+            int32_t s = data[i];
+            if (s < 0) s = -s;  // -32768 -> 32768, still fits int32
+            if (s > peak) peak = s;
+        }
+        return peak;
+    }
+
+    // Limiter parameters
+    static constexpr int32_t CEILING = 32112;            // Asymptotic output ceiling (~-0.18 dBFS)
+    static constexpr int32_t DEFAULT_THRESHOLD = 24576;  // Knee start (~-2.5 dBFS)
+    static constexpr int32_t MIN_THRESHOLD = 4096;       // Keep knee range sane (~-18 dBFS)
+    // Release: 1/16 of remaining per block (~45ms to 1/e); 1/32 at 96 kHz,
+    // where blocks are half as long, to keep the same release time
+    static constexpr int32_t RELEASE_SHIFT = (TimeKeeper::SAMPLE_RATE > 48000) ? 5 : 4;
+    static constexpr size_t LIGHT_SCAN_STRIDE = 4;       // Peak scan decimation at QUALITY_LIGHT
+    static constexpr float THRESHOLD_GLIDE_MS = 30.0f;   // Threshold changes glide (no gain steps)
+
+    // Limiter state (gain modified in audio ISR, threshold set from app thread)
+    SmoothedParam<int32_t> m_threshold;  // Knee threshold (int16 units), set from app thread
+    int32_t m_gain;        // Current gain, Q15 (end of last block)
+    volatile uint8_t m_quality;  // Quality level (set by CpuGovernor from app thread)
+
+    // Effect state (atomic for lock-free cross-thread access)
+    // Note: For limiter, enabled=true means limiting, enabled=false means bypass
+    std::atomic<bool> m_isEnabled;
+};
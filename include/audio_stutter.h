@@ -1,7 +1,11 @@
 #pragma once
 
 #include "audio_effect_base.h"
+#include "overdub_history.h"
+#include "overdub_mix.h"
+#include "smoothed_param.h"
 #include "timekeeper.h"
+#include "wsola_stretch.h"
 #include <atomic>
 #include <Arduino.h>
 
@@ -25,6 +29,11 @@ enum class StutterCaptureEnd : uint8_t {
     QUANTIZED = 1   // End capture at next grid boundary after release
 };
 
+enum class StutterStretch : uint8_t {
+    OFF = 0,        // Play the loop as captured (default)
+    WSOLA = 1       // Time-stretch the loop to follow tempo changes since capture
+};
+
 /**
  * Stutter State Machine (8 states)
  *
@@ -60,30 +69,47 @@ public:
         m_onsetMode = StutterOnset::FREE;    // Default: free mode
         m_captureStartMode = StutterCaptureStart::FREE;    // Default: free mode
         m_captureEndMode = StutterCaptureEnd::FREE;    // Default: free mode
-        m_captureStartAtSample = 0;   // No scheduled capture start
-        m_captureEndAtSample = 0;     // No scheduled capture end
-        m_playbackOnsetAtSample = 0;  // No scheduled playback onset
-        m_playbackLengthAtSample = 0; // No scheduled playback length
+        m_stretchMode = StutterStretch::OFF;
+        m_stretchActive = false;
+        m_captureSpb = 0;
+        clearSchedules();             // Nothing scheduled
         m_stutterHeld = false;        // Track if STUTTER button held (set by controller)
+        m_overdubbing = false;
+        m_overdubFeedback.snap(OverdubMix::FEEDBACK_UNITY);
+        m_overdubFeedback.setTimeConstantMs(FEEDBACK_GLIDE_MS);
 
         // Initialize buffers to silence
         memset(m_stutterBufferL, 0, sizeof(m_stutterBufferL));
         memset(m_stutterBufferR, 0, sizeof(m_stutterBufferR));
+        m_history.begin(m_stutterBufferL, m_stutterBufferR, m_historyPoolL, m_historyPoolR);
+        useCaptureBuffer();
+
+        // Pre-roll ring starts empty
+        m_preRollWrite = 0;
+        m_preRollFill = 0;
+        m_preRollEndSample = 0;
+        m_preRollPaused = false;
+        m_retroBars.store(0, std::memory_order_relaxed);
+        m_retroAtSample = NOT_SCHEDULED;
+        m_retroClaims = 0;
+        m_retroFailures = 0;
     }
 
     // AudioEffectBase interface implementation
     void enable() override {
         // Start playback (used by controller for free onset)
-        m_readPos = 0;  // Start from beginning of captured loop
-        m_state = StutterState::PLAYING;
+        startPlayback();
     }
 
     void disable() override {
         // Stop playback and clear loop
+        clearSchedules();
         m_state = StutterState::IDLE_NO_LOOP;
         m_captureLength = 0;
         m_writePos = 0;
         m_readPos = 0;
+        m_history.reset();
+        useCaptureBuffer();  // Releases a retro loop (the pre-roll resumes)
     }
 
     void toggle() override {
@@ -104,7 +130,25 @@ public:
         return "Stutter";
     }
 
+    uint8_t getStateCode() const override {
+        return static_cast<uint8_t>(m_state);  // StutterState
+    }
+
+    uint8_t getScheduledEvents(ScheduledEvent* out, uint8_t maxEvents) const override {
+        uint8_t count = 0;
+        if (m_captureStartAtSample != NOT_SCHEDULED && count < maxEvents) out[count++] = {"captureStart", m_captureStartAtSample};
+        if (m_captureEndAtSample != NOT_SCHEDULED && count < maxEvents) out[count++] = {"captureEnd", m_captureEndAtSample};
+        if (m_playbackOnsetAtSample != NOT_SCHEDULED && count < maxEvents) out[count++] = {"playbackOnset", m_playbackOnsetAtSample};
+        if (m_playbackLengthAtSample != NOT_SCHEDULED && count < maxEvents) out[count++] = {"playbackStop", m_playbackLengthAtSample};
+        if (m_overdubStartAtSample != NOT_SCHEDULED && count < maxEvents) out[count++] = {"overdubStart", m_overdubStartAtSample};
+        if (m_overdubStopAtSample != NOT_SCHEDULED && count < maxEvents) out[count++] = {"overdubStop", m_overdubStopAtSample};
+        return count;
+    }
+
     // ========== STATE MACHINE CONTROL (called by controller) ==========
+    // Every transition clears the other scheduled slots, so a schedule never
+    // outlives the WAIT state that armed it. Calls that make no sense in the
+    // current state (e.g. playback without a loop) are ignored.
 
     /**
      * Get current state
@@ -113,12 +157,24 @@ public:
         return m_state;
     }
 
+    /**
+     * Loop/buffer positions (read-only, for diagnostics and the host fuzzer)
+     */
+    size_t getCaptureLength() const { return m_captureLength; }
+    size_t getReadPosition() const { return m_readPos; }
+    size_t getWritePosition() const { return m_writePos; }
+    static constexpr size_t getBufferSamples() { return STUTTER_BUFFER_SAMPLES; }
+
     /**
      * Start capture immediately (CaptureStart=Free)
      */
     void startCapture() {
+        clearSchedules();
         m_writePos = 0;  // Reset write position
         m_captureLength = 0;  // Clear previous capture
+        m_history.reset();  // Undo levels belong to the old loop
+        useCaptureBuffer();
+        m_captureSpb = TimeKeeper::getSamplesPerBeat();
         m_state = StutterState::CAPTURING;
     }
 
@@ -126,16 +182,21 @@ public:
      * Schedule capture start (CaptureStart=Quantized)
      */
     void scheduleCaptureStart(uint64_t sample) {
+        clearSchedules();
         m_captureStartAtSample = sample;
         m_state = StutterState::WAIT_CAPTURE_START;
     }
 
     /**
      * Cancel scheduled capture start (STUTTER released during WAIT_CAPTURE_START)
+     * The previous loop (if any) is kept
      */
     void cancelCaptureStart() {
-        m_captureStartAtSample = 0;
-        m_state = StutterState::IDLE_NO_LOOP;
+        if (m_state != StutterState::WAIT_CAPTURE_START) {
+            return;
+        }
+        clearSchedules();
+        m_state = (m_captureLength > 0) ? StutterState::IDLE_WITH_LOOP : StutterState::IDLE_NO_LOOP;
     }
 
     /**
@@ -143,6 +204,10 @@ public:
      * Transitions to PLAYING if STUTTER held, else IDLE_WITH_LOOP
      */
     void endCapture(bool stutterHeld) {
+        if (!isCapturing()) {
+            return;
+        }
+        clearSchedules();
         if (m_writePos > 0) {  // Check we captured something
             m_captureLength = m_writePos;
             if (stutterHeld) {
@@ -161,6 +226,10 @@ public:
      * Schedule capture end (CaptureEnd=Quantized, button released)
      */
     void scheduleCaptureEnd(uint64_t sample, bool stutterHeld) {
+        if (!isCapturing()) {
+            return;
+        }
+        clearSchedules();
         m_captureEndAtSample = sample;
         m_stutterHeld = stutterHeld;  // Remember button state for later transition
         m_state = StutterState::WAIT_CAPTURE_END;
@@ -170,7 +239,12 @@ public:
      * Start playback immediately (Onset=Free)
      */
     void startPlayback() {
+        if (m_captureLength == 0) {
+            return;  // Nothing to play
+        }
+        clearSchedules();
         m_readPos = 0;
+        m_stretchActive = false;
         m_state = StutterState::PLAYING;
     }
 
@@ -178,25 +252,160 @@ public:
      * Schedule playback start (Onset=Quantized)
      */
     void schedulePlaybackOnset(uint64_t sample) {
+        if (m_captureLength == 0) {
+            return;  // Nothing to play
+        }
+        clearSchedules();
         m_playbackOnsetAtSample = sample;
         m_state = StutterState::WAIT_PLAYBACK_ONSET;
     }
 
     /**
      * Stop playback immediately (Length=Free, STUTTER released)
+     * Also cancels a pending onset (released during WAIT_PLAYBACK_ONSET)
      */
     void stopPlayback() {
-        m_state = StutterState::IDLE_WITH_LOOP;
+        clearSchedules();
+        m_state = (m_captureLength > 0) ? StutterState::IDLE_WITH_LOOP : StutterState::IDLE_NO_LOOP;
     }
 
     /**
      * Schedule playback stop (Length=Quantized, STUTTER released)
      */
     void schedulePlaybackLength(uint64_t sample) {
+        if (m_state != StutterState::PLAYING && m_state != StutterState::WAIT_PLAYBACK_LENGTH) {
+            return;
+        }
+        clearSchedules();
         m_playbackLengthAtSample = sample;
         m_state = StutterState::WAIT_PLAYBACK_LENGTH;
     }
 
+    // ========== OVERDUB (called by controller) ==========
+    // Overdub is a layer on top of PLAYING: the live input is mixed into the
+    // loop at the read position (saturating Q15, see overdub_mix.h) and the
+    // mixed result is played. It ends by itself when playback stops.
+    // Each pass can be undone once (see overdub_history.h).
+
+    /**
+     * Start overdubbing now (ignored unless playing, or while an undo/redo
+     * is still being applied)
+     */
+    void startOverdub() {
+        if (m_state != StutterState::PLAYING && m_state != StutterState::WAIT_PLAYBACK_LENGTH) {
+            return;
+        }
+        m_overdubStartAtSample = NOT_SCHEDULED;
+        if (m_overdubbing) {
+            return;
+        }
+        if (m_loopInRing) {
+            m_history.reset();  // No undo for a retro loop (it lives in the pre-roll ring)
+        } else if (!m_history.beginPass()) {
+            return;
+        }
+        m_overdubbing = true;
+    }
+
+    void stopOverdub() {
+        m_overdubStopAtSample = NOT_SCHEDULED;
+        m_overdubbing = false;
+    }
+
+    /**
+     * Schedule overdub start/stop (bar-quantized by the controller); may be
+     * armed together with a playback onset on the same sample
+     */
+    void scheduleOverdubStart(uint64_t sample) {
+        m_overdubStopAtSample = NOT_SCHEDULED;
+        m_overdubStartAtSample = sample;
+    }
+
+    void scheduleOverdubStop(uint64_t sample) {
+        m_overdubStartAtSample = NOT_SCHEDULED;
+        m_overdubStopAtSample = sample;
+    }
+
+    bool isOverdubbing() const { return m_overdubbing; }
+
+    /**
+     * Undo the last overdub pass / redo it again. Applied by the audio ISR
+     * over the next blocks; refused while a pass is running or armed.
+     *
+     * @return true if the request was accepted
+     */
+    bool undoOverdub() {
+        return !overdubActive() && m_history.canUndo() && m_history.requestSwap();
+    }
+
+    bool redoOverdub() {
+        return !overdubActive() && m_history.canRedo() && m_history.requestSwap();
+    }
+
+    bool canUndoOverdub() const { return !overdubActive() && m_history.canUndo(); }
+    bool canRedoOverdub() const { return !overdubActive() && m_history.canRedo(); }
+    bool isHistoryBusy() const { return m_history.busy(); }
+
+    /**
+     * Last pass outgrew the undo pool (mixed, cannot be undone)
+     */
+    bool isUndoUnavailable() const { return m_history.isUnavailable(); }
+
+    /**
+     * Undo pool pages in use (grows with the part of the loop a pass touched)
+     */
+    size_t getHistoryPagesUsed() const { return m_history.getPagesUsed(); }
+    static constexpr size_t getHistoryPoolPages() { return HISTORY_POOL_PAGES; }
+
+    // ========== RETROACTIVE CAPTURE (called by controller) ==========
+    // The input is written to the pre-roll ring on every block, whatever the
+    // state. A retro capture turns the last bars of the ring into the loop
+    // without copying: the loop references ring offsets, and the ring writer
+    // pauses before it would overwrite them. Releasing the loop (clear, new
+    // capture) restarts the pre-roll.
+
+    /**
+     * Claim the `bars` bars before the bar line preceding `atSample` (the
+     * press) and play them at once, in phase with the bar grid. With the
+     * transport stopped, the loop ends at the press and plays from its start.
+     * Applied by the audio ISR on the next block.
+     *
+     * @return false if the pre-roll does not hold that much yet (or no tempo)
+     */
+    bool requestRetroCapture(uint8_t bars, uint64_t atSample) {
+        if (bars == 0 || retroLength(bars) == 0 || retroLength(bars) > getPreRollSamples()) {
+            return false;
+        }
+        m_retroAtSample = atSample;
+        m_retroBars.store(bars, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Samples of continuous input held by the pre-roll ring
+     */
+    size_t getPreRollSamples() const { return m_preRollFill; }
+    static constexpr size_t getPreRollCapacity() { return PREROLL_SAMPLES; }
+
+    bool isLoopInPreRoll() const { return m_loopInRing; }
+    bool isPreRollPaused() const { return m_preRollPaused; }
+    uint32_t getRetroClaimCount() const { return m_retroClaims; }
+    uint32_t getRetroFailureCount() const { return m_retroFailures; }
+
+    /**
+     * Old-layer level kept on each overdub pass (1.0 = no decay). Glides
+     * over FEEDBACK_GLIDE_MS, so changing it during a pass leaves no step.
+     */
+    void setOverdubFeedback(float feedback) {
+        if (feedback < 0.0f) feedback = 0.0f;
+        if (feedback > 1.0f) feedback = 1.0f;
+        m_overdubFeedback.setTarget(static_cast<int32_t>(feedback * OverdubMix::FEEDBACK_UNITY + 0.5f));
+    }
+
+    float getOverdubFeedback() const {
+        return static_cast<float>(m_overdubFeedback.getTarget()) / OverdubMix::FEEDBACK_UNITY;
+    }
+
     // ========== PARAMETER CONTROL ==========
 
     void setLengthMode(StutterLength mode) {
@@ -231,22 +440,71 @@ public:
         return m_captureEndMode;
     }
 
+    /**
+     * Time-stretch playback (see wsola_stretch.h). Engages while playing a
+     * loop of at least WsolaStretch::MIN_LOOP_SAMPLES with a known capture
+     * tempo; an overdub pass plays unstretched (it mixes at loop speed).
+     */
+    void setStretchMode(StutterStretch mode) {
+        m_stretchMode = mode;
+    }
+
+    StutterStretch getStretchMode() const {
+        return m_stretchMode;
+    }
+
+    bool isStretching() const { return m_stretchActive; }
+
+    /**
+     * Current stretch speed (1.0 = as captured; meaningful while stretching)
+     */
+    float getStretchSpeed() const {
+        return static_cast<float>(m_stretch.getSpeed()) / WsolaStretch::SPEED_ONE;
+    }
+
+    /**
+     * CPU governor: the stretch search is the costliest ISR path (see
+     * WsolaStretch quality levels). Applied from the next hop.
+     */
+    uint8_t getQualityLevelCount() const override {
+        return WsolaStretch::QUALITY_LEVELS;
+    }
+
+    void setQualityLevel(uint8_t level) override {
+        m_stretch.setQuality(level);
+    }
+
+    uint8_t getQualityLevel() const override {
+        return m_stretch.getQuality();
+    }
+
+    uint32_t getCaptureSamplesPerBeat() const { return m_captureSpb; }
+
     virtual void update() override {
         uint64_t currentSample = TimeKeeper::getSamplePosition();
         uint64_t blockEndSample = currentSample + AUDIO_BLOCK_SAMPLES;
 
         // ========== CHECK FOR SCHEDULED STATE TRANSITIONS (ISR) ==========
 
+        // Retroactive capture requested by the controller
+        uint8_t retroBars = m_retroBars.exchange(0, std::memory_order_acquire);
+        if (retroBars != 0) {
+            claimRetroLoop(retroBars, m_retroAtSample, currentSample);
+        }
+
         // Check for scheduled capture start
-        if (m_captureStartAtSample > 0 && currentSample >= m_captureStartAtSample && currentSample < blockEndSample) {
+        if (m_captureStartAtSample != NOT_SCHEDULED && currentSample >= m_captureStartAtSample && currentSample < blockEndSample) {
             m_writePos = 0;
             m_captureLength = 0;
+            m_history.reset();
+            useCaptureBuffer();
+            m_captureSpb = TimeKeeper::getSamplesPerBeat();
             m_state = StutterState::CAPTURING;
-            m_captureStartAtSample = 0;
+            m_captureStartAtSample = NOT_SCHEDULED;
         }
 
         // Check for scheduled capture end
-        if (m_captureEndAtSample > 0 && currentSample >= m_captureEndAtSample && currentSample < blockEndSample) {
+        if (m_captureEndAtSample != NOT_SCHEDULED && currentSample >= m_captureEndAtSample && currentSample < blockEndSample) {
             if (m_writePos > 0) {
                 m_captureLength = m_writePos;
                 if (m_stutterHeld) {
@@ -258,22 +516,38 @@ public:
             } else {
                 m_state = StutterState::IDLE_NO_LOOP;
             }
-            m_captureEndAtSample = 0;
+            m_captureEndAtSample = NOT_SCHEDULED;
         }
 
         // Check for scheduled playback onset
-        if (m_playbackOnsetAtSample > 0 && currentSample >= m_playbackOnsetAtSample && currentSample < blockEndSample) {
+        if (m_playbackOnsetAtSample != NOT_SCHEDULED && currentSample >= m_playbackOnsetAtSample && currentSample < blockEndSample) {
             m_readPos = 0;
+            m_stretchActive = false;
             m_state = StutterState::PLAYING;
-            m_playbackOnsetAtSample = 0;
+            m_playbackOnsetAtSample = NOT_SCHEDULED;
         }
 
         // Check for scheduled playback length (stop)
-        if (m_playbackLengthAtSample > 0 && currentSample >= m_playbackLengthAtSample && currentSample < blockEndSample) {
+        if (m_playbackLengthAtSample != NOT_SCHEDULED && currentSample >= m_playbackLengthAtSample && currentSample < blockEndSample) {
             m_state = StutterState::IDLE_WITH_LOOP;
-            m_playbackLengthAtSample = 0;
+            m_playbackLengthAtSample = NOT_SCHEDULED;
         }
 
+        // Check for scheduled overdub start/stop (after onset: may share its sample)
+        if (m_overdubStartAtSample != NOT_SCHEDULED && currentSample >= m_overdubStartAtSample && currentSample < blockEndSample) {
+            startOverdub();
+        }
+        if (m_overdubStopAtSample != NOT_SCHEDULED && currentSample >= m_overdubStopAtSample && currentSample < blockEndSample) {
+            stopOverdub();
+        }
+        if (m_state != StutterState::PLAYING && m_state != StutterState::WAIT_PLAYBACK_LENGTH) {
+            m_overdubbing = false;
+            m_stretchActive = false;
+        }
+
+        // Undo/redo in progress: swap a few more saved chunks ahead of the read head
+        m_history.process(m_readPos, m_captureLength);
+
         // ========== STATE MACHINE AUDIO PROCESSING ==========
 
         switch (m_state) {
@@ -286,6 +560,7 @@ public:
                 audio_block_t* blockR = receiveWritable(1);
 
                 if (blockL && blockR) {
+                    writePreRoll(blockL, blockR, currentSample);
                     transmit(blockL, 0);
                     transmit(blockR, 1);
                 }
@@ -302,6 +577,8 @@ public:
                 audio_block_t* blockR = receiveWritable(1);
 
                 if (blockL && blockR) {
+                    writePreRoll(blockL, blockR, currentSample);
+
                     // Write to buffer if space available
                     for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES && m_writePos < STUTTER_BUFFER_SAMPLES; i++) {
                         m_stutterBufferL[m_writePos] = blockL->data[i];
@@ -319,7 +596,7 @@ public:
                             m_state = StutterState::IDLE_WITH_LOOP;
                         }
                         // Cancel any scheduled capture end
-                        m_captureEndAtSample = 0;
+                        m_captureEndAtSample = NOT_SCHEDULED;
                     }
 
                     // Pass through unmodified
@@ -338,14 +615,53 @@ public:
                 audio_block_t* outL = allocate();
                 audio_block_t* outR = allocate();
 
-                if (outL && outR) {
-                    // Read from captured buffer
-                    for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
-                        outL->data[i] = m_stutterBufferL[m_readPos];
-                        outR->data[i] = m_stutterBufferR[m_readPos];
+                // Live input: mixed into the loop when overdubbing, else discarded
+                audio_block_t* blockL = receiveReadOnly(0);
+                audio_block_t* blockR = receiveReadOnly(1);
+                if (blockL && blockR) {
+                    writePreRoll(blockL, blockR, currentSample);
+                }
+                const bool overdub = m_overdubbing && blockL && blockR;
+                const int32_t feedback = m_overdubFeedback.nextBlock();
+
+                if (outL && outR && useStretch(overdub)) {
+                    // Time-stretched: the loop keeps its pitch and follows the tempo
+                    if (!m_stretchActive) {
+                        m_stretch.reset(m_readPos, m_captureLength);
+                        m_stretchActive = true;
+                    }
+                    m_stretch.setSpeed(m_captureSpb, TimeKeeper::getSamplesPerBeat());
+                    const WsolaStretch::Source src = { m_loopL, m_loopR, m_loopStart, m_loopWrap, m_captureLength };
+                    m_stretch.process(src, outL->data, outR->data, AUDIO_BLOCK_SAMPLES);
+                    m_readPos = m_stretch.getPosition();
 
-                        // Advance read position (loop when reaching end)
-                        m_readPos++;
+                    transmit(outL, 0);
+                    transmit(outR, 1);
+                } else if (outL && outR) {
+                    m_stretchActive = false;
+
+                    // Read (mix first when overdubbing) in runs up to the loop
+                    // end or the end of the backing buffer (pre-roll ring wrap)
+                    size_t i = 0;
+                    while (i < AUDIO_BLOCK_SAMPLES) {
+                        size_t phys = m_loopStart + m_readPos;
+                        if (phys >= m_loopWrap) phys -= m_loopWrap;
+                        size_t run = m_captureLength - m_readPos;
+                        if (run > AUDIO_BLOCK_SAMPLES - i) run = AUDIO_BLOCK_SAMPLES - i;
+                        if (run > m_loopWrap - phys) run = m_loopWrap - phys;
+
+                        if (overdub) {
+                            if (!m_loopInRing) {
+                                m_history.preserve(m_readPos, run);
+                            }
+                            OverdubMix::mix(&m_loopL[phys], &blockL->data[i], run, feedback);
+                            OverdubMix::mix(&m_loopR[phys], &blockR->data[i], run, feedback);
+                        }
+                        memcpy(&outL->data[i], &m_loopL[phys], run * sizeof(int16_t));
+                        memcpy(&outR->data[i], &m_loopR[phys], run * sizeof(int16_t));
+
+                        i += run;
+                        m_readPos += run;
                         if (m_readPos >= m_captureLength) {
                             m_readPos = 0;  // Loop back to start
                         }
@@ -357,10 +673,6 @@ public:
 
                 if (outL) release(outL);
                 if (outR) release(outR);
-
-                // Consume and discard input blocks (not using live audio)
-                audio_block_t* blockL = receiveReadOnly(0);
-                audio_block_t* blockR = receiveReadOnly(1);
                 if (blockL) release(blockL);
                 if (blockR) release(blockR);
                 break;
@@ -370,7 +682,7 @@ public:
 
 private:
     // ========== BUFFER CONFIGURATION ==========
-    // Buffer size: 1 bar @ 70 BPM (min tempo) = ~590KB total (295KB per channel)
+    // Buffer size: 1 bar @ 70 BPM (min tempo) = ~590KB total (295KB per channel) @ 44.1 kHz
     static constexpr uint8_t MIN_TEMPO = 70;
     static constexpr size_t STUTTER_BUFFER_SAMPLES = static_cast<size_t>((1 / (MIN_TEMPO / 60.0)) * TimeKeeper::SAMPLE_RATE) * 4;
 
@@ -380,11 +692,137 @@ private:
     static EXTMEM int16_t m_stutterBufferL[STUTTER_BUFFER_SAMPLES];
     static EXTMEM int16_t m_stutterBufferR[STUTTER_BUFFER_SAMPLES];
 
+    // Overdub undo pool: a page budget of 3/4 of the buffer, used only as far
+    // as a pass reaches. The buffer holds one bar at MIN_TEMPO, so a pass
+    // over a whole one-bar loop stays undoable down to ~94 BPM; a longer
+    // pass is mixed but reports undo unavailable
+    static constexpr size_t HISTORY_POOL_PAGES = overdubHistoryPages(STUTTER_BUFFER_SAMPLES * 3 / 4);
+    using History = OverdubHistory<STUTTER_BUFFER_SAMPLES, HISTORY_POOL_PAGES>;
+    static EXTMEM int16_t m_historyPoolL[History::POOL_SAMPLES];
+    static EXTMEM int16_t m_historyPoolR[History::POOL_SAMPLES];
+
+    // Pre-roll ring: the last PREROLL_BARS bars at the slowest tempo (more
+    // bars at faster tempos), written on every block
+    static constexpr size_t PREROLL_BARS = 8;
+    static constexpr size_t PREROLL_SAMPLES = STUTTER_BUFFER_SAMPLES * PREROLL_BARS;
+    static EXTMEM int16_t m_preRollL[PREROLL_SAMPLES];
+    static EXTMEM int16_t m_preRollR[PREROLL_SAMPLES];
+
+    // Everything above scales with the sample rate: ~6MB @ 44.1 kHz, ~13MB @ 96 kHz
+    static constexpr size_t PSRAM_BYTES = 16UL * 1024 * 1024;
+    static_assert(2 * sizeof(int16_t) * (STUTTER_BUFFER_SAMPLES + History::POOL_SAMPLES + PREROLL_SAMPLES) <= PSRAM_BYTES,
+                  "stutter buffers do not fit in PSRAM at this sample rate");
+
     // ========== BUFFER POSITION STATE ==========
     size_t m_writePos;       // Current write position during capture
     size_t m_readPos;        // Current read position during playback
     size_t m_captureLength;  // Length of captured loop (0 = no loop)
 
+    // Where the loop lives: loop sample n is m_loopL[(m_loopStart + n) % m_loopWrap].
+    // The capture buffer (start 0, no wrap) or a claimed region of the pre-roll ring
+    int16_t* m_loopL;
+    int16_t* m_loopR;
+    size_t m_loopStart;
+    size_t m_loopWrap;
+    bool m_loopInRing;
+
+    void useCaptureBuffer() {
+        m_loopL = m_stutterBufferL;
+        m_loopR = m_stutterBufferR;
+        m_loopStart = 0;
+        m_loopWrap = STUTTER_BUFFER_SAMPLES;
+        m_loopInRing = false;
+    }
+
+    // ========== PRE-ROLL RING ==========
+    size_t m_preRollWrite;         // Next ring index to write
+    size_t m_preRollFill;          // Continuous input held (samples, <= PREROLL_SAMPLES)
+    uint64_t m_preRollEndSample;   // Sample position after the last one written
+    bool m_preRollPaused;          // Writer stopped at a claimed retro loop
+    std::atomic<uint8_t> m_retroBars;  // Pending retro capture (0 = none)
+    uint64_t m_retroAtSample;      // Press position of the pending retro capture (NOT_SCHEDULED = none)
+    uint32_t m_retroClaims;
+    uint32_t m_retroFailures;
+
+    static size_t retroLength(uint8_t bars) {
+        return static_cast<size_t>(bars) * TimeKeeper::getSamplesPerBeat() * TimeKeeper::BEATS_PER_BAR;
+    }
+
+    /**
+     * Append one input block to the ring (ISR). A gap in the sample
+     * position (transport START, missing input, pause) restarts the fill.
+     */
+    void writePreRoll(const audio_block_t* blockL, const audio_block_t* blockR, uint64_t blockStart) {
+        if (blockStart != m_preRollEndSample) {
+            m_preRollFill = 0;
+        }
+
+        // Never overwrite the region a retro loop is playing from
+        m_preRollPaused = false;
+        if (m_loopInRing) {
+            size_t ahead = (m_loopStart + PREROLL_SAMPLES - m_preRollWrite) % PREROLL_SAMPLES;
+            if (ahead < AUDIO_BLOCK_SAMPLES) {
+                m_preRollPaused = true;
+                return;
+            }
+        }
+
+        size_t first = PREROLL_SAMPLES - m_preRollWrite;
+        if (first > AUDIO_BLOCK_SAMPLES) first = AUDIO_BLOCK_SAMPLES;
+        memcpy(&m_preRollL[m_preRollWrite], blockL->data, first * sizeof(int16_t));
+        memcpy(&m_preRollR[m_preRollWrite], blockR->data, first * sizeof(int16_t));
+        if (first < AUDIO_BLOCK_SAMPLES) {
+            memcpy(m_preRollL, &blockL->data[first], (AUDIO_BLOCK_SAMPLES - first) * sizeof(int16_t));
+            memcpy(m_preRollR, &blockR->data[first], (AUDIO_BLOCK_SAMPLES - first) * sizeof(int16_t));
+        }
+
+        m_preRollWrite = (m_preRollWrite + AUDIO_BLOCK_SAMPLES) % PREROLL_SAMPLES;
+        m_preRollEndSample = blockStart + AUDIO_BLOCK_SAMPLES;
+        m_preRollFill += AUDIO_BLOCK_SAMPLES;
+        if (m_preRollFill > PREROLL_SAMPLES) m_preRollFill = PREROLL_SAMPLES;
+    }
+
+    /**
+     * Make the last `bars` bars of the ring the loop and play it (ISR).
+     * No samples are copied: the loop just points into the ring.
+     */
+    void claimRetroLoop(uint8_t bars, uint64_t atSample, uint64_t blockStart) {
+        const size_t length = retroLength(bars);
+        const uint64_t samplesPerBar = static_cast<uint64_t>(TimeKeeper::getSamplesPerBeat()) * TimeKeeper::BEATS_PER_BAR;
+        const bool onGrid = TimeKeeper::isRunning() && samplesPerBar > 0;
+
+        // Loop end: the bar line before the press (or the press itself).
+        // Sample 0 is a real press (first block after START), not "unset"
+        uint64_t end = (atSample != NOT_SCHEDULED) ? atSample : blockStart;
+        if (end > m_preRollEndSample) end = m_preRollEndSample;
+        if (onGrid) end -= end % samplesPerBar;
+
+        const uint64_t oldest = m_preRollEndSample - m_preRollFill;
+        if (length == 0 || length > m_preRollFill || end < oldest + length) {
+            m_retroFailures++;
+            return;
+        }
+
+        clearSchedules();
+        m_overdubbing = false;
+        m_history.reset();
+
+        const size_t back = static_cast<size_t>(m_preRollEndSample - (end - length));
+        m_loopL = m_preRollL;
+        m_loopR = m_preRollR;
+        m_loopStart = (m_preRollWrite + PREROLL_SAMPLES - back) % PREROLL_SAMPLES;
+        m_loopWrap = PREROLL_SAMPLES;
+        m_loopInRing = true;
+
+        m_captureLength = length;
+        m_captureSpb = TimeKeeper::getSamplesPerBeat();
+        m_stretchActive = false;
+        m_writePos = 0;
+        m_readPos = onGrid ? static_cast<size_t>((blockStart - end) % length) : 0;
+        m_state = StutterState::PLAYING;
+        m_retroClaims++;
+    }
+
     // ========== STATE MACHINE ==========
     StutterState m_state;
 
@@ -394,12 +832,51 @@ private:
     StutterCaptureStart m_captureStartMode;  // Capture start mode (FREE or QUANTIZED)
     StutterCaptureEnd m_captureEndMode;      // Capture end mode (FREE or QUANTIZED)
 
+    // ========== TIME-STRETCH ==========
+    StutterStretch m_stretchMode;
+    bool m_stretchActive;    // WSOLA engaged (reset from m_readPos when it engages)
+    uint32_t m_captureSpb;   // Samples per beat when the loop was captured (0 = unknown)
+    WsolaStretch m_stretch;
+
+    bool useStretch(bool overdub) const {
+        return m_stretchMode == StutterStretch::WSOLA && !overdub && m_captureSpb > 0 &&
+               TimeKeeper::getSamplesPerBeat() > 0 && m_captureLength >= WsolaStretch::MIN_LOOP_SAMPLES;
+    }
+
     // ========== SCHEDULED SAMPLE POSITIONS ==========
-    uint64_t m_captureStartAtSample;    // Scheduled capture start (0 = none)
-    uint64_t m_captureEndAtSample;      // Scheduled capture end (0 = none)
-    uint64_t m_playbackOnsetAtSample;   // Scheduled playback onset (0 = none)
-    uint64_t m_playbackLengthAtSample;  // Scheduled playback stop (0 = none)
+    // NOT_SCHEDULED rather than 0: sample 0 is a valid boundary (transport at rest)
+    static constexpr uint64_t NOT_SCHEDULED = UINT64_MAX;
+
+    uint64_t m_captureStartAtSample;    // Scheduled capture start (NOT_SCHEDULED = none)
+    uint64_t m_captureEndAtSample;      // Scheduled capture end (NOT_SCHEDULED = none)
+    uint64_t m_playbackOnsetAtSample;   // Scheduled playback onset (NOT_SCHEDULED = none)
+    uint64_t m_playbackLengthAtSample;  // Scheduled playback stop (NOT_SCHEDULED = none)
+    uint64_t m_overdubStartAtSample;    // Scheduled overdub start (NOT_SCHEDULED = none)
+    uint64_t m_overdubStopAtSample;     // Scheduled overdub stop (NOT_SCHEDULED = none)
+
+    void clearSchedules() {
+        m_captureStartAtSample = NOT_SCHEDULED;
+        m_captureEndAtSample = NOT_SCHEDULED;
+        m_playbackOnsetAtSample = NOT_SCHEDULED;
+        m_playbackLengthAtSample = NOT_SCHEDULED;
+        m_overdubStartAtSample = NOT_SCHEDULED;
+        m_overdubStopAtSample = NOT_SCHEDULED;
+    }
+
+    bool isCapturing() const {
+        return m_state == StutterState::CAPTURING || m_state == StutterState::WAIT_CAPTURE_END;
+    }
 
     // ========== BUTTON STATE TRACKING ==========
     bool m_stutterHeld;  // Is STUTTER button held? (set by controller)
+
+    // ========== OVERDUB ==========
+    bool m_overdubbing;         // Mixing live input into the loop while playing
+    SmoothedParam<int32_t> m_overdubFeedback;  // Q16 old-layer level per pass (FEEDBACK_UNITY = keep)
+    static constexpr float FEEDBACK_GLIDE_MS = 20.0f;
+    History m_history;          // Undo/redo of the last pass
+
+    bool overdubActive() const {
+        return m_overdubbing || m_overdubStartAtSample != NOT_SCHEDULED;
+    }
 };
@@ -3,6 +3,8 @@
 #include <Audio.h>
 #include "timekeeper.h"
 #include "trace.h"
+#include "audio_event_queue.h"
+#include "step_sequencer.h"
 
 class AudioTimeKeeper : public AudioStream {
 public:
@@ -12,6 +14,11 @@ public:
         // Increment sample counter (lock-free atomic operation)
         TimeKeeper::incrementSamples(AUDIO_BLOCK_SAMPLES);
 
+        // Sample-timed commands and sequencer steps due in this block (before
+        // any effect updates)
+        AudioEventQueue::dispatch(TimeKeeper::getSamplePosition());
+        StepSequencer::process(TimeKeeper::getSamplePosition());
+
         // Optional: Trace audio callback (disabled by default - too noisy)
         // TRACE(TRACE_AUDIO_CALLBACK);
 
@@ -8,8 +8,9 @@
  * DESIGN:
  * - Implements IEffectController interface
  * - Owns reference to AudioEffectChoke
- * - Manages parameter editing state (LENGTH, ONSET)
+ * - Manages parameter editing state (LENGTH, ONSET, CURVE, FADE)
  * - Handles free/quantized onset and length modes
+ * - Converts musical fade lengths (fraction of a beat) to samples on engage
  *
  * USAGE:
  *   AudioEffectChoke choke;
@@ -41,9 +42,17 @@ public:
      */
     enum class Parameter : uint8_t {
         LENGTH = 0,  // Choke length (Free, Quantized)
-        ONSET = 1    // Choke onset timing (Free, Quantized)
+        ONSET = 1,   // Choke onset timing (Free, Quantized)
+        CURVE = 2,   // Fade curve (Linear, Equal Power, Exponential)
+        FADE = 3     // Fade length (fixed samples or 1/N beat)
     };
 
+    /**
+     * Fade lengths offered by the encoder menu (beat divisors, 0 = fixed samples)
+     */
+    static constexpr uint8_t FADE_STEP_COUNT = 5;
+    static constexpr uint16_t FADE_STEPS[FADE_STEP_COUNT] = { 0, 64, 32, 16, 8 };
+
     /**
      * Constructor
      *
@@ -67,13 +76,43 @@ public:
      */
     void setCurrentParameter(Parameter param) { m_currentParameter = param; }
 
+    /**
+     * Set fade length in musical units
+     *
+     * Fade becomes 1/beatDivisor of a beat at the tempo current when the
+     * choke engages (e.g. 16 = 1/64 note). Re-evaluated on every press so
+     * it follows tempo changes.
+     *
+     * @param beatDivisor Beat divisor, or 0 to keep the effect's fixed sample length
+     */
+    void setFadeBeatDivisor(uint16_t beatDivisor) { m_fadeBeatDivisor = beatDivisor; }
+
+    /**
+     * Get musical fade divisor (0 = fixed sample length)
+     */
+    uint16_t getFadeBeatDivisor() const { return m_fadeBeatDivisor; }
+
     // Utility functions for bitmap/name mapping
     static BitmapID lengthToBitmap(ChokeLength length);
     static BitmapID onsetToBitmap(ChokeOnset onset);
     static const char* lengthName(ChokeLength length);
     static const char* onsetName(ChokeOnset onset);
+    static const char* curveName(ChokeCurve curve);
+
+    /**
+     * Index of a beat divisor in FADE_STEPS (0 if not listed)
+     */
+    static uint8_t fadeStepIndex(uint16_t beatDivisor);
 
 private:
+    /**
+     * Push musical fade length (if any) to the effect before engaging
+     */
+    void applyMusicalFade();
+
     AudioEffectChoke& m_effect;     // Reference to audio effect (DSP)
     Parameter m_currentParameter;   // Currently selected parameter for editing
+    uint16_t m_fadeBeatDivisor;     // Musical fade length (1/N beat), 0 = fixed samples
+    bool m_shownEnabled;            // Effect state LED/display last reflected
+    bool m_shownSequenced;          // ...and it was a step sequencer gate (not logged)
 };
@@ -0,0 +1,103 @@
+/**
+ * choke_curves.h - Precomputed Q15 fade curves for the choke effect
+ *
+ * PURPOSE:
+ * Gain-vs-position lookup tables so the choke can fade with different
+ * shapes without any transcendental math in the audio ISR.
+ *
+ * DESIGN:
+ * - 65 points per curve (64 segments), Q15 gain (0 = silent, 32767 = unity)
+ * - Position is Q24 (0 = fully muted, POS_ONE = fully open)
+ * - Looked up once per block edge, linearly interpolated between points
+ * - Same table is used for fade-in and fade-out (walked in reverse)
+ *
+ * CURVES:
+ * - LINEAR:      g(x) = x
+ * - EQUAL_POWER: g(x) = sin(x * pi/2)    (constant power through the fade)
+ * - EXPONENTIAL: g(x) = (1000^x - 1) / 999 (dB-linear over 60 dB, exact 0 at start)
+ *
+ * Tables generated offline (Python, round-to-nearest, clamped to 0..32767).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+enum class ChokeCurve : uint8_t {
+    LINEAR = 0,       // Linear gain ramp (default)
+    EQUAL_POWER = 1,  // Sine ramp, smoother perceived level through the fade
+    EXPONENTIAL = 2   // dB-linear ramp, fast tail (punchier cut)
+};
+
+static constexpr uint8_t CHOKE_CURVE_COUNT = 3;
+
+namespace ChokeCurves {
+
+static constexpr uint32_t POS_BITS = 24;
+static constexpr uint32_t POS_ONE = 1UL << POS_BITS;   // Q24 unity position
+static constexpr uint32_t TABLE_SEGMENTS = 64;
+static constexpr uint32_t SEGMENT_SHIFT = POS_BITS - 6; // log2(TABLE_SEGMENTS) = 6
+
+static const int16_t TABLE[CHOKE_CURVE_COUNT][TABLE_SEGMENTS + 1] = {
+    // LINEAR
+    {
+            0,   512,  1024,  1536,  2048,  2560,  3072,  3584,
+         4096,  4608,  5120,  5632,  6144,  6656,  7168,  7680,
+         8192,  8704,  9216,  9728, 10240, 10752, 11264, 11776,
+        12288, 12800, 13312, 13824, 14336, 14848, 15360, 15872,
+        16384, 16895, 17407, 17919, 18431, 18943, 19455, 19967,
+        20479, 20991, 21503, 22015, 22527, 23039, 23551, 24063,
+        24575, 25087, 25599, 26111, 26623, 27135, 27647, 28159,
+        28671, 29183, 29695, 30207, 30719, 31231, 31743, 32255,
+        32767,
+    },
+    // EQUAL_POWER
+    {
+            0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+         6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+        12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+        18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+        23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+        27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+        30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+        32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+        32767,
+    },
+    // EXPONENTIAL
+    {
+            0,     4,     8,    13,    18,    23,    30,    37,
+           45,    54,    64,    75,    87,   101,   116,   133,
+          152,   173,   196,   222,   251,   284,   320,   360,
+          405,   454,   510,   572,   641,   718,   803,   898,
+         1004,  1123,  1254,  1401,  1564,  1746,  1949,  2175,
+         2427,  2707,  3019,  3367,  3755,  4187,  4667,  5203,
+         5800,  6465,  7205,  8030,  8949,  9973, 11113, 12384,
+        13799, 15375, 17131, 19088, 21267, 23694, 26399, 29411,
+        32767,
+    },
+};
+
+/**
+ * Look up Q15 gain at a Q24 fade position
+ *
+ * TIMING: ~10 CPU cycles (2 loads, 1 multiply), called twice per block
+ *
+ * @param curve Curve shape
+ * @param pos   Fade position (0..POS_ONE)
+ * @return Gain in Q15 (0..32767)
+ */
+inline int32_t gainAt(ChokeCurve curve, uint32_t pos) {
+    if (pos >= POS_ONE) {
+        return 32767;
+    }
+
+    const int16_t* table = TABLE[static_cast<uint8_t>(curve) < CHOKE_CURVE_COUNT ? static_cast<uint8_t>(curve) : 0];
+    const uint32_t index = pos >> SEGMENT_SHIFT;
+    const int32_t frac = (pos >> (SEGMENT_SHIFT - 15)) & 0x7FFF;  // Q15 position within segment
+    const int32_t a = table[index];
+    const int32_t b = table[index + 1];
+
+    return a + (((b - a) * frac) >> 15);
+}
+
+}
@@ -0,0 +1,90 @@
+/**
+ * cpu_governor.h - Adaptive audio ISR load governor
+ *
+ * PURPOSE:
+ * Keeps the worst-case audio update below the block period (2.9ms @ 44.1 kHz) by shedding
+ * quality on effects that declare degradable knobs, and giving it back when
+ * headroom returns.
+ *
+ * DESIGN:
+ * - Measurement: AudioStream::cpu_cycles_total_max (worst block, in units of
+ *   64 CPU cycles, maintained by the audio library) is polled and reset once
+ *   per window from the app thread - zero cost in the ISR
+ * - Load is expressed in permille of the block period (1000 = deadline)
+ * - Degrade: one step per window while the worst block exceeds DEGRADE_PERMILLE
+ * - Restore: one step after RESTORE_WINDOWS consecutive windows below
+ *   RESTORE_PERMILLE (hysteresis gap prevents oscillation)
+ * - Order: slots are degraded in registration order (register the effect
+ *   whose quality matters least first) and restored in reverse
+ * - Every change is logged through Trace (TRACE_GOVERNOR_DEGRADE/RESTORE);
+ *   the per-window load goes to telemetry and is traced only when it moves
+ *   by LOAD_TRACE_DELTA_PERMILLE, so idle windows don't evict the trace history
+ *
+ * USAGE:
+ *   CpuGovernor::registerDegradable(&limiter);  // In setup()
+ *   CpuGovernor::update();                      // From app thread loop
+ */
+
+#pragma once
+
+#include "audio_effect_base.h"
+#include <stdint.h>
+
+class CpuGovernor {
+public:
+    static constexpr uint8_t MAX_DEGRADABLE = 8;
+
+    static constexpr uint32_t WINDOW_MS = 100;           // Evaluation window
+    static constexpr uint32_t DEGRADE_PERMILLE = 750;    // Shed quality above 75% of block period
+    static constexpr uint32_t RESTORE_PERMILLE = 500;    // Restore quality below 50%
+    static constexpr uint8_t RESTORE_WINDOWS = 10;       // Headroom must hold for 1s before restoring
+    static constexpr uint32_t LOAD_TRACE_DELTA_PERMILLE = 100;  // Trace load changes of 10% or more
+
+    /**
+     * Register an effect with quality knobs (ignored if it has only one level)
+     *
+     * @return true if registered
+     */
+    static bool registerDegradable(AudioEffectBase* effect);
+
+    /**
+     * Poll ISR load and adjust quality (call from app thread, cheap when idle)
+     */
+    static void update();
+
+    /**
+     * Enable/disable automatic adjustment (disabling restores full quality
+     * within one window; safe to call from any thread)
+     */
+    static void setEnabled(bool enabled);
+
+    static bool isEnabled() { return s_enabled; }
+
+    /**
+     * Worst block load in the last evaluated window (permille of block period)
+     */
+    static uint32_t getLastLoadPermille() { return s_lastLoadPermille; }
+
+    /**
+     * Total quality steps currently shed across all slots (0 = full quality)
+     */
+    static uint8_t getStepsShed();
+
+    /**
+     * Print governor state to Serial (app thread only)
+     */
+    static void printStatus();
+
+private:
+    static uint32_t readAndResetPeakLoad();
+    static bool degradeOneStep();
+    static bool restoreOneStep();
+
+    static AudioEffectBase* s_slots[MAX_DEGRADABLE];
+    static uint8_t s_numSlots;
+    static volatile bool s_enabled;
+    static uint32_t s_lastWindowMs;
+    static uint32_t s_lastLoadPermille;
+    static uint32_t s_tracedLoadPermille;  // Load in the last TRACE_GOVERNOR_LOAD
+    static uint8_t s_quietWindows;
+};
@@ -0,0 +1,156 @@
+/**
+ * deadline_monitor.h - Audio update-cycle watchdog with overrun capture
+ *
+ * PURPOSE:
+ * Leaves evidence behind when the audio ISR misses its deadline. Counts
+ * overruns and, on the first one after arming, freezes a snapshot of the
+ * trace ring, every watched effect's state and its pending scheduled events.
+ *
+ * DESIGN:
+ * - beginCycle()/endCycle() from AudioCycleStart/AudioCycleEnd
+ *   (audio_cycle_markers.h), the first and last objects of the update
+ *   cycle, so the I2S input and output updates are timed too
+ * - Timing via ARM_DWT_CYCCNT (1 load each side, no division in the ISR)
+ * - Two failure signatures:
+ *   OVERRUN:    cycle duration > deadline (default: one block period)
+ *   LATE_START: start-to-start gap > 1.5 block periods (a block was missed,
+ *               e.g. a higher-priority ISR or a long noInterrupts() section)
+ * - Capture happens in the ISR (one ~8KB copy, only once per arm), snapshot
+ *   lives in DMAMEM (OCRAM) so it costs no DTCM
+ * - Dump + re-arm from the main loop (serial console 'o')
+ *
+ * USAGE:
+ *   DeadlineMonitor::watch(&stutter);   // In setup(), any AudioEffectBase
+ *   DeadlineMonitor::begin();
+ *   AudioCycleStart cycleStart;         // First AudioStream declared
+ *   AudioCycleEnd cycleEnd;             // Last AudioStream declared
+ *   DeadlineMonitor::dumpSnapshot();    // Main loop only
+ */
+
+#pragma once
+
+#include "audio_effect_base.h"
+#include "trace.h"
+#include <Arduino.h>
+
+class DeadlineMonitor {
+public:
+    static constexpr uint8_t MAX_WATCHED = 6;
+    static constexpr uint8_t MAX_EVENTS_PER_EFFECT = 4;
+
+    enum class Reason : uint8_t {
+        NONE = 0,
+        OVERRUN = 1,     // Update cycle took longer than the deadline
+        LATE_START = 2   // Update cycle started late (missed block)
+    };
+
+    struct EffectSnapshot {
+        const char* name;
+        bool enabled;
+        uint8_t stateCode;
+        uint8_t numEvents;
+        ScheduledEvent events[MAX_EVENTS_PER_EFFECT];
+    };
+
+    struct Snapshot {
+        Reason reason;
+        uint32_t measuredCycles;    // Duration (OVERRUN) or start-to-start gap (LATE_START)
+        uint32_t budgetCycles;      // One block period at capture time
+        uint32_t timestampUs;       // micros() at capture
+        uint64_t samplePosition;    // TimeKeeper sample position at capture
+        uint32_t overrunCount;      // Counters at capture time
+        uint32_t lateStartCount;
+        uint8_t numEffects;
+        EffectSnapshot effects[MAX_WATCHED];
+        size_t numTraceEvents;
+        TraceEvent trace[Trace::BUFFER_SIZE];
+    };
+
+    /**
+     * Add an effect to the snapshot list (setup only)
+     */
+    static bool watch(AudioEffectBase* effect);
+
+    /**
+     * Compute deadline from CPU clock and arm capture (call after watch())
+     */
+    static void begin();
+
+    /**
+     * Set deadline as permille of the block period (default 1000 = full period)
+     */
+    static void setDeadlinePermille(uint32_t permille);
+
+    /**
+     * Mark start of the audio update cycle (audio ISR)
+     */
+    static inline void beginCycle() {
+        const uint32_t now = ARM_DWT_CYCCNT;
+        if (s_haveLastStart) {
+            const uint32_t gap = now - s_cycleStart;
+            if (gap > s_lateThresholdCycles) {
+                onMiss(Reason::LATE_START, gap);
+            }
+        }
+        s_cycleStart = now;
+        s_haveLastStart = true;
+        s_inCycle = true;
+    }
+
+    /**
+     * Mark end of the audio update cycle (audio ISR)
+     */
+    static inline void endCycle() {
+        if (!s_inCycle) {
+            return;
+        }
+        s_inCycle = false;
+
+        const uint32_t duration = ARM_DWT_CYCCNT - s_cycleStart;
+        if (duration > s_worstCycles) {
+            s_worstCycles = duration;
+        }
+        if (duration > s_deadlineCycles) {
+            onMiss(Reason::OVERRUN, duration);
+        }
+    }
+
+    static uint32_t getOverrunCount() { return s_overrunCount; }
+    static uint32_t getLateStartCount() { return s_lateStartCount; }
+    static uint32_t getWorstCycles() { return s_worstCycles; }
+    static bool hasSnapshot() { return s_captured; }
+
+    /**
+     * Print counters and the frozen snapshot (main loop only)
+     */
+    static void dumpSnapshot();
+
+    /**
+     * Discard snapshot and arm capture for the next miss
+     */
+    static void rearm();
+
+private:
+    static void onMiss(Reason reason, uint32_t cycles);
+    static void capture(Reason reason, uint32_t cycles);
+    static uint32_t cyclesToMicros(uint32_t cycles);
+
+    static AudioEffectBase* s_watched[MAX_WATCHED];
+    static uint8_t s_numWatched;
+
+    static volatile uint32_t s_cycleStart;
+    static volatile bool s_haveLastStart;  // s_cycleStart holds a previous start (any CYCCNT value, 0 included)
+    static volatile bool s_inCycle;
+    static uint32_t s_budgetCycles;
+    static uint32_t s_deadlineCycles;
+    static uint32_t s_lateThresholdCycles;
+    static uint32_t s_deadlinePermille;
+
+    static volatile uint32_t s_overrunCount;
+    static volatile uint32_t s_lateStartCount;
+    static volatile uint32_t s_worstCycles;
+
+    static volatile bool s_armed;
+    static volatile bool s_captured;
+    static Snapshot s_snapshot;
+};
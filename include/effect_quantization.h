@@ -22,6 +22,19 @@ uint32_t calculateQuantizedDuration(Quantization quant);
 
 uint32_t samplesToNextQuantizedBoundary(Quantization quant);
 
+/**
+ * Sample a button action takes effect at: now, or the command's stamp while
+ * that is still ahead (journal replay hands presses over early, so the
+ * controllers schedule the actions on their sample instead of applying
+ * them at once)
+ */
+uint64_t actionSample(const Command& cmd);
+
+/**
+ * First quantize boundary after `at` (the next one from now for a live press)
+ */
+uint64_t quantizedSampleAfter(uint64_t at, Quantization quant);
+
 BitmapID quantizationToBitmap(Quantization quant);
 
 const char* quantizationName(Quantization quant);
@@ -20,6 +20,7 @@ struct EncoderState {
     bool buttonPressed;         // Current button state
     bool buttonLastState;       // Previous button state for edge detection
     uint32_t lastDebounceTime;  // For button debouncing
+    uint64_t lastEventSample;   // Sample position of the last step/press (ISR stamp)
 };
 
 bool begin();
@@ -30,6 +31,9 @@ int32_t getPosition(uint8_t encoderNum);
 
 bool getButton(uint8_t encoderNum);
 
+// Sample position at which the last step or press happened (0 = none yet)
+uint64_t getEventSample(uint8_t encoderNum);
+
 void resetPosition(uint8_t encoderNum);
 
 }
\ No newline at end of file
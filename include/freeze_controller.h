@@ -76,4 +76,6 @@ public:
 private:
     AudioEffectFreeze& m_effect;    // Reference to audio effect (DSP)
     Parameter m_currentParameter;   // Currently selected parameter for editing
+    bool m_shownEnabled;            // Effect state LED/display last reflected
+    bool m_shownSequenced;          // ...and it was a step sequencer gate (not logged)
 };
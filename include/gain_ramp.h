@@ -0,0 +1,42 @@
+/**
+ * gain_ramp.h - Linear Q15 gain ramp across one audio block
+ *
+ * PURPOSE:
+ * Shared by the choke fade and the limiter: both compute a gain at the block
+ * edges (control rate) and interpolate it per sample, so a gain change never
+ * steps inside a block.
+ *
+ * DESIGN:
+ * - Gain is carried in Q15.16 so the per-sample step keeps sub-LSB precision
+ * - Ramps run both ways (fade-out and attack step down): the Q16 scaling is
+ *   a multiply, not a left shift, which is undefined for negative values
+ *   before C++20
+ * - Output saturates to int16 (SSAT on Cortex-M7, one cycle); with gains
+ *   <= 32767 it never triggers, so callers get the plain product
+ *
+ * USAGE:
+ *   GainRamp::apply(block->data, gainStart, gainEnd);  // Q15 gains, 0..32767
+ */
+
+#pragma once
+
+#include <AudioStream.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility/dspinst.h>
+
+namespace GainRamp {
+
+static constexpr int32_t Q16_ONE = 65536;
+
+static inline void apply(int16_t* data, int32_t gainStart, int32_t gainEnd) {
+    int32_t gain = gainStart * Q16_ONE;
+    const int32_t step = ((gainEnd - gainStart) * Q16_ONE) / static_cast<int32_t>(AUDIO_BLOCK_SAMPLES);
+
+    for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+        gain += step;
+        data[i] = static_cast<int16_t>(signed_saturate_rshift(static_cast<int32_t>(data[i]) * (gain >> 16), 16, 15));
+    }
+}
+
+}  // namespace GainRamp
@@ -16,6 +16,9 @@ namespace MidiIO {
 
     bool popEvent(MidiEvent& outEvent);
 
+    // Same, plus the sample position the event arrived at (stamped when parsed)
+    bool popEvent(MidiEvent& outEvent, uint64_t& outSampleTime);
+
     bool popClock(uint32_t& outMicros);
 
     bool running();
@@ -0,0 +1,294 @@
+/**
+ * overdub_history.h - One level of undo/redo for overdub passes (copy-on-write pages)
+ *
+ * PURPOSE:
+ * An overdub pass mixes into the loop buffer in place, so the previous
+ * layer is gone once the pass has run over it. OverdubHistory keeps the
+ * pre-pass content of only the parts the pass actually touched, and can
+ * swap it back (undo) and forth again (redo).
+ *
+ * DESIGN:
+ * - The loop buffer is divided into pages of PAGE_SAMPLES; each page is
+ *   divided into chunks of one audio block. A page table maps a loop page
+ *   to a slot in the pool (POOL_PAGES slots, allocated on first touch), and
+ *   a chunk mask per page records which chunks the slot holds
+ * - Copy-on-write: preserve() runs before every mix and copies the chunks
+ *   about to be written that are not saved yet. The read head moves one
+ *   block per ISR, so a block touches at most two chunks: the copy cost
+ *   per ISR is bounded and spread over the whole pass
+ * - Memory follows the edit, not the loop: a pass over a quarter of the
+ *   loop uses a quarter of the loop's pages. The pool is a page budget
+ *   (POOL_PAGES, static: no heap in the ISR) chosen by the owner, smaller
+ *   than the loop. A pass that outgrows it is still mixed, but the level
+ *   becomes UNAVAILABLE (undo refused, reported) until the next pass
+ * - Undo and redo are the same operation: swap every saved chunk with the
+ *   loop. The swap runs in the audio ISR, SWAP_CHUNKS_PER_BLOCK chunks per
+ *   block, starting at the read head and walking forward. The swap front
+ *   moves faster than the read head, so everything heard after the request
+ *   is already the target layer - there is no mixed old/new playback
+ * - A new pass drops the previous undo/redo level (single level)
+ *
+ * THREADING:
+ * requestSwap() may be called from any thread (it only sets a flag). All
+ * other calls belong to the audio ISR, or to a thread while the owner does
+ * not run the ISR side (reset on capture/clear, like the stutter state).
+ *
+ * USAGE:
+ *   OverdubHistory<LOOP_SAMPLES, POOL_PAGES> history;
+ *   history.begin(loopL, loopR, poolL, poolR);
+ *   // ISR: pass start, then before each mix
+ *   history.beginPass();
+ *   history.preserve(readPos, run);
+ *   // Any thread
+ *   if (history.canUndo()) history.requestSwap();
+ *   // ISR, every block
+ *   history.process(readPos, loopLength);
+ */
+
+#pragma once
+
+#include <AudioStream.h>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+static constexpr size_t OVERDUB_HISTORY_PAGE_SAMPLES = AUDIO_BLOCK_SAMPLES * 16;
+
+/**
+ * Pages covering `samples` (loop page table size; owners size the pool budget with it)
+ */
+static constexpr size_t overdubHistoryPages(size_t samples) {
+    return (samples + OVERDUB_HISTORY_PAGE_SAMPLES - 1) / OVERDUB_HISTORY_PAGE_SAMPLES;
+}
+
+template<size_t LOOP_SAMPLES, size_t POOL_PAGES = overdubHistoryPages(LOOP_SAMPLES)>
+class OverdubHistory {
+public:
+    static constexpr size_t CHUNK_SAMPLES = AUDIO_BLOCK_SAMPLES;
+    static constexpr size_t CHUNKS_PER_PAGE = OVERDUB_HISTORY_PAGE_SAMPLES / AUDIO_BLOCK_SAMPLES;  // uint16_t mask
+    static constexpr size_t PAGE_SAMPLES = OVERDUB_HISTORY_PAGE_SAMPLES;
+    static constexpr size_t LOOP_PAGES = overdubHistoryPages(LOOP_SAMPLES);
+    static constexpr size_t LOOP_CHUNKS = (LOOP_SAMPLES + CHUNK_SAMPLES - 1) / CHUNK_SAMPLES;
+    static constexpr size_t POOL_SAMPLES = POOL_PAGES * PAGE_SAMPLES;  // Per channel
+    static constexpr size_t SWAP_CHUNKS_PER_BLOCK = 4;
+
+    static_assert(POOL_PAGES < 0xFFFF, "pool slot index must fit in uint16_t");
+
+    /**
+     * What the pool holds
+     */
+    enum class Saved : uint8_t {
+        NONE = 0,    // Nothing to undo or redo
+        BEFORE = 1,  // Pre-pass content: undo available
+        AFTER = 2,   // Undone pass: redo available
+        UNAVAILABLE = 3  // Last pass outgrew the pool: mixed, cannot be undone
+    };
+
+    /**
+     * Attach the loop buffer and the pool (pool: POOL_SAMPLES per channel)
+     */
+    void begin(int16_t* loopL, int16_t* loopR, int16_t* poolL, int16_t* poolR) {
+        m_loop[0] = loopL;
+        m_loop[1] = loopR;
+        m_pool[0] = poolL;
+        m_pool[1] = poolR;
+        reset();
+    }
+
+    /**
+     * Forget everything (new loop captured, loop cleared)
+     */
+    void reset() {
+        clearTable();
+        m_saved = Saved::NONE;
+        m_swapping = false;
+        m_swapRequested.store(false, std::memory_order_relaxed);
+    }
+
+    // ========== COPY-ON-WRITE (audio ISR) ==========
+
+    /**
+     * A new overdub pass starts: drops the previous undo/redo level.
+     * Refused while a swap is pending or running.
+     */
+    bool beginPass() {
+        if (busy()) {
+            return false;
+        }
+        clearTable();
+        m_saved = Saved::BEFORE;
+        return true;
+    }
+
+    /**
+     * Save the chunks of [pos, pos + samples) not saved yet in this pass.
+     * Call before mixing into that range.
+     */
+    void preserve(size_t pos, size_t samples) {
+        if (m_saved != Saved::BEFORE || samples == 0) {
+            return;
+        }
+        const size_t last = (pos + samples - 1) / CHUNK_SAMPLES;
+        for (size_t chunk = pos / CHUNK_SAMPLES; chunk <= last && chunk < LOOP_CHUNKS; chunk++) {
+            const size_t page = chunk / CHUNKS_PER_PAGE;
+            const uint16_t bit = static_cast<uint16_t>(1u << (chunk % CHUNKS_PER_PAGE));
+            if (m_mask[page] & bit) {
+                continue;
+            }
+            if (m_slot[page] == NO_SLOT) {
+                if (m_pagesUsed >= POOL_PAGES) {
+                    // Over budget: this pass cannot be undone
+                    clearTable();
+                    m_saved = Saved::UNAVAILABLE;
+                    m_overflows++;
+                    return;
+                }
+                m_slot[page] = static_cast<uint16_t>(m_pagesUsed++);
+            }
+            for (int ch = 0; ch < 2; ch++) {
+                memcpy(poolChunk(ch, page, chunk), loopChunk(ch, chunk), chunkBytes(chunk));
+            }
+            m_mask[page] |= bit;
+            m_savedChunks++;
+        }
+    }
+
+    // ========== UNDO / REDO ==========
+
+    /**
+     * Ask the ISR to swap the saved chunks with the loop (undo when
+     * canUndo(), redo when canRedo())
+     *
+     * @return false if there is nothing saved or a swap is already pending
+     */
+    bool requestSwap() {
+        if (!hasLevel() || busy()) {
+            return false;
+        }
+        m_swapRequested.store(true, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Audio ISR, every block: runs a bounded part of a requested swap
+     *
+     * @param readPos Loop read position (the swap starts here)
+     * @param loopLength Loop length in samples (0 = no loop)
+     */
+    void process(size_t readPos, size_t loopLength) {
+        if (!m_swapping) {
+            if (!m_swapRequested.load(std::memory_order_acquire)) {
+                return;
+            }
+            m_swapRequested.store(false, std::memory_order_relaxed);
+            if (!hasLevel() || loopLength == 0) {
+                return;
+            }
+            memcpy(m_pending, m_mask, sizeof(m_pending));
+            m_pendingChunks = m_savedChunks;
+            m_cursor = readPos / CHUNK_SAMPLES;
+            m_swapping = true;
+        }
+
+        size_t swapped = 0;
+        while (m_pendingChunks > 0 && swapped < SWAP_CHUNKS_PER_BLOCK) {
+            if (m_cursor >= LOOP_CHUNKS) {
+                m_cursor = 0;
+            }
+            const size_t page = m_cursor / CHUNKS_PER_PAGE;
+            if (m_pending[page] == 0) {
+                m_cursor = (page + 1) * CHUNKS_PER_PAGE;  // Skip the page
+                continue;
+            }
+            const uint16_t bit = static_cast<uint16_t>(1u << (m_cursor % CHUNKS_PER_PAGE));
+            if (m_pending[page] & bit) {
+                swapChunk(page, m_cursor);
+                m_pending[page] &= static_cast<uint16_t>(~bit);
+                m_pendingChunks--;
+                swapped++;
+            }
+            m_cursor++;
+        }
+
+        if (m_pendingChunks == 0) {
+            m_saved = (m_saved == Saved::BEFORE) ? Saved::AFTER : Saved::BEFORE;
+            m_swapping = false;
+            m_swaps++;
+        }
+    }
+
+    // ========== STATUS ==========
+
+    bool busy() const { return m_swapping || m_swapRequested.load(std::memory_order_acquire); }
+    bool canUndo() const { return m_saved == Saved::BEFORE && !busy(); }
+    bool canRedo() const { return m_saved == Saved::AFTER && !busy(); }
+    bool isUnavailable() const { return m_saved == Saved::UNAVAILABLE; }
+    Saved getSaved() const { return m_saved; }
+
+    size_t getPagesUsed() const { return m_pagesUsed; }
+    size_t getSavedChunks() const { return m_savedChunks; }
+    uint32_t getSwapCount() const { return m_swaps; }
+    uint32_t getOverflowCount() const { return m_overflows; }
+
+private:
+    static constexpr uint16_t NO_SLOT = 0xFFFF;
+
+    bool hasLevel() const { return m_saved == Saved::BEFORE || m_saved == Saved::AFTER; }
+
+    void clearTable() {
+        for (size_t page = 0; page < LOOP_PAGES; page++) {
+            m_slot[page] = NO_SLOT;
+            m_mask[page] = 0;
+        }
+        m_pagesUsed = 0;
+        m_savedChunks = 0;
+    }
+
+    int16_t* loopChunk(int ch, size_t chunk) const {
+        return m_loop[ch] + chunk * CHUNK_SAMPLES;
+    }
+
+    int16_t* poolChunk(int ch, size_t page, size_t chunk) const {
+        return m_pool[ch] + m_slot[page] * PAGE_SAMPLES + (chunk % CHUNKS_PER_PAGE) * CHUNK_SAMPLES;
+    }
+
+    static size_t chunkBytes(size_t chunk) {
+        // The last chunk of the buffer may be short
+        const size_t start = chunk * CHUNK_SAMPLES;
+        const size_t n = (LOOP_SAMPLES - start < CHUNK_SAMPLES) ? LOOP_SAMPLES - start : CHUNK_SAMPLES;
+        return n * sizeof(int16_t);
+    }
+
+    void swapChunk(size_t page, size_t chunk) {
+        int16_t temp[CHUNK_SAMPLES];
+        const size_t bytes = chunkBytes(chunk);
+        for (int ch = 0; ch < 2; ch++) {
+            int16_t* loop = loopChunk(ch, chunk);
+            int16_t* saved = poolChunk(ch, page, chunk);
+            memcpy(temp, loop, bytes);
+            memcpy(loop, saved, bytes);
+            memcpy(saved, temp, bytes);
+        }
+    }
+
+    int16_t* m_loop[2] = { nullptr, nullptr };
+    int16_t* m_pool[2] = { nullptr, nullptr };
+
+    // Page table (loop page -> pool slot) and saved chunks per page
+    uint16_t m_slot[LOOP_PAGES];
+    uint16_t m_mask[LOOP_PAGES];
+    size_t m_pagesUsed = 0;
+    size_t m_savedChunks = 0;
+    Saved m_saved = Saved::NONE;
+
+    // Swap in progress (ISR only)
+    bool m_swapping = false;
+    uint16_t m_pending[LOOP_PAGES];
+    size_t m_pendingChunks = 0;
+    size_t m_cursor = 0;
+    std::atomic<bool> m_swapRequested{false};
+
+    uint32_t m_swaps = 0;
+    uint32_t m_overflows = 0;
+};
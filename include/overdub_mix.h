@@ -0,0 +1,117 @@
+/**
+ * overdub_mix.h - Saturating Q15 overdub kernel for the stutter loop buffer
+ *
+ * PURPOSE:
+ * Mixes a block of live input into the loop buffer in place:
+ *     loop[i] = sat16(loop[i] * feedback + input[i])
+ * This is the whole per-sample cost of overdubbing, and the loop buffer sits
+ * in PSRAM, so the kernel is shaped around that read-modify-write.
+ *
+ * DESIGN:
+ * - Feedback is Q16 (FEEDBACK_UNITY = 65536 = keep the old layer as is),
+ *   applied with SMULWB/SMULWT: unity is bit-exact, lower values decay the
+ *   older layers a little on every pass
+ * - Two samples per 32-bit word: one load and one store per sample pair,
+ *   SMULWB + SMULWT + PKHBT for the feedback, QADD16 for the saturating add.
+ *   Unrolled to 4 words (8 samples) so the loads are issued back to back -
+ *   PSRAM reads go through the FlexSPI cache in 32-byte lines, and a run
+ *   of sequential loads keeps each line fill busy instead of stalling per
+ *   sample
+ * - Unity feedback skips the multiply (QADD16 only)
+ * - Both pointers must be 4-byte aligned for the packed path (the loop
+ *   length and every block offset are even); anything else, and the odd
+ *   tail, go through the scalar loop
+ * - mixScalar() is the bit-exact reference (tests, benchmarks)
+ *
+ * USAGE:
+ *   OverdubMix::mix(&loopL[readPos], inL->data, n, feedbackQ16);
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utility/dspinst.h>
+
+namespace OverdubMix {
+
+static constexpr int32_t FEEDBACK_UNITY = 65536;  // Q16 1.0
+
+// Sample pair as one word; may_alias because the same memory is also
+// read and written as int16_t
+typedef uint32_t __attribute__((__may_alias__)) SamplePair;
+
+/**
+ * Reference kernel: one sample at a time
+ */
+static inline void mixScalar(int16_t* loop, const int16_t* input, size_t samples, int32_t feedback) {
+    for (size_t i = 0; i < samples; i++) {
+        int32_t decayed = signed_multiply_32x16b(feedback, static_cast<uint16_t>(loop[i]));
+        loop[i] = saturate16(decayed + input[i]);
+    }
+}
+
+/**
+ * Feedback applied to both halves of a packed sample pair
+ */
+static inline uint32_t decayPair(uint32_t pair, int32_t feedback) {
+    int32_t lo = signed_multiply_32x16b(feedback, pair);
+    int32_t hi = signed_multiply_32x16t(feedback, pair);
+    return pack_16b_16b(hi, lo);
+}
+
+/**
+ * Packed kernel (falls back to mixScalar() for unaligned buffers)
+ */
+static inline void mix(int16_t* loop, const int16_t* input, size_t samples, int32_t feedback) {
+    if (((reinterpret_cast<uintptr_t>(loop) | reinterpret_cast<uintptr_t>(input)) & 3) != 0) {
+        mixScalar(loop, input, samples, feedback);
+        return;
+    }
+
+    SamplePair* dst = reinterpret_cast<SamplePair*>(loop);
+    const SamplePair* src = reinterpret_cast<const SamplePair*>(input);
+    size_t words = samples / 2;
+
+    if (feedback >= FEEDBACK_UNITY) {
+        while (words >= 4) {
+            uint32_t a = dst[0], b = dst[1], c = dst[2], d = dst[3];
+            dst[0] = signed_add_16_and_16(a, src[0]);
+            dst[1] = signed_add_16_and_16(b, src[1]);
+            dst[2] = signed_add_16_and_16(c, src[2]);
+            dst[3] = signed_add_16_and_16(d, src[3]);
+            dst += 4;
+            src += 4;
+            words -= 4;
+        }
+        while (words > 0) {
+            *dst = signed_add_16_and_16(*dst, *src);
+            dst++;
+            src++;
+            words--;
+        }
+    } else {
+        while (words >= 4) {
+            uint32_t a = dst[0], b = dst[1], c = dst[2], d = dst[3];
+            dst[0] = signed_add_16_and_16(decayPair(a, feedback), src[0]);
+            dst[1] = signed_add_16_and_16(decayPair(b, feedback), src[1]);
+            dst[2] = signed_add_16_and_16(decayPair(c, feedback), src[2]);
+            dst[3] = signed_add_16_and_16(decayPair(d, feedback), src[3]);
+            dst += 4;
+            src += 4;
+            words -= 4;
+        }
+        while (words > 0) {
+            *dst = signed_add_16_and_16(decayPair(*dst, feedback), *src);
+            dst++;
+            src++;
+            words--;
+        }
+    }
+
+    if (samples & 1) {
+        mixScalar(loop + samples - 1, input + samples - 1, 1, feedback);
+    }
+}
+
+}  // namespace OverdubMix
@@ -0,0 +1,192 @@
+/**
+ * performance_journal.h - Record incoming commands and replay them on the beat grid
+ *
+ * PURPOSE:
+ * Captures a performance (every Command from the input path, with its
+ * source sample stamp) into a RAM journal, then plays it back in sync with
+ * the MIDI clock so a take repeats exactly, bar for bar. The journal can be
+ * serialized to bytes and loaded back.
+ *
+ * DESIGN:
+ * - Position: each entry stores the bar since the recording anchor and the
+ *   phase within that bar (Q24 fraction), computed from the source stamp
+ *   (Command::sampleTime) - not from when the app thread got to it
+ * - Anchor: recording starts at the bar the performer is in; replay starts
+ *   at the next bar line (or now, when started exactly on one)
+ * - Replay: update() (app thread) hands out entries that fall within
+ *   LOOKAHEAD_SAMPLES, stamped with their target sample. Targets use the
+ *   tempo at posting time (steady clock assumed)
+ * - Button presses/releases (STUTTER, FUNC, CHOKE, FREEZE) and looper
+ *   commands go to the controller handler (setControllerHandler()), i.e.
+ *   the same path as a live press, so onset/length quantize modes apply
+ *   again. A press handed over before its target is applied by the
+ *   controller as actions scheduled on that sample (onset, release, capture
+ *   start/end, playback stop...), quantized from there. The handler may
+ *   refuse an entry until the state it depends on has settled; the entries
+ *   after it wait. Without a handler nothing is replayed
+ * - Transport START/STOP ends recording and replay (the sample position
+ *   is rebased on START, so the anchor would no longer mean anything)
+ * - Storage: MAX_ENTRIES * 24 bytes in DMAMEM (OCRAM, off the DTCM budget)
+ *
+ * SERIALIZED FORMAT (little-endian, what both Teensy and host use in memory):
+ *   Header  magic "MLPJ", version, entry size, entry count, length in bars
+ *   Entries raw JournalEntry records
+ *
+ * USAGE:
+ * All calls on the app thread: console keys post JOURNAL_* commands
+ *   PerformanceJournal::startRecording();      // Console 'R' (JOURNAL_RECORD)
+ *   PerformanceJournal::record(cmd);           // Every incoming command
+ *   PerformanceJournal::stopRecording();       // Console 'R' again
+ *   PerformanceJournal::setControllerHandler(handleReplayedCommand);  // AppLogic::begin()
+ *   PerformanceJournal::startReplay(true);     // Console 'P' (JOURNAL_REPLAY), looping
+ *   PerformanceJournal::update();              // App thread loop
+ */
+
+#pragma once
+
+#include "command.h"
+#include <Arduino.h>
+#include <functional>
+#include <AudioStream.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * One recorded command and its musical position
+ */
+struct JournalEntry {
+    Command cmd;         // As received (cmd.sampleTime = source stamp)
+    uint32_t bar;        // Bars since the recording anchor
+    uint32_t barPhase;   // Position within the bar, Q24 (0 = downbeat)
+};
+
+static_assert(sizeof(JournalEntry) == 24, "JournalEntry should be 24 bytes (serialized as-is)");
+static_assert(std::is_trivially_copyable<JournalEntry>::value, "JournalEntry must be trivially copyable");
+
+/**
+ * Takes a replayed controller command (cmd.sampleTime = target sample) on
+ * the app thread; false = not yet, offer it again on the next update()
+ */
+using ControllerHandler = std::function<bool(const Command& cmd)>;
+
+class PerformanceJournal {
+public:
+    static constexpr uint16_t MAX_ENTRIES = 1024;
+    static constexpr uint32_t PHASE_BITS = 24;
+    static constexpr uint32_t LOOKAHEAD_SAMPLES = 4 * AUDIO_BLOCK_SAMPLES;  // ~11.6ms, > app loop period
+    static constexpr uint32_t MAGIC = 0x4A504C4D;  // "MLPJ"
+    static constexpr uint16_t FORMAT_VERSION = 1;
+
+    // ========== RECORDING (app thread) ==========
+
+    /**
+     * Clear the journal and start recording from the current bar
+     *
+     * @return false if the transport is not running (no bar grid)
+     */
+    static bool startRecording();
+
+    /**
+     * Append a command (no-op unless recording)
+     */
+    static void record(const Command& cmd);
+
+    /**
+     * Stop recording; the take length is rounded to the nearest whole bar
+     * (at least one bar, and never shorter than the last entry)
+     */
+    static void stopRecording();
+
+    static bool isRecording() { return s_recording; }
+
+    // ========== REPLAY (app thread) ==========
+
+    /**
+     * Start replay from the next bar line
+     *
+     * @param loop Repeat the take every getLengthBars() bars until stopped
+     * @return false if recording, transport stopped, or nothing replayable
+     */
+    static bool startReplay(bool loop);
+
+    static void stopReplay();
+
+    static bool isReplaying() { return s_replaying; }
+
+    /**
+     * Route replayed button and looper commands to the controllers
+     * (nullptr: not replayed)
+     */
+    static void setControllerHandler(ControllerHandler handler);
+
+    /**
+     * Hand out entries due within LOOKAHEAD_SAMPLES to the controller
+     * handler (call every app loop; cheap when not replaying)
+     */
+    static void update();
+
+    /**
+     * Transport START/STOP: end recording and replay
+     */
+    static void onTransportChange();
+
+    // ========== CONTENTS ==========
+
+    static uint16_t getEntryCount() { return s_count; }
+    static uint32_t getLengthBars() { return s_lengthBars; }
+    static uint32_t getDroppedCount() { return s_dropped; }
+    static const JournalEntry* getEntry(uint16_t index);
+    static void clear();
+
+    // ========== SAVE / LOAD ==========
+
+    static size_t serializedSize();
+
+    /**
+     * Write header + entries to `out`
+     *
+     * @return Bytes written, 0 if `capacity` is too small
+     */
+    static size_t serialize(uint8_t* out, size_t capacity);
+
+    /**
+     * Replace the journal with a serialized one (stops recording/replay)
+     *
+     * @return false (journal unchanged) if the data is not a valid journal
+     */
+    static bool deserialize(const uint8_t* data, size_t size);
+
+    /**
+     * Print the journal to Serial (app thread only)
+     */
+    static void dump();
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t entrySize;
+        uint16_t count;
+        uint16_t reserved;
+        uint32_t lengthBars;
+    };
+
+    static bool isControllerCommand(const Command& cmd);
+    static bool isReplayable(const Command& cmd);
+    static uint32_t samplesPerBar();
+
+    static JournalEntry s_entries[MAX_ENTRIES];
+    static uint16_t s_count;
+    static uint32_t s_lengthBars;
+    static uint32_t s_dropped;  // Commands lost to a full journal
+
+    static bool s_recording;
+    static uint64_t s_recordAnchor;  // Sample of the bar line recording started in
+
+    static bool s_replaying;
+    static bool s_replayLoop;
+    static uint64_t s_replayAnchor;  // Sample of the bar line replay started on
+    static uint16_t s_replayCursor;  // Next entry to post
+    static uint32_t s_replayPass;    // Completed loops
+    static ControllerHandler s_controllerHandler;
+};
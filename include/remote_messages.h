@@ -0,0 +1,211 @@
+/**
+ * remote_messages.h - Binary remote-control protocol: message layouts
+ *
+ * PURPOSE:
+ * The packet layer of the protocol spoken over USB serial by RemoteProtocol
+ * (firmware, remote_protocol.h) and host/tools/microloop_remote (Linux
+ * CLI). Frames are COBS + CRC-16 (utils/cobs.h). Plain C++, no Teensy
+ * headers, so both sides compile the same definitions.
+ *
+ * SESSION:
+ * The USB console is text until it receives a 0x00 byte (the COBS frame
+ * delimiter, never typed by a human): from then on the port carries frames
+ * only. BYE, or IDLE_TIMEOUT_MS without a valid frame, returns to text.
+ * Log messages arrive as LOG packets while a session is open.
+ *
+ * PACKET: [type u8][seq u8][body...]  (multi-byte fields little-endian)
+ * A reply carries the request's seq; unsolicited packets (LOG, streamed
+ * TELEMETRY) carry seq 0.
+ *
+ *   Request           Body                                   Reply
+ *   HELLO             -                                      HELLO_REPLY
+ *   PING              0..MAX_BODY bytes                      PONG (same bytes)
+ *   GET_PARAM         effect u8, param u8                    PARAM
+ *   SET_PARAM         effect u8, param u8, value f32         PARAM (read back)
+ *   COMMAND           type u8, effect u8, param1 u8,         ACK
+ *                     param2 u8, value u32
+ *   TELEMETRY         period ms u16 (0 = one snapshot, stop) TELEMETRY_DATA (then every period)
+ *   TRACE             -                                      TRACE_DATA x n
+ *   BULK_READ         length u32                             BULK_DATA x n
+ *   BYE               -                                      ACK
+ *
+ *   HELLO_REPLY       version u8, sample rate u32, block samples u16,
+ *                     max body u16
+ *   PARAM             effect u8, param u8, value f32
+ *   ACK               status u8 (REMOTE_OK or an error code)
+ *   TELEMETRY_DATA    RemoteTelemetry (TELEMETRY_BYTES)
+ *   TRACE_DATA        first u16, total u16, events x (timestamp u32, id u16,
+ *                     value u16); last chunk when first + count == total
+ *   BULK_DATA         offset u32, bytes (byte i of the stream = i & 0xFF);
+ *                     last chunk when offset + count == length
+ *   LOG               text (one formatted log line, no line ending)
+ *   ERROR             code u8 (bad frame, unknown type, bad length, ...)
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace RemoteMsg {
+
+constexpr uint8_t VERSION = 1;
+constexpr size_t MAX_BODY = 240;              // Body bytes per packet
+constexpr size_t HEADER_BYTES = 2;            // type + seq
+constexpr size_t MAX_PACKET = HEADER_BYTES + MAX_BODY;
+constexpr uint32_t IDLE_TIMEOUT_MS = 5000;    // Session ends without frames for this long
+
+// Effect addresses: EffectID values, plus effects outside EffectManager
+constexpr uint8_t EFFECT_LIMITER = 16;
+
+enum Type : uint8_t {
+    // Requests (host -> device)
+    HELLO = 0x01,
+    PING = 0x02,
+    GET_PARAM = 0x03,
+    SET_PARAM = 0x04,
+    COMMAND = 0x05,
+    TELEMETRY = 0x06,
+    TRACE = 0x07,
+    BULK_READ = 0x08,
+    BYE = 0x09,
+
+    // Replies and unsolicited packets (device -> host)
+    ACK = 0x80,
+    HELLO_REPLY = 0x81,
+    PONG = 0x82,
+    PARAM = 0x83,
+    TELEMETRY_DATA = 0x86,
+    TRACE_DATA = 0x87,
+    BULK_DATA = 0x88,
+    LOG = 0x89,
+    ERROR = 0xFF,
+};
+
+enum Status : uint8_t {
+    OK = 0,
+    ERR_BAD_FRAME = 1,     // Bad COBS stuffing or CRC (seq unknown: 0)
+    ERR_UNKNOWN_TYPE = 2,
+    ERR_BAD_LENGTH = 3,    // Body too short or too long for the type
+    ERR_NO_EFFECT = 4,     // Effect address not exposed
+    ERR_QUEUE_FULL = 5,    // Command/parameter queue full, not posted
+    ERR_BUSY = 6,          // A TRACE/BULK_READ transfer or SET_PARAM is still running
+};
+
+constexpr size_t TRACE_EVENT_BYTES = 8;
+constexpr size_t TRACE_EVENTS_PER_PACKET = (MAX_BODY - 4) / TRACE_EVENT_BYTES;  // 29
+constexpr size_t BULK_BYTES_PER_PACKET = MAX_BODY - 4;                          // 236
+
+// ========== LITTLE-ENDIAN FIELDS ==========
+
+inline void put16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+inline void put32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+inline void putFloat(uint8_t* p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    put32(p, bits);
+}
+
+inline uint16_t get16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t get32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline float getFloat(const uint8_t* p) {
+    const uint32_t bits = get32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+// ========== TELEMETRY SNAPSHOT ==========
+
+constexpr uint8_t MAX_TELEMETRY_EFFECTS = 4;
+
+struct RemoteTelemetry {
+    uint32_t uptimeMs;
+    uint32_t samplePosition;      // Low 32 bits of TimeKeeper's position
+    uint16_t bpmX100;
+    uint8_t transport;            // TimeKeeper::TransportState
+    uint8_t governorSteps;        // Quality steps shed by the CPU governor
+    uint16_t cpuLoadPermille;     // Worst block of the last governor window
+    uint16_t cpuLoadMaxPermille;  // Worst block since boot
+    uint16_t limiterGainQ15;
+    uint8_t audioBlocksUsed;
+    uint8_t audioBlocksMax;
+    uint8_t commandQueueDepth;    // Commands posted to the app thread, not yet handled
+    uint8_t eventQueueDepth;      // Timed commands waiting for the audio ISR
+    uint8_t logPending;           // Messages waiting in the log ring
+    uint8_t effectCount;
+    uint32_t overruns;            // Audio deadline overruns since boot
+    uint32_t logDropped;          // Log messages dropped since boot
+    struct {
+        uint8_t id;               // Effect address
+        uint8_t state;            // getStateCode()
+        uint8_t enabled;
+    } effects[MAX_TELEMETRY_EFFECTS];
+};
+
+constexpr size_t TELEMETRY_BYTES = 32 + 3 * MAX_TELEMETRY_EFFECTS;
+
+inline void packTelemetry(const RemoteTelemetry& t, uint8_t* p) {
+    put32(p + 0, t.uptimeMs);
+    put32(p + 4, t.samplePosition);
+    put16(p + 8, t.bpmX100);
+    p[10] = t.transport;
+    p[11] = t.governorSteps;
+    put16(p + 12, t.cpuLoadPermille);
+    put16(p + 14, t.cpuLoadMaxPermille);
+    put16(p + 16, t.limiterGainQ15);
+    p[18] = t.audioBlocksUsed;
+    p[19] = t.audioBlocksMax;
+    p[20] = t.commandQueueDepth;
+    p[21] = t.eventQueueDepth;
+    p[22] = t.logPending;
+    p[23] = t.effectCount;
+    put32(p + 24, t.overruns);
+    put32(p + 28, t.logDropped);
+    for (uint8_t i = 0; i < MAX_TELEMETRY_EFFECTS; i++) {
+        p[32 + 3 * i] = t.effects[i].id;
+        p[33 + 3 * i] = t.effects[i].state;
+        p[34 + 3 * i] = t.effects[i].enabled;
+    }
+}
+
+inline void unpackTelemetry(const uint8_t* p, RemoteTelemetry& t) {
+    t.uptimeMs = get32(p + 0);
+    t.samplePosition = get32(p + 4);
+    t.bpmX100 = get16(p + 8);
+    t.transport = p[10];
+    t.governorSteps = p[11];
+    t.cpuLoadPermille = get16(p + 12);
+    t.cpuLoadMaxPermille = get16(p + 14);
+    t.limiterGainQ15 = get16(p + 16);
+    t.audioBlocksUsed = p[18];
+    t.audioBlocksMax = p[19];
+    t.commandQueueDepth = p[20];
+    t.eventQueueDepth = p[21];
+    t.logPending = p[22];
+    t.effectCount = p[23];
+    t.overruns = get32(p + 24);
+    t.logDropped = get32(p + 28);
+    for (uint8_t i = 0; i < MAX_TELEMETRY_EFFECTS; i++) {
+        t.effects[i].id = p[32 + 3 * i];
+        t.effects[i].state = p[33 + 3 * i];
+        t.effects[i].enabled = p[34 + 3 * i];
+    }
+}
+
+}  // namespace RemoteMsg
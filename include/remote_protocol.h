@@ -0,0 +1,117 @@
+/**
+ * remote_protocol.h - Binary remote control and telemetry over the USB console
+ *
+ * PURPOSE:
+ * Lets a host program drive and observe the device without a human at the
+ * text console: set/read effect parameters, inject commands, stream a
+ * telemetry snapshot, pull the trace ring and measure link latency and
+ * throughput (host/tools/microloop_remote). Message layouts live in
+ * remote_messages.h, framing (COBS + CRC-16) in utils/cobs.h.
+ *
+ * DESIGN:
+ * - Runs in loop() (the console's thread): no extra thread, no extra stack.
+ *   activate() is called when the console reads a 0x00 byte; from then on
+ *   poll() owns Serial RX until BYE or IDLE_TIMEOUT_MS of silence
+ * - Parameters: SET_PARAM is posted to the app thread (AppLogic::postParameter),
+ *   which owns the effects' control side next to its controllers; poll()
+ *   replies once it was applied, with getParameter()'s read-back. GET_PARAM
+ *   reads directly. One SET_PARAM at a time (ERR_BUSY otherwise)
+ * - Commands: COMMAND is posted to the app thread (AppLogic::postCommand)
+ *   stamped with the current sample position, exactly like a console key
+ * - Transfers: TRACE snapshots the trace ring once (DMAMEM copy) and BULK_READ
+ *   generates a pattern; both are sent FRAMES_PER_POLL packets per poll(),
+ *   so loop() stays responsive and the host sees back-to-back frames
+ * - Log: while a session is open the log thread leaves the ring alone and
+ *   poll() sends each message as a LOG packet (plain text would corrupt
+ *   the frame stream)
+ * - Never blocks loop(): every frame waits for USB TX room. Transfers and
+ *   log messages resume on a later poll(), telemetry ticks are skipped and
+ *   a reply the host is not reading is dropped
+ *
+ * USAGE:
+ *   RemoteProtocol::expose(uint8_t(EffectID::STUTTER), &stutter);  // setup()
+ *   RemoteProtocol::expose(RemoteMsg::EFFECT_LIMITER, &limiter);
+ *   case '\0': RemoteProtocol::activate(); break;                   // Console
+ *   RemoteProtocol::poll();                                          // Every loop()
+ */
+
+#pragma once
+
+#include "audio_effect_base.h"
+#include "remote_messages.h"
+#include "trace.h"
+#include <Arduino.h>
+
+class RemoteProtocol {
+public:
+    static constexpr uint8_t MAX_EXPOSED = RemoteMsg::MAX_TELEMETRY_EFFECTS;
+    static constexpr uint8_t FRAMES_PER_POLL = 8;       // Transfer packets per poll()
+    static constexpr uint8_t LOG_MESSAGES_PER_POLL = 4;
+    static constexpr uint16_t MIN_TELEMETRY_PERIOD_MS = 10;
+
+    /**
+     * Make an effect addressable by GET_PARAM/SET_PARAM and list it in telemetry
+     *
+     * @param address Effect address on the wire (EffectID value or RemoteMsg::EFFECT_*)
+     * @return false if the table is full or the effect is null
+     */
+    static bool expose(uint8_t address, AudioEffectBase* effect);
+
+    /**
+     * Enter binary mode (console read a 0x00 sync byte)
+     */
+    static void activate();
+
+    /**
+     * Session open: Serial RX belongs to poll(), text output must stay off the port
+     */
+    static bool isActive() { return s_active; }
+
+    /**
+     * Receive, dispatch, stream (loop() only, returns at once when inactive)
+     */
+    static void poll();
+
+    /**
+     * Build one telemetry snapshot (also used by tests)
+     */
+    static void collectTelemetry(RemoteMsg::RemoteTelemetry& out);
+
+private:
+    struct Exposed {
+        uint8_t address;
+        AudioEffectBase* effect;
+    };
+
+    static AudioEffectBase* findEffect(uint8_t address);
+    static void deactivate(const char* reason);
+    static void handlePacket(const uint8_t* packet, size_t length);
+    static void send(uint8_t type, uint8_t seq, const uint8_t* body, size_t length);
+    static void sendStatus(uint8_t type, uint8_t seq, uint8_t status);
+    static void sendParam(uint8_t seq, uint8_t address, uint8_t param, float value);
+    static void sendTelemetry(uint8_t seq);
+    static void continueTransfer();
+    static void forwardLog();
+
+    static Exposed s_exposed[MAX_EXPOSED];
+    static uint8_t s_numExposed;
+
+    static bool s_active;
+    static uint32_t s_lastRxMs;
+
+    static uint16_t s_telemetryPeriodMs;  // 0 = not streaming
+    static uint32_t s_lastTelemetryMs;
+
+    // Running TRACE / BULK_READ transfer (one at a time)
+    static uint8_t s_transferType;        // 0 = none
+    static uint8_t s_transferSeq;
+    static uint32_t s_transferOffset;     // Events (TRACE) or bytes (BULK_READ) sent
+    static uint32_t s_transferTotal;
+    static TraceEvent s_traceCopy[Trace::BUFFER_SIZE];
+
+    // SET_PARAM posted to the app thread, reply pending (one at a time)
+    static bool s_setPending;
+    static uint8_t s_setSeq;
+    static uint8_t s_setAddress;
+    static uint8_t s_setParam;
+};
@@ -0,0 +1,170 @@
+/**
+ * smoothed_param.h - Lock-free smoothed parameter (app thread target, audio ISR glide)
+ *
+ * PURPOSE:
+ * A continuous parameter (feedback, threshold, mix, cutoff, grain size) set
+ * from the app thread takes effect at the next block boundary as a step,
+ * which is audible as zipper noise when it is turned. SmoothedParam lets
+ * the app thread post a target and the audio ISR glide towards it.
+ *
+ * DESIGN:
+ * - Target: one atomic value, written by the app thread and read by the ISR.
+ *   No lock, no queue: a newer target simply replaces an older one
+ * - Glide: one-pole per block, value += (target - value) * coef. coef comes
+ *   from a time constant (setTimeConstantMs/Samples(), expf() runs in the
+ *   calling thread, the ISR only multiplies). When the step rounds to zero
+ *   the value snaps to the target, so it always settles exactly
+ * - Per block: nextBlock() returns the value for the whole block (the
+ *   cheapest form, enough for per-block gain computers and mix levels)
+ * - Per sample: after nextBlock(), ramp() interpolates linearly from the
+ *   previous block's value to the new one in Q.16 (the gain ramp scheme of
+ *   choke and limiter), so the value is continuous across blocks
+ * - Fast path: once settled, nextBlock() is one atomic load and a compare;
+ *   blockIsConstant() tells the caller to use its constant-value code
+ *
+ * THREADING:
+ * setTarget() and setTimeConstant*() from any thread (one writer at a
+ * time). nextBlock(), ramp(), value() and blockIsConstant() belong to the
+ * audio ISR. snap() jumps without a glide: ISR, or setup before audio runs.
+ *
+ * USAGE:
+ *   SmoothedParam<int32_t> m_level{FEEDBACK_UNITY};
+ *   m_level.setTimeConstantMs(20.0f);                  // setup
+ *   m_level.setTarget(level);                          // app thread
+ *   // audio ISR, once per block
+ *   const int32_t level = m_level.nextBlock();         // block-constant
+ *   if (!m_level.blockIsConstant()) {
+ *       auto ramp = m_level.ramp();                    // or per sample
+ *       for (...) out[i] = apply(in[i], ramp.next());
+ *   }
+ */
+
+#pragma once
+
+#include <AudioStream.h>
+#include <atomic>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include "timekeeper.h"
+
+template<typename T = int32_t>
+class SmoothedParam {
+    static_assert(std::is_integral<T>::value && sizeof(T) <= sizeof(int32_t),
+                  "SmoothedParam holds integer (fixed-point) values up to 32 bits");
+
+public:
+    static constexpr uint32_t COEF_SHIFT = 16;
+    static constexpr uint32_t COEF_ONE = 1UL << COEF_SHIFT;  // Jump in one block
+
+    explicit SmoothedParam(T initial = 0) {
+        snap(initial);
+    }
+
+    // ========== APP THREAD ==========
+
+    void setTarget(T target) {
+        m_target.store(target, std::memory_order_relaxed);
+    }
+
+    T getTarget() const {
+        return m_target.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Time constant in samples (time to cover 63% of a change); 0 = no glide
+     */
+    void setTimeConstantSamples(float samples) {
+        uint32_t coef = COEF_ONE;
+        if (samples > 0.0f) {
+            const float perBlock = 1.0f - expf(-static_cast<float>(AUDIO_BLOCK_SAMPLES) / samples);
+            coef = static_cast<uint32_t>(perBlock * COEF_ONE + 0.5f);
+            if (coef < 1) coef = 1;
+        }
+        m_coef.store(coef, std::memory_order_relaxed);
+    }
+
+    void setTimeConstantMs(float ms) {
+        setTimeConstantSamples(ms * TimeKeeper::SAMPLE_RATE / 1000.0f);
+    }
+
+    uint32_t getCoefficient() const {
+        return m_coef.load(std::memory_order_relaxed);
+    }
+
+    // ========== AUDIO ISR ==========
+
+    /**
+     * Jump to `value` (target too), no glide
+     */
+    void snap(T value) {
+        m_target.store(value, std::memory_order_relaxed);
+        m_value = value;
+        m_previous = value;
+    }
+
+    /**
+     * Advance one block
+     *
+     * @return Value for this block (block-constant use)
+     */
+    T nextBlock() {
+        m_previous = m_value;
+        const T target = m_target.load(std::memory_order_relaxed);
+        if (m_value == target) {
+            return m_value;
+        }
+
+        const int64_t delta = static_cast<int64_t>(target) - m_value;
+        const int64_t magnitude = delta < 0 ? -delta : delta;
+        const int64_t step = (magnitude * m_coef.load(std::memory_order_relaxed)) >> COEF_SHIFT;
+        if (step == 0 || step >= magnitude) {
+            m_value = target;
+        } else {
+            m_value = static_cast<T>(m_value + (delta < 0 ? -step : step));
+        }
+        return m_value;
+    }
+
+    /**
+     * Per-sample interpolation over the block just advanced
+     */
+    struct Ramp {
+        int64_t acc;   // Q.16
+        int64_t step;  // Q.16 per sample
+
+        T next() {
+            const T v = static_cast<T>(acc >> 16);
+            acc += step;
+            return v;
+        }
+    };
+
+    Ramp ramp(size_t samples = AUDIO_BLOCK_SAMPLES) const {
+        Ramp r;
+        r.acc = static_cast<int64_t>(m_previous) * 65536;
+        r.step = ((static_cast<int64_t>(m_value) - m_previous) * 65536) / static_cast<int64_t>(samples);
+        return r;
+    }
+
+    /**
+     * The block just advanced has one value (previous == current)
+     */
+    bool blockIsConstant() const { return m_previous == m_value; }
+
+    /**
+     * The value has reached the target (nothing left to glide)
+     */
+    bool settled() const { return m_value == m_target.load(std::memory_order_relaxed); }
+
+    T value() const { return m_value; }
+
+private:
+    std::atomic<T> m_target{0};
+    std::atomic<uint32_t> m_coef{COEF_ONE};
+
+    // Audio ISR only
+    T m_value = 0;
+    T m_previous = 0;
+};
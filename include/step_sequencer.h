@@ -0,0 +1,159 @@
+/**
+ * step_sequencer.h - 16/32-step effect trigger sequencer, evaluated in the audio ISR
+ *
+ * PURPOSE:
+ * Plays a pattern of effect gates (one lane each for stutter, freeze and
+ * choke) on the 1/16 note grid. A set step engages its lane's effect; the
+ * first clear step after a run of set steps releases it, so consecutive set
+ * steps tie into one long gate.
+ *
+ * DESIGN:
+ * - Timing: process() runs from AudioTimeKeeper::update() right after the
+ *   sample counter advances, and fires every step boundary that falls in the
+ *   block - independent of app thread load. Step boundaries are computed
+ *   to the sample, but the gate is applied at the start of the block
+ *   holding the boundary: up to AUDIO_BLOCK_SAMPLES - 1 samples (2.9 ms at
+ *   44.1 kHz) early, never late. The effects switch state per block (their
+ *   own scheduled onsets/releases have the same granularity), and splitting
+ *   every block in three effects is not worth a sub-block gain; early
+ *   rather than late keeps a gate ahead of the transient on its step, as
+ *   the quantize lookahead does
+ * - Feedback: the effect calls bypass the controllers (ISR), which pick
+ *   the changes up by edge detection for LEDs and display
+ * - Grid: anchored on the bar line of the sample-domain grid (position
+ *   modulo samples-per-bar, not the MIDI tick grid of
+ *   TimeKeeper::samplesToNextBar(): the ISR needs no tick state); each step
+ *   length is recomputed from the current samples-per-beat, so tempo changes
+ *   bend the grid without drift (beat k of the pattern is always k whole
+ *   beats after the previous one)
+ * - Runs while enabled AND the transport is running; transport STOP (or
+ *   disable) releases every lane the sequencer engaged. START rebases the
+ *   sample position to 0, which is a bar line; the sequencer sees the
+ *   position go backwards and restarts the pattern on the DAW's downbeat
+ * - Pattern: one uint32_t gate bitset per lane + length (13 bytes), written
+ *   by the app thread with single-word stores; the ISR reads a lane word
+ *   once per step, so an edit takes effect on the next step
+ * - Lane actions (all ISR-safe flag/state stores):
+ *     STUTTER  startPlayback() / stopPlayback() - plays the captured loop,
+ *              keeps it on release (no loop captured: step ignored)
+ *     FREEZE   enable() / disable()
+ *     CHOKE    enable() / disable() (fades as for the button)
+ * - The sequencer only releases what it engaged: a lane the performer
+ *   holds is not cut off by an empty step
+ *
+ * USAGE:
+ *   StepSequencer::begin(&stutter, &freeze, &choke);  // AppLogic::begin()
+ *   StepSequencer::setStep(StepSequencer::Lane::CHOKE, 4, true);
+ *   StepSequencer::setEnabled(true);                  // Starts on the next bar line
+ *   StepSequencer::process(blockStart);               // Audio ISR
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+
+class AudioEffectStutter;
+class AudioEffectFreeze;
+class AudioEffectChoke;
+
+/**
+ * Compact pattern: bit n of lanes[l] = lane l gate on step n
+ */
+struct StepPattern {
+    uint32_t lanes[3];
+    uint8_t length;  // 16 or 32 steps
+};
+
+class StepSequencer {
+public:
+    enum class Lane : uint8_t {
+        STUTTER = 0,
+        FREEZE = 1,
+        CHOKE = 2
+    };
+
+    static constexpr uint8_t LANE_COUNT = 3;
+    static constexpr uint8_t MAX_STEPS = 32;
+    static constexpr uint8_t STEPS_PER_BEAT = 4;  // 1/16 notes
+
+    /**
+     * Attach the effects the lanes drive (nullptr = lane silent)
+     */
+    static void begin(AudioEffectStutter* stutter, AudioEffectFreeze* freeze, AudioEffectChoke* choke);
+
+    // ========== TRANSPORT (app thread) ==========
+
+    /**
+     * Start on the next bar line (while the transport runs) or stop and
+     * release held lanes at the next block
+     */
+    static void setEnabled(bool enabled);
+
+    static bool isEnabled() { return s_enabled; }
+
+    /**
+     * Currently stepping (enabled, transport running, anchored)
+     */
+    static bool isPlaying() { return s_playing; }
+
+    /**
+     * Step that fired last (0..length-1), for display/LED feedback
+     */
+    static uint8_t getCurrentStep() { return s_currentStep; }
+
+    /**
+     * Lane currently gated on by the sequencer (controllers use it to tell
+     * sequencer gates from scheduled onsets in their LED/display feedback)
+     */
+    static bool holdsLane(Lane lane) { return (s_engaged >> static_cast<uint8_t>(lane)) & 1U; }
+
+    // ========== PATTERN EDITING (app thread) ==========
+
+    static void setStep(Lane lane, uint8_t step, bool on);
+    static bool getStep(Lane lane, uint8_t step);
+    static void toggleStep(Lane lane, uint8_t step);
+    static void clearLane(Lane lane);
+
+    /**
+     * Pattern length (16 or 32; other values are rejected)
+     */
+    static bool setLength(uint8_t steps);
+    static uint8_t getLength() { return s_pattern.length; }
+
+    static void getPattern(StepPattern& out);
+    static bool setPattern(const StepPattern& pattern);
+
+    static const char* laneName(Lane lane);
+
+    // ========== AUDIO ISR ==========
+
+    /**
+     * Fire every step boundary in [blockStart, blockStart + AUDIO_BLOCK_SAMPLES)
+     */
+    static void process(uint64_t blockStart);
+
+private:
+    static void anchor(uint64_t blockStart, uint32_t samplesPerBeat);
+    static void fireStep(uint8_t step);
+    static void engage(uint8_t lane);
+    static void release(uint8_t lane);
+    static void releaseAll();
+
+    static AudioEffectStutter* s_stutter;
+    static AudioEffectFreeze* s_freeze;
+    static AudioEffectChoke* s_choke;
+
+    static StepPattern s_pattern;
+    static volatile bool s_enabled;
+
+    // ISR state
+    static volatile bool s_playing;
+    static volatile uint8_t s_currentStep;
+    static uint8_t s_nextStep;        // Pattern step fired at s_nextStepAt
+    static uint8_t s_subStep;         // Step within the current beat (0..STEPS_PER_BEAT-1)
+    static uint64_t s_beatStart;      // Sample of the current pattern beat
+    static uint64_t s_nextStepAt;     // Sample of the next step boundary
+    static uint64_t s_lastBlockStart; // Detects the START rebase
+    static volatile uint8_t s_engaged;  // Lanes the sequencer engaged (bit per lane)
+};
@@ -63,6 +63,16 @@ public:
     void updateVisualFeedback() override;
     EffectID getEffectID() const override { return EffectID::STUTTER; }
 
+    /**
+     * Looper commands (LOOP_RECORD / LOOP_OVERDUB / LOOP_CLEAR)
+     *
+     * Record and overdub start/stop land on the next bar line while the
+     * transport runs (immediately when it is stopped).
+     *
+     * @return true if cmd was a looper command
+     */
+    bool handleLoopCommand(const Command& cmd);
+
     /**
      * Get current parameter being edited
      */
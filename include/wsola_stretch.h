@@ -0,0 +1,324 @@
+/**
+ * wsola_stretch.h - WSOLA time-stretch playback of a loop (audio ISR)
+ *
+ * PURPOSE:
+ * Plays a loop faster or slower without changing its pitch, so a loop
+ * captured at one tempo stays on the beat when the tempo moves. Used by
+ * the stutter effect with speed = samples per beat at capture / samples
+ * per beat now (= current tempo / tempo at capture).
+ *
+ * DESIGN (waveform-similarity overlap-add):
+ * - Output is built from grains of GRAIN samples, HOP = GRAIN / 2 apart,
+ *   with a linear crossfade over each HOP: the tail of the previous grain
+ *   fades out while the next grain fades in
+ * - The analysis position advances HOP * speed per HOP of output (Q16, no
+ *   drift). The next grain is not taken exactly there but within +/- SEEK
+ *   of it, where it best matches the continuation of the previous grain
+ *   (normalized cross-correlation), so the crossfade joins similar
+ *   waveforms instead of producing phasing and clicks
+ * - The correlation search runs on a mono, DECIMATE-times decimated copy
+ *   of the search region (coarse lags), then refines +/- (DECIMATE - 1)
+ *   lags around the winner at full rate. It is split into steps and spread
+ *   over the blocks of a hop (SEARCH_STEPS_PER_BLOCK), so the ISR cost is
+ *   even from block to block instead of spiking once per grain
+ * - Quality levels (CPU governor, setQuality() from the app thread): FULL
+ *   searches +/- SEEK and refines; NARROW searches +/- SEEK / 2 without the
+ *   full-rate refine (about half the steps, so half the per-block cost);
+ *   NO_SEARCH takes every grain at its nominal position (plain overlap-add,
+ *   may phase on tonal material). A search runs to its end with the level
+ *   it started with, so a change applies from the next hop without a glitch
+ * - Speed 1.0 with d = 0 winning (ties keep d = 0) reproduces the loop
+ *   bit-exactly, at every quality level
+ * - Loops shorter than MIN_LOOP_SAMPLES cannot hold the search region and
+ *   should be played unstretched
+ *
+ * USAGE:
+ *   WsolaStretch::Source src = { loopL, loopR, start, wrap, length };
+ *   stretch.reset(readPos, length);
+ *   stretch.setSpeed(captureSpb, currentSpb);
+ *   stretch.process(src, outL, outR, AUDIO_BLOCK_SAMPLES);   // every block
+ *   readPos = stretch.getPosition();
+ */
+
+#pragma once
+
+#include <AudioStream.h>
+#include <stddef.h>
+#include <stdint.h>
+
+class WsolaStretch {
+public:
+    static constexpr size_t GRAIN = 1024;             // ~23 ms
+    static constexpr size_t HOP = GRAIN / 2;          // Output samples per grain
+    static constexpr uint32_t HOP_SHIFT = 9;          // log2(HOP)
+    static constexpr size_t SEEK = 256;               // Search range +/- (samples)
+    static constexpr size_t DECIMATE = 4;             // Search decimation
+    static constexpr size_t MIN_LOOP_SAMPLES = GRAIN + 2 * SEEK;
+
+    static constexpr uint32_t SPEED_ONE = 1UL << 16;  // Q16
+    static constexpr uint32_t SPEED_MIN = SPEED_ONE / 2;
+    static constexpr uint32_t SPEED_MAX = SPEED_ONE * 2;
+
+    static constexpr size_t TARGET_POINTS = HOP / DECIMATE;                     // 128
+    static constexpr size_t COARSE_LAGS = 2 * SEEK / DECIMATE + 1;              // 129
+    static constexpr size_t REGION_POINTS = COARSE_LAGS + TARGET_POINTS - 1;    // 256
+    static constexpr size_t FINE_LAGS = 2 * (DECIMATE - 1);                     // 6
+    static constexpr size_t SEARCH_STEPS = 1 + COARSE_LAGS + FINE_LAGS;         // + region build
+    static constexpr size_t BLOCKS_PER_HOP = HOP / AUDIO_BLOCK_SAMPLES;
+    static constexpr size_t SEARCH_STEPS_PER_BLOCK = (SEARCH_STEPS + BLOCKS_PER_HOP - 1) / BLOCKS_PER_HOP;
+
+    // Quality levels (0 = full quality, higher = cheaper)
+    static constexpr uint8_t QUALITY_FULL = 0;
+    static constexpr uint8_t QUALITY_NARROW = 1;     // +/- SEEK / 2, no refine
+    static constexpr uint8_t QUALITY_NO_SEARCH = 2;  // Nominal positions only
+    static constexpr uint8_t QUALITY_LEVELS = 3;
+
+    /**
+     * Loop being played: sample n is left[(start + n) % wrap], n < length
+     */
+    struct Source {
+        const int16_t* left;
+        const int16_t* right;
+        size_t start;
+        size_t wrap;
+        size_t length;
+    };
+
+    /**
+     * Start (or restart) at loop sample `position`
+     */
+    void reset(size_t position, size_t length) {
+        m_length = length;
+        m_nominal = static_cast<uint64_t>(position) << 16;
+        m_prevPos = position;
+        m_curPos = position;  // First hop: both grains at the same place (plain read)
+        m_offset = 0;
+        m_lastOffset = 0;
+        m_searchStep = 0;
+        m_searchSteps = 0;  // Search starts with the first process()
+        m_searchPending = true;
+    }
+
+    /**
+     * Search quality for the next hops (app thread; clamped to NO_SEARCH)
+     */
+    void setQuality(uint8_t level) {
+        m_quality = (level > QUALITY_NO_SEARCH) ? QUALITY_NO_SEARCH : level;
+    }
+
+    uint8_t getQuality() const { return m_quality; }
+
+    /**
+     * Speed from samples per beat at capture and now (clamped to 0.5..2.0)
+     */
+    void setSpeed(uint32_t captureSpb, uint32_t currentSpb) {
+        uint32_t speed = SPEED_ONE;
+        if (captureSpb > 0 && currentSpb > 0) {
+            uint64_t q = (static_cast<uint64_t>(captureSpb) << 16) / currentSpb;
+            speed = (q < SPEED_MIN) ? SPEED_MIN : (q > SPEED_MAX) ? SPEED_MAX : static_cast<uint32_t>(q);
+        }
+        m_speed = speed;
+    }
+
+    uint32_t getSpeed() const { return m_speed; }
+
+    /**
+     * Loop position being played (follows the nominal analysis position)
+     */
+    size_t getPosition() const {
+        uint64_t pos = (m_nominal + static_cast<uint64_t>(m_offset) * m_speed) >> 16;
+        return m_length > 0 ? static_cast<size_t>(pos % m_length) : 0;
+    }
+
+    /**
+     * Render n samples (audio ISR)
+     */
+    void process(const Source& src, int16_t* outL, int16_t* outR, size_t n) {
+        if (m_searchPending) {
+            beginSearch();
+        }
+        runSearch(src, m_stepsPerBlock);
+
+        for (size_t i = 0; i < n; i++) {
+            const int32_t t = static_cast<int32_t>(m_offset);
+            const int32_t fadeOut = static_cast<int32_t>(HOP) - t;
+            const size_t a = phys(src, m_prevPos + m_offset);
+            const size_t b = phys(src, m_curPos + m_offset);
+            outL[i] = static_cast<int16_t>((src.left[a] * fadeOut + src.left[b] * t) >> HOP_SHIFT);
+            outR[i] = static_cast<int16_t>((src.right[a] * fadeOut + src.right[b] * t) >> HOP_SHIFT);
+
+            if (++m_offset == HOP) {
+                nextHop(src);
+            }
+        }
+    }
+
+    /**
+     * Search offset chosen for the current grain (diagnostics, tests)
+     */
+    int32_t getLastOffset() const { return m_lastOffset; }
+
+private:
+    // ========== POSITIONS ==========
+
+    size_t wrapLoop(size_t n) const {
+        return n % m_length;
+    }
+
+    size_t phys(const Source& src, size_t n) const {
+        size_t p = src.start + wrapLoop(n);
+        return (p >= src.wrap) ? p - src.wrap : p;
+    }
+
+    int32_t mono(const Source& src, size_t n) const {
+        size_t p = phys(src, n);
+        return (static_cast<int32_t>(src.left[p]) + src.right[p]) >> 1;
+    }
+
+    void nextHop(const Source& src) {
+        // Finish the search if the hop was shorter than planned
+        runSearch(src, SEARCH_STEPS);
+        m_prevPos = wrapLoop(m_curPos + HOP);  // Continuation of the current grain
+        m_curPos = m_nextPos;
+        m_nominal = m_nextNominal;
+        m_offset = 0;
+        m_searchPending = true;
+    }
+
+    // ========== SIMILARITY SEARCH ==========
+    // Step 0 builds the decimated target (what the current grain continues
+    // with) and search region; steps 1..m_lagCount try the decimated lags,
+    // the rest refine around the best one at full rate. The quality level
+    // is latched here: the lag range and refine steps hold for the hop.
+
+    void beginSearch() {
+        m_searchPending = false;
+        m_nextNominal = (m_nominal + static_cast<uint64_t>(HOP) * m_speed) % (static_cast<uint64_t>(m_length) << 16);
+        m_searchStep = 0;
+
+        const uint8_t quality = m_quality;
+        if (quality == QUALITY_NO_SEARCH) {
+            m_searchSteps = 0;
+            m_lastOffset = 0;
+            m_nextPos = wrapLoop(static_cast<size_t>(m_nextNominal >> 16));
+            return;
+        }
+        const bool narrow = (quality == QUALITY_NARROW);
+        m_lagFirst = narrow ? (COARSE_LAGS - 1) / 4 : 0;               // Centered on d = 0
+        m_lagCount = narrow ? (COARSE_LAGS - 1) / 2 + 1 : COARSE_LAGS;
+        m_searchSteps = 1 + m_lagCount + (narrow ? 0 : FINE_LAGS);
+        m_stepsPerBlock = (m_searchSteps + BLOCKS_PER_HOP - 1) / BLOCKS_PER_HOP;
+    }
+
+    void runSearch(const Source& src, size_t steps) {
+        while (steps-- > 0 && m_searchStep < m_searchSteps) {
+            searchStep(src, m_searchStep++);
+        }
+    }
+
+    void searchStep(const Source& src, size_t step) {
+        const size_t nominal = static_cast<size_t>(m_nextNominal >> 16);
+        const size_t regionStart = nominal + m_length - SEEK;  // Kept positive (wrapped on read)
+
+        if (step == 0) {
+            const size_t target = m_curPos + HOP;
+            for (size_t i = 0; i < TARGET_POINTS; i++) {
+                m_target[i] = static_cast<int16_t>(mono(src, target + i * DECIMATE));
+            }
+            for (size_t i = 0; i < REGION_POINTS; i++) {
+                m_region[i] = static_cast<int16_t>(mono(src, regionStart + i * DECIMATE));
+            }
+            // Start from d = 0 so ties (and silence) keep the nominal position
+            m_bestLag = static_cast<int32_t>(SEEK);
+            m_bestScore = scoreDecimated(SEEK / DECIMATE);
+            return;
+        }
+
+        if (step <= m_lagCount) {
+            const size_t j = m_lagFirst + step - 1;
+            const float score = scoreDecimated(j);
+            if (score > m_bestScore) {
+                m_bestScore = score;
+                m_bestLag = static_cast<int32_t>(j * DECIMATE);
+            }
+            if (step == m_lagCount) {
+                m_coarseLag = m_bestLag;
+            }
+        } else {
+            // Fine: coarse -3..-1, +1..+3
+            const int32_t k = static_cast<int32_t>(step - m_lagCount - 1);  // 0..5
+            const int32_t delta = (k < static_cast<int32_t>(DECIMATE - 1)) ? k - static_cast<int32_t>(DECIMATE - 1)
+                                                                           : k - static_cast<int32_t>(DECIMATE - 2);
+            const int32_t lag = m_coarseLag + delta;
+            if (lag >= 0 && lag <= static_cast<int32_t>(2 * SEEK)) {
+                const float score = scoreFull(src, regionStart + static_cast<size_t>(lag));
+                if (score > m_bestScore) {
+                    m_bestScore = score;
+                    m_bestLag = lag;
+                }
+            }
+        }
+
+        if (step == m_searchSteps - 1) {
+            m_lastOffset = m_bestLag - static_cast<int32_t>(SEEK);
+            m_nextPos = wrapLoop(regionStart + static_cast<size_t>(m_bestLag));
+        }
+    }
+
+    static float normalized(int64_t corr, int64_t energy) {
+        // corr * |corr| / energy: same order as corr / sqrt(energy), no sqrt
+        if (energy <= 0) {
+            return 0.0f;
+        }
+        const float c = static_cast<float>(corr);
+        return c * (c < 0.0f ? -c : c) / static_cast<float>(energy);
+    }
+
+    float scoreDecimated(size_t j) const {
+        int64_t corr = 0;
+        int64_t energy = 0;
+        for (size_t i = 0; i < TARGET_POINTS; i++) {
+            const int32_t x = m_region[j + i];
+            corr += static_cast<int32_t>(m_target[i]) * x;
+            energy += x * x;
+        }
+        return normalized(corr, energy);
+    }
+
+    float scoreFull(const Source& src, size_t candidate) const {
+        int64_t corr = 0;
+        int64_t energy = 0;
+        for (size_t i = 0; i < TARGET_POINTS; i++) {
+            const int32_t x = mono(src, candidate + i * DECIMATE);
+            corr += static_cast<int32_t>(m_target[i]) * x;
+            energy += x * x;
+        }
+        return normalized(corr, energy);
+    }
+
+    // ========== STATE ==========
+    size_t m_length = 0;
+    uint32_t m_speed = SPEED_ONE;
+
+    uint64_t m_nominal = 0;      // Q16 analysis position of the current grain
+    size_t m_prevPos = 0;        // Fading-out grain (loop position at offset 0)
+    size_t m_curPos = 0;         // Fading-in grain
+    size_t m_offset = 0;         // Output position within the hop
+
+    // Search for the next grain
+    volatile uint8_t m_quality = QUALITY_FULL;  // Written by the app thread
+    bool m_searchPending = true;
+    size_t m_searchStep = 0;
+    size_t m_searchSteps = 0;                   // For the quality latched in beginSearch()
+    size_t m_stepsPerBlock = SEARCH_STEPS_PER_BLOCK;
+    size_t m_lagFirst = 0;
+    size_t m_lagCount = COARSE_LAGS;
+    uint64_t m_nextNominal = 0;
+    size_t m_nextPos = 0;
+    int32_t m_bestLag = 0;
+    int32_t m_coarseLag = 0;
+    float m_bestScore = 0.0f;
+    int32_t m_lastOffset = 0;
+    int16_t m_target[TARGET_POINTS];
+    int16_t m_region[REGION_POINTS];
+};
@@ -7,6 +7,7 @@
 #include "audio_stutter.h"
 #include "effect_manager.h"
 #include "trace.h"
+#include "log.h"
 #include "timekeeper.h"
 #include "effect_quantization.h"
 #include "encoder_menu.h"
@@ -15,6 +16,12 @@
 #include "freeze_controller.h"
 #include "stutter_controller.h"
 #include "app_state.h"
+#include "cpu_governor.h"
+#include "telemetry.h"
+#include "spsc_queue.h"
+#include "performance_journal.h"
+#include "audio_event_queue.h"
+#include "step_sequencer.h"
 
 #include <TeensyThreads.h>
 
@@ -52,6 +59,60 @@ static EncoderMenu::Handler* s_encoder2 = nullptr;  // FREEZE parameters
 static EncoderMenu::Handler* s_encoder3 = nullptr;  // CHOKE parameters
 static EncoderMenu::Handler* s_encoder4 = nullptr;  // Global quantization
 
+// ========== POSTED COMMANDS ==========
+static SPSCQueue<Command, 16> s_postedCommands;  // Console -> app thread (AppLogic::postCommand)
+
+struct PostedParameter {
+    AudioEffectBase* effect;
+    uint8_t paramIndex;
+    float value;
+};
+static SPSCQueue<PostedParameter, 8> s_postedParameters;  // Remote -> app thread (AppLogic::postParameter)
+static uint32_t s_parametersPosted = 0;                    // Producer only
+static volatile uint32_t s_parametersApplied = 0;          // App thread only
+
+// ========== PATTERN EDIT STATE ==========
+static uint8_t s_patternCursor = 0;  // Step edited by encoders 1-3 in PATTERN_EDIT mode
+
+// ========== PATTERN EDIT FUNCTIONS ==========
+// In PATTERN_EDIT mode encoder 4 moves the step cursor, encoders 1-3 edit
+// the STUTTER/FREEZE/CHOKE lane at the cursor: turn right sets the step,
+// left clears it, click toggles it and moves the cursor on (step entry)
+
+static bool inPatternEdit() {
+    return s_appState.getMode() == AppMode::PATTERN_EDIT;
+}
+
+/**
+ * Report an edited step through the log (blocking Serial output has no
+ * place on this thread)
+ */
+static void logPatternStep(StepSequencer::Lane lane, uint8_t step) {
+    StepPattern pattern;
+    StepSequencer::getPattern(pattern);
+    LOG_INFO("Pattern %s step %u %s (lane 0x%08X)", StepSequencer::laneName(lane), step + 1,
+             StepSequencer::getStep(lane, step) ? "on" : "off", pattern.lanes[static_cast<uint8_t>(lane)]);
+}
+
+static void patternEditTurn(StepSequencer::Lane lane, int8_t delta) {
+    StepSequencer::setStep(lane, s_patternCursor, delta > 0);
+    logPatternStep(lane, s_patternCursor);
+}
+
+static void patternEditClick(StepSequencer::Lane lane) {
+    StepSequencer::toggleStep(lane, s_patternCursor);
+    logPatternStep(lane, s_patternCursor);
+    s_patternCursor = (s_patternCursor + 1) % StepSequencer::getLength();
+}
+
+static void patternCursorTurn(int8_t delta) {
+    int16_t length = StepSequencer::getLength();
+    int16_t cursor = (static_cast<int16_t>(s_patternCursor) + delta) % length;
+    if (cursor < 0) cursor += length;
+    s_patternCursor = static_cast<uint8_t>(cursor);
+    LOG_INFO("Pattern step %u", s_patternCursor + 1);
+}
+
 // ========== ENCODER SETUP FUNCTIONS ==========
 // These functions configure the behavior of each encoder menu handler
 
@@ -60,30 +121,38 @@ static void setupEncoder1() {
 
     // Button press: Cycle between ONSET → LENGTH → CAPTURE_START → CAPTURE_END
     s_encoder1->onButtonPress([]() {
+        if (inPatternEdit()) {
+            patternEditClick(StepSequencer::Lane::STUTTER);
+            return;
+        }
         StutterController::Parameter current = s_stutterController->getCurrentParameter();
 
         // Cycle to next parameter
         if (current == StutterController::Parameter::ONSET) {
             s_stutterController->setCurrentParameter(StutterController::Parameter::LENGTH);
-            Serial.println("Stutter Parameter: LENGTH");
+            LOG_INFO("Stutter Parameter: LENGTH");
             DisplayIO::showBitmap(StutterController::lengthToBitmap(stutter.getLengthMode()));
         } else if (current == StutterController::Parameter::LENGTH) {
             s_stutterController->setCurrentParameter(StutterController::Parameter::CAPTURE_START);
-            Serial.println("Stutter Parameter: CAPTURE_START");
+            LOG_INFO("Stutter Parameter: CAPTURE_START");
             DisplayIO::showBitmap(StutterController::captureStartToBitmap(stutter.getCaptureStartMode()));
         } else if (current == StutterController::Parameter::CAPTURE_START) {
             s_stutterController->setCurrentParameter(StutterController::Parameter::CAPTURE_END);
-            Serial.println("Stutter Parameter: CAPTURE_END");
+            LOG_INFO("Stutter Parameter: CAPTURE_END");
             DisplayIO::showBitmap(StutterController::captureEndToBitmap(stutter.getCaptureEndMode()));
         } else {  // CAPTURE_END
             s_stutterController->setCurrentParameter(StutterController::Parameter::ONSET);
-            Serial.println("Stutter Parameter: ONSET");
+            LOG_INFO("Stutter Parameter: ONSET");
             DisplayIO::showBitmap(StutterController::onsetToBitmap(stutter.getOnsetMode()));
         }
     });
 
     // Value change: Adjust current parameter
     s_encoder1->onValueChange([](int8_t delta) {
+        if (inPatternEdit()) {
+            patternEditTurn(StepSequencer::Lane::STUTTER, delta);
+            return;
+        }
         StutterController::Parameter param = s_stutterController->getCurrentParameter();
 
         if (param == StutterController::Parameter::ONSET) {
@@ -95,8 +164,7 @@ static void setupEncoder1() {
                 StutterOnset newOnset = static_cast<StutterOnset>(newIndex);
                 stutter.setOnsetMode(newOnset);
                 DisplayIO::showBitmap(StutterController::onsetToBitmap(newOnset));
-                Serial.print("Stutter Onset: ");
-                Serial.println(StutterController::onsetName(newOnset));
+                LOG_INFO("Stutter Onset: %s", StutterController::onsetName(newOnset));
             }
         } else if (param == StutterController::Parameter::LENGTH) {
             int8_t currentIndex = static_cast<int8_t>(stutter.getLengthMode());
@@ -107,8 +175,7 @@ static void setupEncoder1() {
                 StutterLength newLength = static_cast<StutterLength>(newIndex);
                 stutter.setLengthMode(newLength);
                 DisplayIO::showBitmap(StutterController::lengthToBitmap(newLength));
-                Serial.print("Stutter Length: ");
-                Serial.println(StutterController::lengthName(newLength));
+                LOG_INFO("Stutter Length: %s", StutterController::lengthName(newLength));
             }
         } else if (param == StutterController::Parameter::CAPTURE_START) {
             int8_t currentIndex = static_cast<int8_t>(stutter.getCaptureStartMode());
@@ -119,8 +186,7 @@ static void setupEncoder1() {
                 StutterCaptureStart newCaptureStart = static_cast<StutterCaptureStart>(newIndex);
                 stutter.setCaptureStartMode(newCaptureStart);
                 DisplayIO::showBitmap(StutterController::captureStartToBitmap(newCaptureStart));
-                Serial.print("Stutter Capture Start: ");
-                Serial.println(StutterController::captureStartName(newCaptureStart));
+                LOG_INFO("Stutter Capture Start: %s", StutterController::captureStartName(newCaptureStart));
             }
         } else {  // CAPTURE_END
             int8_t currentIndex = static_cast<int8_t>(stutter.getCaptureEndMode());
@@ -131,14 +197,16 @@ static void setupEncoder1() {
                 StutterCaptureEnd newCaptureEnd = static_cast<StutterCaptureEnd>(newIndex);
                 stutter.setCaptureEndMode(newCaptureEnd);
                 DisplayIO::showBitmap(StutterController::captureEndToBitmap(newCaptureEnd));
-                Serial.print("Stutter Capture End: ");
-                Serial.println(StutterController::captureEndName(newCaptureEnd));
+                LOG_INFO("Stutter Capture End: %s", StutterController::captureEndName(newCaptureEnd));
             }
         }
     });
 
     // Display update: Show current parameter or return to effect display
     s_encoder1->onDisplayUpdate([](bool isTouched) {
+        if (inPatternEdit()) {
+            return;  // Pattern shown on the console
+        }
         if (isTouched) {
             StutterController::Parameter param = s_stutterController->getCurrentParameter();
             if (param == StutterController::Parameter::ONSET) {
@@ -161,20 +229,28 @@ static void setupEncoder2() {
 
     // Button press: Cycle between LENGTH and ONSET parameters
     s_encoder2->onButtonPress([]() {
+        if (inPatternEdit()) {
+            patternEditClick(StepSequencer::Lane::FREEZE);
+            return;
+        }
         FreezeController::Parameter current = s_freezeController->getCurrentParameter();
         if (current == FreezeController::Parameter::LENGTH) {
             s_freezeController->setCurrentParameter(FreezeController::Parameter::ONSET);
-            Serial.println("Freeze Parameter: ONSET");
+            LOG_INFO("Freeze Parameter: ONSET");
             DisplayIO::showBitmap(FreezeController::onsetToBitmap(freeze.getOnsetMode()));
         } else {
             s_freezeController->setCurrentParameter(FreezeController::Parameter::LENGTH);
-            Serial.println("Freeze Parameter: LENGTH");
+            LOG_INFO("Freeze Parameter: LENGTH");
             DisplayIO::showBitmap(FreezeController::lengthToBitmap(freeze.getLengthMode()));
         }
     });
 
     // Value change: Adjust current parameter
     s_encoder2->onValueChange([](int8_t delta) {
+        if (inPatternEdit()) {
+            patternEditTurn(StepSequencer::Lane::FREEZE, delta);
+            return;
+        }
         FreezeController::Parameter param = s_freezeController->getCurrentParameter();
 
         if (param == FreezeController::Parameter::LENGTH) {
@@ -186,8 +262,7 @@ static void setupEncoder2() {
                 FreezeLength newLength = static_cast<FreezeLength>(newIndex);
                 freeze.setLengthMode(newLength);
                 DisplayIO::showBitmap(FreezeController::lengthToBitmap(newLength));
-                Serial.print("Freeze Length: ");
-                Serial.println(FreezeController::lengthName(newLength));
+                LOG_INFO("Freeze Length: %s", FreezeController::lengthName(newLength));
             }
         } else {  // ONSET parameter
             int8_t currentIndex = static_cast<int8_t>(freeze.getOnsetMode());
@@ -198,14 +273,16 @@ static void setupEncoder2() {
                 FreezeOnset newOnset = static_cast<FreezeOnset>(newIndex);
                 freeze.setOnsetMode(newOnset);
                 DisplayIO::showBitmap(FreezeController::onsetToBitmap(newOnset));
-                Serial.print("Freeze Onset: ");
-                Serial.println(FreezeController::onsetName(newOnset));
+                LOG_INFO("Freeze Onset: %s", FreezeController::onsetName(newOnset));
             }
         }
     });
 
     // Display update: Show current parameter or return to effect display
     s_encoder2->onDisplayUpdate([](bool isTouched) {
+        if (inPatternEdit()) {
+            return;  // Pattern shown on the console
+        }
         if (isTouched) {
             FreezeController::Parameter param = s_freezeController->getCurrentParameter();
             if (param == FreezeController::Parameter::LENGTH) {
@@ -222,22 +299,40 @@ static void setupEncoder2() {
 static void setupEncoder3() {
     s_encoder3 = new EncoderMenu::Handler(2);  // Encoder 3 is index 2 (CHOKE parameters)
 
-    // Button press: Cycle between LENGTH and ONSET parameters
+    // Button press: Cycle between LENGTH → ONSET → CURVE → FADE parameters
+    // (CURVE and FADE have no bitmaps: the display keeps the choke screen,
+    // the value goes to the log)
     s_encoder3->onButtonPress([]() {
+        if (inPatternEdit()) {
+            patternEditClick(StepSequencer::Lane::CHOKE);
+            return;
+        }
         ChokeController::Parameter current = s_chokeController->getCurrentParameter();
         if (current == ChokeController::Parameter::LENGTH) {
             s_chokeController->setCurrentParameter(ChokeController::Parameter::ONSET);
-            Serial.println("Choke Parameter: ONSET");
+            LOG_INFO("Choke Parameter: ONSET");
             DisplayIO::showBitmap(ChokeController::onsetToBitmap(choke.getOnsetMode()));
-        } else {
+        } else if (current == ChokeController::Parameter::ONSET) {
+            s_chokeController->setCurrentParameter(ChokeController::Parameter::CURVE);
+            LOG_INFO("Choke Parameter: CURVE (%s)", ChokeController::curveName(choke.getCurve()));
+            DisplayIO::showBitmap(BitmapID::CHOKE_ACTIVE);
+        } else if (current == ChokeController::Parameter::CURVE) {
+            s_chokeController->setCurrentParameter(ChokeController::Parameter::FADE);
+            LOG_INFO("Choke Parameter: FADE");
+            DisplayIO::showBitmap(BitmapID::CHOKE_ACTIVE);
+        } else {  // FADE
             s_chokeController->setCurrentParameter(ChokeController::Parameter::LENGTH);
-            Serial.println("Choke Parameter: LENGTH");
+            LOG_INFO("Choke Parameter: LENGTH");
             DisplayIO::showBitmap(ChokeController::lengthToBitmap(choke.getLengthMode()));
         }
     });
 
     // Value change: Adjust current parameter
     s_encoder3->onValueChange([](int8_t delta) {
+        if (inPatternEdit()) {
+            patternEditTurn(StepSequencer::Lane::CHOKE, delta);
+            return;
+        }
         ChokeController::Parameter param = s_chokeController->getCurrentParameter();
 
         if (param == ChokeController::Parameter::LENGTH) {
@@ -253,10 +348,9 @@ static void setupEncoder3() {
                 ChokeLength newLength = static_cast<ChokeLength>(newIndex);
                 choke.setLengthMode(newLength);
                 DisplayIO::showBitmap(ChokeController::lengthToBitmap(newLength));
-                Serial.print("Choke Length: ");
-                Serial.println(ChokeController::lengthName(newLength));
+                LOG_INFO("Choke Length: %s", ChokeController::lengthName(newLength));
             }
-        } else {  // ONSET parameter
+        } else if (param == ChokeController::Parameter::ONSET) {
             // Update ONSET parameter
             int8_t currentIndex = static_cast<int8_t>(choke.getOnsetMode());
             int8_t newIndex = currentIndex + delta;
@@ -269,21 +363,58 @@ static void setupEncoder3() {
                 ChokeOnset newOnset = static_cast<ChokeOnset>(newIndex);
                 choke.setOnsetMode(newOnset);
                 DisplayIO::showBitmap(ChokeController::onsetToBitmap(newOnset));
-                Serial.print("Choke Onset: ");
-                Serial.println(ChokeController::onsetName(newOnset));
+                LOG_INFO("Choke Onset: %s", ChokeController::onsetName(newOnset));
+            }
+        } else if (param == ChokeController::Parameter::CURVE) {
+            // Update fade curve
+            int8_t currentIndex = static_cast<int8_t>(choke.getCurve());
+            int8_t newIndex = currentIndex + delta;
+
+            // Clamp to valid range
+            if (newIndex < 0) newIndex = 0;
+            if (newIndex > CHOKE_CURVE_COUNT - 1) newIndex = CHOKE_CURVE_COUNT - 1;
+
+            if (newIndex != currentIndex) {
+                ChokeCurve newCurve = static_cast<ChokeCurve>(newIndex);
+                choke.setCurve(newCurve);
+                LOG_INFO("Choke Curve: %s", ChokeController::curveName(newCurve));
+            }
+        } else {  // FADE parameter
+            // Step through fixed length → 1/64 → 1/32 → 1/16 → 1/8 beat
+            int8_t currentIndex = static_cast<int8_t>(
+                ChokeController::fadeStepIndex(s_chokeController->getFadeBeatDivisor()));
+            int8_t newIndex = currentIndex + delta;
+
+            // Clamp to valid range
+            if (newIndex < 0) newIndex = 0;
+            if (newIndex > ChokeController::FADE_STEP_COUNT - 1) newIndex = ChokeController::FADE_STEP_COUNT - 1;
+
+            if (newIndex != currentIndex) {
+                uint16_t divisor = ChokeController::FADE_STEPS[newIndex];
+                s_chokeController->setFadeBeatDivisor(divisor);
+                if (divisor == 0) {
+                    LOG_INFO("Choke Fade: %u samples (fixed)", static_cast<unsigned>(choke.getFadeSamples()));
+                } else {
+                    LOG_INFO("Choke Fade: 1/%u beat", divisor);
+                }
             }
         }
     });
 
     // Display update: Show current parameter or return to effect display
     s_encoder3->onDisplayUpdate([](bool isTouched) {
+        if (inPatternEdit()) {
+            return;  // Pattern shown on the console
+        }
         if (isTouched) {
             // Show current parameter
             ChokeController::Parameter param = s_chokeController->getCurrentParameter();
             if (param == ChokeController::Parameter::LENGTH) {
                 DisplayIO::showBitmap(ChokeController::lengthToBitmap(choke.getLengthMode()));
-            } else {
+            } else if (param == ChokeController::Parameter::ONSET) {
                 DisplayIO::showBitmap(ChokeController::onsetToBitmap(choke.getOnsetMode()));
+            } else {
+                DisplayIO::showBitmap(BitmapID::CHOKE_ACTIVE);
             }
         } else {
             // Cooldown expired - return to effect display
@@ -295,8 +426,25 @@ static void setupEncoder3() {
 static void setupEncoder4() {
     s_encoder4 = new EncoderMenu::Handler(3);  // Encoder 4 is index 3
 
-    // Value change: Adjust global quantization
+    // Button press: Enter/leave step pattern editing
+    s_encoder4->onButtonPress([]() {
+        if (inPatternEdit()) {
+            s_appState.setMode(AppMode::NORMAL);
+            LOG_INFO("Pattern edit: OFF");
+        } else {
+            s_appState.setMode(AppMode::PATTERN_EDIT);
+            LOG_INFO("Pattern edit: ON (enc 4 = step, enc 1-3 = stutter/freeze/choke lane)");
+            LOG_INFO("Pattern step %u of %u", s_patternCursor + 1, StepSequencer::getLength());
+        }
+    });
+
+    // Value change: Adjust global quantization (pattern edit: move the step cursor)
     s_encoder4->onValueChange([](int8_t delta) {
+        if (inPatternEdit()) {
+            patternCursorTurn(delta);
+            return;
+        }
+
         int8_t currentIndex = static_cast<int8_t>(EffectQuantization::getGlobalQuantization());
         int8_t newIndex = currentIndex + delta;
 
@@ -308,13 +456,15 @@ static void setupEncoder4() {
             Quantization newQuant = static_cast<Quantization>(newIndex);
             EffectQuantization::setGlobalQuantization(newQuant);
             DisplayIO::showBitmap(EffectQuantization::quantizationToBitmap(newQuant));
-            Serial.print("Global Quantization: ");
-            Serial.println(EffectQuantization::quantizationName(newQuant));
+            LOG_INFO("Global Quantization: %s", EffectQuantization::quantizationName(newQuant));
         }
     });
 
     // Display update: Show quantization or return to effect display
     s_encoder4->onDisplayUpdate([](bool isTouched) {
+        if (inPatternEdit()) {
+            return;  // Pattern shown on the console
+        }
         if (isTouched) {
             // Show current quantization
             Quantization quant = EffectQuantization::getGlobalQuantization();
@@ -330,62 +480,178 @@ static void setupEncoder4() {
 // These functions break up the main thread loop into logical sections
 
 /**
- * Process input commands from button queue
- * Handles effect toggle/enable/disable and visual feedback
+ * Route one command: looper commands and CHOKE/FREEZE/STUTTER buttons go to
+ * their controllers, anything else to EffectManager
  */
-static void processInputCommands() {
-    Command cmd;
-    while (InputIO::popCommand(cmd)) {
-        // Check if CHOKE/FREEZE controllers want to intercept
-        bool handled = false;
-
-        if (cmd.targetEffect == EffectID::CHOKE && s_chokeController) {
-            if (cmd.type == CommandType::EFFECT_ENABLE || cmd.type == CommandType::EFFECT_TOGGLE) {
-                handled = s_chokeController->handleButtonPress(cmd);
-            } else if (cmd.type == CommandType::EFFECT_DISABLE) {
-                handled = s_chokeController->handleButtonRelease(cmd);
+static void routeCommand(const Command& cmd) {
+    // Check if CHOKE/FREEZE controllers want to intercept
+    bool handled = false;
+
+    if (cmd.type >= CommandType::LOOP_RECORD && cmd.type <= CommandType::LOOP_RETRO) {
+        handled = s_stutterController && s_stutterController->handleLoopCommand(cmd);
+    } else if (cmd.targetEffect == EffectID::CHOKE && s_chokeController) {
+        if (cmd.type == CommandType::EFFECT_ENABLE || cmd.type == CommandType::EFFECT_TOGGLE) {
+            handled = s_chokeController->handleButtonPress(cmd);
+        } else if (cmd.type == CommandType::EFFECT_DISABLE) {
+            handled = s_chokeController->handleButtonRelease(cmd);
+        }
+    } else if (cmd.targetEffect == EffectID::FREEZE && s_freezeController) {
+        if (cmd.type == CommandType::EFFECT_ENABLE || cmd.type == CommandType::EFFECT_TOGGLE) {
+            handled = s_freezeController->handleButtonPress(cmd);
+        } else if (cmd.type == CommandType::EFFECT_DISABLE) {
+            handled = s_freezeController->handleButtonRelease(cmd);
+        }
+    } else if (cmd.targetEffect == EffectID::STUTTER && s_stutterController) {
+        if (cmd.type == CommandType::EFFECT_ENABLE || cmd.type == CommandType::EFFECT_TOGGLE) {
+            handled = s_stutterController->handleButtonPress(cmd);
+        } else if (cmd.type == CommandType::EFFECT_DISABLE) {
+            handled = s_stutterController->handleButtonRelease(cmd);
+        }
+    } else if (cmd.targetEffect == EffectID::FUNC && s_stutterController) {
+        // FUNC is handled by stutter controller (modifier button)
+        if (cmd.type == CommandType::EFFECT_ENABLE) {
+            handled = s_stutterController->handleButtonPress(cmd);
+        } else if (cmd.type == CommandType::EFFECT_DISABLE) {
+            handled = s_stutterController->handleButtonRelease(cmd);
+        }
+    }
+
+    // If handler didn't intercept, execute via EffectManager
+    if (!handled && EffectManager::executeCommand(cmd)) {
+        // Update visual feedback
+        AudioEffectBase* effect = EffectManager::getEffect(cmd.targetEffect);
+        if (effect) {
+            bool enabled = effect->isEnabled();
+            InputIO::setLED(cmd.targetEffect, enabled);
+
+            if (enabled) {
+                DisplayManager::instance().setLastActivatedEffect(cmd.targetEffect);
+            } else {
+                DisplayManager::instance().setLastActivatedEffect(EffectID::NONE);
             }
-        } else if (cmd.targetEffect == EffectID::FREEZE && s_freezeController) {
-            if (cmd.type == CommandType::EFFECT_ENABLE || cmd.type == CommandType::EFFECT_TOGGLE) {
-                handled = s_freezeController->handleButtonPress(cmd);
-            } else if (cmd.type == CommandType::EFFECT_DISABLE) {
-                handled = s_freezeController->handleButtonRelease(cmd);
+
+            DisplayManager::instance().updateDisplay();
+            LOG_INFO("%s %s", effect->getName(), enabled ? "ENABLED" : "DISABLED");
+        }
+    }
+}
+
+/**
+ * Journal control from the console: the journal's state belongs to this
+ * thread (record() and update() run here)
+ *
+ * @return false if cmd is not a control command
+ */
+static bool handleControlCommand(const Command& cmd) {
+    switch (cmd.type) {
+        case CommandType::JOURNAL_RECORD:
+            if (PerformanceJournal::isRecording()) {
+                PerformanceJournal::stopRecording();
+                LOG_INFO("Journal: recorded %u commands over %u bars",
+                         static_cast<unsigned>(PerformanceJournal::getEntryCount()),
+                         static_cast<unsigned>(PerformanceJournal::getLengthBars()));
+            } else if (PerformanceJournal::startRecording()) {
+                LOG_INFO("Journal: RECORDING");
             }
-        } else if (cmd.targetEffect == EffectID::STUTTER && s_stutterController) {
-            if (cmd.type == CommandType::EFFECT_ENABLE || cmd.type == CommandType::EFFECT_TOGGLE) {
-                handled = s_stutterController->handleButtonPress(cmd);
-            } else if (cmd.type == CommandType::EFFECT_DISABLE) {
-                handled = s_stutterController->handleButtonRelease(cmd);
+            return true;
+
+        case CommandType::JOURNAL_REPLAY:
+            if (PerformanceJournal::isReplaying()) {
+                PerformanceJournal::stopReplay();
+                LOG_INFO("Journal: replay STOPPED");
+            } else if (PerformanceJournal::startReplay(true)) {
+                LOG_INFO("Journal: REPLAYING from next bar");
             }
-        } else if (cmd.targetEffect == EffectID::FUNC && s_stutterController) {
-            // FUNC is handled by stutter controller (modifier button)
-            if (cmd.type == CommandType::EFFECT_ENABLE) {
-                handled = s_stutterController->handleButtonPress(cmd);
-            } else if (cmd.type == CommandType::EFFECT_DISABLE) {
-                handled = s_stutterController->handleButtonRelease(cmd);
+            return true;
+
+        case CommandType::JOURNAL_DUMP:
+            PerformanceJournal::dump();
+            return true;
+
+        case CommandType::SEQ_TOGGLE:
+            StepSequencer::setEnabled(!StepSequencer::isEnabled());
+            LOG_INFO("Sequencer: %s", StepSequencer::isEnabled() ? "ON (next bar)" : "OFF");
+            return true;
+
+        case CommandType::SEQ_LENGTH: {
+            uint32_t steps = cmd.value ? cmd.value : (StepSequencer::getLength() == 16 ? 32 : 16);
+            if (steps <= StepSequencer::MAX_STEPS && StepSequencer::setLength(static_cast<uint8_t>(steps))) {
+                // Keep the edit cursor inside the pattern
+                if (s_patternCursor >= StepSequencer::getLength()) {
+                    s_patternCursor = 0;
+                }
+                StepPattern pattern;
+                StepSequencer::getPattern(pattern);
+                LOG_INFO("Pattern: %u steps (S 0x%08X F 0x%08X C 0x%08X)", pattern.length, pattern.lanes[0],
+                         pattern.lanes[1], pattern.lanes[2]);
             }
+            return true;
         }
 
-        // If handler didn't intercept, execute via EffectManager
-        if (!handled && EffectManager::executeCommand(cmd)) {
-            // Update visual feedback
-            AudioEffectBase* effect = EffectManager::getEffect(cmd.targetEffect);
-            if (effect) {
-                bool enabled = effect->isEnabled();
-                InputIO::setLED(cmd.targetEffect, enabled);
+        default:
+            return false;
+    }
+}
 
-                if (enabled) {
-                    DisplayManager::instance().setLastActivatedEffect(cmd.targetEffect);
-                } else {
-                    DisplayManager::instance().setLastActivatedEffect(EffectID::NONE);
-                }
+/**
+ * One input command: measure its latency, journal it, route it
+ */
+static void handleCommand(const Command& cmd) {
+    if (handleControlCommand(cmd)) {
+        return;  // Not part of the performance: not journaled
+    }
 
-                DisplayManager::instance().updateDisplay();
-                Serial.print(effect->getName());
-                Serial.println(enabled ? " ENABLED" : " DISABLED");
-            }
+    // Source-to-app delay (ISR stamp -> now), skipped across a transport reset
+    if (cmd.isStamped()) {
+        uint64_t now = TimeKeeper::getSamplePosition();
+        if (now >= cmd.sampleTime) {
+            uint64_t delay = now - cmd.sampleTime;
+            Telemetry::updateMax(TELEM_INPUT_LATENCY_MAX, delay > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(delay));
         }
     }
+
+    PerformanceJournal::record(cmd);
+    routeCommand(cmd);
+}
+
+/**
+ * Journal replay of a button or looper command (stamped with its target).
+ * Presses and releases are taken ahead of time so the controller schedules
+ * them on the target sample, but only once no earlier action of that effect
+ * is pending (it decides on the current state). Looper commands quantize to
+ * the bar line themselves: they are taken when due.
+ */
+static bool handleReplayedCommand(const Command& cmd) {
+    if (cmd.sampleTime > TimeKeeper::getSamplePosition()) {
+        const bool looper = (cmd.type >= CommandType::LOOP_RECORD && cmd.type <= CommandType::LOOP_RETRO);
+        const AudioEffectBase& effect = (cmd.targetEffect == EffectID::CHOKE)    ? static_cast<AudioEffectBase&>(choke)
+                                        : (cmd.targetEffect == EffectID::FREEZE) ? static_cast<AudioEffectBase&>(freeze)
+                                                                                 : static_cast<AudioEffectBase&>(stutter);
+        if (looper || !effect.isSettledUntil(cmd.sampleTime)) {
+            return false;
+        }
+    }
+    routeCommand(cmd);
+    return true;
+}
+
+/**
+ * Process input commands from the button queue and AppLogic::postCommand()
+ */
+static void processInputCommands() {
+    Command cmd;
+    while (InputIO::popCommand(cmd)) {
+        handleCommand(cmd);
+    }
+    while (s_postedCommands.pop(cmd)) {
+        handleCommand(cmd);
+    }
+
+    PostedParameter param;
+    while (s_postedParameters.pop(param)) {
+        param.effect->setParameter(param.paramIndex, param.value);
+        s_parametersApplied = s_parametersApplied + 1;
+    }
 }
 
 /**
@@ -427,6 +693,8 @@ static void processTransportEvents() {
             case MidiEvent::START: {
                 s_lastTickMicros = 0;
                 s_transportActive = true;
+                PerformanceJournal::onTransportChange();
+                AudioEventQueue::flush();  // Targets are sample positions: START rebases them
                 TimeKeeper::reset();
                 TimeKeeper::setTransportState(TimeKeeper::TransportState::PLAYING);
 
@@ -437,24 +705,26 @@ static void processTransportEvents() {
                 s_ledOffSample = TimeKeeper::getSamplePosition() + pulseSamples;
                 TRACE(TRACE_BEAT_LED_ON);
                 TRACE(TRACE_MIDI_START);
-                Serial.println("▶ START");
+                LOG_INFO("▶ START");
                 break;
             }
 
             case MidiEvent::STOP:
                 s_transportActive = false;
+                PerformanceJournal::onTransportChange();
+                AudioEventQueue::flush();
                 TimeKeeper::setTransportState(TimeKeeper::TransportState::STOPPED);
                 digitalWrite(LED_PIN, LOW);
                 s_ledOffSample = 0;
                 TRACE(TRACE_MIDI_STOP);
-                Serial.println("■ STOP");
+                LOG_INFO("■ STOP");
                 break;
 
             case MidiEvent::CONTINUE:
                 s_transportActive = true;
                 TimeKeeper::setTransportState(TimeKeeper::TransportState::PLAYING);
                 TRACE(TRACE_MIDI_CONTINUE);
-                Serial.println("▶ CONTINUE");
+                LOG_INFO("▶ CONTINUE");
                 break;
         }
     }
@@ -521,6 +791,12 @@ void AppLogic::begin() {
     s_freezeController = new FreezeController(freeze);
     s_stutterController = new StutterController(stutter);
 
+    // Journal replay of stutter presses goes through the controllers
+    PerformanceJournal::setControllerHandler(handleReplayedCommand);
+
+    // Step sequencer lanes (pattern plays from the audio ISR)
+    StepSequencer::begin(&stutter, &freeze, &choke);
+
     // Setup encoders
     setupEncoder1();  // STUTTER parameters
     setupEncoder2();  // FREEZE parameters
@@ -531,6 +807,26 @@ void AppLogic::begin() {
     s_transportActive = false;
 }
 
+bool AppLogic::postCommand(const Command& cmd) {
+    return s_postedCommands.push(cmd);
+}
+
+size_t AppLogic::pendingCommands() {
+    return s_postedCommands.size();
+}
+
+bool AppLogic::postParameter(AudioEffectBase* effect, uint8_t paramIndex, float value) {
+    if (!s_postedParameters.push(PostedParameter{effect, paramIndex, value})) {
+        return false;
+    }
+    s_parametersPosted++;
+    return true;
+}
+
+bool AppLogic::parametersApplied() {
+    return s_parametersApplied == s_parametersPosted;
+}
+
 void AppLogic::threadLoop() {
     for (;;) {
         // Main application loop - organized into logical sections
@@ -554,14 +850,20 @@ void AppLogic::threadLoop() {
         // 6. Update beat indicator LED
         updateBeatLed();
 
-        // 7. Periodic debug output (optional)
+        // 7. Adapt effect quality to audio ISR load (windowed, cheap when idle)
+        CpuGovernor::update();
+
+        // 8. Post journal replay commands due soon to the audio ISR
+        PerformanceJournal::update();
+
+        // 9. Periodic debug output (optional)
         uint32_t now = millis();
         if (now - s_lastPrint >= PRINT_INTERVAL_MS) {
             s_lastPrint = now;
             // Optional: Print status here
         }
 
-        // 8. Yield CPU to other threads
+        // 10. Yield CPU to other threads
         threads.delay(2);
     }
 }
@@ -0,0 +1,69 @@
+#include "audio_event_queue.h"
+#include "effect_manager.h"
+#include "trace.h"
+#include <Arduino.h>
+
+SPSCQueue<Command, AudioEventQueue::QUEUE_SIZE> AudioEventQueue::s_queue;
+volatile bool AudioEventQueue::s_flushRequested = false;
+volatile uint32_t AudioEventQueue::s_dispatched = 0;
+volatile uint32_t AudioEventQueue::s_late = 0;
+volatile uint32_t AudioEventQueue::s_rejected = 0;
+
+bool AudioEventQueue::post(const Command& cmd) {
+    // An unstamped command (NOT_STAMPED) would sit at the head forever
+    if (!cmd.isStamped() || !s_queue.push(cmd)) {
+        s_rejected = s_rejected + 1;
+        return false;
+    }
+    return true;
+}
+
+void AudioEventQueue::dispatch(uint64_t blockStart) {
+    const uint64_t blockEnd = blockStart + AUDIO_BLOCK_SAMPLES;
+
+    Command cmd;
+    if (s_flushRequested) {
+        while (s_queue.pop(cmd)) {
+        }
+        s_flushRequested = false;
+    }
+
+    while (s_queue.peek(cmd) && cmd.sampleTime < blockEnd) {
+        s_queue.pop(cmd);
+
+        if (cmd.sampleTime < blockStart) {
+            s_late = s_late + 1;
+        }
+        if (execute(cmd)) {
+            s_dispatched = s_dispatched + 1;
+            TRACE(TRACE_EVENT_DISPATCH, static_cast<uint16_t>(cmd.targetEffect));
+        } else {
+            s_rejected = s_rejected + 1;
+        }
+    }
+}
+
+bool AudioEventQueue::execute(const Command& cmd) {
+    // No Serial output here: this runs in the audio ISR
+    AudioEffectBase* effect = EffectManager::getEffect(cmd.targetEffect);
+    if (effect == nullptr) {
+        return false;
+    }
+
+    switch (cmd.type) {
+        case CommandType::EFFECT_ENABLE:
+            effect->enable();
+            return true;
+
+        case CommandType::EFFECT_DISABLE:
+            effect->disable();
+            return true;
+
+        case CommandType::EFFECT_TOGGLE:
+            effect->toggle();
+            return true;
+
+        default:
+            return false;
+    }
+}
@@ -1,12 +1,17 @@
 #include "choke_controller.h"
 #include "input_io.h"
 #include "display_manager.h"
+#include "step_sequencer.h"
 #include "timekeeper.h"
+#include "log.h"
 #include <Arduino.h>
 
 ChokeController::ChokeController(AudioEffectChoke& effect)
     : m_effect(effect),
-      m_currentParameter(Parameter::LENGTH) {
+      m_currentParameter(Parameter::LENGTH),
+      m_fadeBeatDivisor(0),
+      m_shownEnabled(false),
+      m_shownSequenced(false) {
 }
 
 BitmapID ChokeController::lengthToBitmap(ChokeLength length) {
@@ -41,6 +46,34 @@ const char* ChokeController::onsetName(ChokeOnset onset) {
     }
 }
 
+const char* ChokeController::curveName(ChokeCurve curve) {
+    switch (curve) {
+        case ChokeCurve::LINEAR:      return "Linear";
+        case ChokeCurve::EQUAL_POWER: return "Equal Power";
+        case ChokeCurve::EXPONENTIAL: return "Exponential";
+        default: return "Linear";
+    }
+}
+
+constexpr uint16_t ChokeController::FADE_STEPS[FADE_STEP_COUNT];
+
+uint8_t ChokeController::fadeStepIndex(uint16_t beatDivisor) {
+    for (uint8_t i = 0; i < FADE_STEP_COUNT; i++) {
+        if (FADE_STEPS[i] == beatDivisor) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+void ChokeController::applyMusicalFade() {
+    if (m_fadeBeatDivisor == 0) {
+        return;  // Fixed sample length (set directly on the effect)
+    }
+
+    m_effect.setFadeSamples(TimeKeeper::getSamplesPerBeat() / m_fadeBeatDivisor);
+}
+
 bool ChokeController::handleButtonPress(const Command& cmd) {
     if (cmd.targetEffect != EffectID::CHOKE) {
         return false;  // Not our effect
@@ -53,48 +86,56 @@ bool ChokeController::handleButtonPress(const Command& cmd) {
     ChokeLength lengthMode = m_effect.getLengthMode();
     ChokeOnset onsetMode = m_effect.getOnsetMode();
 
+    applyMusicalFade();
+
+    // Press sample: now, or later for a press journal replay hands over early
+    const uint64_t at = EffectQuantization::actionSample(cmd);
+    const bool ahead = at > TimeKeeper::getSamplePosition();
+
     if (onsetMode == ChokeOnset::FREE) {
-        // FREE ONSET: Engage immediately
-        m_effect.enable();
+        // FREE ONSET: Engage on the press sample (immediately for a live press)
+        if (ahead) {
+            m_effect.scheduleOnset(at);
+        } else {
+            m_effect.enable();
+        }
 
         if (lengthMode == ChokeLength::QUANTIZED) {
             // FREE ONSET + QUANTIZED LENGTH
             Quantization quant = EffectQuantization::getGlobalQuantization();
             uint32_t durationSamples = EffectQuantization::calculateQuantizedDuration(quant);
-            uint64_t releaseSample = TimeKeeper::getSamplePosition() + durationSamples;
+            uint64_t releaseSample = at + durationSamples;
             m_effect.scheduleRelease(releaseSample);
 
-            Serial.print("Choke ENGAGED (Free onset, Quantized length=");
-            Serial.print(EffectQuantization::quantizationName(quant));
-            Serial.println(")");
+            LOG_INFO("Choke ENGAGED (Free onset, Quantized length=%s)", EffectQuantization::quantizationName(quant));
         } else {
             // FREE ONSET + FREE LENGTH
-            Serial.println("Choke ENGAGED (Free onset, Free length)");
+            LOG_INFO("Choke ENGAGED (Free onset, Free length)");
         }
 
-        // Update visual feedback
-        InputIO::setLED(EffectID::CHOKE, true);
-        DisplayManager::instance().setLastActivatedEffect(EffectID::CHOKE);
-        DisplayIO::showChoke();
+        // Update visual feedback (a scheduled onset shows when it fires)
+        if (!ahead) {
+            InputIO::setLED(EffectID::CHOKE, true);
+            DisplayManager::instance().setLastActivatedEffect(EffectID::CHOKE);
+            DisplayIO::showChoke();
+        }
         return true;  // Command handled
     } else {
         // QUANTIZED ONSET: Schedule for next boundary with lookahead offset
         Quantization quant = EffectQuantization::getGlobalQuantization();
 
-        // DEBUG: Get all timing info
         uint64_t currentSample = TimeKeeper::getSamplePosition();
-        uint32_t samplesPerBeat = TimeKeeper::getSamplesPerBeat();
-        uint32_t beatNumber = TimeKeeper::getBeatNumber();
-        uint32_t tickInBeat = TimeKeeper::getTickInBeat();
 
-        uint32_t samplesToNext = EffectQuantization::samplesToNextQuantizedBoundary(quant);
+        // Next boundary after the press (from now for a live press)
+        uint64_t boundary = EffectQuantization::quantizedSampleAfter(at, quant);
+        uint32_t samplesToNext = static_cast<uint32_t>(boundary - at);
 
         // Apply lookahead offset (fire early to catch external audio transients)
         uint32_t lookahead = EffectQuantization::getLookaheadOffset();
         uint32_t adjustedSamples = (samplesToNext > lookahead) ? (samplesToNext - lookahead) : 0;
 
         // Calculate absolute sample position for onset
-        uint64_t onsetSample = currentSample + adjustedSamples;
+        uint64_t onsetSample = at + adjustedSamples;
 
         // Schedule onset in ISR (same as how length scheduling works)
         m_effect.scheduleOnset(onsetSample);
@@ -106,22 +147,11 @@ bool ChokeController::handleButtonPress(const Command& cmd) {
             m_effect.scheduleRelease(releaseSample);
         }
 
-        Serial.print("ONSET DEBUG: currentSample=");
-        Serial.print((uint32_t)currentSample);
-        Serial.print(" beat=");
-        Serial.print(beatNumber);
-        Serial.print(" tick=");
-        Serial.print(tickInBeat);
-        Serial.print(" spb=");
-        Serial.print(samplesPerBeat);
-        Serial.print(" samplesToNext=");
-        Serial.print(samplesToNext);
-        Serial.print(" lookahead=");
-        Serial.print(lookahead);
-        Serial.print(" adjusted=");
-        Serial.print(adjustedSamples);
-        Serial.print(" onsetSample=");
-        Serial.println((uint32_t)onsetSample);
+        // Timing detail (LOG_LEVEL=LOG_LEVEL_DEBUG builds only)
+        LOG_DEBUG("ONSET DEBUG: currentSample=%u beat=%u tick=%u spb=%u", (uint32_t)currentSample,
+                  TimeKeeper::getBeatNumber(), TimeKeeper::getTickInBeat(), TimeKeeper::getSamplesPerBeat());
+        LOG_DEBUG("ONSET DEBUG: samplesToNext=%u lookahead=%u adjusted=%u onsetSample=%u",
+                  samplesToNext, lookahead, adjustedSamples, (uint32_t)onsetSample);
 
         return true;  // Command handled
     }
@@ -140,24 +170,42 @@ bool ChokeController::handleButtonRelease(const Command& cmd) {
 
     if (lengthMode == ChokeLength::QUANTIZED) {
         // QUANTIZED LENGTH: Ignore release (auto-releases)
-        Serial.println("Choke button released (ignored - quantized length)");
+        LOG_INFO("Choke button released (ignored - quantized length)");
         return true;  // Command handled (skip default disable)
     }
 
+    // Replayed ahead of time: release on the stamp, unless the onset has
+    // not fired by then (released before the boundary, as below)
+    if (EffectQuantization::actionSample(cmd) > TimeKeeper::getSamplePosition()) {
+        if (m_effect.isOnsetPending()) {
+            m_effect.cancelScheduledOnset();
+        } else {
+            m_effect.scheduleRelease(cmd.sampleTime);
+        }
+        return true;
+    }
+
     // FREE LENGTH: Check if we have scheduled onset via ISR API
     // QUANTIZED ONSET + FREE LENGTH: Cancel scheduled onset
     m_effect.cancelScheduledOnset();
-    Serial.println("Choke scheduled onset CANCELLED (button released before beat)");
+    LOG_INFO("Choke scheduled onset CANCELLED (button released before beat)");
 
     // FREE ONSET + FREE LENGTH: Fall through to default disable
     return false;  // Let EffectManager handle disable
 }
 
 void ChokeController::updateVisualFeedback() {
-    // Check for ISR-fired onset (QUANTIZED ONSET mode)
-    // Detect rising edge: choke enabled but display not showing it yet
-    if (m_effect.isEnabled() && DisplayManager::instance().getLastActivatedEffect() != EffectID::CHOKE) {
-        // ISR fired onset - update visual feedback
+    // Edge detection on the effect itself: a scheduled onset/release fired in
+    // the ISR, or the step sequencer gated the choke (the button handlers
+    // update LED and display themselves; repeating that here is harmless)
+    const bool enabled = m_effect.isEnabled();
+    if (enabled == m_shownEnabled) {
+        return;
+    }
+    m_shownEnabled = enabled;
+
+    if (enabled) {
+        m_shownSequenced = StepSequencer::holdsLane(StepSequencer::Lane::CHOKE);
         InputIO::setLED(EffectID::CHOKE, true);
         DisplayManager::instance().setLastActivatedEffect(EffectID::CHOKE);
         DisplayIO::showChoke();
@@ -166,30 +214,22 @@ void ChokeController::updateVisualFeedback() {
         ChokeOnset onsetMode = m_effect.getOnsetMode();
         ChokeLength lengthMode = m_effect.getLengthMode();
 
-        if (onsetMode == ChokeOnset::QUANTIZED) {
+        if (onsetMode == ChokeOnset::QUANTIZED && !m_shownSequenced) {
             Quantization quant = EffectQuantization::getGlobalQuantization();
-            Serial.print("Choke ENGAGED at scheduled onset (");
-            Serial.print(EffectQuantization::quantizationName(quant));
-            Serial.print(" boundary, ");
-            Serial.print(lengthMode == ChokeLength::QUANTIZED ? "Quantized length)" : "Free length)");
-            Serial.println();
+            LOG_INFO("Choke ENGAGED at scheduled onset (%s boundary, %s length)",
+                     EffectQuantization::quantizationName(quant),
+                     lengthMode == ChokeLength::QUANTIZED ? "Quantized" : "Free");
         }
+        return;
     }
 
-    // Check for auto-release (QUANTIZED LENGTH mode)
-    // Detect falling edge: choke disabled but display still showing it
-    if (!m_effect.isEnabled() && DisplayManager::instance().getLastActivatedEffect() == EffectID::CHOKE) {
-        // Only auto-release if in QUANTIZED length mode
-        if (m_effect.getLengthMode() == ChokeLength::QUANTIZED) {
-            // Choke auto-released - update display
-            DisplayManager::instance().setLastActivatedEffect(EffectID::NONE);
-            DisplayManager::instance().updateDisplay();
-
-            // Update LED to reflect disabled state
-            InputIO::setLED(EffectID::CHOKE, false);
-
-            // Debug output
-            Serial.println("Choke auto-released (Quantized mode)");
-        }
+    // Released: LED off even if another effect took the display since
+    InputIO::setLED(EffectID::CHOKE, false);
+    if (DisplayManager::instance().getLastActivatedEffect() == EffectID::CHOKE) {
+        DisplayManager::instance().setLastActivatedEffect(EffectID::NONE);
+        DisplayManager::instance().updateDisplay();
+    }
+    if (m_effect.getLengthMode() == ChokeLength::QUANTIZED && !m_shownSequenced) {
+        LOG_INFO("Choke auto-released (Quantized mode)");
     }
 }
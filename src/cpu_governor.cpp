@@ -0,0 +1,169 @@
+#include "cpu_governor.h"
+#include "timekeeper.h"
+#include "trace.h"
+#include "telemetry.h"
+#include <Arduino.h>
+
+AudioEffectBase* CpuGovernor::s_slots[MAX_DEGRADABLE] = {};
+uint8_t CpuGovernor::s_numSlots = 0;
+volatile bool CpuGovernor::s_enabled = true;
+uint32_t CpuGovernor::s_lastWindowMs = 0;
+uint32_t CpuGovernor::s_lastLoadPermille = 0;
+uint32_t CpuGovernor::s_tracedLoadPermille = 0;
+uint8_t CpuGovernor::s_quietWindows = 0;
+
+bool CpuGovernor::registerDegradable(AudioEffectBase* effect) {
+    if (effect == nullptr) {
+        Serial.println("ERROR: CpuGovernor::registerDegradable() - effect is null");
+        return false;
+    }
+
+    if (effect->getQualityLevelCount() < 2) {
+        Serial.print("CpuGovernor: '");
+        Serial.print(effect->getName());
+        Serial.println("' has no quality levels, ignored");
+        return false;
+    }
+
+    if (s_numSlots >= MAX_DEGRADABLE) {
+        Serial.print("ERROR: CpuGovernor::registerDegradable() - registry full (max ");
+        Serial.print(MAX_DEGRADABLE);
+        Serial.println(" effects)");
+        return false;
+    }
+
+    s_slots[s_numSlots++] = effect;
+
+    Serial.print("CpuGovernor: Registered '");
+    Serial.print(effect->getName());
+    Serial.print("' (");
+    Serial.print(effect->getQualityLevelCount());
+    Serial.println(" quality levels)");
+
+    return true;
+}
+
+void CpuGovernor::update() {
+    uint32_t now = millis();
+    if (now - s_lastWindowMs < WINDOW_MS) {
+        return;
+    }
+    s_lastWindowMs = now;
+
+    uint32_t load = readAndResetPeakLoad();
+    s_lastLoadPermille = load;
+    Telemetry::set(TELEM_CPU_BLOCK_LOAD, load);
+    Telemetry::updateMax(TELEM_CPU_BLOCK_LOAD_MAX, load);
+
+    // Trace ring is post-mortem history: only record load steps, not every window
+    uint32_t delta = (load > s_tracedLoadPermille) ? load - s_tracedLoadPermille : s_tracedLoadPermille - load;
+    if (delta >= LOAD_TRACE_DELTA_PERMILLE) {
+        s_tracedLoadPermille = load;
+        TRACE(TRACE_GOVERNOR_LOAD, load > 0xFFFF ? 0xFFFF : load);
+    }
+
+    if (!s_enabled) {
+        // Manual override: return everything to full quality
+        while (restoreOneStep()) {
+        }
+        Telemetry::set(TELEM_GOVERNOR_STEPS, 0);
+        return;
+    }
+
+    if (load > DEGRADE_PERMILLE) {
+        // Over budget: shed one step now, re-measure next window
+        s_quietWindows = 0;
+        degradeOneStep();
+    } else if (load < RESTORE_PERMILLE) {
+        // Headroom: only restore once it has held for RESTORE_WINDOWS
+        if (++s_quietWindows >= RESTORE_WINDOWS) {
+            s_quietWindows = 0;
+            restoreOneStep();
+        }
+    } else {
+        // Inside hysteresis band: hold current quality
+        s_quietWindows = 0;
+    }
+
+    Telemetry::set(TELEM_GOVERNOR_STEPS, getStepsShed());
+}
+
+void CpuGovernor::setEnabled(bool enabled) {
+    // Only flips the flag - slots are touched exclusively from update()
+    // (app thread), which restores full quality on its next window
+    s_enabled = enabled;
+}
+
+uint8_t CpuGovernor::getStepsShed() {
+    uint8_t steps = 0;
+    for (uint8_t i = 0; i < s_numSlots; i++) {
+        steps += s_slots[i]->getQualityLevel();
+    }
+    return steps;
+}
+
+void CpuGovernor::printStatus() {
+    Serial.println("\n=== CPU Governor ===");
+    Serial.print("Mode: ");
+    Serial.println(s_enabled ? "AUTO" : "OFF (full quality)");
+    Serial.print("Worst block (last window): ");
+    Serial.print(s_lastLoadPermille / 10);
+    Serial.print(".");
+    Serial.print(s_lastLoadPermille % 10);
+    Serial.println("% of block period");
+    for (uint8_t i = 0; i < s_numSlots; i++) {
+        Serial.print("  [");
+        Serial.print(i);
+        Serial.print("] ");
+        Serial.print(s_slots[i]->getName());
+        Serial.print(": level ");
+        Serial.print(s_slots[i]->getQualityLevel());
+        Serial.print("/");
+        Serial.println(s_slots[i]->getQualityLevelCount() - 1);
+    }
+    Serial.println("====================\n");
+}
+
+// ========== INTERNAL ==========
+
+uint32_t CpuGovernor::readAndResetPeakLoad() {
+    // Worst-case update() since last reset, in units of 64 CPU cycles
+    // (same reset the library's AudioProcessorUsageMaxReset() performs)
+    uint32_t peak = AudioStream::cpu_cycles_total_max;
+    AudioStream::cpu_cycles_total_max = AudioStream::cpu_cycles_total;
+
+    // Block period in the same units (F_CPU_ACTUAL tracks runtime clock changes)
+    uint32_t budget = static_cast<uint32_t>(
+        (static_cast<uint64_t>(F_CPU_ACTUAL) * AUDIO_BLOCK_SAMPLES) / (TimeKeeper::SAMPLE_RATE * 64ULL));
+    if (budget == 0) {
+        return 0;
+    }
+
+    return (peak * 1000) / budget;
+}
+
+bool CpuGovernor::degradeOneStep() {
+    for (uint8_t i = 0; i < s_numSlots; i++) {
+        AudioEffectBase* effect = s_slots[i];
+        uint8_t level = effect->getQualityLevel();
+        if (level + 1 < effect->getQualityLevelCount()) {
+            effect->setQualityLevel(level + 1);
+            TRACE(TRACE_GOVERNOR_DEGRADE, (i << 8) | (level + 1));
+            return true;
+        }
+    }
+    return false;  // Everything already at lowest quality
+}
+
+bool CpuGovernor::restoreOneStep() {
+    for (int8_t i = s_numSlots - 1; i >= 0; i--) {
+        AudioEffectBase* effect = s_slots[i];
+        uint8_t level = effect->getQualityLevel();
+        if (level > 0) {
+            effect->setQualityLevel(level - 1);
+            TRACE(TRACE_GOVERNOR_RESTORE, (i << 8) | (level - 1));
+            return true;
+        }
+    }
+    return false;  // Already at full quality
+}
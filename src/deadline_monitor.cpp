@@ -0,0 +1,190 @@
+#include "deadline_monitor.h"
+#include "timekeeper.h"
+#include "telemetry.h"
+
+AudioEffectBase* DeadlineMonitor::s_watched[MAX_WATCHED] = {};
+uint8_t DeadlineMonitor::s_numWatched = 0;
+
+volatile uint32_t DeadlineMonitor::s_cycleStart = 0;
+volatile bool DeadlineMonitor::s_haveLastStart = false;
+volatile bool DeadlineMonitor::s_inCycle = false;
+uint32_t DeadlineMonitor::s_budgetCycles = 0xFFFFFFFF;         // Disabled until begin()
+uint32_t DeadlineMonitor::s_deadlineCycles = 0xFFFFFFFF;
+uint32_t DeadlineMonitor::s_lateThresholdCycles = 0xFFFFFFFF;
+uint32_t DeadlineMonitor::s_deadlinePermille = 1000;
+
+volatile uint32_t DeadlineMonitor::s_overrunCount = 0;
+volatile uint32_t DeadlineMonitor::s_lateStartCount = 0;
+volatile uint32_t DeadlineMonitor::s_worstCycles = 0;
+
+volatile bool DeadlineMonitor::s_armed = false;
+volatile bool DeadlineMonitor::s_captured = false;
+
+// Snapshot lives in OCRAM (DMAMEM): ~8.5KB we don't want in DTCM.
+// Not zeroed at startup - only read after s_captured is set.
+DMAMEM DeadlineMonitor::Snapshot DeadlineMonitor::s_snapshot;
+
+bool DeadlineMonitor::watch(AudioEffectBase* effect) {
+    if (effect == nullptr) {
+        Serial.println("ERROR: DeadlineMonitor::watch() - effect is null");
+        return false;
+    }
+
+    if (s_numWatched >= MAX_WATCHED) {
+        Serial.print("ERROR: DeadlineMonitor::watch() - list full (max ");
+        Serial.print(MAX_WATCHED);
+        Serial.println(" effects)");
+        return false;
+    }
+
+    s_watched[s_numWatched++] = effect;
+    return true;
+}
+
+void DeadlineMonitor::begin() {
+    // One block period in CPU cycles (F_CPU_ACTUAL tracks runtime clock changes)
+    s_budgetCycles = static_cast<uint32_t>(
+        (static_cast<uint64_t>(F_CPU_ACTUAL) * AUDIO_BLOCK_SAMPLES) / TimeKeeper::SAMPLE_RATE);
+    s_lateThresholdCycles = s_budgetCycles + s_budgetCycles / 2;
+    setDeadlinePermille(s_deadlinePermille);
+
+    s_haveLastStart = false;  // Don't flag a gap on the very first cycle
+    rearm();
+}
+
+void DeadlineMonitor::setDeadlinePermille(uint32_t permille) {
+    if (permille < 100) permille = 100;
+    s_deadlinePermille = permille;
+    s_deadlineCycles = static_cast<uint32_t>((static_cast<uint64_t>(s_budgetCycles) * permille) / 1000);
+}
+
+void DeadlineMonitor::rearm() {
+    s_captured = false;
+    s_armed = true;
+}
+
+// ========== ISR PATH ==========
+
+void DeadlineMonitor::onMiss(Reason reason, uint32_t cycles) {
+    uint32_t us = cyclesToMicros(cycles);
+
+    if (reason == Reason::OVERRUN) {
+        s_overrunCount++;
+        Telemetry::add(TELEM_AUDIO_OVERRUNS, 1);
+        Telemetry::updateMax(TELEM_AUDIO_CYCLE_MAX, cycles);
+        TRACE(TRACE_AUDIO_OVERRUN, us > 0xFFFF ? 0xFFFF : us);
+    } else {
+        s_lateStartCount++;
+        Telemetry::add(TELEM_AUDIO_LATE_STARTS, 1);
+        TRACE(TRACE_AUDIO_LATE_START, us > 0xFFFF ? 0xFFFF : us);
+    }
+
+    if (s_armed) {
+        s_armed = false;  // One capture per arm: keep the first (root-cause) evidence
+        capture(reason, cycles);
+    }
+}
+
+void DeadlineMonitor::capture(Reason reason, uint32_t cycles) {
+    Snapshot& snap = s_snapshot;
+
+    snap.reason = reason;
+    snap.measuredCycles = cycles;
+    snap.budgetCycles = s_budgetCycles;
+    snap.timestampUs = micros();
+    snap.samplePosition = TimeKeeper::getSamplePosition();
+    snap.overrunCount = s_overrunCount;
+    snap.lateStartCount = s_lateStartCount;
+
+    snap.numEffects = s_numWatched;
+    for (uint8_t i = 0; i < s_numWatched; i++) {
+        const AudioEffectBase* effect = s_watched[i];
+        EffectSnapshot& es = snap.effects[i];
+        es.name = effect->getName();
+        es.enabled = effect->isEnabled();
+        es.stateCode = effect->getStateCode();
+        es.numEvents = effect->getScheduledEvents(es.events, MAX_EVENTS_PER_EFFECT);
+    }
+
+    snap.numTraceEvents = Trace::snapshot(snap.trace);
+
+    s_captured = true;
+}
+
+uint32_t DeadlineMonitor::cyclesToMicros(uint32_t cycles) {
+    return cycles / (F_CPU_ACTUAL / 1000000);
+}
+
+// ========== REPORTING (main loop) ==========
+
+void DeadlineMonitor::dumpSnapshot() {
+    Serial.println("\n=== AUDIO DEADLINE MONITOR ===");
+    Serial.print("Deadline: ");
+    Serial.print(cyclesToMicros(s_deadlineCycles));
+    Serial.print(" us (");
+    Serial.print(s_deadlinePermille / 10);
+    Serial.println("% of block period)");
+    Serial.print("Overruns: ");
+    Serial.print(s_overrunCount);
+    Serial.print(", late starts: ");
+    Serial.print(s_lateStartCount);
+    Serial.print(", worst cycle: ");
+    Serial.print(cyclesToMicros(s_worstCycles));
+    Serial.println(" us");
+
+    if (!s_captured) {
+        Serial.println(s_armed ? "No snapshot (armed)" : "No snapshot (disarmed)");
+        Serial.println("=== END DEADLINE MONITOR ===\n");
+        return;
+    }
+
+    const Snapshot& snap = s_snapshot;
+    Serial.println("--- Snapshot ---");
+    Serial.print("Reason: ");
+    Serial.println(snap.reason == Reason::OVERRUN ? "OVERRUN" : "LATE_START");
+    Serial.print("Measured: ");
+    Serial.print(cyclesToMicros(snap.measuredCycles));
+    Serial.print(" us (budget ");
+    Serial.print(cyclesToMicros(snap.budgetCycles));
+    Serial.println(" us)");
+    Serial.print("At: ");
+    Serial.print(snap.timestampUs);
+    Serial.print(" us, sample ");
+    Serial.println((uint32_t)snap.samplePosition);  // Print low 32 bits
+
+    for (uint8_t i = 0; i < snap.numEffects; i++) {
+        const EffectSnapshot& es = snap.effects[i];
+        Serial.print("  ");
+        Serial.print(es.name);
+        Serial.print(": ");
+        Serial.print(es.enabled ? "ENABLED" : "DISABLED");
+        Serial.print(" state=");
+        Serial.println(es.stateCode);
+        for (uint8_t j = 0; j < es.numEvents; j++) {
+            Serial.print("    pending ");
+            Serial.print(es.events[j].label);
+            Serial.print(" @ sample ");
+            Serial.print((uint32_t)es.events[j].atSample);
+            Serial.print(" (");
+            Serial.print(static_cast<int32_t>(es.events[j].atSample - snap.samplePosition));
+            Serial.println(" from capture)");
+        }
+    }
+
+    Serial.print("Trace at capture (");
+    Serial.print(snap.numTraceEvents);
+    Serial.println(" events):");
+    Serial.println("Timestamp(µs) | ID  | Value | Event");
+    for (size_t i = 0; i < snap.numTraceEvents; i++) {
+        const TraceEvent& e = snap.trace[i];
+        Serial.print(e.timestamp);
+        Serial.print(" | ");
+        Serial.print(e.eventId);
+        Serial.print(" | ");
+        Serial.print(e.value);
+        Serial.print(" | ");
+        Serial.println(Trace::eventName(e.eventId));
+    }
+
+    Serial.println("=== END DEADLINE MONITOR ===\n");
+}
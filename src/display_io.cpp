@@ -2,6 +2,7 @@
 #include "bitmaps.h"
 #include "spsc_queue.h"
 #include "trace.h"
+#include "log.h"
 #include <Adafruit_SSD1306.h>
 #include <Adafruit_GFX.h>
 #include <TeensyThreads.h>
@@ -60,8 +61,7 @@ static void drawBitmap(BitmapID id) {
 
     // Bounds check
     if (index >= NUM_BITMAPS) {
-        Serial.print("ERROR: Invalid bitmap ID: ");
-        Serial.println(index);
+        LOG_ERROR("Invalid bitmap ID: %u", index);
         return;
     }
 
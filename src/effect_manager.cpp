@@ -1,5 +1,6 @@
 #include "effect_manager.h"
 #include <Arduino.h>  // For Serial debug output
+#include "log.h"
 
 EffectManager::EffectEntry EffectManager::s_effects[MAX_EFFECTS] = {};
 
@@ -62,9 +63,8 @@ bool EffectManager::executeCommand(const Command& cmd) {
     AudioEffectBase* effect = getEffect(cmd.targetEffect);
     if (effect == nullptr) {
         // Effect not found - log error
-        Serial.print("ERROR: EffectManager::executeCommand() - effect ID ");
-        Serial.print(static_cast<uint8_t>(cmd.targetEffect));
-        Serial.println(" not registered");
+        LOG_ERROR("EffectManager::executeCommand() - effect ID %u not registered",
+                  static_cast<uint8_t>(cmd.targetEffect));
         return false;
     }
 
@@ -89,8 +89,7 @@ bool EffectManager::executeCommand(const Command& cmd) {
 
         default:
             // Unknown command type
-            Serial.print("ERROR: EffectManager::executeCommand() - unknown command type ");
-            Serial.println(static_cast<uint8_t>(cmd.type));
+            LOG_ERROR("EffectManager::executeCommand() - unknown command type %u", static_cast<uint8_t>(cmd.type));
             return false;
     }
 }
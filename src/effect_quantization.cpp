@@ -41,6 +41,20 @@ uint32_t samplesToNextQuantizedBoundary(Quantization quant) {
     return TimeKeeper::samplesToNextSubdivision(subdivision);
 }
 
+uint64_t actionSample(const Command& cmd) {
+    const uint64_t now = TimeKeeper::getSamplePosition();
+    return (cmd.isStamped() && cmd.sampleTime > now) ? cmd.sampleTime : now;
+}
+
+uint64_t quantizedSampleAfter(uint64_t at, Quantization quant) {
+    const uint32_t grid = calculateQuantizedDuration(quant);
+    uint64_t boundary = TimeKeeper::getSamplePosition() + samplesToNextQuantizedBoundary(quant);
+    if (grid > 0 && at >= boundary) {
+        boundary += ((at - boundary) / grid + 1) * grid;
+    }
+    return boundary;
+}
+
 BitmapID quantizationToBitmap(Quantization quant) {
     switch (quant) {
         case Quantization::QUANT_32: return BitmapID::QUANT_32;
@@ -1,4 +1,5 @@
 #include "encoder_io.h"
+#include "timekeeper.h"
 
 namespace EncoderIO {
 
@@ -11,7 +12,8 @@ static const uint8_t INT_PIN = 36;
 // Event queue to pass captured states from ISR to main loop
 struct EncoderEvent {
     uint16_t capturedPins;  // All 16 pins captured at interrupt time
-    uint32_t timestamp;     // When the interrupt fired
+    uint32_t timestamp;     // When the interrupt fired (millis, debounce)
+    uint64_t sampleTime;    // When the interrupt fired (sample position)
 };
 
 // Circular buffer for events (power of 2 for fast modulo)
@@ -42,6 +44,7 @@ static void encoderISR() {
     if (nextHead != eventQueueTail) {
         eventQueue[eventQueueHead].capturedPins = captured;
         eventQueue[eventQueueHead].timestamp = millis();
+        eventQueue[eventQueueHead].sampleTime = TimeKeeper::getSamplePosition();
         eventQueueHead = nextHead;
     }
     // If overflow, we drop this event (main loop can't keep up)
@@ -98,6 +101,7 @@ bool begin() {
         encoders[i].buttonLastState = mcp.digitalRead(encoderPins[i].pinSW);
         encoders[i].position = 0;
         encoders[i].lastDebounceTime = 0;
+        encoders[i].lastEventSample = 0;
     }
 
     // Enable interrupt-on-change for all pins
@@ -127,6 +131,7 @@ void update() {
         // Get next event from queue (copy volatile data to local)
         uint16_t pins = eventQueue[eventQueueTail].capturedPins;
         uint32_t timestamp = eventQueue[eventQueueTail].timestamp;
+        uint64_t sampleTime = eventQueue[eventQueueTail].sampleTime;
         eventQueueTail = (eventQueueTail + 1) & (EVENT_QUEUE_SIZE - 1);
 
         // Process all encoders with this captured state
@@ -143,6 +148,7 @@ void update() {
 
                 if (dir != 0) {
                     encoders[i].position += dir;
+                    encoders[i].lastEventSample = sampleTime;
                 }
 
                 encoders[i].lastState = currState;
@@ -157,6 +163,7 @@ void update() {
                 if ((timestamp - encoders[i].lastDebounceTime) > DEBOUNCE_TIME_MS) {
                     encoders[i].buttonPressed = true;
                     encoders[i].lastDebounceTime = timestamp;
+                    encoders[i].lastEventSample = sampleTime;
                 }
             }
 
@@ -181,6 +188,13 @@ bool getButton(uint8_t encoderNum) {
     return false;
 }
 
+uint64_t getEventSample(uint8_t encoderNum) {
+    if (encoderNum < 4) {
+        return encoders[encoderNum].lastEventSample;
+    }
+    return 0;
+}
+
 void resetPosition(uint8_t encoderNum) {
     if (encoderNum < 4) {
         encoders[encoderNum].position = 0;
@@ -1,12 +1,16 @@
 #include "freeze_controller.h"
 #include "input_io.h"
 #include "display_manager.h"
+#include "step_sequencer.h"
 #include "timekeeper.h"
+#include "log.h"
 #include <Arduino.h>
 
 FreezeController::FreezeController(AudioEffectFreeze& effect)
     : m_effect(effect),
-      m_currentParameter(Parameter::LENGTH) {
+      m_currentParameter(Parameter::LENGTH),
+      m_shownEnabled(false),
+      m_shownSequenced(false) {
 }
 
 BitmapID FreezeController::lengthToBitmap(FreezeLength length) {
@@ -53,41 +57,51 @@ bool FreezeController::handleButtonPress(const Command& cmd) {
     FreezeLength lengthMode = m_effect.getLengthMode();
     FreezeOnset onsetMode = m_effect.getOnsetMode();
 
+    // Press sample: now, or later for a press journal replay hands over early
+    const uint64_t at = EffectQuantization::actionSample(cmd);
+    const bool ahead = at > TimeKeeper::getSamplePosition();
+
     if (onsetMode == FreezeOnset::FREE) {
-        // FREE ONSET: Engage immediately
-        m_effect.enable();
+        // FREE ONSET: Engage on the press sample (immediately for a live press)
+        if (ahead) {
+            m_effect.scheduleOnset(at);
+        } else {
+            m_effect.enable();
+        }
 
         if (lengthMode == FreezeLength::QUANTIZED) {
             // FREE ONSET + QUANTIZED LENGTH
             Quantization quant = EffectQuantization::getGlobalQuantization();
             uint32_t durationSamples = EffectQuantization::calculateQuantizedDuration(quant);
-            uint64_t releaseSample = TimeKeeper::getSamplePosition() + durationSamples;
+            uint64_t releaseSample = at + durationSamples;
             m_effect.scheduleRelease(releaseSample);
 
-            Serial.print("Freeze ENGAGED (Free onset, Quantized length=");
-            Serial.print(EffectQuantization::quantizationName(quant));
-            Serial.println(")");
+            LOG_INFO("Freeze ENGAGED (Free onset, Quantized length=%s)", EffectQuantization::quantizationName(quant));
         } else {
             // FREE ONSET + FREE LENGTH
-            Serial.println("Freeze ENGAGED (Free onset, Free length)");
+            LOG_INFO("Freeze ENGAGED (Free onset, Free length)");
         }
 
-        // Update visual feedback
-        InputIO::setLED(EffectID::FREEZE, true);
-        DisplayManager::instance().setLastActivatedEffect(EffectID::FREEZE);
-        DisplayIO::showBitmap(BitmapID::FREEZE_ACTIVE);
+        // Update visual feedback (a scheduled onset shows when it fires)
+        if (!ahead) {
+            InputIO::setLED(EffectID::FREEZE, true);
+            DisplayManager::instance().setLastActivatedEffect(EffectID::FREEZE);
+            DisplayIO::showBitmap(BitmapID::FREEZE_ACTIVE);
+        }
         return true;  // Command handled
     } else {
         // QUANTIZED ONSET: Schedule for next boundary with lookahead offset
         Quantization quant = EffectQuantization::getGlobalQuantization();
-        uint32_t samplesToNext = EffectQuantization::samplesToNextQuantizedBoundary(quant);
+        // Next boundary after the press (from now for a live press)
+        uint64_t boundary = EffectQuantization::quantizedSampleAfter(at, quant);
+        uint32_t samplesToNext = static_cast<uint32_t>(boundary - at);
 
         // Apply lookahead offset (fire early to catch external audio transients)
         uint32_t lookahead = EffectQuantization::getLookaheadOffset();
         uint32_t adjustedSamples = (samplesToNext > lookahead) ? (samplesToNext - lookahead) : 0;
 
         // Calculate absolute sample position for onset
-        uint64_t onsetSample = TimeKeeper::getSamplePosition() + adjustedSamples;
+        uint64_t onsetSample = at + adjustedSamples;
 
         // Schedule onset in ISR (same as how length scheduling works)
         m_effect.scheduleOnset(onsetSample);
@@ -99,13 +113,8 @@ bool FreezeController::handleButtonPress(const Command& cmd) {
             m_effect.scheduleRelease(releaseSample);
         }
 
-        Serial.print("Freeze ONSET scheduled (");
-        Serial.print(EffectQuantization::quantizationName(quant));
-        Serial.print(" grid, ");
-        Serial.print(adjustedSamples);
-        Serial.print(" samples, lookahead=");
-        Serial.print(lookahead);
-        Serial.println(")");
+        LOG_INFO("Freeze ONSET scheduled (%s grid, %u samples, lookahead=%u)",
+                 EffectQuantization::quantizationName(quant), adjustedSamples, lookahead);
 
         return true;  // Command handled
     }
@@ -124,24 +133,42 @@ bool FreezeController::handleButtonRelease(const Command& cmd) {
 
     if (lengthMode == FreezeLength::QUANTIZED) {
         // QUANTIZED LENGTH: Ignore release (auto-releases)
-        Serial.println("Freeze button released (ignored - quantized length)");
+        LOG_INFO("Freeze button released (ignored - quantized length)");
         return true;  // Command handled (skip default disable)
     }
 
+    // Replayed ahead of time: release on the stamp, unless the onset has
+    // not fired by then (released before the boundary, as below)
+    if (EffectQuantization::actionSample(cmd) > TimeKeeper::getSamplePosition()) {
+        if (m_effect.isOnsetPending()) {
+            m_effect.cancelScheduledOnset();
+        } else {
+            m_effect.scheduleRelease(cmd.sampleTime);
+        }
+        return true;
+    }
+
     // FREE LENGTH: Check if we have scheduled onset via ISR API
     // QUANTIZED ONSET + FREE LENGTH: Cancel scheduled onset
     m_effect.cancelScheduledOnset();
-    Serial.println("Freeze scheduled onset CANCELLED (button released before beat)");
+    LOG_INFO("Freeze scheduled onset CANCELLED (button released before beat)");
 
     // FREE ONSET + FREE LENGTH: Fall through to default disable
     return false;  // Let EffectManager handle disable
 }
 
 void FreezeController::updateVisualFeedback() {
-    // Check for ISR-fired onset (QUANTIZED ONSET mode)
-    // Detect rising edge: freeze enabled but display not showing it yet
-    if (m_effect.isEnabled() && DisplayManager::instance().getLastActivatedEffect() != EffectID::FREEZE) {
-        // ISR fired onset - update visual feedback
+    // Edge detection on the effect itself: a scheduled onset/release fired in
+    // the ISR, or the step sequencer gated the freeze (the button handlers
+    // update LED and display themselves; repeating that here is harmless)
+    const bool enabled = m_effect.isEnabled();
+    if (enabled == m_shownEnabled) {
+        return;
+    }
+    m_shownEnabled = enabled;
+
+    if (enabled) {
+        m_shownSequenced = StepSequencer::holdsLane(StepSequencer::Lane::FREEZE);
         InputIO::setLED(EffectID::FREEZE, true);
         DisplayManager::instance().setLastActivatedEffect(EffectID::FREEZE);
         DisplayIO::showBitmap(BitmapID::FREEZE_ACTIVE);
@@ -150,30 +177,22 @@ void FreezeController::updateVisualFeedback() {
         FreezeOnset onsetMode = m_effect.getOnsetMode();
         FreezeLength lengthMode = m_effect.getLengthMode();
 
-        if (onsetMode == FreezeOnset::QUANTIZED) {
+        if (onsetMode == FreezeOnset::QUANTIZED && !m_shownSequenced) {
             Quantization quant = EffectQuantization::getGlobalQuantization();
-            Serial.print("Freeze ENGAGED at scheduled onset (");
-            Serial.print(EffectQuantization::quantizationName(quant));
-            Serial.print(" boundary, ");
-            Serial.print(lengthMode == FreezeLength::QUANTIZED ? "Quantized length)" : "Free length)");
-            Serial.println();
+            LOG_INFO("Freeze ENGAGED at scheduled onset (%s boundary, %s length)",
+                     EffectQuantization::quantizationName(quant),
+                     lengthMode == FreezeLength::QUANTIZED ? "Quantized" : "Free");
         }
+        return;
     }
 
-    // Check for auto-release (QUANTIZED LENGTH mode)
-    // Detect falling edge: freeze disabled but display still showing it
-    if (!m_effect.isEnabled() && DisplayManager::instance().getLastActivatedEffect() == EffectID::FREEZE) {
-        // Only auto-release if in QUANTIZED length mode
-        if (m_effect.getLengthMode() == FreezeLength::QUANTIZED) {
-            // Freeze auto-released - update display
-            DisplayManager::instance().setLastActivatedEffect(EffectID::NONE);
-            DisplayManager::instance().updateDisplay();
-
-            // Update LED to reflect disabled state
-            InputIO::setLED(EffectID::FREEZE, false);
-
-            // Debug output
-            Serial.println("Freeze auto-released (Quantized mode)");
-        }
+    // Released: LED off even if another effect took the display since
+    InputIO::setLED(EffectID::FREEZE, false);
+    if (DisplayManager::instance().getLastActivatedEffect() == EffectID::FREEZE) {
+        DisplayManager::instance().setLastActivatedEffect(EffectID::NONE);
+        DisplayManager::instance().updateDisplay();
+    }
+    if (m_effect.getLengthMode() == FreezeLength::QUANTIZED && !m_shownSequenced) {
+        LOG_INFO("Freeze auto-released (Quantized mode)");
     }
 }
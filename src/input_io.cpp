@@ -1,5 +1,6 @@
 #include "input_io.h"
 #include "spsc_queue.h"
+#include "timekeeper.h"
 #include "trace.h"
 #include <Adafruit_NeoKey_1x4.h>
 #include <seesaw_neopixel.h>
@@ -14,6 +15,9 @@ static constexpr uint8_t NUM_KEYS = 4;             // Neokey has 4 keys
 // This defers the I2C read (~20-50µs) out of the ISR context (~1µs)
 static volatile bool interruptPending = false;
 
+// Sample position when the ISR fired (the press time, before I2C/thread latency)
+static volatile uint64_t interruptSample = 0;
+
 static constexpr uint32_t LED_COLOR_RED = 0xFF0000;       // Choke engaged
 static constexpr uint32_t LED_COLOR_GREEN = 0x00FF00;     // Effect disabled (default)
 static constexpr uint32_t LED_COLOR_CYAN = 0x00FFFF;      // Freeze engaged
@@ -72,8 +76,9 @@ static constexpr size_t NUM_MAPPINGS = sizeof(buttonMappings) / sizeof(buttonMap
 // ISR: Called when Neokey detects any button change
 // OPTIMIZED: No I2C operations in ISR - just set a flag (<1µs)
 static void neokeyISR() {
-    // Simply flag that an interrupt occurred
+    // Simply flag that an interrupt occurred and when
     // The actual I2C read happens in threadLoop() outside ISR context
+    interruptSample = TimeKeeper::getSamplePosition();
     interruptPending = true;
 }
 
@@ -123,6 +128,7 @@ void InputIO::threadLoop() {
             // Clear flag atomically to prevent race with ISR
             noInterrupts();
             interruptPending = false;
+            uint64_t pressSample = interruptSample;
             interrupts();
 
             // Now perform the I2C read outside ISR context
@@ -146,8 +152,8 @@ void InputIO::threadLoop() {
                         // Update timestamp
                         lastEventTime[keyIndex] = now;
 
-                        // Emit appropriate command
-                        Command cmd = pressed ? mapping.pressCommand : mapping.releaseCommand;
+                        // Emit appropriate command, stamped with the interrupt time
+                        Command cmd = (pressed ? mapping.pressCommand : mapping.releaseCommand).at(pressSample);
 
                         // Only push non-NONE commands
                         if (cmd.type != CommandType::NONE) {
@@ -9,17 +9,29 @@
 #include "audio_freeze.h"
 #include "audio_choke.h"
 #include "audio_stutter.h"
+#include "audio_limiter.h"
+#include "audio_codec.h"
 #include "effect_manager.h"
+#include "cpu_governor.h"
+#include "deadline_monitor.h"
 #include "trace.h"
+#include "log.h"
+#include "telemetry.h"
+#include "stack_monitor.h"
 #include "timekeeper.h"
 #include "audio_timekeeper.h"
+#include "audio_cycle_markers.h"
+#include "remote_protocol.h"
 
+AudioCycleStart cycleStart;  // Deadline timing starts (keep declared first)
 AudioInputI2S i2s_in;
 AudioTimeKeeper timekeeper;  // Tracks sample position
 AudioEffectFreeze freeze;    // Circular buffer freeze effect
 AudioEffectChoke choke;      // Smooth mute effect
 AudioEffectStutter stutter;
+AudioEffectLimiter limiter;  // Output safety limiter (last stage before the I2S output)
 AudioOutputI2S i2s_out;
+AudioCycleEnd cycleEnd;      // Deadline timing ends (keep declared last)
 
 // Audio connections (stereo L+R)
 AudioConnection patchCord1(i2s_in, 0, timekeeper, 0);   // Left in → TimeKeeper
@@ -30,11 +42,34 @@ AudioConnection patchCord5(stutter, 0, freeze, 0);
 AudioConnection patchCord6(stutter, 1, freeze, 1);
 AudioConnection patchCord7(freeze, 1, choke, 0);
 AudioConnection patchCord8(freeze, 1, choke, 1);
-AudioConnection patchCord9(choke, 0, i2s_out, 0);       // Choke → Left out
-AudioConnection patchCord10(choke, 1, i2s_out, 1);       // Choke → Right out
+AudioConnection patchCord9(choke, 0, limiter, 0);
+AudioConnection patchCord10(choke, 1, limiter, 1);
+AudioConnection patchCord11(limiter, 0, i2s_out, 0);     // Limiter → Left out
+AudioConnection patchCord12(limiter, 1, i2s_out, 1);     // Limiter → Right out
 
 // Teensy Audio Library SGTL5000 control
-AudioControlSGTL5000 codec;
+AudioCodec codec;
+
+// Thread stacks (static so they can be painted before the threads start)
+static constexpr size_t IO_STACK_SIZE = 2048;
+static constexpr size_t INPUT_STACK_SIZE = 2048;
+static constexpr size_t DISPLAY_STACK_SIZE = 2048;
+static constexpr size_t APP_STACK_SIZE = 3072;
+static constexpr size_t LOG_STACK_SIZE = 2048;
+alignas(8) static uint8_t s_ioStack[IO_STACK_SIZE];
+alignas(8) static uint8_t s_inputStack[INPUT_STACK_SIZE];
+alignas(8) static uint8_t s_displayStack[DISPLAY_STACK_SIZE];
+alignas(8) static uint8_t s_appStack[APP_STACK_SIZE];
+alignas(8) static uint8_t s_logStack[LOG_STACK_SIZE];
+
+// Log thread: drains the log ring to Serial (the only thread that may block on USB)
+static constexpr size_t LOG_DRAIN_BATCH = 8;         // Messages per pass
+static constexpr uint32_t LOG_DRAIN_INTERVAL_MS = 20;
+
+// Stack high-water scan period (guard words are checked every loop)
+static constexpr uint32_t STACK_SCAN_INTERVAL_MS = 1000;
+static uint32_t s_lastStackScanMs = 0;
+static uint8_t s_stackGuardsReported = 0;
 
 void ioThreadEntry() {
     MidiIO::threadLoop();  // Never returns
@@ -52,14 +87,36 @@ void appThreadEntry() {
     AppLogic::threadLoop();  // Never returns
 }
 
+void logThreadEntry() {
+    while (1) {
+        // Sleep only once the ring is empty, so bursts drain in a few passes.
+        // A remote session forwards the log itself (text would break its frames)
+        if (RemoteProtocol::isActive() || Log::drain(Serial, LOG_DRAIN_BATCH) < LOG_DRAIN_BATCH) {
+            threads.delay(LOG_DRAIN_INTERVAL_MS);
+        } else {
+            threads.yield();
+        }
+    }
+}
+
 void setup() {
     Serial.begin(115200);
 
+    // Before anything records: keep the previous run's trace (warm reset only)
+    size_t recoveredEvents = Trace::begin();
+
     // Print crash report if available (from previous run)
     // DEBUGGING AID: If Teensy crashed, this tells us why
     if (CrashReport) {
         Serial.print(CrashReport);
     }
+    if (recoveredEvents > 0) {
+        Serial.print("Trace: ");
+        Serial.print(recoveredEvents);
+        Serial.print(" events recovered from boot #");
+        Serial.print(Trace::getBootCount() - 1);
+        Serial.println(" ('T' to dump)");
+    }
 
     Serial.println("=== MicroLoop Initializing ===");
 
@@ -73,6 +130,7 @@ void setup() {
             delay(100);
         }
     }
+    codec.setSampleRate(TimeKeeper::SAMPLE_RATE);  // enable() sets 44.1 kHz
 
     // Configure for line-in and line-out operation
     // IMPORTANT: Use MOTU M4 **REAR LINE INPUTS 3-4** (not front combo jacks!)
@@ -83,7 +141,9 @@ void setup() {
     codec.volume(0.3);  // Headphone volume (0.0-1.0) - start low to avoid clipping
     codec.unmuteHeadphone();  // Unmute headphone (for testing)
 
-    Serial.println("Audio: OK (using Teensy Audio Library SGTL5000)");
+    Serial.print("Audio: OK (using Teensy Audio Library SGTL5000, ");
+    Serial.print(TimeKeeper::SAMPLE_RATE);
+    Serial.println(" Hz)");
 
     TimeKeeper::begin();
     Serial.println("TimeKeeper: OK");
@@ -149,18 +209,46 @@ void setup() {
     Serial.print(EffectManager::getNumEffects());
     Serial.println(" effect(s)");
 
-    int ioThreadId = threads.addThread(ioThreadEntry, 2048);
-    int inputThreadId = threads.addThread(inputThreadEntry, 2048);
-    int displayThreadId = threads.addThread(displayThreadEntry, 2048);
-    int appThreadId = threads.addThread(appThreadEntry, 3072);
-
-    if (ioThreadId < 0 || inputThreadId < 0 || displayThreadId < 0 || appThreadId < 0) {
+    // Degradable effects, cheapest-to-degrade first
+    CpuGovernor::registerDegradable(&limiter);
+    CpuGovernor::registerDegradable(&stutter);  // WSOLA search range
+
+    // Audio ISR watchdog (snapshot includes these effects on overrun)
+    DeadlineMonitor::watch(&stutter);
+    DeadlineMonitor::watch(&freeze);
+    DeadlineMonitor::watch(&choke);
+    DeadlineMonitor::watch(&limiter);
+    DeadlineMonitor::begin();
+    Serial.println("Deadline Monitor: Armed");
+
+    // Effects reachable by the binary remote protocol (GET/SET_PARAM, telemetry)
+    RemoteProtocol::expose(static_cast<uint8_t>(EffectID::STUTTER), &stutter);
+    RemoteProtocol::expose(static_cast<uint8_t>(EffectID::FREEZE), &freeze);
+    RemoteProtocol::expose(static_cast<uint8_t>(EffectID::CHOKE), &choke);
+    RemoteProtocol::expose(RemoteMsg::EFFECT_LIMITER, &limiter);
+
+    // Paint stacks before any thread touches them
+    StackMonitor::registerStack("io", s_ioStack, IO_STACK_SIZE, TELEM_STACK_IO_USED);
+    StackMonitor::registerStack("input", s_inputStack, INPUT_STACK_SIZE, TELEM_STACK_INPUT_USED);
+    StackMonitor::registerStack("display", s_displayStack, DISPLAY_STACK_SIZE, TELEM_STACK_DISPLAY_USED);
+    StackMonitor::registerStack("app", s_appStack, APP_STACK_SIZE, TELEM_STACK_APP_USED);
+    StackMonitor::registerStack("log", s_logStack, LOG_STACK_SIZE, TELEM_STACK_LOG_USED);
+
+    // addThread(fn, arg, stack_size, stack) - size must be the third argument
+    int ioThreadId = threads.addThread(ioThreadEntry, 0, IO_STACK_SIZE, s_ioStack);
+    int inputThreadId = threads.addThread(inputThreadEntry, 0, INPUT_STACK_SIZE, s_inputStack);
+    int displayThreadId = threads.addThread(displayThreadEntry, 0, DISPLAY_STACK_SIZE, s_displayStack);
+    int appThreadId = threads.addThread(appThreadEntry, 0, APP_STACK_SIZE, s_appStack);
+    int logThreadId = threads.addThread(logThreadEntry, 0, LOG_STACK_SIZE, s_logStack);
+
+    if (ioThreadId < 0 || inputThreadId < 0 || displayThreadId < 0 || appThreadId < 0 || logThreadId < 0) {
         Serial.println("ERROR: Thread creation failed!");
         while (1);  // Halt
     }
 
     // threads.setTimeSlice(ioThreadId, 2);   // 2ms - very responsive
     // threads.setTimeSlice(appThreadId, 5);  // 5ms - moderate
+    threads.setTimeSlice(logThreadId, 1);  // No priorities in TeensyThreads: shortest slice = background
 
     Serial.println("Threads: Started");
     Serial.println("=== MicroLoop Running ===");
@@ -168,7 +256,27 @@ void setup() {
     Serial.println("Commands:");
     Serial.println("  't' - Dump trace buffer");
     Serial.println("  'c' - Clear trace buffer");
+    Serial.println("  'T' - Dump the previous run's trace (after a crash or reset)");
     Serial.println("  's' - Show TimeKeeper status");
+    Serial.println("  'm' - Dump telemetry (resets limiter min gain, shows log drops)");
+    Serial.println("  'l' - Toggle output limiter bypass");
+    Serial.println("  'g' - Show CPU governor status");
+    Serial.println("  'G' - Toggle CPU governor (off = full quality)");
+    Serial.println("  'o' - Dump audio overrun snapshot and re-arm");
+    Serial.println("  'k' - Show thread stack usage");
+    Serial.println("  'R' - Start/stop journal recording");
+    Serial.println("  'P' - Start/stop journal replay (looped, from the next bar)");
+    Serial.println("  'j' - Dump performance journal");
+    Serial.println("  'q' - Start/stop step sequencer (from the next bar)");
+    Serial.println("  'r' - Looper record / close loop (next bar)");
+    Serial.println("  'd' - Looper overdub on/off (next bar)");
+    Serial.println("  'x' - Looper clear");
+    Serial.println("  'u' - Undo last overdub pass ('U' redo)");
+    Serial.println("  '1'/'2'/'4' - Loop the last 1/2/4 bars (pre-roll, no wait)");
+    Serial.println("  'w' - Loop time-stretch on/off (follow tempo changes)");
+    Serial.println("  'f' - Cycle overdub feedback (100/90/75/50%)");
+    Serial.println("  'Q' - Switch pattern length 16/32 (logs the pattern)");
+    Serial.println("  0x00 - Binary remote session (host/tools/microloop_remote)");
     Serial.println();
 }
 
@@ -176,8 +284,23 @@ void loop() {
     // Process encoder events (drains queue from ISR)
     EncoderIO::update();
 
+    // Stack guard check every pass (cheap), full high-water scan periodically
+    uint8_t guardsHit = StackMonitor::checkGuards();
+    if (guardsHit > s_stackGuardsReported) {
+        s_stackGuardsReported = guardsHit;
+        LOG_WARN("Thread stack guard zone reached ('k' for details)");
+    }
+    uint32_t nowMs = millis();
+    if (nowMs - s_lastStackScanMs >= STACK_SCAN_INTERVAL_MS) {
+        s_lastStackScanMs = nowMs;
+        StackMonitor::scan();
+    }
+
+    // Binary remote session: owns Serial while active
+    RemoteProtocol::poll();
+
     // Check for serial commands (non-blocking)
-    if (Serial.available()) {
+    if (!RemoteProtocol::isActive() && Serial.available()) {
         char cmd = Serial.read();
         switch (cmd) {
             case 't':  // Dump trace buffer
@@ -185,6 +308,10 @@ void loop() {
                 Trace::dump();
                 break;
 
+            case 'T':  // Trace recovered from the previous run
+                Trace::dumpPrevious();
+                break;
+
             case 'c':  // Clear trace buffer
                 Serial.println("\n[Clearing trace buffer...]");
                 Trace::clear();
@@ -221,6 +348,121 @@ void loop() {
                 Serial.println("=========================\n");
                 break;
 
+            case 'm': {  // Dump telemetry
+                Telemetry::dump();
+                uint32_t minGain = Telemetry::exchange(TELEM_LIMITER_GAIN_MIN, AudioEffectLimiter::GAIN_UNITY);
+                Serial.print("Limiter: ");
+                Serial.println(limiter.isEnabled() ? "ACTIVE" : "BYPASSED");
+                Serial.print("Max gain reduction: ");
+                Serial.print(-20.0f * log10f((float)(minGain > 0 ? minGain : 1) / AudioEffectLimiter::GAIN_UNITY), 2);
+                Serial.println(" dB (window reset)");
+                Serial.print("Log: ");
+                Serial.print(Log::pending());
+                Serial.print(" pending, ");
+                Serial.print(Log::getDroppedCount());
+                Serial.println(" dropped since boot");
+                break;
+            }
+
+            case 'l':  // Toggle limiter bypass
+                limiter.toggle();
+                Serial.print("Limiter: ");
+                Serial.println(limiter.isEnabled() ? "ACTIVE" : "BYPASSED");
+                break;
+
+            case 'g':  // CPU governor status
+                CpuGovernor::printStatus();
+                break;
+
+            case 'G':  // Toggle CPU governor
+                CpuGovernor::setEnabled(!CpuGovernor::isEnabled());
+                Serial.print("CPU Governor: ");
+                Serial.println(CpuGovernor::isEnabled() ? "AUTO" : "OFF");
+                break;
+
+            case 'o':  // Dump deadline monitor snapshot, then re-arm capture
+                DeadlineMonitor::dumpSnapshot();
+                DeadlineMonitor::rearm();
+                Serial.println("Deadline monitor re-armed.");
+                break;
+
+            case 'k':  // Thread stack high-water marks
+                StackMonitor::scan();
+                StackMonitor::printReport();
+                break;
+
+            case 'R':  // Journal record / replay / contents: the journal lives on the app thread
+            case 'P':
+            case 'j': {
+                CommandType type = (cmd == 'R') ? CommandType::JOURNAL_RECORD
+                                 : (cmd == 'P') ? CommandType::JOURNAL_REPLAY
+                                                : CommandType::JOURNAL_DUMP;
+                if (!AppLogic::postCommand(Command{type, EffectID::NONE}.at(TimeKeeper::getSamplePosition()))) {
+                    Serial.println("WARNING: command queue full");
+                }
+                break;
+            }
+
+            case 'r':  // Looper commands go through the app thread like buttons
+            case 'd':
+            case 'x':
+            case 'u':
+            case 'U': {
+                CommandType type = (cmd == 'r') ? CommandType::LOOP_RECORD
+                                 : (cmd == 'd') ? CommandType::LOOP_OVERDUB
+                                 : (cmd == 'x') ? CommandType::LOOP_CLEAR
+                                 : (cmd == 'u') ? CommandType::LOOP_UNDO
+                                                : CommandType::LOOP_REDO;
+                if (!AppLogic::postCommand(Command{type, EffectID::STUTTER}.at(TimeKeeper::getSamplePosition()))) {
+                    Serial.println("WARNING: command queue full");
+                }
+                break;
+            }
+
+            case '1':  // Retro capture: loop the last 1/2/4 bars from the pre-roll
+            case '2':
+            case '4': {
+                Command retro{CommandType::LOOP_RETRO, EffectID::STUTTER, static_cast<uint32_t>(cmd - '0')};
+                if (!AppLogic::postCommand(retro.at(TimeKeeper::getSamplePosition()))) {
+                    Serial.println("WARNING: command queue full");
+                }
+                break;
+            }
+
+            case 'w':  // Loop time-stretch on/off
+                if (stutter.isStretching()) {
+                    Serial.print("Loop time-stretch speed: ");
+                    Serial.println(stutter.getStretchSpeed(), 4);
+                }
+                stutter.setStretchMode(stutter.getStretchMode() == StutterStretch::OFF ? StutterStretch::WSOLA
+                                                                                       : StutterStretch::OFF);
+                Serial.print("Loop time-stretch: ");
+                Serial.println(stutter.getStretchMode() == StutterStretch::WSOLA ? "ON (follows tempo)" : "OFF");
+                break;
+
+            case 'f': {  // Overdub feedback: 100 -> 90 -> 75 -> 50 -> 100%
+                float feedback = stutter.getOverdubFeedback();
+                feedback = (feedback > 0.95f) ? 0.9f : (feedback > 0.8f) ? 0.75f : (feedback > 0.6f) ? 0.5f : 1.0f;
+                stutter.setOverdubFeedback(feedback);
+                Serial.print("Overdub feedback: ");
+                Serial.print(static_cast<int>(feedback * 100.0f + 0.5f));
+                Serial.println("%");
+                break;
+            }
+
+            case 'q':  // Sequencer keys go through the app thread (it edits the pattern too)
+            case 'Q': {
+                CommandType type = (cmd == 'q') ? CommandType::SEQ_TOGGLE : CommandType::SEQ_LENGTH;  // Length 0: switch
+                if (!AppLogic::postCommand(Command{type, EffectID::NONE}.at(TimeKeeper::getSamplePosition()))) {
+                    Serial.println("WARNING: command queue full");
+                }
+                break;
+            }
+
+            case '\0':  // COBS frame delimiter: a host opens a binary session
+                RemoteProtocol::activate();
+                break;
+
             case '\n':
             case '\r':
                 // Ignore newlines
@@ -229,10 +471,10 @@ void loop() {
             default:
                 Serial.print("Unknown command: ");
                 Serial.println(cmd);
-                Serial.println("Commands: 't' (dump trace), 'c' (clear trace), 's' (status)");
+                Serial.println("Commands: 't' (dump trace), 'T' (previous run), 'c' (clear trace), 's' (status), 'm' (telemetry), 'l' (limiter), 'g'/'G' (governor), 'o' (overruns), 'k' (stacks), 'R'/'P'/'j' (journal), 'q'/'Q' (sequencer), 'r'/'d'/'x'/'u'/'U'/'1'/'2'/'4'/'w'/'f' (looper)");
                 break;
         }
     }
 
-    delay(10);  // Don't hog CPU
+    delay(RemoteProtocol::isActive() ? 1 : 10);  // Don't hog CPU (shorter while a host is waiting for replies)
 }
\ No newline at end of file
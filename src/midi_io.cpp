@@ -2,6 +2,7 @@
 #include <MIDI.h>
 #include <TeensyThreads.h>
 #include "spsc_queue.h"
+#include "timekeeper.h"
 #include "trace.h"
 
 // Create MIDI instance on Serial8 (RX8=pin34, TX8=pin35)
@@ -9,7 +10,13 @@ MIDI_CREATE_INSTANCE(HardwareSerial, Serial8, DIN);
 
 // Lock-free queues using our generic SPSC implementation
 static SPSCQueue<uint32_t, 256> clockQueue;  // Timestamps in microseconds
-static SPSCQueue<MidiEvent, 32> eventQueue;  // Transport events
+
+// Transport event, stamped with the sample position it was parsed at
+struct TimedMidiEvent {
+    MidiEvent event;
+    uint64_t sampleTime;
+};
+static SPSCQueue<TimedMidiEvent, 32> eventQueue;  // Transport events
 
 // Transport state (volatile for cross-thread visibility)
 static volatile bool transportRunning = false;
@@ -30,19 +37,23 @@ static void onClock() {
     }
 }
 
+static void pushEvent(MidiEvent event) {
+    eventQueue.push(TimedMidiEvent{ event, TimeKeeper::getSamplePosition() });
+}
+
 static void onStart() {
     transportRunning = true;
-    eventQueue.push(MidiEvent::START);
+    pushEvent(MidiEvent::START);
 }
 
 static void onStop() {
     transportRunning = false;
-    eventQueue.push(MidiEvent::STOP);
+    pushEvent(MidiEvent::STOP);
 }
 
 static void onContinue() {
     transportRunning = true;
-    eventQueue.push(MidiEvent::CONTINUE);
+    pushEvent(MidiEvent::CONTINUE);
 }
 
 // Public API Implementation
@@ -78,8 +89,19 @@ void MidiIO::threadLoop() {
 }
 
 bool MidiIO::popEvent(MidiEvent& outEvent) {
+    uint64_t sampleTime;
+    return popEvent(outEvent, sampleTime);
+}
+
+bool MidiIO::popEvent(MidiEvent& outEvent, uint64_t& outSampleTime) {
     // SPSC queue pop is lock-free and O(1)
-    return eventQueue.pop(outEvent);
+    TimedMidiEvent timed;
+    if (!eventQueue.pop(timed)) {
+        return false;
+    }
+    outEvent = timed.event;
+    outSampleTime = timed.sampleTime;
+    return true;
 }
 
 bool MidiIO::popClock(uint32_t& outMicros) {
@@ -0,0 +1,294 @@
+#include "performance_journal.h"
+#include "timekeeper.h"
+#include "trace.h"
+#include "log.h"
+#include <string.h>
+
+DMAMEM JournalEntry PerformanceJournal::s_entries[PerformanceJournal::MAX_ENTRIES];
+uint16_t PerformanceJournal::s_count = 0;
+uint32_t PerformanceJournal::s_lengthBars = 0;
+uint32_t PerformanceJournal::s_dropped = 0;
+
+bool PerformanceJournal::s_recording = false;
+uint64_t PerformanceJournal::s_recordAnchor = 0;
+
+bool PerformanceJournal::s_replaying = false;
+bool PerformanceJournal::s_replayLoop = false;
+uint64_t PerformanceJournal::s_replayAnchor = 0;
+uint16_t PerformanceJournal::s_replayCursor = 0;
+uint32_t PerformanceJournal::s_replayPass = 0;
+ControllerHandler PerformanceJournal::s_controllerHandler;
+
+// ========== RECORDING ==========
+
+bool PerformanceJournal::startRecording() {
+    const uint32_t spbar = samplesPerBar();
+    if (!TimeKeeper::isRunning() || spbar == 0) {
+        LOG_ERROR("PerformanceJournal::startRecording() - transport not running");
+        return false;
+    }
+
+    stopReplay();
+    clear();
+
+    // Anchor on the bar line the performer is in (TimeKeeper's MIDI bar
+    // grid), so bar 0 is this bar
+    const uint64_t now = TimeKeeper::getSamplePosition();
+    const uint32_t toNext = TimeKeeper::samplesToNextBar();
+    const uint32_t withinBar = (toNext == spbar) ? 0 : spbar - toNext;
+    s_recordAnchor = (now > withinBar) ? now - withinBar : 0;
+    s_recording = true;
+
+    TRACE(TRACE_JOURNAL_RECORD, 1);
+    return true;
+}
+
+void PerformanceJournal::record(const Command& cmd) {
+    if (!s_recording) {
+        return;
+    }
+    if (s_count >= MAX_ENTRIES) {
+        s_dropped++;
+        return;
+    }
+
+    // Position from the source stamp; unstamped commands happened "now"
+    uint64_t at = cmd.isStamped() ? cmd.sampleTime : TimeKeeper::getSamplePosition();
+    if (at < s_recordAnchor) {
+        at = s_recordAnchor;  // Pressed before the bar we anchored on
+    }
+
+    const uint32_t spbar = samplesPerBar();
+    const uint64_t offset = at - s_recordAnchor;
+    const uint32_t withinBar = static_cast<uint32_t>(offset % spbar);
+
+    JournalEntry& entry = s_entries[s_count];
+    entry.cmd = cmd.at(at);
+    entry.bar = static_cast<uint32_t>(offset / spbar);
+    entry.barPhase = static_cast<uint32_t>((static_cast<uint64_t>(withinBar) << PHASE_BITS) / spbar);
+    s_count++;
+}
+
+void PerformanceJournal::stopRecording() {
+    if (!s_recording) {
+        return;
+    }
+    s_recording = false;
+    TRACE(TRACE_JOURNAL_RECORD, 0);
+
+    // Take length: nearest whole bar to where recording stopped, but never
+    // shorter than the bar holding the last entry
+    uint32_t bars = 1;
+    const uint32_t spbar = samplesPerBar();
+    if (spbar > 0) {
+        const uint64_t elapsed = TimeKeeper::getSamplePosition() - s_recordAnchor;
+        bars = static_cast<uint32_t>((elapsed + spbar / 2) / spbar);
+    }
+    if (s_count > 0 && bars < s_entries[s_count - 1].bar + 1) {
+        bars = s_entries[s_count - 1].bar + 1;
+    }
+    s_lengthBars = bars > 0 ? bars : 1;
+}
+
+// ========== REPLAY ==========
+
+bool PerformanceJournal::startReplay(bool loop) {
+    if (s_recording) {
+        LOG_ERROR("PerformanceJournal::startReplay() - still recording");
+        return false;
+    }
+    const uint32_t spbar = samplesPerBar();
+    if (!TimeKeeper::isRunning() || spbar == 0) {
+        LOG_ERROR("PerformanceJournal::startReplay() - transport not running");
+        return false;
+    }
+
+    bool any = false;
+    for (uint16_t i = 0; i < s_count && !any; i++) {
+        any = isReplayable(s_entries[i].cmd);
+    }
+    if (!any) {
+        LOG_ERROR("PerformanceJournal::startReplay() - nothing to replay");
+        return false;
+    }
+
+    // Next bar line (exactly on a bar line: the bar that starts now)
+    const uint64_t now = TimeKeeper::getSamplePosition();
+    const uint32_t toNext = TimeKeeper::samplesToNextBar();
+    s_replayAnchor = (toNext == spbar) ? now : now + toNext;
+    s_replayCursor = 0;
+    s_replayPass = 0;
+    s_replayLoop = loop;
+    s_replaying = true;
+
+    TRACE(TRACE_JOURNAL_REPLAY, 1);
+    return true;
+}
+
+void PerformanceJournal::stopReplay() {
+    // Commands already posted still fire (at most LOOKAHEAD_SAMPLES ahead)
+    if (s_replaying) {
+        TRACE(TRACE_JOURNAL_REPLAY, 0);
+    }
+    s_replaying = false;
+}
+
+void PerformanceJournal::setControllerHandler(ControllerHandler handler) {
+    s_controllerHandler = handler;
+}
+
+void PerformanceJournal::update() {
+    if (!s_replaying) {
+        return;
+    }
+    const uint32_t spbar = samplesPerBar();
+    if (spbar == 0) {
+        return;
+    }
+
+    const uint64_t horizon = TimeKeeper::getSamplePosition() + LOOKAHEAD_SAMPLES;
+
+    while (s_replaying) {
+        if (s_replayCursor >= s_count) {
+            if (!s_replayLoop) {
+                s_replaying = false;
+                break;
+            }
+            s_replayCursor = 0;
+            s_replayPass++;
+        }
+
+        const JournalEntry& entry = s_entries[s_replayCursor];
+        if (!isReplayable(entry.cmd)) {
+            s_replayCursor++;
+            continue;
+        }
+
+        const uint64_t bar = static_cast<uint64_t>(s_replayPass) * s_lengthBars + entry.bar;
+        const uint64_t target = s_replayAnchor + bar * spbar +
+                                ((static_cast<uint64_t>(entry.barPhase) * spbar) >> PHASE_BITS);
+        if (target > horizon) {
+            break;
+        }
+        // Controller not ready: retry on the next loop
+        if (!s_controllerHandler(entry.cmd.at(target))) {
+            break;
+        }
+        s_replayCursor++;
+    }
+}
+
+void PerformanceJournal::onTransportChange() {
+    stopRecording();
+    stopReplay();
+}
+
+// ========== CONTENTS ==========
+
+const JournalEntry* PerformanceJournal::getEntry(uint16_t index) {
+    return index < s_count ? &s_entries[index] : nullptr;
+}
+
+void PerformanceJournal::clear() {
+    s_count = 0;
+    s_lengthBars = 0;
+    s_dropped = 0;
+}
+
+bool PerformanceJournal::isControllerCommand(const Command& cmd) {
+    // Buttons and the looper: each goes through its effect's controller
+    if (cmd.type >= CommandType::LOOP_RECORD && cmd.type <= CommandType::LOOP_RETRO) {
+        return true;
+    }
+    if (cmd.targetEffect == EffectID::NONE) {
+        return false;
+    }
+    return cmd.type == CommandType::EFFECT_ENABLE || cmd.type == CommandType::EFFECT_DISABLE ||
+           cmd.type == CommandType::EFFECT_TOGGLE;
+}
+
+bool PerformanceJournal::isReplayable(const Command& cmd) {
+    return isControllerCommand(cmd) && s_controllerHandler;
+}
+
+uint32_t PerformanceJournal::samplesPerBar() {
+    return TimeKeeper::getSamplesPerBeat() * TimeKeeper::BEATS_PER_BAR;
+}
+
+// ========== SAVE / LOAD ==========
+
+size_t PerformanceJournal::serializedSize() {
+    return sizeof(Header) + static_cast<size_t>(s_count) * sizeof(JournalEntry);
+}
+
+size_t PerformanceJournal::serialize(uint8_t* out, size_t capacity) {
+    const size_t size = serializedSize();
+    if (out == nullptr || capacity < size) {
+        LOG_ERROR("PerformanceJournal::serialize() - buffer too small");
+        return 0;
+    }
+
+    Header header = {};
+    header.magic = MAGIC;
+    header.version = FORMAT_VERSION;
+    header.entrySize = sizeof(JournalEntry);
+    header.count = s_count;
+    header.lengthBars = s_lengthBars;
+
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), s_entries, static_cast<size_t>(s_count) * sizeof(JournalEntry));
+    return size;
+}
+
+bool PerformanceJournal::deserialize(const uint8_t* data, size_t size) {
+    Header header;
+    if (data == nullptr || size < sizeof(header)) {
+        LOG_ERROR("PerformanceJournal::deserialize() - truncated header");
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if (header.magic != MAGIC || header.version != FORMAT_VERSION || header.entrySize != sizeof(JournalEntry)) {
+        LOG_ERROR("PerformanceJournal::deserialize() - not a journal (magic/version/entry size)");
+        return false;
+    }
+    if (header.count > MAX_ENTRIES || size < sizeof(header) + header.count * sizeof(JournalEntry)) {
+        LOG_ERROR("PerformanceJournal::deserialize() - bad entry count");
+        return false;
+    }
+
+    s_recording = false;
+    s_replaying = false;
+    memcpy(s_entries, data + sizeof(header), header.count * sizeof(JournalEntry));
+    s_count = header.count;
+    s_lengthBars = header.lengthBars > 0 ? header.lengthBars : 1;
+    s_dropped = 0;
+    return true;
+}
+
+void PerformanceJournal::dump() {
+    Serial.print("Journal: ");
+    Serial.print(s_count);
+    Serial.print(" entries, ");
+    Serial.print(s_lengthBars);
+    Serial.print(" bars");
+    if (s_dropped > 0) {
+        Serial.print(", ");
+        Serial.print(s_dropped);
+        Serial.print(" dropped");
+    }
+    Serial.println(s_recording ? " (recording)" : s_replaying ? " (replaying)" : "");
+
+    for (uint16_t i = 0; i < s_count; i++) {
+        const JournalEntry& e = s_entries[i];
+        Serial.print("  bar ");
+        Serial.print(e.bar);
+        Serial.print(" + ");
+        Serial.print(static_cast<uint32_t>((e.barPhase * 1000ULL) >> PHASE_BITS));
+        Serial.print("/1000  type ");
+        Serial.print(static_cast<uint8_t>(e.cmd.type));
+        Serial.print(" effect ");
+        Serial.print(static_cast<uint8_t>(e.cmd.targetEffect));
+        Serial.println(isReplayable(e.cmd) ? "" : "  (not replayed)");
+    }
+}
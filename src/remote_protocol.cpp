@@ -0,0 +1,418 @@
+#include "remote_protocol.h"
+#include "app_logic.h"
+#include "audio_event_queue.h"
+#include "cobs.h"
+#include "deadline_monitor.h"
+#include "log.h"
+#include "telemetry.h"
+#include "timekeeper.h"
+#include <Audio.h>
+
+using namespace RemoteMsg;
+
+RemoteProtocol::Exposed RemoteProtocol::s_exposed[MAX_EXPOSED] = {};
+uint8_t RemoteProtocol::s_numExposed = 0;
+bool RemoteProtocol::s_active = false;
+uint32_t RemoteProtocol::s_lastRxMs = 0;
+uint16_t RemoteProtocol::s_telemetryPeriodMs = 0;
+uint32_t RemoteProtocol::s_lastTelemetryMs = 0;
+uint8_t RemoteProtocol::s_transferType = 0;
+uint8_t RemoteProtocol::s_transferSeq = 0;
+uint32_t RemoteProtocol::s_transferOffset = 0;
+uint32_t RemoteProtocol::s_transferTotal = 0;
+bool RemoteProtocol::s_setPending = false;
+uint8_t RemoteProtocol::s_setSeq = 0;
+uint8_t RemoteProtocol::s_setAddress = 0;
+uint8_t RemoteProtocol::s_setParam = 0;
+DMAMEM TraceEvent RemoteProtocol::s_traceCopy[Trace::BUFFER_SIZE];
+
+static FrameDecoder<MAX_PACKET> s_decoder;
+
+// Wire size of the largest frame (each frame goes out in one Serial.write)
+static constexpr size_t MAX_WIRE = Cobs::maxFrameSize(MAX_PACKET);
+
+// Room for one more frame without blocking loop() (a host that stopped
+// reading fills the USB TX buffer; Serial.write() would then wait for it)
+static bool txRoom() {
+    return Serial.availableForWrite() >= static_cast<int>(MAX_WIRE);
+}
+
+/**
+ * Print adapter for Log::drain(): one LOG packet per formatted line
+ */
+class LogPacketPrint : public Print {
+public:
+    size_t write(uint8_t b) override {
+        if (b == '\r') {
+            return 1;
+        }
+        if (b == '\n') {
+            flushLine();
+            return 1;
+        }
+        if (m_length < MAX_BODY) {
+            m_line[m_length++] = b;  // Longer lines are truncated
+        }
+        return 1;
+    }
+
+    void flushLine() {
+        if (m_length > 0) {
+            m_send(LOG, 0, m_line, m_length);
+            m_length = 0;
+        }
+    }
+
+    explicit LogPacketPrint(void (*send)(uint8_t, uint8_t, const uint8_t*, size_t)) : m_send(send) {}
+
+private:
+    void (*m_send)(uint8_t, uint8_t, const uint8_t*, size_t);
+    uint8_t m_line[MAX_BODY];
+    size_t m_length = 0;
+};
+
+// ========== SETUP ==========
+
+bool RemoteProtocol::expose(uint8_t address, AudioEffectBase* effect) {
+    if (effect == nullptr) {
+        Serial.println("ERROR: RemoteProtocol::expose() - effect is null");
+        return false;
+    }
+    if (s_numExposed >= MAX_EXPOSED) {
+        Serial.print("ERROR: RemoteProtocol::expose() - table full (max ");
+        Serial.print(MAX_EXPOSED);
+        Serial.println(" effects)");
+        return false;
+    }
+    s_exposed[s_numExposed++] = Exposed{address, effect};
+    return true;
+}
+
+AudioEffectBase* RemoteProtocol::findEffect(uint8_t address) {
+    for (uint8_t i = 0; i < s_numExposed; i++) {
+        if (s_exposed[i].address == address) {
+            return s_exposed[i].effect;
+        }
+    }
+    return nullptr;
+}
+
+// ========== SESSION ==========
+
+void RemoteProtocol::activate() {
+    s_decoder.reset();
+    s_telemetryPeriodMs = 0;
+    s_transferType = 0;
+    s_setPending = false;
+    s_lastRxMs = millis();
+    s_active = true;
+
+    // Terminates any text the host received before the session: its frame
+    // decoder drops it as one bad frame instead of merging it with ours
+    const uint8_t delimiter = Cobs::DELIMITER;
+    Serial.write(&delimiter, 1);
+}
+
+void RemoteProtocol::deactivate(const char* reason) {
+    s_active = false;
+    s_telemetryPeriodMs = 0;
+    s_transferType = 0;
+    s_setPending = false;
+    LOG_INFO("Remote: session closed (%s)", reason);
+}
+
+void RemoteProtocol::poll() {
+    if (!s_active) {
+        return;
+    }
+
+    // Bytes after a BYE stay in Serial RX for the text console
+    while (s_active && Serial.available()) {
+        const uint8_t byte = static_cast<uint8_t>(Serial.read());
+        switch (s_decoder.feed(byte)) {
+            case FrameDecoder<MAX_PACKET>::FRAME:
+                s_lastRxMs = millis();
+                handlePacket(s_decoder.packet(), s_decoder.packetLength());
+                break;
+            case FrameDecoder<MAX_PACKET>::BAD_FRAME:
+            case FrameDecoder<MAX_PACKET>::OVERSIZED:
+                sendStatus(ERROR, 0, ERR_BAD_FRAME);
+                break;
+            case FrameDecoder<MAX_PACKET>::NONE:
+                break;
+        }
+    }
+    if (!s_active) {
+        return;
+    }
+
+    const uint32_t nowMs = millis();
+    if (s_transferType != 0) {
+        s_lastRxMs = nowMs;  // A running transfer keeps the session open
+    } else if (nowMs - s_lastRxMs >= IDLE_TIMEOUT_MS) {
+        deactivate("idle timeout");
+        return;
+    }
+
+    // SET_PARAM reply once the app thread wrote the value (read-back is the new value)
+    if (s_setPending && AppLogic::parametersApplied()) {
+        AudioEffectBase* effect = findEffect(s_setAddress);
+        s_setPending = false;
+        sendParam(s_setSeq, s_setAddress, s_setParam, effect->getParameter(s_setParam));
+    }
+
+    // A snapshot the host cannot take now is skipped, not queued
+    if (s_telemetryPeriodMs > 0 && nowMs - s_lastTelemetryMs >= s_telemetryPeriodMs && txRoom()) {
+        s_lastTelemetryMs = nowMs;
+        sendTelemetry(0);
+    }
+
+    continueTransfer();
+    forwardLog();
+}
+
+// ========== REQUESTS ==========
+
+void RemoteProtocol::handlePacket(const uint8_t* packet, size_t length) {
+    if (length < HEADER_BYTES) {
+        sendStatus(ERROR, 0, ERR_BAD_LENGTH);
+        return;
+    }
+    const uint8_t type = packet[0];
+    const uint8_t seq = packet[1];
+    const uint8_t* body = packet + HEADER_BYTES;
+    const size_t bodyLength = length - HEADER_BYTES;
+
+    switch (type) {
+        case HELLO: {
+            // A (re)connecting host starts from a clean session
+            s_telemetryPeriodMs = 0;
+            s_transferType = 0;
+            s_setPending = false;
+            uint8_t reply[9];
+            reply[0] = VERSION;
+            put32(reply + 1, TimeKeeper::SAMPLE_RATE);
+            put16(reply + 5, AUDIO_BLOCK_SAMPLES);
+            put16(reply + 7, MAX_BODY);
+            send(HELLO_REPLY, seq, reply, sizeof(reply));
+            break;
+        }
+
+        case PING:
+            send(PONG, seq, body, bodyLength);
+            break;
+
+        case GET_PARAM:
+        case SET_PARAM: {
+            if (bodyLength != (type == GET_PARAM ? 2u : 6u)) {
+                sendStatus(ERROR, seq, ERR_BAD_LENGTH);
+                break;
+            }
+            AudioEffectBase* effect = findEffect(body[0]);
+            if (effect == nullptr) {
+                sendStatus(ERROR, seq, ERR_NO_EFFECT);
+                break;
+            }
+            if (type == GET_PARAM) {
+                sendParam(seq, body[0], body[1], effect->getParameter(body[1]));
+                break;
+            }
+
+            // The app thread's controllers write the same effects: the
+            // value is applied there and read back by poll() afterwards
+            if (s_setPending) {
+                sendStatus(ERROR, seq, ERR_BUSY);
+                break;
+            }
+            if (!AppLogic::postParameter(effect, body[1], getFloat(body + 2))) {
+                sendStatus(ERROR, seq, ERR_QUEUE_FULL);
+                break;
+            }
+            s_setPending = true;
+            s_setSeq = seq;
+            s_setAddress = body[0];
+            s_setParam = body[1];
+            break;
+        }
+
+        case COMMAND: {
+            if (bodyLength != 8) {
+                sendStatus(ERROR, seq, ERR_BAD_LENGTH);
+                break;
+            }
+            Command cmd;
+            cmd.type = static_cast<CommandType>(body[0]);
+            cmd.targetEffect = static_cast<EffectID>(body[1]);
+            cmd.param1 = body[2];
+            cmd.param2 = body[3];
+            cmd.value = get32(body + 4);
+            const bool posted = AppLogic::postCommand(cmd.at(TimeKeeper::getSamplePosition()));
+            sendStatus(ACK, seq, posted ? OK : ERR_QUEUE_FULL);
+            break;
+        }
+
+        case TELEMETRY: {
+            if (bodyLength != 2) {
+                sendStatus(ERROR, seq, ERR_BAD_LENGTH);
+                break;
+            }
+            uint16_t period = get16(body);
+            if (period > 0 && period < MIN_TELEMETRY_PERIOD_MS) {
+                period = MIN_TELEMETRY_PERIOD_MS;
+            }
+            s_telemetryPeriodMs = period;
+            s_lastTelemetryMs = millis();
+            sendTelemetry(seq);
+            break;
+        }
+
+        case TRACE:
+        case BULK_READ: {
+            if (s_transferType != 0) {
+                sendStatus(ERROR, seq, ERR_BUSY);
+                break;
+            }
+            if (bodyLength != (type == TRACE ? 0u : 4u)) {
+                sendStatus(ERROR, seq, ERR_BAD_LENGTH);
+                break;
+            }
+            s_transferType = type;
+            s_transferSeq = seq;
+            s_transferOffset = 0;
+            s_transferTotal = (type == TRACE) ? Trace::snapshot(s_traceCopy) : get32(body);
+            continueTransfer();
+            break;
+        }
+
+        case BYE:
+            sendStatus(ACK, seq, OK);
+            deactivate("bye");
+            break;
+
+        default:
+            sendStatus(ERROR, seq, ERR_UNKNOWN_TYPE);
+            break;
+    }
+}
+
+// ========== REPLIES ==========
+
+void RemoteProtocol::send(uint8_t type, uint8_t seq, const uint8_t* body, size_t length) {
+    if (length > MAX_BODY) {
+        length = MAX_BODY;
+    }
+    uint8_t packet[MAX_PACKET];
+    packet[0] = type;
+    packet[1] = seq;
+    memcpy(packet + HEADER_BYTES, body, length);
+
+    uint8_t wire[MAX_WIRE];
+    const size_t n = Cobs::encodeFrame(packet, HEADER_BYTES + length, wire);
+    if (Serial.availableForWrite() < static_cast<int>(n)) {
+        return;  // Host not reading: drop the frame rather than block loop()
+    }
+    Serial.write(wire, n);
+}
+
+void RemoteProtocol::sendStatus(uint8_t type, uint8_t seq, uint8_t status) {
+    send(type, seq, &status, 1);
+}
+
+void RemoteProtocol::sendParam(uint8_t seq, uint8_t address, uint8_t param, float value) {
+    uint8_t body[6];
+    body[0] = address;
+    body[1] = param;
+    putFloat(body + 2, value);
+    send(PARAM, seq, body, sizeof(body));
+}
+
+void RemoteProtocol::collectTelemetry(RemoteTelemetry& out) {
+    memset(&out, 0, sizeof(out));
+    out.uptimeMs = millis();
+    out.samplePosition = static_cast<uint32_t>(TimeKeeper::getSamplePosition());
+    out.bpmX100 = static_cast<uint16_t>(TimeKeeper::getBPM() * 100.0f + 0.5f);
+    out.transport = static_cast<uint8_t>(TimeKeeper::getTransportState());
+    out.governorSteps = static_cast<uint8_t>(Telemetry::get(TELEM_GOVERNOR_STEPS));
+    out.cpuLoadPermille = static_cast<uint16_t>(Telemetry::get(TELEM_CPU_BLOCK_LOAD));
+    out.cpuLoadMaxPermille = static_cast<uint16_t>(Telemetry::get(TELEM_CPU_BLOCK_LOAD_MAX));
+    out.limiterGainQ15 = static_cast<uint16_t>(Telemetry::get(TELEM_LIMITER_GAIN));
+    out.audioBlocksUsed = static_cast<uint8_t>(AudioMemoryUsage());
+    out.audioBlocksMax = static_cast<uint8_t>(AudioMemoryUsageMax());
+    out.commandQueueDepth = static_cast<uint8_t>(AppLogic::pendingCommands());
+    out.eventQueueDepth = static_cast<uint8_t>(AudioEventQueue::pending());
+    const uint32_t logPending = Log::pending();
+    out.logPending = static_cast<uint8_t>(logPending > 255 ? 255 : logPending);
+    out.effectCount = s_numExposed;
+    out.overruns = DeadlineMonitor::getOverrunCount();
+    out.logDropped = Log::getDroppedCount();
+    for (uint8_t i = 0; i < s_numExposed; i++) {
+        out.effects[i].id = s_exposed[i].address;
+        out.effects[i].state = s_exposed[i].effect->getStateCode();
+        out.effects[i].enabled = s_exposed[i].effect->isEnabled() ? 1 : 0;
+    }
+}
+
+void RemoteProtocol::sendTelemetry(uint8_t seq) {
+    RemoteTelemetry snapshot;
+    collectTelemetry(snapshot);
+    uint8_t body[TELEMETRY_BYTES];
+    packTelemetry(snapshot, body);
+    send(TELEMETRY_DATA, seq, body, sizeof(body));
+}
+
+// ========== TRANSFERS ==========
+
+void RemoteProtocol::continueTransfer() {
+    uint8_t body[MAX_BODY];
+    for (uint8_t frame = 0; frame < FRAMES_PER_POLL && s_transferType != 0; frame++) {
+        // Never block loop() on a host that stopped reading: resume next poll()
+        if (!txRoom()) {
+            break;
+        }
+
+        size_t length;
+        if (s_transferType == TRACE) {
+            size_t count = s_transferTotal - s_transferOffset;
+            if (count > TRACE_EVENTS_PER_PACKET) count = TRACE_EVENTS_PER_PACKET;
+            put16(body, static_cast<uint16_t>(s_transferOffset));
+            put16(body + 2, static_cast<uint16_t>(s_transferTotal));
+            for (size_t i = 0; i < count; i++) {
+                const TraceEvent& e = s_traceCopy[s_transferOffset + i];
+                uint8_t* p = body + 4 + i * TRACE_EVENT_BYTES;
+                put32(p, e.timestamp);
+                put16(p + 4, e.eventId);
+                put16(p + 6, e.value);
+            }
+            length = 4 + count * TRACE_EVENT_BYTES;
+            s_transferOffset += count;
+        } else {
+            size_t count = s_transferTotal - s_transferOffset;
+            if (count > BULK_BYTES_PER_PACKET) count = BULK_BYTES_PER_PACKET;
+            put32(body, s_transferOffset);
+            for (size_t i = 0; i < count; i++) {
+                body[4 + i] = static_cast<uint8_t>(s_transferOffset + i);
+            }
+            length = 4 + count;
+            s_transferOffset += count;
+        }
+
+        send(s_transferType == TRACE ? TRACE_DATA : BULK_DATA, s_transferSeq, body, length);
+        if (s_transferOffset >= s_transferTotal) {
+            s_transferType = 0;  // Last chunk sent (an empty transfer sends one empty chunk)
+        }
+    }
+}
+
+// ========== LOG ==========
+
+void RemoteProtocol::forwardLog() {
+    // Messages stay in the log ring until there is room to send them
+    int room = Serial.availableForWrite() / static_cast<int>(MAX_WIRE);
+    if (room > LOG_MESSAGES_PER_POLL) room = LOG_MESSAGES_PER_POLL;
+    if (room <= 0) {
+        return;
+    }
+    static LogPacketPrint s_logOut(send);
+    Log::drain(s_logOut, static_cast<size_t>(room));
+    s_logOut.flushLine();
+}
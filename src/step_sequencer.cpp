@@ -0,0 +1,232 @@
+#include "step_sequencer.h"
+#include "audio_choke.h"
+#include "audio_freeze.h"
+#include "audio_stutter.h"
+#include "timekeeper.h"
+#include "trace.h"
+#include "log.h"
+
+AudioEffectStutter* StepSequencer::s_stutter = nullptr;
+AudioEffectFreeze* StepSequencer::s_freeze = nullptr;
+AudioEffectChoke* StepSequencer::s_choke = nullptr;
+
+StepPattern StepSequencer::s_pattern = { { 0, 0, 0 }, 16 };
+volatile bool StepSequencer::s_enabled = false;
+
+volatile bool StepSequencer::s_playing = false;
+volatile uint8_t StepSequencer::s_currentStep = 0;
+uint8_t StepSequencer::s_nextStep = 0;
+uint8_t StepSequencer::s_subStep = 0;
+uint64_t StepSequencer::s_beatStart = 0;
+uint64_t StepSequencer::s_nextStepAt = 0;
+uint64_t StepSequencer::s_lastBlockStart = 0;
+volatile uint8_t StepSequencer::s_engaged = 0;
+
+void StepSequencer::begin(AudioEffectStutter* stutter, AudioEffectFreeze* freeze, AudioEffectChoke* choke) {
+    s_stutter = stutter;
+    s_freeze = freeze;
+    s_choke = choke;
+}
+
+// ========== TRANSPORT ==========
+
+void StepSequencer::setEnabled(bool enabled) {
+    // The ISR anchors on the next bar line / releases held lanes
+    s_enabled = enabled;
+}
+
+// ========== PATTERN EDITING ==========
+
+void StepSequencer::setStep(Lane lane, uint8_t step, bool on) {
+    uint8_t l = static_cast<uint8_t>(lane);
+    if (l >= LANE_COUNT || step >= MAX_STEPS) {
+        return;
+    }
+    uint32_t bits = s_pattern.lanes[l];
+    bits = on ? (bits | (1UL << step)) : (bits & ~(1UL << step));
+    s_pattern.lanes[l] = bits;  // Single-word store: the ISR sees old or new
+}
+
+bool StepSequencer::getStep(Lane lane, uint8_t step) {
+    uint8_t l = static_cast<uint8_t>(lane);
+    if (l >= LANE_COUNT || step >= MAX_STEPS) {
+        return false;
+    }
+    return (s_pattern.lanes[l] >> step) & 1U;
+}
+
+void StepSequencer::toggleStep(Lane lane, uint8_t step) {
+    setStep(lane, step, !getStep(lane, step));
+}
+
+void StepSequencer::clearLane(Lane lane) {
+    uint8_t l = static_cast<uint8_t>(lane);
+    if (l < LANE_COUNT) {
+        s_pattern.lanes[l] = 0;
+    }
+}
+
+bool StepSequencer::setLength(uint8_t steps) {
+    if (steps != 16 && steps != 32) {
+        LOG_ERROR("StepSequencer::setLength() - length must be 16 or 32 steps");
+        return false;
+    }
+    s_pattern.length = steps;
+    return true;
+}
+
+void StepSequencer::getPattern(StepPattern& out) {
+    out = s_pattern;
+}
+
+bool StepSequencer::setPattern(const StepPattern& pattern) {
+    if (pattern.length != 16 && pattern.length != 32) {
+        LOG_ERROR("StepSequencer::setPattern() - length must be 16 or 32 steps");
+        return false;
+    }
+    for (uint8_t l = 0; l < LANE_COUNT; l++) {
+        s_pattern.lanes[l] = pattern.lanes[l];
+    }
+    s_pattern.length = pattern.length;
+    return true;
+}
+
+const char* StepSequencer::laneName(Lane lane) {
+    switch (lane) {
+        case Lane::STUTTER: return "Stutter";
+        case Lane::FREEZE: return "Freeze";
+        case Lane::CHOKE: return "Choke";
+    }
+    return "?";
+}
+
+// ========== AUDIO ISR ==========
+
+void StepSequencer::process(uint64_t blockStart) {
+    const uint32_t spb = TimeKeeper::getSamplesPerBeat();
+
+    if (!s_enabled || !TimeKeeper::isRunning() || spb == 0) {
+        if (s_playing) {
+            releaseAll();
+            s_playing = false;
+            TRACE(TRACE_SEQ_STOP);
+        }
+        return;
+    }
+
+    // Transport START rebases the sample position: restart on the new grid
+    if (s_playing && blockStart < s_lastBlockStart) {
+        releaseAll();
+        s_playing = false;
+    }
+    s_lastBlockStart = blockStart;
+
+    if (!s_playing) {
+        anchor(blockStart, spb);
+    }
+
+    const uint64_t blockEnd = blockStart + AUDIO_BLOCK_SAMPLES;
+    while (s_nextStepAt < blockEnd) {
+        if (s_nextStep >= s_pattern.length) {
+            s_nextStep = 0;  // Shortened while playing
+        }
+        fireStep(s_nextStep);
+
+        // Next boundary from the current tempo: beat lines stay whole beats apart
+        s_nextStep = (s_nextStep + 1 < s_pattern.length) ? s_nextStep + 1 : 0;
+        s_subStep++;
+        if (s_subStep == STEPS_PER_BEAT) {
+            s_subStep = 0;
+            s_beatStart += spb;
+        }
+        s_nextStepAt = s_beatStart + (static_cast<uint64_t>(s_subStep) * spb) / STEPS_PER_BEAT;
+    }
+}
+
+void StepSequencer::anchor(uint64_t blockStart, uint32_t samplesPerBeat) {
+    // Next bar line; one that passed within this block fires now (late by
+    // less than a block) rather than a bar later
+    const uint32_t samplesPerBar = samplesPerBeat * TimeKeeper::BEATS_PER_BAR;
+    const uint32_t withinBar = static_cast<uint32_t>(blockStart % samplesPerBar);
+    uint64_t barStart = blockStart - withinBar;
+    if (withinBar >= AUDIO_BLOCK_SAMPLES) {
+        barStart += samplesPerBar;
+    }
+
+    s_beatStart = barStart;
+    s_nextStepAt = barStart;
+    s_subStep = 0;
+    s_nextStep = 0;
+    s_engaged = 0;
+    s_playing = true;
+    TRACE(TRACE_SEQ_START, s_pattern.length);
+}
+
+void StepSequencer::fireStep(uint8_t step) {
+    s_currentStep = step;
+    for (uint8_t l = 0; l < LANE_COUNT; l++) {
+        const bool on = (s_pattern.lanes[l] >> step) & 1U;
+        const bool engaged = (s_engaged >> l) & 1U;
+        if (on && !engaged) {
+            engage(l);
+        } else if (!on && engaged) {
+            release(l);
+        }
+    }
+}
+
+void StepSequencer::engage(uint8_t lane) {
+    // Leave effects the performer already has on alone (and unowned)
+    bool started = false;
+    switch (static_cast<Lane>(lane)) {
+        case Lane::STUTTER:
+            if (s_stutter && s_stutter->getState() == StutterState::IDLE_WITH_LOOP) {
+                s_stutter->startPlayback();
+                started = true;
+            }
+            break;
+        case Lane::FREEZE:
+            if (s_freeze && !s_freeze->isEnabled()) {
+                s_freeze->enable();
+                started = true;
+            }
+            break;
+        case Lane::CHOKE:
+            if (s_choke && !s_choke->isEnabled()) {
+                s_choke->enable();
+                started = true;
+            }
+            break;
+    }
+    if (started) {
+        s_engaged |= (1U << lane);
+        TRACE(TRACE_SEQ_ENGAGE, static_cast<uint16_t>((lane << 8) | s_currentStep));
+    }
+}
+
+void StepSequencer::release(uint8_t lane) {
+    switch (static_cast<Lane>(lane)) {
+        case Lane::STUTTER:
+            // Only stop our own playback (a capture may have started since)
+            if (s_stutter && s_stutter->getState() == StutterState::PLAYING) {
+                s_stutter->stopPlayback();
+            }
+            break;
+        case Lane::FREEZE:
+            if (s_freeze) s_freeze->disable();
+            break;
+        case Lane::CHOKE:
+            if (s_choke) s_choke->disable();
+            break;
+    }
+    s_engaged &= ~(1U << lane);
+    TRACE(TRACE_SEQ_RELEASE, static_cast<uint16_t>((lane << 8) | s_currentStep));
+}
+
+void StepSequencer::releaseAll() {
+    for (uint8_t l = 0; l < LANE_COUNT; l++) {
+        if ((s_engaged >> l) & 1U) {
+            release(l);
+        }
+    }
+}
@@ -2,11 +2,16 @@
 #include "input_io.h"
 #include "display_manager.h"
 #include "timekeeper.h"
+#include "log.h"
 #include <Arduino.h>
 
 // Define static EXTMEM buffers for AudioEffectStutter
 EXTMEM int16_t AudioEffectStutter::m_stutterBufferL[AudioEffectStutter::STUTTER_BUFFER_SAMPLES];
 EXTMEM int16_t AudioEffectStutter::m_stutterBufferR[AudioEffectStutter::STUTTER_BUFFER_SAMPLES];
+EXTMEM int16_t AudioEffectStutter::m_historyPoolL[AudioEffectStutter::History::POOL_SAMPLES];
+EXTMEM int16_t AudioEffectStutter::m_historyPoolR[AudioEffectStutter::History::POOL_SAMPLES];
+EXTMEM int16_t AudioEffectStutter::m_preRollL[AudioEffectStutter::PREROLL_SAMPLES];
+EXTMEM int16_t AudioEffectStutter::m_preRollR[AudioEffectStutter::PREROLL_SAMPLES];
 
 StutterController::StutterController(AudioEffectStutter& effect)
     : m_effect(effect),
@@ -97,6 +102,15 @@ const char* StutterController::captureEndName(StutterCaptureEnd captureEnd) {
     }
 }
 
+// ========== ACTION TIMING ==========
+
+using EffectQuantization::actionSample;
+using EffectQuantization::quantizedSampleAfter;
+
+static bool isAhead(uint64_t sample) {
+    return sample > TimeKeeper::getSamplePosition();
+}
+
 // ========== BUTTON PRESS HANDLER ==========
 
 bool StutterController::handleButtonPress(const Command& cmd) {
@@ -118,6 +132,7 @@ bool StutterController::handleButtonPress(const Command& cmd) {
     m_stutterHeld = true;  // Track that STUTTER is now held
 
     StutterState currentState = m_effect.getState();
+    const uint64_t at = actionSample(cmd);
 
     // ========== FUNC+STUTTER COMBO (CAPTURE MODE) ==========
     if (m_funcHeld) {
@@ -126,24 +141,24 @@ bool StutterController::handleButtonPress(const Command& cmd) {
 
         if (currentState == StutterState::IDLE_WITH_LOOP) {
             // Delete existing loop and start new capture
-            Serial.println("Stutter: Deleting existing loop, starting new capture");
+            LOG_INFO("Stutter: Deleting existing loop, starting new capture");
         }
 
         StutterCaptureStart captureStartMode = m_effect.getCaptureStartMode();
 
         if (captureStartMode == StutterCaptureStart::FREE) {
-            // FREE CAPTURE START: Start capturing immediately
-            m_effect.startCapture();
-            Serial.println("Stutter: CAPTURE started (Free)");
+            // FREE CAPTURE START: Start capturing immediately (on the press sample)
+            if (isAhead(at)) {
+                m_effect.scheduleCaptureStart(at);
+            } else {
+                m_effect.startCapture();
+            }
+            LOG_INFO("Stutter: CAPTURE started (Free)");
         } else {
             // QUANTIZED CAPTURE START: Schedule capture start
             Quantization quant = EffectQuantization::getGlobalQuantization();
-            uint32_t samplesToNext = EffectQuantization::samplesToNextQuantizedBoundary(quant);
-            uint64_t captureStartSample = TimeKeeper::getSamplePosition() + samplesToNext;
-            m_effect.scheduleCaptureStart(captureStartSample);
-            Serial.print("Stutter: CAPTURE START scheduled (");
-            Serial.print(EffectQuantization::quantizationName(quant));
-            Serial.println(")");
+            m_effect.scheduleCaptureStart(quantizedSampleAfter(at, quant));
+            LOG_INFO("Stutter: CAPTURE START scheduled (%s)", EffectQuantization::quantizationName(quant));
         }
 
         // Update visual feedback
@@ -156,7 +171,7 @@ bool StutterController::handleButtonPress(const Command& cmd) {
     // Check if we have a captured loop
     if (currentState == StutterState::IDLE_NO_LOOP) {
         // No loop captured - can't play
-        Serial.println("Stutter: No loop captured (press FUNC+STUTTER to capture)");
+        LOG_INFO("Stutter: No loop captured (press FUNC+STUTTER to capture)");
         return true;  // Command handled (don't let EffectManager try to enable)
     }
 
@@ -165,18 +180,18 @@ bool StutterController::handleButtonPress(const Command& cmd) {
         StutterOnset onsetMode = m_effect.getOnsetMode();
 
         if (onsetMode == StutterOnset::FREE) {
-            // FREE ONSET: Start playback immediately
-            m_effect.startPlayback();
-            Serial.println("Stutter: PLAYBACK started (Free onset)");
+            // FREE ONSET: Start playback immediately (on the press sample)
+            if (isAhead(at)) {
+                m_effect.schedulePlaybackOnset(at);
+            } else {
+                m_effect.startPlayback();
+            }
+            LOG_INFO("Stutter: PLAYBACK started (Free onset)");
         } else {
             // QUANTIZED ONSET: Schedule playback start
             Quantization quant = EffectQuantization::getGlobalQuantization();
-            uint32_t samplesToNext = EffectQuantization::samplesToNextQuantizedBoundary(quant);
-            uint64_t playbackOnsetSample = TimeKeeper::getSamplePosition() + samplesToNext;
-            m_effect.schedulePlaybackOnset(playbackOnsetSample);
-            Serial.print("Stutter: PLAYBACK ONSET scheduled (");
-            Serial.print(EffectQuantization::quantizationName(quant));
-            Serial.println(")");
+            m_effect.schedulePlaybackOnset(quantizedSampleAfter(at, quant));
+            LOG_INFO("Stutter: PLAYBACK ONSET scheduled (%s)", EffectQuantization::quantizationName(quant));
         }
 
         // Update visual feedback
@@ -186,15 +201,134 @@ bool StutterController::handleButtonPress(const Command& cmd) {
     }
 
     // Ignore button press in other states (already capturing/playing/waiting)
-    Serial.print("Stutter: Button press ignored (state=");
-    Serial.print(static_cast<int>(currentState));
-    Serial.println(")");
+    LOG_INFO("Stutter: Button press ignored (state=%d)", static_cast<int>(currentState));
     return true;  // Command handled
 }
 
+// ========== LOOPER COMMANDS ==========
+
+/**
+ * Next bar line, or 0 = now when there is no bar grid
+ */
+static uint64_t nextBarSample() {
+    if (!TimeKeeper::isRunning() || TimeKeeper::getSamplesPerBeat() == 0) {
+        return 0;
+    }
+    return TimeKeeper::getSamplePosition() + TimeKeeper::samplesToNextBar();
+}
+
+bool StutterController::handleLoopCommand(const Command& cmd) {
+    const uint64_t bar = nextBarSample();
+    const StutterState state = m_effect.getState();
+    const bool capturing = (state == StutterState::CAPTURING || state == StutterState::WAIT_CAPTURE_END);
+
+    switch (cmd.type) {
+        case CommandType::LOOP_RECORD:
+            if (state == StutterState::WAIT_CAPTURE_START) {
+                m_effect.cancelCaptureStart();
+                LOG_INFO("Looper: RECORD cancelled");
+            } else if (capturing) {
+                // Close the loop and keep playing it (as if STUTTER were held)
+                if (bar == 0) {
+                    m_effect.endCapture(true);
+                } else {
+                    m_effect.scheduleCaptureEnd(bar, true);
+                }
+                LOG_INFO("Looper: RECORD end -> PLAY");
+            } else {
+                if (bar == 0) {
+                    m_effect.startCapture();
+                } else {
+                    m_effect.scheduleCaptureStart(bar);
+                }
+                LOG_INFO("%s", bar == 0 ? "Looper: RECORD" : "Looper: RECORD at next bar");
+            }
+            break;
+
+        case CommandType::LOOP_OVERDUB:
+            if (m_effect.getCaptureLength() == 0 || capturing) {
+                LOG_INFO("Looper: nothing to overdub (record a loop first)");
+                return true;
+            }
+            if (m_effect.isOverdubbing()) {
+                if (bar == 0) {
+                    m_effect.stopOverdub();
+                } else {
+                    m_effect.scheduleOverdubStop(bar);
+                }
+                LOG_INFO("Looper: OVERDUB off");
+            } else {
+                // Play the loop from the same bar line if it is not playing yet
+                if (state == StutterState::IDLE_WITH_LOOP || state == StutterState::WAIT_PLAYBACK_ONSET) {
+                    if (bar == 0) {
+                        m_effect.startPlayback();
+                    } else {
+                        m_effect.schedulePlaybackOnset(bar);
+                    }
+                }
+                if (bar == 0) {
+                    m_effect.startOverdub();
+                } else {
+                    m_effect.scheduleOverdubStart(bar);
+                }
+                LOG_INFO("Looper: OVERDUB on");
+            }
+            break;
+
+        case CommandType::LOOP_CLEAR:
+            m_effect.disable();
+            LOG_INFO("Looper: CLEARED");
+            break;
+
+        case CommandType::LOOP_RETRO: {
+            const uint8_t bars = static_cast<uint8_t>(cmd.value);
+            if (bars != 1 && bars != 2 && bars != 4) {
+                LOG_ERROR("StutterController::handleLoopCommand() - retro capture takes 1, 2 or 4 bars");
+                return true;
+            }
+            if (TimeKeeper::getSamplesPerBeat() == 0) {
+                LOG_INFO("Looper: no tempo yet (retro capture needs MIDI clock)");
+                return true;
+            }
+            const uint64_t at = cmd.isStamped() ? cmd.sampleTime : TimeKeeper::getSamplePosition();
+            if (!m_effect.requestRetroCapture(bars, at)) {
+                LOG_INFO("Looper: pre-roll holds only %u samples", m_effect.getPreRollSamples());
+                return true;
+            }
+            LOG_INFO("Looper: RETRO last %u %s -> PLAY", bars, bars == 1 ? "bar" : "bars");
+            break;
+        }
+
+        case CommandType::LOOP_UNDO:
+        case CommandType::LOOP_REDO: {
+            const bool undo = (cmd.type == CommandType::LOOP_UNDO);
+            if (undo ? m_effect.undoOverdub() : m_effect.redoOverdub()) {
+                LOG_INFO("%s", undo ? "Looper: UNDO" : "Looper: REDO");
+            } else if (m_effect.isOverdubbing() || m_effect.isHistoryBusy()) {
+                LOG_INFO("Looper: busy (stop the overdub pass first)");
+            } else if (undo && m_effect.isUndoUnavailable()) {
+                LOG_INFO("Looper: last pass exceeded the undo budget (%u pages), cannot undo",
+                         static_cast<unsigned>(m_effect.getHistoryPoolPages()));
+            } else {
+                LOG_INFO("%s", undo ? "Looper: nothing to undo" : "Looper: nothing to redo");
+            }
+            return true;
+        }
+
+        default:
+            return false;
+    }
+
+    DisplayManager::instance().setLastActivatedEffect(EffectID::STUTTER);
+    DisplayIO::showBitmap(stateToBitmap(m_effect.getState()));
+    return true;
+}
+
 // ========== BUTTON RELEASE HANDLER ==========
 
 bool StutterController::handleButtonRelease(const Command& cmd) {
+    const uint64_t at = actionSample(cmd);
+
     // Track FUNC button releases
     if (cmd.targetEffect == EffectID::FUNC) {
         m_funcHeld = false;
@@ -208,17 +342,18 @@ bool StutterController::handleButtonRelease(const Command& cmd) {
 
             if (captureEndMode == StutterCaptureEnd::FREE) {
                 // FREE CAPTURE END: End immediately, transition based on STUTTER held
-                m_effect.endCapture(true);  // STUTTER held = true
-                Serial.println("Stutter: CAPTURE ended (Free, FUNC released, STUTTER held → PLAYING)");
+                if (isAhead(at)) {
+                    m_effect.scheduleCaptureEnd(at, true);
+                } else {
+                    m_effect.endCapture(true);  // STUTTER held = true
+                }
+                LOG_INFO("Stutter: CAPTURE ended (Free, FUNC released, STUTTER held → PLAYING)");
             } else {
                 // QUANTIZED CAPTURE END: Schedule end
                 Quantization quant = EffectQuantization::getGlobalQuantization();
-                uint32_t samplesToNext = EffectQuantization::samplesToNextQuantizedBoundary(quant);
-                uint64_t captureEndSample = TimeKeeper::getSamplePosition() + samplesToNext;
-                m_effect.scheduleCaptureEnd(captureEndSample, true);  // STUTTER held = true
-                Serial.print("Stutter: CAPTURE END scheduled (");
-                Serial.print(EffectQuantization::quantizationName(quant));
-                Serial.println(", FUNC released, STUTTER held)");
+                m_effect.scheduleCaptureEnd(quantizedSampleAfter(at, quant), true);  // STUTTER held = true
+                LOG_INFO("Stutter: CAPTURE END scheduled (%s, FUNC released, STUTTER held)",
+                         EffectQuantization::quantizationName(quant));
             }
 
             // Update visual feedback
@@ -247,7 +382,7 @@ bool StutterController::handleButtonRelease(const Command& cmd) {
         // STUTTER released before capture started (waiting for quantized boundary)
         // Cancel capture and return to idle
         m_effect.cancelCaptureStart();
-        Serial.println("Stutter: CAPTURE CANCELLED (released before start)");
+        LOG_INFO("Stutter: CAPTURE CANCELLED (released before start)");
         DisplayManager::instance().setLastActivatedEffect(EffectID::NONE);
         DisplayManager::instance().updateDisplay();
         return true;  // Command handled
@@ -260,17 +395,18 @@ bool StutterController::handleButtonRelease(const Command& cmd) {
 
         if (captureEndMode == StutterCaptureEnd::FREE) {
             // FREE CAPTURE END: End immediately
-            m_effect.endCapture(false);  // STUTTER not held = false
-            Serial.println("Stutter: CAPTURE ended (Free, STUTTER released → IDLE_WITH_LOOP)");
+            if (isAhead(at)) {
+                m_effect.scheduleCaptureEnd(at, false);
+            } else {
+                m_effect.endCapture(false);  // STUTTER not held = false
+            }
+            LOG_INFO("Stutter: CAPTURE ended (Free, STUTTER released → IDLE_WITH_LOOP)");
         } else {
             // QUANTIZED CAPTURE END: Schedule end
             Quantization quant = EffectQuantization::getGlobalQuantization();
-            uint32_t samplesToNext = EffectQuantization::samplesToNextQuantizedBoundary(quant);
-            uint64_t captureEndSample = TimeKeeper::getSamplePosition() + samplesToNext;
-            m_effect.scheduleCaptureEnd(captureEndSample, false);  // STUTTER not held = false
-            Serial.print("Stutter: CAPTURE END scheduled (");
-            Serial.print(EffectQuantization::quantizationName(quant));
-            Serial.println(", STUTTER released)");
+            m_effect.scheduleCaptureEnd(quantizedSampleAfter(at, quant), false);  // STUTTER not held = false
+            LOG_INFO("Stutter: CAPTURE END scheduled (%s, STUTTER released)",
+                     EffectQuantization::quantizationName(quant));
         }
 
         // Update visual feedback
@@ -285,7 +421,7 @@ bool StutterController::handleButtonRelease(const Command& cmd) {
         // Just return to IDLE_WITH_LOOP (don't cancel - let it time out naturally)
         // Actually, better to cancel so we don't have orphaned scheduled events
         m_effect.stopPlayback();  // Transition to IDLE_WITH_LOOP
-        Serial.println("Stutter: PLAYBACK CANCELLED (released before onset)");
+        LOG_INFO("Stutter: PLAYBACK CANCELLED (released before onset)");
         DisplayIO::showBitmap(stateToBitmap(m_effect.getState()));
         return true;  // Command handled
     }
@@ -295,18 +431,18 @@ bool StutterController::handleButtonRelease(const Command& cmd) {
         StutterLength lengthMode = m_effect.getLengthMode();
 
         if (lengthMode == StutterLength::FREE) {
-            // FREE LENGTH: Stop immediately
-            m_effect.stopPlayback();
-            Serial.println("Stutter: PLAYBACK stopped (Free length)");
+            // FREE LENGTH: Stop immediately (on the release sample)
+            if (isAhead(at)) {
+                m_effect.schedulePlaybackLength(at);
+            } else {
+                m_effect.stopPlayback();
+            }
+            LOG_INFO("Stutter: PLAYBACK stopped (Free length)");
         } else {
             // QUANTIZED LENGTH: Schedule stop at next grid boundary
             Quantization quant = EffectQuantization::getGlobalQuantization();
-            uint32_t samplesToNext = EffectQuantization::samplesToNextQuantizedBoundary(quant);
-            uint64_t playbackLengthSample = TimeKeeper::getSamplePosition() + samplesToNext;
-            m_effect.schedulePlaybackLength(playbackLengthSample);
-            Serial.print("Stutter: PLAYBACK STOP scheduled (");
-            Serial.print(EffectQuantization::quantizationName(quant));
-            Serial.println(")");
+            m_effect.schedulePlaybackLength(quantizedSampleAfter(at, quant));
+            LOG_INFO("Stutter: PLAYBACK STOP scheduled (%s)", EffectQuantization::quantizationName(quant));
         }
 
         // Update visual feedback
@@ -334,17 +470,9 @@ void StutterController::updateVisualFeedback() {
             m_ledBlinkState = !m_ledBlinkState;
             m_lastBlinkTime = now;
 
-            // Determine LED color based on state
-            uint32_t ledColor;
-            if (currentState == StutterState::WAIT_CAPTURE_START) {
-                ledColor = m_ledBlinkState ? 0xFF0000 : 0x000000;  // RED blinking
-            } else {  // WAIT_PLAYBACK_ONSET
-                ledColor = m_ledBlinkState ? 0x0000FF : 0x000000;  // BLUE blinking
-            }
-
-            // Update Neokey LED directly (bypass InputIO::setLED which doesn't support colors)
-            // Note: This would need to be implemented in InputIO or we use the existing setLED
-            // For now, use InputIO::setLED with boolean
+            // InputIO::setLED() is on/off only (the key's effect color), so
+            // WAIT_CAPTURE_START (red) and WAIT_PLAYBACK_ONSET (blue) blink alike
+            // until InputIO supports per-state colors
             InputIO::setLED(EffectID::STUTTER, m_ledBlinkState);
         }
     } else {
@@ -390,11 +518,7 @@ void StutterController::updateVisualFeedback() {
 
     if (currentState != s_lastState) {
         // State changed - update display
-        Serial.print("Stutter: State changed (");
-        Serial.print(static_cast<int>(s_lastState));
-        Serial.print(" → ");
-        Serial.print(static_cast<int>(currentState));
-        Serial.println(")");
+        LOG_INFO("Stutter: State changed (%d → %d)", static_cast<int>(s_lastState), static_cast<int>(currentState));
 
         // Update display if this effect is active
         if (currentState != StutterState::IDLE_NO_LOOP && currentState != StutterState::IDLE_WITH_LOOP) {
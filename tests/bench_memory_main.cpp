@@ -0,0 +1,349 @@
+/**
+ * Memory Bandwidth/Latency Benchmark
+ *
+ * Measures the three RAM regions we place audio buffers in, using the access
+ * patterns our effects actually perform, so buffer placement (EXTMEM for
+ * stutter, DTCM for freeze, DMAMEM for snapshots) can be decided from data.
+ *
+ * Regions:
+ * - DTCM:  Default .bss (tightly coupled, never cached, single-cycle)
+ * - OCRAM: DMAMEM (on-chip RAM2 behind the L1 data cache)
+ * - PSRAM: EXTMEM (external QSPI PSRAM behind the L1 data cache, skipped if
+ *          not fitted)
+ *
+ * Cache modes (OCRAM/PSRAM; DTCM reports the same number for both):
+ * - cold: buffer flushed+invalidated from L1 before every timed run
+ *         (arm_dcache_flush_delete) - every line comes from the bus
+ * - warm: untimed pass first, working set (WARM_BYTES) fits in the 32KB L1
+ *
+ * Patterns (16-bit samples, 128-sample blocks like AUDIO_BLOCK_SAMPLES):
+ * - seq_read / seq_write:  block-by-block linear sweep
+ * - reverse_read:          block-by-block sweep from the end, samples reversed
+ * - stride_read_<N>:       one sample every N bytes (16/32/64 - 32 = cache line)
+ * - wrap_copy:             128-sample copies out of a circular buffer at a
+ *                          position that is not block aligned, so ~every copy
+ *                          splits into two memcpy()s at the wrap (freeze/stutter)
+ * - stereo_planar:         read L and R blocks from two separate buffers
+ * - stereo_interleaved:    read the same frames from one LRLR buffer
+ * - latency_chase:         dependent pointer chase, one load per cache line,
+ *                          shuffled order (ns per load, defeats prefetch)
+ *
+ * Output: one JSON object per line (JSON Lines), e.g.
+ *   {"bench":"mem","region":"PSRAM","pattern":"seq_read","cache":"cold",
+ *    "bytes":32768,"reps":5,"cycles_min":..., "cycles_max":...,
+ *    "mb_per_s":..., "ns_per_access":...}
+ * Lines starting with '#' are human-readable comments. Capture with any
+ * serial logger and filter with: grep '^{'
+ *
+ * Build: swap the add_executable() line in CMakeLists.txt (see BENCHMARKS).
+ * Upload, open Serial Monitor @ 115200 baud. Press any key to rerun.
+ */
+
+#include <Arduino.h>
+
+// ========== CONFIGURATION ==========
+static constexpr size_t BENCH_BYTES = 32768;   // Cold working set (= L1 D-cache size)
+static constexpr size_t WARM_BYTES = 8192;     // Warm working set (comfortably cache-resident)
+static constexpr size_t BLOCK_SAMPLES = 128;   // AUDIO_BLOCK_SAMPLES
+static constexpr size_t CACHE_LINE = 32;       // Cortex-M7 L1 line size
+static constexpr uint8_t REPS = 5;
+
+static constexpr size_t BENCH_SAMPLES = BENCH_BYTES / sizeof(int16_t);
+
+// ========== BUFFERS (one per region) ==========
+alignas(32) static int16_t s_dtcmBuf[BENCH_SAMPLES];
+alignas(32) DMAMEM static int16_t s_ocramBuf[BENCH_SAMPLES];
+alignas(32) EXTMEM static int16_t s_psramBuf[BENCH_SAMPLES];
+
+// Destination block (DTCM, like audio_block_t from the pool)
+alignas(32) static int16_t s_blockL[BLOCK_SAMPLES];
+alignas(32) static int16_t s_blockR[BLOCK_SAMPLES];
+
+// Keeps reads from being optimized away
+static volatile int32_t s_sink = 0;
+
+extern "C" uint8_t external_psram_size;  // Teensy core: PSRAM size in MB (0 = not fitted)
+
+struct Region {
+    const char* name;
+    int16_t* buffer;
+    bool cached;
+};
+
+enum class CacheMode : uint8_t { COLD, WARM };
+
+// Pattern: processes 'bytes' of 'buf', returns number of memory accesses made
+typedef uint32_t (*PatternFn)(int16_t* buf, size_t bytes);
+
+// ========== PATTERNS ==========
+
+static uint32_t patternSeqRead(int16_t* buf, size_t bytes) {
+    const size_t samples = bytes / sizeof(int16_t);
+    int32_t acc = 0;
+    for (size_t block = 0; block < samples; block += BLOCK_SAMPLES) {
+        const int16_t* p = buf + block;
+        for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+            acc += p[i];
+        }
+    }
+    s_sink = acc;
+    return samples;
+}
+
+static uint32_t patternSeqWrite(int16_t* buf, size_t bytes) {
+    const size_t samples = bytes / sizeof(int16_t);
+    for (size_t block = 0; block < samples; block += BLOCK_SAMPLES) {
+        memcpy(buf + block, s_blockL, sizeof(s_blockL));
+    }
+    return samples;
+}
+
+static uint32_t patternReverseRead(int16_t* buf, size_t bytes) {
+    const size_t samples = bytes / sizeof(int16_t);
+    int32_t acc = 0;
+    for (size_t block = samples; block >= BLOCK_SAMPLES; block -= BLOCK_SAMPLES) {
+        const int16_t* p = buf + block - 1;
+        for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+            acc += *(p - i);
+        }
+    }
+    s_sink = acc;
+    return samples;
+}
+
+template <size_t STRIDE_BYTES>
+static uint32_t patternStrideRead(int16_t* buf, size_t bytes) {
+    constexpr size_t step = STRIDE_BYTES / sizeof(int16_t);
+    const size_t samples = bytes / sizeof(int16_t);
+    int32_t acc = 0;
+    for (size_t i = 0; i < samples; i += step) {
+        acc += buf[i];
+    }
+    s_sink = acc;
+    return samples / step;
+}
+
+static uint32_t patternWrapCopy(int16_t* buf, size_t bytes) {
+    // Circular read of 128-sample blocks, starting off-grid so blocks straddle the wrap
+    const size_t samples = bytes / sizeof(int16_t);
+    const size_t blocks = samples / BLOCK_SAMPLES;
+    size_t readPos = samples - 37;
+    for (size_t b = 0; b < blocks; b++) {
+        size_t firstPart = samples - readPos;
+        if (firstPart >= BLOCK_SAMPLES) {
+            memcpy(s_blockL, buf + readPos, BLOCK_SAMPLES * sizeof(int16_t));
+        } else {
+            memcpy(s_blockL, buf + readPos, firstPart * sizeof(int16_t));
+            memcpy(s_blockL + firstPart, buf, (BLOCK_SAMPLES - firstPart) * sizeof(int16_t));
+        }
+        readPos += BLOCK_SAMPLES + 3;  // Drift so the split point moves every block
+        if (readPos >= samples) readPos -= samples;
+    }
+    s_sink = s_blockL[0];
+    return blocks * BLOCK_SAMPLES;
+}
+
+static uint32_t patternStereoPlanar(int16_t* buf, size_t bytes) {
+    // First half = L plane, second half = R plane
+    const size_t frames = bytes / (2 * sizeof(int16_t));
+    const int16_t* left = buf;
+    const int16_t* right = buf + frames;
+    for (size_t f = 0; f < frames; f += BLOCK_SAMPLES) {
+        for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+            s_blockL[i] = left[f + i];
+            s_blockR[i] = right[f + i];
+        }
+    }
+    s_sink = s_blockL[0] + s_blockR[0];
+    return frames * 2;
+}
+
+static uint32_t patternStereoInterleaved(int16_t* buf, size_t bytes) {
+    // LRLR... frames
+    const size_t frames = bytes / (2 * sizeof(int16_t));
+    for (size_t f = 0; f < frames; f += BLOCK_SAMPLES) {
+        const int16_t* p = buf + 2 * f;
+        for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+            s_blockL[i] = p[2 * i];
+            s_blockR[i] = p[2 * i + 1];
+        }
+    }
+    s_sink = s_blockL[0] + s_blockR[0];
+    return frames * 2;
+}
+
+/**
+ * Build a shuffled single-cycle pointer chain, one node per cache line
+ * (stored as uint32_t byte offsets so the chain is position independent)
+ */
+static void buildChaseChain(int16_t* buf, size_t bytes) {
+    const uint32_t nodes = bytes / CACHE_LINE;
+    uint8_t* base = reinterpret_cast<uint8_t*>(buf);
+
+    // Sattolo's algorithm: random single cycle through all nodes
+    static uint16_t order[BENCH_BYTES / CACHE_LINE];
+    for (uint32_t i = 0; i < nodes; i++) order[i] = i;
+    uint32_t seed = 0x12345678;
+    for (uint32_t i = nodes - 1; i > 0; i--) {
+        seed = seed * 1664525 + 1013904223;  // LCG
+        uint32_t j = seed % i;
+        uint16_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    for (uint32_t i = 0; i < nodes; i++) {
+        uint32_t from = order[i];
+        uint32_t to = order[(i + 1) % nodes];
+        *reinterpret_cast<uint32_t*>(base + from * CACHE_LINE) = to * CACHE_LINE;
+    }
+}
+
+static uint32_t patternLatencyChase(int16_t* buf, size_t bytes) {
+    const uint32_t nodes = bytes / CACHE_LINE;
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(buf);
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < nodes; i++) {
+        offset = *reinterpret_cast<const volatile uint32_t*>(base + offset);
+    }
+    s_sink = offset;
+    return nodes;
+}
+
+// ========== RUNNER ==========
+
+static void printJson(const Region& region, const char* pattern, CacheMode mode, size_t bytes,
+                      uint32_t cyclesMin, uint32_t cyclesMax, uint32_t accesses) {
+    const float cyclesPerUs = F_CPU_ACTUAL / 1000000.0f;
+    const float us = cyclesMin / cyclesPerUs;
+    const float mbPerS = (us > 0.0f) ? (bytes / us) : 0.0f;  // bytes/µs == MB/s
+    const float nsPerAccess = (accesses > 0) ? (us * 1000.0f / accesses) : 0.0f;
+
+    Serial.print("{\"bench\":\"mem\",\"region\":\"");
+    Serial.print(region.name);
+    Serial.print("\",\"pattern\":\"");
+    Serial.print(pattern);
+    Serial.print("\",\"cache\":\"");
+    Serial.print(mode == CacheMode::COLD ? "cold" : "warm");
+    Serial.print("\",\"bytes\":");
+    Serial.print(bytes);
+    Serial.print(",\"reps\":");
+    Serial.print(REPS);
+    Serial.print(",\"cycles_min\":");
+    Serial.print(cyclesMin);
+    Serial.print(",\"cycles_max\":");
+    Serial.print(cyclesMax);
+    Serial.print(",\"mb_per_s\":");
+    Serial.print(mbPerS, 1);
+    Serial.print(",\"ns_per_access\":");
+    Serial.print(nsPerAccess, 2);
+    Serial.println("}");
+}
+
+static void runPattern(const Region& region, const char* name, PatternFn fn, CacheMode mode) {
+    const size_t bytes = (mode == CacheMode::COLD) ? BENCH_BYTES : WARM_BYTES;
+    uint32_t cyclesMin = 0xFFFFFFFF;
+    uint32_t cyclesMax = 0;
+    uint32_t accesses = 0;
+
+    if (mode == CacheMode::WARM) {
+        fn(region.buffer, bytes);  // Untimed pass pulls working set into L1
+    }
+
+    for (uint8_t rep = 0; rep < REPS; rep++) {
+        if (mode == CacheMode::COLD && region.cached) {
+            // Write back and invalidate: next access must go to the bus
+            arm_dcache_flush_delete(region.buffer, bytes);
+        }
+
+        noInterrupts();  // Keep audio/USB ISRs out of the measurement
+        uint32_t start = ARM_DWT_CYCCNT;
+        accesses = fn(region.buffer, bytes);
+        uint32_t cycles = ARM_DWT_CYCCNT - start;
+        interrupts();
+
+        if (cycles < cyclesMin) cyclesMin = cycles;
+        if (cycles > cyclesMax) cyclesMax = cycles;
+    }
+
+    printJson(region, name, mode, bytes, cyclesMin, cyclesMax, accesses);
+}
+
+static void runRegion(const Region& region) {
+    Serial.print("# Region ");
+    Serial.println(region.name);
+
+    // Fill with a non-trivial pattern (values don't matter, but avoid all-zero)
+    for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+        region.buffer[i] = static_cast<int16_t>(i * 7);
+    }
+
+    const CacheMode modes[] = {CacheMode::COLD, CacheMode::WARM};
+    for (CacheMode mode : modes) {
+        runPattern(region, "seq_read", patternSeqRead, mode);
+        runPattern(region, "seq_write", patternSeqWrite, mode);
+        runPattern(region, "reverse_read", patternReverseRead, mode);
+        runPattern(region, "stride_read_16", patternStrideRead<16>, mode);
+        runPattern(region, "stride_read_32", patternStrideRead<32>, mode);
+        runPattern(region, "stride_read_64", patternStrideRead<64>, mode);
+        runPattern(region, "wrap_copy", patternWrapCopy, mode);
+        runPattern(region, "stereo_planar", patternStereoPlanar, mode);
+        runPattern(region, "stereo_interleaved", patternStereoInterleaved, mode);
+    }
+
+    // Latency chain overwrites buffer contents, so it runs last.
+    // Chain spans exactly the working set of each mode.
+    for (CacheMode mode : modes) {
+        const size_t bytes = (mode == CacheMode::COLD) ? BENCH_BYTES : WARM_BYTES;
+        buildChaseChain(region.buffer, bytes);
+        if (region.cached) {
+            arm_dcache_flush(region.buffer, bytes);  // Chain must reach memory
+        }
+        runPattern(region, "latency_chase", patternLatencyChase, mode);
+    }
+}
+
+static void runAll() {
+    Serial.print("# MicroLoop memory benchmark, F_CPU_ACTUAL=");
+    Serial.print(F_CPU_ACTUAL);
+    Serial.print(", bytes=");
+    Serial.print(BENCH_BYTES);
+    Serial.print(", warm_bytes=");
+    Serial.println(WARM_BYTES);
+
+    const Region dtcm = {"DTCM", s_dtcmBuf, false};
+    const Region ocram = {"OCRAM", s_ocramBuf, true};
+    const Region psram = {"PSRAM", s_psramBuf, true};
+
+    runRegion(dtcm);
+    runRegion(ocram);
+    if (external_psram_size > 0) {
+        runRegion(psram);
+    } else {
+        Serial.println("# PSRAM not fitted, skipped");
+    }
+
+    Serial.println("# Done. Press any key to rerun.");
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial && millis() < 3000);  // Wait up to 3s for serial
+
+    Serial.println();
+    Serial.println("# ╔════════════════════════════════════════╗");
+    Serial.println("# ║    MicroLoop Memory Benchmark          ║");
+    Serial.println("# ╚════════════════════════════════════════╝");
+
+    // DWT cycle counter is enabled by the Teensy 4 startup code
+    runAll();
+}
+
+void loop() {
+    if (Serial.available()) {
+        while (Serial.available()) {
+            Serial.read();
+        }
+        runAll();
+    }
+    delay(10);
+}
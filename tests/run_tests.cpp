@@ -20,6 +20,17 @@
 #include "test_timekeeper.cpp"
 #include "test_trace.cpp"
 #include "test_spsc_queue.cpp"
+#include "test_telemetry.cpp"
+#include "test_stack_monitor.cpp"
+#include "test_quantization.cpp"
+#include "test_dsp_kernels.cpp"
+#include "test_display_frame.cpp"
+#include "test_perf_journal.cpp"
+#include "test_step_sequencer.cpp"
+#include "test_overdub_history.cpp"
+#include "test_smoothed_param.cpp"
+#include "test_log.cpp"
+#include "test_remote.cpp"
 
 void setup() {
     // Initialize serial
@@ -0,0 +1,96 @@
+/**
+ * run_tests_host.cpp - Host (Linux) test entry point
+ *
+ * Same suites as run_tests.cpp, built against the Teensy stubs by
+ * host/CMakeLists.txt (target microloop_tests, MICROLOOP_HOST defined).
+ *
+ * USAGE:
+ *   microloop_tests              Run every test, then every benchmark
+ *   microloop_tests TimeKeeper_  Only entries whose name starts with the prefix
+ *   microloop_tests --json results.jsonl [prefix]
+ *                                Benchmark JSON records to a file instead of stdout
+ *                                (compare two runs with bench_compare)
+ *
+ * Exit code: number of failed tests (0 = all passed).
+ */
+
+#include <Arduino.h>
+#include "test_runner.h"
+#include "timekeeper.h"
+#include "trace.h"
+
+// Include test files (they auto-register via TEST() macro)
+#include "test_timekeeper.cpp"
+#include "test_trace.cpp"
+#include "test_spsc_queue.cpp"
+#include "test_telemetry.cpp"
+#include "test_stack_monitor.cpp"
+#include "test_quantization.cpp"
+#include "test_dsp_kernels.cpp"
+#include "test_display_frame.cpp"
+#include "test_perf_journal.cpp"
+#include "test_step_sequencer.cpp"
+#include "test_overdub_history.cpp"
+#include "test_smoothed_param.cpp"
+#include "test_log.cpp"
+#include "test_remote.cpp"
+
+/**
+ * Print into a stdio file (benchmark JSON records)
+ */
+class FilePrint : public Print {
+public:
+    explicit FilePrint(FILE* file) : m_file(file) {}
+
+    size_t write(uint8_t b) override {
+        return fputc(b, m_file) == EOF ? 0 : 1;
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+        return fwrite(buffer, 1, size, m_file);
+    }
+
+private:
+    FILE* m_file;
+};
+
+int main(int argc, char** argv) {
+    const char* jsonPath = nullptr;
+    const char* filter = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (filter == nullptr && argv[i][0] != '-') {
+            filter = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s [--json file] [name-prefix]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    FILE* jsonFile = nullptr;
+    if (jsonPath != nullptr) {
+        jsonFile = fopen(jsonPath, "w");
+        if (jsonFile == nullptr) {
+            fprintf(stderr, "ERROR: cannot create %s\n", jsonPath);
+            return 1;
+        }
+    }
+    FilePrint jsonOut(jsonFile);
+    if (jsonFile != nullptr) {
+        TestRunner::setJsonOutput(&jsonOut);
+    }
+
+    Serial.simSetEcho(true);  // Serial output to stdout
+
+    TimeKeeper::begin();
+    Trace::clear();
+
+    int failed = RUN_TESTS_MATCHING(filter);
+    fflush(stdout);
+
+    if (jsonFile != nullptr) {
+        fclose(jsonFile);
+    }
+    return failed > 255 ? 255 : failed;
+}
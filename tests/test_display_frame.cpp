@@ -0,0 +1,43 @@
+/**
+ * test_display_frame.cpp - Display frame cost benchmarks
+ *
+ * PURPOSE:
+ * A frame is what DisplayIO::threadLoop() does per command: clear the
+ * framebuffer, blit a full-screen 128x64 bitmap, push it over I2C. The two
+ * halves are measured separately because they scale differently: render is
+ * CPU (code changes), push is bus time (~1 KB at 400 kHz, ~25 ms).
+ *
+ * NOTES:
+ * - Uses its own SSD1306 instance on Wire1 (DisplayIO is not started in the
+ *   test build); with no panel fitted the push only measures NACKed writes
+ * - The host driver does not rasterise: host figures only track call
+ *   overhead, compare device captures for real frame times
+ */
+
+#include <Adafruit_SSD1306.h>
+#include <Wire.h>
+#include "test_runner.h"
+#include "bitmaps.h"
+
+static Adafruit_SSD1306 s_frameDisplay(128, 64, &Wire1, -1);
+
+static void displayFrameBegin() {
+    static bool started = false;
+    if (!started) {
+        Wire1.begin();
+        Wire1.setClock(400000);  // Same bus speed as DisplayIO::begin()
+        s_frameDisplay.begin(SSD1306_SWITCHCAPVCC, 0x3C);
+        started = true;
+    }
+}
+
+BENCHMARK(DisplayFrame_Render, 100) {
+    displayFrameBegin();
+    s_frameDisplay.clearDisplay();
+    s_frameDisplay.drawBitmap(0, 0, bitmap_default, 128, 64, WHITE);
+}
+
+BENCHMARK(DisplayFrame_Push, 4) {
+    displayFrameBegin();
+    s_frameDisplay.display();
+}
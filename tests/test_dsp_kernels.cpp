@@ -0,0 +1,517 @@
+/**
+ * test_dsp_kernels.cpp - Unit tests and benchmarks for the audio ISR kernels
+ *
+ * PURPOSE:
+ * The choke fade curves and the limiter gain computer are pure functions,
+ * so their invariants are tested directly. The per-block costs are measured
+ * the way the audio ISR runs them: a source object feeds stereo blocks to
+ * the effect, a sink takes them back to the pool, and one benchmark
+ * operation is one update() of each object in the chain.
+ * DspKernels_SourceSinkBlock runs the same chain without an effect -
+ * subtract it to get the cost of the effect's update().
+ * The overdub mix kernel is benchmarked on its own against a loop buffer
+ * in EXTMEM, walked block by block the way a playing loop is (on the
+ * device this is the PSRAM read-modify-write; on the host plain RAM).
+ * The WSOLA stretch is measured per block with its search spread over the
+ * hop, at full quality and at the governor's first step down; host renders with quality metrics are in host/tools/stretch_render.cpp.
+ */
+
+#include <Audio.h>
+#include "test_runner.h"
+#include "audio_choke.h"
+#include "audio_limiter.h"
+#include "choke_curves.h"
+#include "gain_ramp.h"
+#include "overdub_mix.h"
+#include "wsola_stretch.h"
+
+// ========== FIXTURE ==========
+
+/**
+ * Stereo block source: near full-scale square wave (limiter always working)
+ */
+class DspBenchSource : public AudioStream {
+public:
+    DspBenchSource() : AudioStream(0, nullptr) {}
+
+    void update() override {
+        for (unsigned char channel = 0; channel < 2; channel++) {
+            audio_block_t* block = allocate();
+            if (block == nullptr) {
+                return;
+            }
+            for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+                block->data[i] = (i & 16) ? 32000 : -32000;
+            }
+            transmit(block, channel);
+            release(block);
+        }
+    }
+};
+
+/**
+ * Stereo block source: constant level (0 = silence, 32767 = full-scale step)
+ */
+class DspStepSource : public AudioStream {
+public:
+    DspStepSource() : AudioStream(0, nullptr) {}
+
+    void update() override {
+        for (unsigned char channel = 0; channel < 2; channel++) {
+            audio_block_t* block = allocate();
+            if (block == nullptr) {
+                return;
+            }
+            for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+                block->data[i] = level;
+            }
+            transmit(block, channel);
+            release(block);
+        }
+    }
+
+    int16_t level = 0;
+};
+
+/**
+ * Stereo block sink: records the output peak
+ */
+class DspBenchSink : public AudioStream {
+public:
+    DspBenchSink() : AudioStream(2, m_inputQueue) {}
+
+    void update() override {
+        for (unsigned int channel = 0; channel < 2; channel++) {
+            audio_block_t* block = receiveReadOnly(channel);
+            if (block == nullptr) {
+                continue;
+            }
+            for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+                int32_t s = block->data[i];
+                if (s < 0) s = -s;
+                if (s > peak) peak = s;
+            }
+            release(block);
+        }
+    }
+
+    int32_t peak = 0;
+
+private:
+    audio_block_t* m_inputQueue[2];
+};
+
+// One chain per effect (no shared blocks, so no copy-on-write)
+static DspBenchSource s_dspBaseSource;
+static DspBenchSink s_dspBaseSink;
+static AudioConnection s_dspBasePatchL(s_dspBaseSource, 0, s_dspBaseSink, 0);
+static AudioConnection s_dspBasePatchR(s_dspBaseSource, 1, s_dspBaseSink, 1);
+
+static DspBenchSource s_dspChokeSource;
+static AudioEffectChoke s_dspChoke;
+static DspBenchSink s_dspChokeSink;
+static AudioConnection s_dspChokePatchInL(s_dspChokeSource, 0, s_dspChoke, 0);
+static AudioConnection s_dspChokePatchInR(s_dspChokeSource, 1, s_dspChoke, 1);
+static AudioConnection s_dspChokePatchOutL(s_dspChoke, 0, s_dspChokeSink, 0);
+static AudioConnection s_dspChokePatchOutR(s_dspChoke, 1, s_dspChokeSink, 1);
+
+static DspBenchSource s_dspLimiterSource;
+static AudioEffectLimiter s_dspLimiter;
+static DspBenchSink s_dspLimiterSink;
+static AudioConnection s_dspLimiterPatchInL(s_dspLimiterSource, 0, s_dspLimiter, 0);
+static AudioConnection s_dspLimiterPatchInR(s_dspLimiterSource, 1, s_dspLimiter, 1);
+static AudioConnection s_dspLimiterPatchOutL(s_dspLimiter, 0, s_dspLimiterSink, 0);
+static AudioConnection s_dspLimiterPatchOutR(s_dspLimiter, 1, s_dspLimiterSink, 1);
+
+static DspStepSource s_dspStepSource;
+static AudioEffectLimiter s_dspStepLimiter;
+static DspBenchSink s_dspStepSink;
+static AudioConnection s_dspStepPatchInL(s_dspStepSource, 0, s_dspStepLimiter, 0);
+static AudioConnection s_dspStepPatchInR(s_dspStepSource, 1, s_dspStepLimiter, 1);
+static AudioConnection s_dspStepPatchOutL(s_dspStepLimiter, 0, s_dspStepSink, 0);
+static AudioConnection s_dspStepPatchOutR(s_dspStepLimiter, 1, s_dspStepSink, 1);
+
+static void dspBenchBegin() {
+    // Two blocks in flight per chain update
+    static bool allocated = false;
+    if (!allocated) {
+        AudioMemory(8);
+        allocated = true;
+    }
+}
+
+// ========== CHOKE CURVES ==========
+
+TEST(DspKernels_ChokeCurves_EndpointsAndMonotonic) {
+    for (uint8_t c = 0; c < CHOKE_CURVE_COUNT; c++) {
+        ChokeCurve curve = static_cast<ChokeCurve>(c);
+        ASSERT_EQ(ChokeCurves::gainAt(curve, 0), 0);
+        ASSERT_EQ(ChokeCurves::gainAt(curve, ChokeCurves::POS_ONE), 32767);
+
+        int32_t previous = 0;
+        for (uint32_t pos = 0; pos < ChokeCurves::POS_ONE; pos += 4099) {
+            int32_t gain = ChokeCurves::gainAt(curve, pos);
+            ASSERT_TRUE(gain >= previous);
+            previous = gain;
+        }
+    }
+}
+
+// ========== LIMITER GAIN COMPUTER ==========
+
+TEST(DspKernels_LimiterGain_UnityBelowThreshold) {
+    const int32_t threshold = 24576;
+    ASSERT_EQ(AudioEffectLimiter::computeGain(0, threshold), AudioEffectLimiter::GAIN_UNITY);
+    ASSERT_EQ(AudioEffectLimiter::computeGain(threshold, threshold), AudioEffectLimiter::GAIN_UNITY);
+    ASSERT_LT(AudioEffectLimiter::computeGain(threshold + 1, threshold), AudioEffectLimiter::GAIN_UNITY + 1);
+}
+
+TEST(DspKernels_LimiterGain_OutputMonotonicBelowFullScale) {
+    // Knee output (peak * gain) rises with the peak and never reaches full scale
+    for (int32_t threshold = 4096; threshold < 32112; threshold += 4001) {
+        int32_t previous = 0;
+        for (int32_t peak = threshold; peak <= 32768; peak += 61) {
+            int32_t out = (peak * AudioEffectLimiter::computeGain(peak, threshold)) >> 15;
+            ASSERT_TRUE(out + 1 >= previous);  // Q15 rounding: 1 LSB
+            ASSERT_LT(out, 32767);
+            previous = out;
+        }
+    }
+}
+
+TEST(DspKernels_LimiterBlock_StaysBelowFullScale) {
+    dspBenchBegin();
+    s_dspLimiterSink.peak = 0;
+    for (int i = 0; i < 4; i++) {
+        s_dspLimiterSource.update();
+        s_dspLimiter.update();
+        s_dspLimiterSink.update();
+    }
+    ASSERT_GT(s_dspLimiterSink.peak, 24576);
+    ASSERT_LT(s_dspLimiterSink.peak, 32767);
+}
+
+TEST(DspKernels_LimiterBlock_StepAtBlockStartNotClipped) {
+    // Silence leaves the gain at unity, then full scale from sample 0:
+    // attack must already hold the first sample below the ceiling
+    dspBenchBegin();
+    s_dspStepSource.level = 0;
+    s_dspStepSource.update();
+    s_dspStepLimiter.update();
+    s_dspStepSink.update();
+    ASSERT_EQ(s_dspStepLimiter.getGain(), AudioEffectLimiter::GAIN_UNITY);
+
+    s_dspStepSource.level = 32767;
+    s_dspStepSink.peak = 0;
+    s_dspStepSource.update();
+    s_dspStepLimiter.update();
+    s_dspStepSink.update();
+    ASSERT_GT(s_dspStepSink.peak, 24576);
+    ASSERT_LT(s_dspStepSink.peak, 32112);  // Below the limiter ceiling: no SSAT clipping
+}
+
+TEST(DspKernels_GainRamp_RunsBothWays) {
+    // Fade-out (negative step) and fade-in land on their end gain
+    int16_t down[AUDIO_BLOCK_SAMPLES];
+    int16_t up[AUDIO_BLOCK_SAMPLES];
+    for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+        down[i] = -20000;
+        up[i] = 20000;
+    }
+    GainRamp::apply(down, 32767, 0);
+    GainRamp::apply(up, 0, 32767);
+
+    ASSERT_EQ(down[AUDIO_BLOCK_SAMPLES - 1], 0);
+    ASSERT_GT(up[AUDIO_BLOCK_SAMPLES - 1], 19990);
+    for (size_t i = 1; i < AUDIO_BLOCK_SAMPLES; i++) {
+        ASSERT_TRUE(down[i] >= down[i - 1]);  // Magnitude falls monotonically
+        ASSERT_TRUE(up[i] >= up[i - 1]);
+    }
+}
+
+// ========== OVERDUB MIX ==========
+
+static uint32_t s_dspRng = 0x1234567;
+
+static int16_t dspRandomSample() {
+    // xorshift32, full 16-bit range
+    s_dspRng ^= s_dspRng << 13;
+    s_dspRng ^= s_dspRng >> 17;
+    s_dspRng ^= s_dspRng << 5;
+    return static_cast<int16_t>(s_dspRng);
+}
+
+TEST(DspKernels_OverdubMix_PackedMatchesScalar) {
+    // Aligned, odd length and misaligned loop pointer, several feedbacks
+    alignas(4) static int16_t loopA[AUDIO_BLOCK_SAMPLES + 2];
+    alignas(4) static int16_t loopB[AUDIO_BLOCK_SAMPLES + 2];
+    alignas(4) static int16_t input[AUDIO_BLOCK_SAMPLES + 2];
+    const int32_t feedbacks[] = { OverdubMix::FEEDBACK_UNITY, 58982, 32768, 1, 0 };
+    const size_t lengths[] = { AUDIO_BLOCK_SAMPLES, 127, 6, 1 };
+
+    for (int32_t feedback : feedbacks) {
+        for (size_t length : lengths) {
+            for (size_t offset = 0; offset < 2; offset++) {
+                for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES + 2; i++) {
+                    loopA[i] = loopB[i] = dspRandomSample();
+                    input[i] = dspRandomSample();
+                }
+                OverdubMix::mix(loopA + offset, input, length, feedback);
+                OverdubMix::mixScalar(loopB + offset, input, length, feedback);
+                for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES + 2; i++) {
+                    ASSERT_EQ(loopA[i], loopB[i]);
+                }
+            }
+        }
+    }
+}
+
+TEST(DspKernels_OverdubMix_SaturatesAndKeepsLayer) {
+    alignas(4) int16_t loop[4] = { 30000, -30000, 1234, -1 };
+    alignas(4) const int16_t input[4] = { 10000, -10000, 0, 0 };
+
+    OverdubMix::mix(loop, input, 4, OverdubMix::FEEDBACK_UNITY);
+    ASSERT_EQ(loop[0], 32767);
+    ASSERT_EQ(loop[1], -32768);
+    ASSERT_EQ(loop[2], 1234);  // Unity feedback is bit-exact
+    ASSERT_EQ(loop[3], -1);
+
+    // Half feedback halves the old layer
+    OverdubMix::mix(loop, input, 4, OverdubMix::FEEDBACK_UNITY / 2);
+    ASSERT_EQ(loop[2], 617);
+}
+
+// ========== WSOLA STRETCH ==========
+
+static constexpr size_t DSP_STRETCH_LOOP = 44100;  // Stereo loop, 1 s
+static int16_t s_dspStretchL[DSP_STRETCH_LOOP];
+static int16_t s_dspStretchR[DSP_STRETCH_LOOP];
+
+static WsolaStretch::Source dspStretchSource() {
+    static bool filled = false;
+    if (!filled) {
+        for (size_t i = 0; i < DSP_STRETCH_LOOP; i++) {
+            s_dspStretchL[i] = dspRandomSample();
+            s_dspStretchR[i] = dspRandomSample();
+        }
+        filled = true;
+    }
+    // Start inside the buffer and wrap, as a loop claimed from the pre-roll ring does
+    return WsolaStretch::Source{ s_dspStretchL, s_dspStretchR, 1000, DSP_STRETCH_LOOP, DSP_STRETCH_LOOP - 3000 };
+}
+
+static int16_t dspStretchAt(const WsolaStretch::Source& src, const int16_t* buffer, size_t n) {
+    return buffer[(src.start + n % src.length) % src.wrap];
+}
+
+TEST(DspKernels_Wsola_UnitySpeedIsBitExact) {
+    const WsolaStretch::Source src = dspStretchSource();
+    static WsolaStretch stretch;
+    stretch.reset(src.length - 700, src.length);  // Wraps over the loop end
+    stretch.setSpeed(22050, 22050);
+
+    int16_t outL[AUDIO_BLOCK_SAMPLES];
+    int16_t outR[AUDIO_BLOCK_SAMPLES];
+    size_t pos = src.length - 700;
+    bool ok = true;
+    for (int block = 0; block < 100; block++) {
+        stretch.process(src, outL, outR, AUDIO_BLOCK_SAMPLES);
+        for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES; i++, pos++) {
+            ok = ok && outL[i] == dspStretchAt(src, s_dspStretchL, pos);
+            ok = ok && outR[i] == dspStretchAt(src, s_dspStretchR, pos);
+        }
+        ok = ok && stretch.getLastOffset() == 0;
+    }
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(stretch.getPosition(), pos % src.length);
+}
+
+TEST(DspKernels_Wsola_PositionFollowsSpeed) {
+    // 124 -> 128 BPM (loop plays faster) and 128 -> 120 BPM (slower)
+    const WsolaStretch::Source src = dspStretchSource();
+    const uint32_t capture[] = { 21338, 20672 };  // spb at 124 / 128 BPM
+    const uint32_t now[] = { 20672, 22050 };      // spb at 128 / 120 BPM
+
+    for (int c = 0; c < 2; c++) {
+        static WsolaStretch stretch;
+        stretch.reset(0, src.length);
+        stretch.setSpeed(capture[c], now[c]);
+
+        int16_t outL[AUDIO_BLOCK_SAMPLES];
+        int16_t outR[AUDIO_BLOCK_SAMPLES];
+        const int blocks = 120;  // 30 hops
+        int32_t worstOffset = 0;
+        for (int block = 0; block < blocks; block++) {
+            stretch.process(src, outL, outR, AUDIO_BLOCK_SAMPLES);
+            int32_t offset = stretch.getLastOffset();
+            if (offset < 0) offset = -offset;
+            if (offset > worstOffset) worstOffset = offset;
+        }
+
+        // Nominal position: exactly samples * speed (Q16), no drift
+        uint64_t expected = ((static_cast<uint64_t>(blocks) * AUDIO_BLOCK_SAMPLES * stretch.getSpeed()) >> 16) % src.length;
+        ASSERT_EQ(stretch.getPosition(), static_cast<size_t>(expected));
+        ASSERT_TRUE(worstOffset <= static_cast<int32_t>(WsolaStretch::SEEK));
+    }
+}
+
+TEST(DspKernels_Wsola_QualityLevelsNarrowTheSearch) {
+    // Each level keeps the nominal position; the chosen offsets stay in its range
+    const WsolaStretch::Source src = dspStretchSource();
+    const int32_t maxOffset[WsolaStretch::QUALITY_LEVELS] = { static_cast<int32_t>(WsolaStretch::SEEK),
+                                                              static_cast<int32_t>(WsolaStretch::SEEK / 2), 0 };
+
+    for (uint8_t level = 0; level < WsolaStretch::QUALITY_LEVELS; level++) {
+        static WsolaStretch stretch;
+        stretch.setQuality(level);
+        ASSERT_EQ(stretch.getQuality(), level);
+        stretch.reset(0, src.length);
+        stretch.setSpeed(21338, 20672);
+
+        int16_t outL[AUDIO_BLOCK_SAMPLES];
+        int16_t outR[AUDIO_BLOCK_SAMPLES];
+        const int blocks = 120;
+        int32_t worstOffset = 0;
+        for (int block = 0; block < blocks; block++) {
+            stretch.process(src, outL, outR, AUDIO_BLOCK_SAMPLES);
+            int32_t offset = stretch.getLastOffset();
+            if (offset < 0) offset = -offset;
+            if (offset > worstOffset) worstOffset = offset;
+        }
+        uint64_t expected = ((static_cast<uint64_t>(blocks) * AUDIO_BLOCK_SAMPLES * stretch.getSpeed()) >> 16) % src.length;
+        ASSERT_EQ(stretch.getPosition(), static_cast<size_t>(expected));
+        ASSERT_TRUE(worstOffset <= maxOffset[level]);
+        if (level == WsolaStretch::QUALITY_FULL) {
+            ASSERT_TRUE(worstOffset > static_cast<int32_t>(WsolaStretch::SEEK / 2));  // Full range in use
+        }
+    }
+
+    static WsolaStretch clamped;
+    clamped.setQuality(WsolaStretch::QUALITY_LEVELS);
+    ASSERT_EQ(clamped.getQuality(), WsolaStretch::QUALITY_NO_SEARCH);
+}
+
+TEST(DspKernels_Wsola_QualityChangeKeepsUnityBitExact) {
+    // Switching levels mid-play (as the governor does) never steps the output
+    const WsolaStretch::Source src = dspStretchSource();
+    static WsolaStretch stretch;
+    stretch.reset(0, src.length);
+    stretch.setSpeed(22050, 22050);
+
+    int16_t outL[AUDIO_BLOCK_SAMPLES];
+    int16_t outR[AUDIO_BLOCK_SAMPLES];
+    size_t pos = 0;
+    bool ok = true;
+    for (int block = 0; block < 60; block++) {
+        stretch.setQuality(static_cast<uint8_t>((block / 7) % WsolaStretch::QUALITY_LEVELS));
+        stretch.process(src, outL, outR, AUDIO_BLOCK_SAMPLES);
+        for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES; i++, pos++) {
+            ok = ok && outL[i] == dspStretchAt(src, s_dspStretchL, pos);
+            ok = ok && outR[i] == dspStretchAt(src, s_dspStretchR, pos);
+        }
+    }
+    ASSERT_TRUE(ok);
+}
+
+// ========== KERNEL COST ==========
+
+BENCHMARK(DspKernels_ChokeGainAt, 1000) {
+    // Two lookups per block edge (start and end of the fade step)
+    static uint32_t pos = 0;
+    pos += 0x00012345;
+    benchmarkSink(ChokeCurves::gainAt(ChokeCurve::EQUAL_POWER, pos & (ChokeCurves::POS_ONE - 1)));
+}
+
+BENCHMARK(DspKernels_LimiterComputeGain, 1000) {
+    static int32_t peak = 24576;
+    peak = (peak >= 32768) ? 24577 : peak + 7;
+    benchmarkSink(AudioEffectLimiter::computeGain(peak, 24576));
+}
+
+// Loop buffer walked block by block (64K samples = 128KB, larger than any cache)
+static constexpr size_t DSP_OVERDUB_LOOP_SAMPLES = 65536;
+alignas(32) static EXTMEM int16_t s_dspOverdubLoop[DSP_OVERDUB_LOOP_SAMPLES];
+alignas(4) static int16_t s_dspOverdubInput[AUDIO_BLOCK_SAMPLES];
+static size_t s_dspOverdubPos = 0;
+
+static int16_t* dspOverdubNextBlock() {
+    int16_t* block = &s_dspOverdubLoop[s_dspOverdubPos];
+    s_dspOverdubPos = (s_dspOverdubPos + AUDIO_BLOCK_SAMPLES) % DSP_OVERDUB_LOOP_SAMPLES;
+    return block;
+}
+
+BENCHMARK(DspKernels_OverdubMixScalar, 500) {
+    OverdubMix::mixScalar(dspOverdubNextBlock(), s_dspOverdubInput, AUDIO_BLOCK_SAMPLES, 58982);
+}
+
+BENCHMARK(DspKernels_OverdubMixPacked, 500) {
+    OverdubMix::mix(dspOverdubNextBlock(), s_dspOverdubInput, AUDIO_BLOCK_SAMPLES, 58982);
+}
+
+BENCHMARK(DspKernels_OverdubMixUnity, 500) {
+    OverdubMix::mix(dspOverdubNextBlock(), s_dspOverdubInput, AUDIO_BLOCK_SAMPLES, OverdubMix::FEEDBACK_UNITY);
+}
+
+// One block at 124 -> 128 BPM, search included (spread over the hop's blocks)
+BENCHMARK(DspKernels_WsolaBlock, 400) {
+    static const WsolaStretch::Source src = dspStretchSource();
+    static WsolaStretch stretch;
+    static bool started = false;
+    static int16_t outL[AUDIO_BLOCK_SAMPLES];
+    static int16_t outR[AUDIO_BLOCK_SAMPLES];
+    if (!started) {
+        stretch.reset(0, src.length);
+        stretch.setSpeed(21338, 20672);
+        started = true;
+    }
+    stretch.process(src, outL, outR, AUDIO_BLOCK_SAMPLES);
+    benchmarkSink(outL[0]);
+}
+
+// Same at the governor's first step down (half the search range, no refine)
+BENCHMARK(DspKernels_WsolaBlockNarrow, 400) {
+    static const WsolaStretch::Source src = dspStretchSource();
+    static WsolaStretch stretch;
+    static bool started = false;
+    static int16_t outL[AUDIO_BLOCK_SAMPLES];
+    static int16_t outR[AUDIO_BLOCK_SAMPLES];
+    if (!started) {
+        stretch.setQuality(WsolaStretch::QUALITY_NARROW);
+        stretch.reset(0, src.length);
+        stretch.setSpeed(21338, 20672);
+        started = true;
+    }
+    stretch.process(src, outL, outR, AUDIO_BLOCK_SAMPLES);
+    benchmarkSink(outL[0]);
+}
+
+// ========== BLOCK COST (one update() per op) ==========
+
+BENCHMARK(DspKernels_SourceSinkBlock, 200) {
+    dspBenchBegin();
+    s_dspBaseSource.update();
+    s_dspBaseSink.update();
+}
+
+BENCHMARK(DspKernels_ChokeFadeBlock, 200) {
+    // Toggled every block: always inside a fade (gain ramp path)
+    static bool muted = false;
+    dspBenchBegin();
+    muted = !muted;
+    if (muted) {
+        s_dspChoke.enable();
+    } else {
+        s_dspChoke.disable();
+    }
+    s_dspChokeSource.update();
+    s_dspChoke.update();
+    s_dspChokeSink.update();
+}
+
+BENCHMARK(DspKernels_LimiterBlock, 200) {
+    // Source is above the knee: peak scan, gain computer and SSAT ramp
+    dspBenchBegin();
+    s_dspLimiterSource.update();
+    s_dspLimiter.update();
+    s_dspLimiterSink.update();
+}
@@ -0,0 +1,152 @@
+/**
+ * test_log.cpp - Unit tests for the deferred-formatting log sink
+ *
+ * Queues messages the way controllers do (LOG_* macros, no Serial) and
+ * drains them into a memory Print the way the log thread drains into
+ * Serial. Checks formatting, ordering, batch limits, full-ring drops and
+ * the compile-time level filter.
+ */
+
+#include "test_runner.h"
+#include "log.h"
+#include <string.h>
+
+/**
+ * Print into a fixed buffer (stands in for Serial)
+ */
+class LogCapture : public Print {
+public:
+    size_t write(uint8_t b) override {
+        if (m_length + 1 < sizeof(m_text)) {
+            m_text[m_length++] = static_cast<char>(b);
+            m_text[m_length] = '\0';
+        }
+        return 1;
+    }
+
+    using Print::write;
+
+    bool contains(const char* text) const { return strstr(m_text, text) != nullptr; }
+    const char* text() const { return m_text; }
+    void reset() { m_length = 0; m_text[0] = '\0'; }
+
+private:
+    char m_text[2048] = {};
+    size_t m_length = 0;
+};
+
+// ========== FORMATTING ==========
+
+TEST(Log_FormatsDeferredArguments) {
+    Log::clear();
+    static const char* name = "1/16";  // Static: read when drained
+    int32_t negative = -42;
+    uint32_t samples = 11025;
+    LOG_INFO("q=%s n=%d s=%u h=%x c=%c f=%.3f p=100%%", name, negative, samples, 255u);
+    LOG_INFO("c=%c f=%.3f", 'L', 1.5f);
+
+    LogCapture out;
+    ASSERT_EQ(Log::drain(out), 2);
+    ASSERT_TRUE(out.contains("q=1/16 n=-42 s=11025 h=FF c=? f=? p=100%"));  // 4 args, 6 conversions
+    ASSERT_TRUE(out.contains("c=L f=1.500"));
+    ASSERT_EQ(Log::pending(), 0);
+}
+
+TEST(Log_ErrorAndWarnPrefixes) {
+    Log::clear();
+    LOG_ERROR("StepSequencer::setLength() - length must be 16 or 32 steps");
+    LOG_WARN("Looper: pre-roll holds only %u samples", 100u);
+    LOG_INFO("Looper: CLEARED");
+
+    LogCapture out;
+    Log::drain(out);
+    ASSERT_TRUE(out.contains("ERROR: StepSequencer::setLength()"));
+    ASSERT_TRUE(out.contains("WARNING: Looper: pre-roll holds only 100 samples"));
+    ASSERT_TRUE(out.contains("] Looper: CLEARED"));  // INFO: timestamp, no prefix
+}
+
+// ========== RING ==========
+
+TEST(Log_DrainsInOrderInBatches) {
+    Log::clear();
+    for (int i = 0; i < 10; i++) {
+        LOG_INFO("msg %d;", i);
+    }
+
+    LogCapture out;
+    ASSERT_EQ(Log::drain(out, 4), 4);
+    ASSERT_EQ(Log::pending(), 6);
+    ASSERT_EQ(Log::drain(out, 100), 6);
+
+    const char* last = out.text();
+    for (int i = 0; i < 10; i++) {
+        char expected[16];
+        snprintf(expected, sizeof(expected), "msg %d;", i);
+        const char* at = strstr(last, expected);
+        ASSERT_TRUE(at != nullptr);
+        last = at;
+    }
+}
+
+TEST(Log_FullRingDropsAndCounts) {
+    Log::clear();
+    for (uint32_t i = 0; i < Log::CAPACITY; i++) {
+        ASSERT_TRUE(LOG_INFO("fill %u", i));
+    }
+    ASSERT_FALSE(LOG_INFO("over"));  // The caller never waits
+    ASSERT_FALSE(LOG_INFO("over"));
+    ASSERT_EQ(Log::getDroppedCount(), 2);
+    ASSERT_EQ(Log::pending(), Log::CAPACITY);
+
+    LogCapture out;
+    Log::drain(out, 1);
+    ASSERT_TRUE(out.contains("WARNING: Log - 2 message(s) dropped"));
+    ASSERT_TRUE(LOG_INFO("room again"));  // One slot freed
+
+    out.reset();
+    Log::drain(out);
+    ASSERT_FALSE(out.contains("dropped"));  // Reported once
+    ASSERT_TRUE(out.contains("room again"));
+    ASSERT_EQ(Log::getDroppedCount(), 2);
+}
+
+TEST(Log_WrapsAroundManyLaps) {
+    Log::clear();
+    LogCapture out;
+    for (uint32_t i = 0; i < Log::CAPACITY * 5 + 3; i++) {
+        ASSERT_TRUE(LOG_INFO("lap %u", i));
+        if (Log::pending() > Log::CAPACITY / 2) {
+            out.reset();
+            Log::drain(out);
+        }
+    }
+    out.reset();
+    Log::drain(out);
+    char expected[16];
+    snprintf(expected, sizeof(expected), "lap %u", static_cast<unsigned>(Log::CAPACITY * 5 + 2));
+    ASSERT_TRUE(out.contains(expected));
+    ASSERT_EQ(Log::getDroppedCount(), 0);
+}
+
+// ========== LEVEL FILTER ==========
+
+TEST(Log_DebugCompiledOutAtDefaultLevel) {
+    Log::clear();
+    int evaluated = 0;
+    LOG_DEBUG("never %d", ++evaluated);  // LOG_LEVEL defaults to INFO
+    (void)evaluated;
+    ASSERT_EQ(LOG_LEVEL, LOG_LEVEL_INFO);
+    ASSERT_EQ(evaluated, 0);  // Arguments are not even evaluated
+    ASSERT_EQ(Log::pending(), 0);
+}
+
+// ========== COST ==========
+
+// Producer side of one typical controller message (no formatting, no I/O)
+BENCHMARK(Log_Write, 1000) {
+    static const char* name = "1/16";
+    if (Log::pending() >= Log::CAPACITY - 1) {
+        Log::clear();
+    }
+    LOG_INFO("Stutter: CAPTURE START scheduled (%s) at %u", name, 12345u);
+}
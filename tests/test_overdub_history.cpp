@@ -0,0 +1,265 @@
+/**
+ * test_overdub_history.cpp - Unit tests for overdub undo/redo (copy-on-write pages)
+ *
+ * PURPOSE:
+ * Runs OverdubHistory on a small loop (not a multiple of the chunk size, so
+ * the short last chunk is covered) with the same call order as the stutter
+ * ISR: preserve() then OverdubMix::mix() per run, process() once per block.
+ * Checks that undo/redo restore the layers bit-exactly, that only touched
+ * pages are used, and that a swap is spread over blocks.
+ */
+
+#include "test_runner.h"
+#include "overdub_history.h"
+#include "overdub_mix.h"
+
+// ========== FIXTURE ==========
+
+static constexpr size_t HIST_LOOP = 5000;  // 3 pages, 40 chunks (last one short)
+using TestHistory = OverdubHistory<HIST_LOOP>;
+using TinyHistory = OverdubHistory<HIST_LOOP, 1>;
+
+alignas(4) static int16_t s_histLoopL[HIST_LOOP];
+alignas(4) static int16_t s_histLoopR[HIST_LOOP];
+alignas(4) static int16_t s_histPoolL[TestHistory::POOL_SAMPLES];
+alignas(4) static int16_t s_histPoolR[TestHistory::POOL_SAMPLES];
+alignas(4) static int16_t s_histInput[AUDIO_BLOCK_SAMPLES];
+static int16_t s_histSnapshotL[HIST_LOOP];
+static int16_t s_histSnapshotR[HIST_LOOP];
+
+static void histFill() {
+    for (size_t i = 0; i < HIST_LOOP; i++) {
+        s_histLoopL[i] = static_cast<int16_t>(i * 7);
+        s_histLoopR[i] = static_cast<int16_t>(-static_cast<int32_t>(i) * 3);
+    }
+    for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+        s_histInput[i] = static_cast<int16_t>(1000 + i);
+    }
+}
+
+static void histSnapshot() {
+    memcpy(s_histSnapshotL, s_histLoopL, sizeof(s_histLoopL));
+    memcpy(s_histSnapshotR, s_histLoopR, sizeof(s_histLoopR));
+}
+
+static bool histMatchesSnapshot() {
+    return memcmp(s_histSnapshotL, s_histLoopL, sizeof(s_histLoopL)) == 0 &&
+           memcmp(s_histSnapshotR, s_histLoopR, sizeof(s_histLoopR)) == 0;
+}
+
+/**
+ * Overdub `samples` from `pos` one block at a time, wrapping at the loop end
+ */
+template<typename History>
+static void histOverdub(History& history, size_t pos, size_t samples, int32_t feedback) {
+    while (samples > 0) {
+        size_t block = samples < AUDIO_BLOCK_SAMPLES ? samples : AUDIO_BLOCK_SAMPLES;
+        size_t i = 0;
+        while (i < block) {
+            size_t run = HIST_LOOP - pos;
+            if (run > block - i) run = block - i;
+            history.preserve(pos, run);
+            OverdubMix::mix(&s_histLoopL[pos], &s_histInput[i], run, feedback);
+            OverdubMix::mix(&s_histLoopR[pos], &s_histInput[i], run, feedback);
+            i += run;
+            pos = (pos + run) % HIST_LOOP;
+        }
+        samples -= block;
+    }
+}
+
+/**
+ * Run process() block by block until the swap is done
+ *
+ * @return blocks taken
+ */
+template<typename History>
+static uint32_t histRunSwap(History& history, size_t readPos) {
+    uint32_t blocks = 0;
+    while (history.busy() && blocks < 10000) {
+        history.process(readPos, HIST_LOOP);
+        readPos = (readPos + AUDIO_BLOCK_SAMPLES) % HIST_LOOP;
+        blocks++;
+    }
+    return blocks;
+}
+
+// ========== UNDO / REDO ==========
+
+TEST(OverdubHistory_UndoRedo_BitExact) {
+    static TestHistory history;
+    histFill();
+    history.begin(s_histLoopL, s_histLoopR, s_histPoolL, s_histPoolR);
+    histSnapshot();
+
+    // Full loop plus a wrap, with decay (every touched sample changes)
+    ASSERT_TRUE(history.beginPass());
+    histOverdub(history, 300, HIST_LOOP + 500, 58982);
+    ASSERT_FALSE(histMatchesSnapshot());
+    ASSERT_TRUE(history.canUndo());
+
+    // Undo
+    static int16_t mixedL[HIST_LOOP];
+    memcpy(mixedL, s_histLoopL, sizeof(mixedL));
+    ASSERT_TRUE(history.requestSwap());
+    ASSERT_FALSE(history.requestSwap());  // Already pending
+    histRunSwap(history, 1000);
+    ASSERT_TRUE(histMatchesSnapshot());
+    ASSERT_TRUE(history.canRedo());
+    ASSERT_FALSE(history.canUndo());
+
+    // Redo
+    ASSERT_TRUE(history.requestSwap());
+    histRunSwap(history, 4900);
+    ASSERT_EQ(memcmp(mixedL, s_histLoopL, sizeof(mixedL)), 0);
+    ASSERT_TRUE(history.canUndo());
+}
+
+TEST(OverdubHistory_NewPassDropsPreviousLevel) {
+    static TestHistory history;
+    histFill();
+    history.begin(s_histLoopL, s_histLoopR, s_histPoolL, s_histPoolR);
+
+    ASSERT_TRUE(history.beginPass());
+    histOverdub(history, 0, 1024, OverdubMix::FEEDBACK_UNITY);
+    histSnapshot();  // After pass 1
+
+    ASSERT_TRUE(history.beginPass());
+    histOverdub(history, 512, 1024, OverdubMix::FEEDBACK_UNITY);
+
+    // One undo goes back to the end of pass 1, not further
+    ASSERT_TRUE(history.requestSwap());
+    histRunSwap(history, 0);
+    ASSERT_TRUE(histMatchesSnapshot());
+    ASSERT_FALSE(history.canUndo());
+}
+
+// ========== MEMORY ==========
+
+TEST(OverdubHistory_OnlyTouchedPagesAreUsed) {
+    static TestHistory history;
+    histFill();
+    history.begin(s_histLoopL, s_histLoopR, s_histPoolL, s_histPoolR);
+
+    ASSERT_TRUE(history.beginPass());
+    histOverdub(history, 2048 + 64, 3 * AUDIO_BLOCK_SAMPLES, OverdubMix::FEEDBACK_UNITY);
+    ASSERT_EQ(history.getPagesUsed(), 1U);
+    ASSERT_EQ(history.getSavedChunks(), 4U);  // Unaligned: 3 blocks span 4 chunks
+
+    // Wrapping over the loop end touches the short last chunk and page 0
+    histOverdub(history, HIST_LOOP - 50, 100, OverdubMix::FEEDBACK_UNITY);
+    ASSERT_EQ(history.getPagesUsed(), 3U);
+}
+
+TEST(OverdubHistory_PoolExhaustedDropsUndo) {
+    static TinyHistory history;  // One page
+    histFill();
+    history.begin(s_histLoopL, s_histLoopR, s_histPoolL, s_histPoolR);
+
+    ASSERT_TRUE(history.beginPass());
+    histOverdub(history, 0, 2048, OverdubMix::FEEDBACK_UNITY);
+    ASSERT_TRUE(history.canUndo());
+
+    histOverdub(history, 2048, AUDIO_BLOCK_SAMPLES, OverdubMix::FEEDBACK_UNITY);
+    ASSERT_FALSE(history.canUndo());
+    ASSERT_TRUE(history.isUnavailable());
+    ASSERT_EQ(history.getOverflowCount(), 1U);
+    ASSERT_FALSE(history.requestSwap());
+    history.process(0, HIST_LOOP);
+    ASSERT_FALSE(history.busy());
+
+    // The next pass within budget can be undone again
+    ASSERT_TRUE(history.beginPass());
+    ASSERT_FALSE(history.isUnavailable());
+    histOverdub(history, 0, AUDIO_BLOCK_SAMPLES, OverdubMix::FEEDBACK_UNITY);
+    ASSERT_TRUE(history.canUndo());
+}
+
+// ========== ISR BUDGET ==========
+
+TEST(OverdubHistory_SwapIsSpreadOverBlocks) {
+    static TestHistory history;
+    histFill();
+    history.begin(s_histLoopL, s_histLoopR, s_histPoolL, s_histPoolR);
+
+    ASSERT_TRUE(history.beginPass());
+    histOverdub(history, 0, HIST_LOOP, OverdubMix::FEEDBACK_UNITY);
+    const size_t chunks = history.getSavedChunks();
+    ASSERT_EQ(chunks, TestHistory::LOOP_CHUNKS);
+
+    ASSERT_TRUE(history.requestSwap());
+    ASSERT_FALSE(history.beginPass());  // No new pass while swapping
+    uint32_t blocks = histRunSwap(history, 0);
+    uint32_t expected = static_cast<uint32_t>((chunks + TestHistory::SWAP_CHUNKS_PER_BLOCK - 1) /
+                                              TestHistory::SWAP_CHUNKS_PER_BLOCK);
+    ASSERT_EQ(blocks, expected);
+    ASSERT_EQ(history.getSwapCount(), 1U);
+}
+
+TEST(OverdubHistory_SwapStaysAheadOfReadHead) {
+    // Every block the reader plays after the request must already be undone
+    static TestHistory history;
+    histFill();
+    history.begin(s_histLoopL, s_histLoopR, s_histPoolL, s_histPoolR);
+    histSnapshot();
+
+    ASSERT_TRUE(history.beginPass());
+    histOverdub(history, 0, HIST_LOOP, OverdubMix::FEEDBACK_UNITY);
+    ASSERT_TRUE(history.requestSwap());
+
+    bool ok = true;
+    size_t readPos = 1700;
+    while (history.busy()) {
+        history.process(readPos, HIST_LOOP);
+        for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+            size_t p = (readPos + i) % HIST_LOOP;
+            ok = ok && (s_histLoopL[p] == s_histSnapshotL[p]);
+        }
+        readPos = (readPos + AUDIO_BLOCK_SAMPLES) % HIST_LOOP;
+    }
+    ASSERT_TRUE(ok);
+    ASSERT_TRUE(histMatchesSnapshot());
+}
+
+TEST(OverdubHistory_ResetForgetsPass) {
+    static TestHistory history;
+    histFill();
+    history.begin(s_histLoopL, s_histLoopR, s_histPoolL, s_histPoolR);
+
+    ASSERT_TRUE(history.beginPass());
+    histOverdub(history, 0, 256, OverdubMix::FEEDBACK_UNITY);
+    ASSERT_TRUE(history.requestSwap());
+    history.reset();  // New capture while the undo was pending
+    ASSERT_FALSE(history.busy());
+    ASSERT_FALSE(history.canUndo());
+    ASSERT_EQ(history.getPagesUsed(), 0U);
+}
+
+// ========== COST ==========
+
+// Copy-on-write worst case: the run straddles two chunks, both unsaved
+BENCHMARK(OverdubHistory_PreserveBlock, 200) {
+    static TestHistory history;
+    static size_t pos = 0;
+    if (pos == 0) {
+        history.begin(s_histLoopL, s_histLoopR, s_histPoolL, s_histPoolR);
+        history.beginPass();
+    }
+    history.preserve(pos + 64, AUDIO_BLOCK_SAMPLES);
+    pos += 2 * AUDIO_BLOCK_SAMPLES;
+    if (pos + 3 * AUDIO_BLOCK_SAMPLES > HIST_LOOP) {
+        pos = 0;
+    }
+}
+
+// One ISR's share of an undo: SWAP_CHUNKS_PER_BLOCK chunk swaps
+BENCHMARK(OverdubHistory_SwapBlock, 200) {
+    static TestHistory history;
+    if (!history.busy()) {
+        history.begin(s_histLoopL, s_histLoopR, s_histPoolL, s_histPoolR);
+        history.beginPass();
+        history.preserve(0, HIST_LOOP);
+        history.requestSwap();
+    }
+    history.process(0, HIST_LOOP);
+}
@@ -0,0 +1,373 @@
+/**
+ * test_perf_journal.cpp - Unit tests for PerformanceJournal and AudioEventQueue
+ *
+ * PURPOSE:
+ * The journal stores commands as (bar, phase) against the bar it was started
+ * in and replays them on a later bar line through the controller handler.
+ * These tests drive TimeKeeper by hand (MIDI ticks on time), record what the
+ * handler is given and when, and cover AudioEventQueue (called the way
+ * AudioTimeKeeper::update() does) with a stand-in effect registered as CHOKE.
+ */
+
+#include <Audio.h>
+#include "test_runner.h"
+#include "audio_effect_base.h"
+#include "audio_event_queue.h"
+#include "effect_manager.h"
+#include "performance_journal.h"
+#include "timekeeper.h"
+
+// ========== FIXTURE ==========
+
+/**
+ * Records enable/disable calls with the block they happened in
+ */
+class JournalProbeEffect : public AudioEffectBase {
+public:
+    JournalProbeEffect() : AudioEffectBase(0) {}
+
+    void enable() override { m_enabled = true; lastChangeAt = TimeKeeper::getSamplePosition(); changes++; }
+    void disable() override { m_enabled = false; lastChangeAt = TimeKeeper::getSamplePosition(); changes++; }
+    void toggle() override { m_enabled ? disable() : enable(); }
+    bool isEnabled() const override { return m_enabled; }
+    const char* getName() const override { return "Probe"; }
+    void update() override {}
+
+    uint64_t lastChangeAt = 0;
+    uint32_t changes = 0;
+
+private:
+    bool m_enabled = false;
+};
+
+static JournalProbeEffect s_journalProbe;
+
+// ~120 BPM with a whole number of samples per MIDI tick (919), so the tick
+// grid the bar lines come from and the sample positions below coincide
+static const uint32_t JOURNAL_SPB = 22056;
+static const uint32_t JOURNAL_SPBAR = JOURNAL_SPB * TimeKeeper::BEATS_PER_BAR;
+static const uint32_t JOURNAL_SPT = JOURNAL_SPB / TimeKeeper::MIDI_PPQN;
+
+static uint64_t s_journalNextTick = JOURNAL_SPT;
+
+// Commands taken by the recording handler, and the position they were taken at
+static Command s_journalTaken[16];
+static uint64_t s_journalTakenAt[16];
+static uint32_t s_journalTakenCount = 0;
+
+/**
+ * Controller handler that takes every command it is offered
+ */
+static bool journalTake(const Command& cmd) {
+    if (s_journalTakenCount >= 16) {
+        return false;
+    }
+    s_journalTakenAt[s_journalTakenCount] = TimeKeeper::getSamplePosition();
+    s_journalTaken[s_journalTakenCount++] = cmd;
+    return true;
+}
+
+/**
+ * Transport running at 120 BPM from sample 0, queue and probe cleared
+ */
+static void journalBegin() {
+    static bool registered = EffectManager::registerEffect(EffectID::CHOKE, &s_journalProbe);
+    (void)registered;
+
+    PerformanceJournal::onTransportChange();
+    PerformanceJournal::clear();
+    PerformanceJournal::setControllerHandler(nullptr);
+    s_journalTakenCount = 0;
+    AudioEventQueue::flush();
+    AudioEventQueue::dispatch(0);  // Drain
+
+    TimeKeeper::reset();
+    TimeKeeper::setSamplesPerBeat(JOURNAL_SPB);
+    TimeKeeper::setTransportState(TimeKeeper::TransportState::PLAYING);
+    s_journalNextTick = JOURNAL_SPT;
+
+    s_journalProbe.disable();
+    s_journalProbe.changes = 0;
+}
+
+/**
+ * Advance the sample position with MIDI ticks arriving on time
+ */
+static void journalAdvance(uint64_t samples) {
+    const uint64_t until = TimeKeeper::getSamplePosition() + samples;
+    while (s_journalNextTick <= until) {
+        TimeKeeper::incrementSamples(static_cast<uint32_t>(s_journalNextTick - TimeKeeper::getSamplePosition()));
+        TimeKeeper::incrementTick();
+        s_journalNextTick += JOURNAL_SPT;
+    }
+    TimeKeeper::incrementSamples(static_cast<uint32_t>(until - TimeKeeper::getSamplePosition()));
+}
+
+/**
+ * Advance one audio block the way AudioTimeKeeper::update() does
+ */
+static void journalBlock() {
+    journalAdvance(AUDIO_BLOCK_SAMPLES);
+    AudioEventQueue::dispatch(TimeKeeper::getSamplePosition());
+}
+
+/**
+ * Run blocks (with the app thread's journal update in between) until `until`
+ */
+static void journalRunTo(uint64_t until) {
+    while (TimeKeeper::getSamplePosition() + AUDIO_BLOCK_SAMPLES <= until) {
+        PerformanceJournal::update();
+        journalBlock();
+    }
+}
+
+// ========== AUDIO EVENT QUEUE ==========
+
+TEST(Journal_EventQueue_FiresInTargetBlock) {
+    journalBegin();
+    journalAdvance(10 * AUDIO_BLOCK_SAMPLES);
+
+    uint64_t target = TimeKeeper::getSamplePosition() + 3 * AUDIO_BLOCK_SAMPLES + 17;
+    ASSERT_TRUE(AudioEventQueue::post(Command{CommandType::EFFECT_ENABLE, EffectID::CHOKE}.at(target)));
+
+    journalBlock();
+    journalBlock();
+    ASSERT_FALSE(s_journalProbe.isEnabled());
+
+    journalBlock();  // Block [target - 17, target - 17 + 128)
+    ASSERT_TRUE(s_journalProbe.isEnabled());
+    ASSERT_TRUE(s_journalProbe.lastChangeAt <= target);
+    ASSERT_TRUE(target < s_journalProbe.lastChangeAt + AUDIO_BLOCK_SAMPLES);
+    ASSERT_EQ(AudioEventQueue::pending(), 0U);
+}
+
+TEST(Journal_EventQueue_LateCommandFiresNextBlock) {
+    journalBegin();
+    journalAdvance(10 * AUDIO_BLOCK_SAMPLES);
+
+    uint32_t late = AudioEventQueue::getLateCount();
+    AudioEventQueue::post(Command{CommandType::EFFECT_TOGGLE, EffectID::CHOKE}.at(5));
+    journalBlock();
+    ASSERT_TRUE(s_journalProbe.isEnabled());
+    ASSERT_EQ(AudioEventQueue::getLateCount(), late + 1);
+}
+
+TEST(Journal_EventQueue_RejectsUnsupported) {
+    journalBegin();
+
+    uint32_t rejected = AudioEventQueue::getRejectedCount();
+    AudioEventQueue::post(Command{CommandType::EFFECT_ENABLE, EffectID::STUTTER}.at(1));  // Not registered
+    Command param{CommandType::EFFECT_SET_PARAM, EffectID::CHOKE};
+    AudioEventQueue::post(param.at(2));
+    ASSERT_FALSE(AudioEventQueue::post(Command{CommandType::EFFECT_ENABLE, EffectID::CHOKE}));  // No target
+    journalBlock();
+
+    ASSERT_EQ(s_journalProbe.changes, 0U);
+    ASSERT_EQ(AudioEventQueue::getRejectedCount(), rejected + 3);
+}
+
+TEST(Journal_EventQueue_FlushDropsPending) {
+    journalBegin();
+
+    AudioEventQueue::post(Command{CommandType::EFFECT_ENABLE, EffectID::CHOKE}.at(AUDIO_BLOCK_SAMPLES));
+    AudioEventQueue::flush();
+    journalBlock();
+    ASSERT_FALSE(s_journalProbe.isEnabled());
+    ASSERT_EQ(AudioEventQueue::pending(), 0U);
+}
+
+// ========== RECORDING ==========
+
+TEST(Journal_Record_RequiresRunningTransport) {
+    journalBegin();
+    TimeKeeper::setTransportState(TimeKeeper::TransportState::STOPPED);
+    ASSERT_FALSE(PerformanceJournal::startRecording());
+    ASSERT_FALSE(PerformanceJournal::isRecording());
+}
+
+TEST(Journal_Record_BarAndPhaseFromStamp) {
+    journalBegin();
+    journalAdvance(3 * JOURNAL_SPBAR + 1000);  // Inside bar 3
+    ASSERT_TRUE(PerformanceJournal::startRecording());
+
+    // Stamped on beat 2 of the next bar, handled a block later
+    uint64_t stamp = 4 * JOURNAL_SPBAR + 2 * JOURNAL_SPB;
+    journalAdvance(static_cast<uint32_t>(stamp - TimeKeeper::getSamplePosition()) + AUDIO_BLOCK_SAMPLES);
+    PerformanceJournal::record(Command{CommandType::EFFECT_ENABLE, EffectID::CHOKE}.at(stamp));
+
+    // Stamped before the anchor bar: clamped to its downbeat
+    PerformanceJournal::record(Command{CommandType::EFFECT_DISABLE, EffectID::CHOKE}.at(100));
+
+    ASSERT_EQ(PerformanceJournal::getEntryCount(), 2U);
+    const JournalEntry* e = PerformanceJournal::getEntry(0);
+    ASSERT_EQ(e->bar, 1U);
+    ASSERT_EQ(e->barPhase, 1U << (PerformanceJournal::PHASE_BITS - 1));  // Half a bar
+    ASSERT_EQ(e->cmd.sampleTime, stamp);
+    ASSERT_EQ(PerformanceJournal::getEntry(1)->bar, 0U);
+    ASSERT_EQ(PerformanceJournal::getEntry(1)->barPhase, 0U);
+}
+
+TEST(Journal_Record_LengthRoundsToWholeBars) {
+    journalBegin();
+    ASSERT_TRUE(PerformanceJournal::startRecording());
+    PerformanceJournal::record(Command{CommandType::EFFECT_ENABLE, EffectID::CHOKE}.at(JOURNAL_SPBAR / 4));
+
+    journalAdvance(2 * JOURNAL_SPBAR - 500);  // Stopped just before bar 2
+    PerformanceJournal::stopRecording();
+    ASSERT_EQ(PerformanceJournal::getLengthBars(), 2U);
+
+    // Not recording: ignored
+    PerformanceJournal::record(Command{CommandType::EFFECT_DISABLE, EffectID::CHOKE});
+    ASSERT_EQ(PerformanceJournal::getEntryCount(), 1U);
+}
+
+// ========== REPLAY ==========
+
+TEST(Journal_Replay_SameBarPositionsOnLaterBar) {
+    journalBegin();
+    ASSERT_TRUE(PerformanceJournal::startRecording());
+    uint64_t onAt = JOURNAL_SPB + 300;            // Bar 0, beat 1
+    uint64_t offAt = JOURNAL_SPBAR + 3 * JOURNAL_SPB;  // Bar 1, beat 3
+    Command param{CommandType::EFFECT_SET_PARAM, EffectID::CHOKE};
+    PerformanceJournal::record(Command{CommandType::EFFECT_ENABLE, EffectID::CHOKE}.at(onAt));
+    PerformanceJournal::record(param.at(onAt));  // Not replayed
+    PerformanceJournal::record(Command{CommandType::EFFECT_DISABLE, EffectID::CHOKE}.at(offAt));
+    journalAdvance(2 * JOURNAL_SPBAR);
+    PerformanceJournal::stopRecording();
+    ASSERT_EQ(PerformanceJournal::getLengthBars(), 2U);
+
+    // Start mid-bar 2: replay begins on bar 3
+    PerformanceJournal::setControllerHandler(journalTake);
+    journalAdvance(JOURNAL_SPBAR / 3);
+    ASSERT_TRUE(PerformanceJournal::startReplay(false));
+    uint64_t base = 3 * JOURNAL_SPBAR;
+
+    // Handed over ahead of the target, stamped with it (Q24 phase rounds down)
+    journalRunTo(base + onAt);
+    ASSERT_EQ(s_journalTakenCount, 1U);
+    ASSERT_TRUE(s_journalTaken[0].type == CommandType::EFFECT_ENABLE);
+    ASSERT_TRUE(s_journalTaken[0].targetEffect == EffectID::CHOKE);
+    ASSERT_TRUE(base + onAt - s_journalTaken[0].sampleTime <= 1);
+    ASSERT_TRUE(s_journalTakenAt[0] < s_journalTaken[0].sampleTime);
+
+    journalRunTo(base + offAt);
+    ASSERT_EQ(s_journalTakenCount, 2U);
+    ASSERT_TRUE(s_journalTaken[1].type == CommandType::EFFECT_DISABLE);
+    ASSERT_TRUE(base + offAt - s_journalTaken[1].sampleTime <= 1);
+
+    journalRunTo(base + 2 * JOURNAL_SPBAR + AUDIO_BLOCK_SAMPLES);
+    ASSERT_FALSE(PerformanceJournal::isReplaying());
+}
+
+TEST(Journal_Replay_LoopRepeatsEveryTake) {
+    journalBegin();
+    ASSERT_TRUE(PerformanceJournal::startRecording());
+    PerformanceJournal::record(Command{CommandType::EFFECT_TOGGLE, EffectID::FREEZE}.at(JOURNAL_SPB));
+    journalAdvance(JOURNAL_SPBAR);
+    PerformanceJournal::stopRecording();
+    ASSERT_EQ(PerformanceJournal::getLengthBars(), 1U);
+
+    PerformanceJournal::setControllerHandler(journalTake);
+    ASSERT_TRUE(PerformanceJournal::startReplay(true));  // On the bar line: bar 1 itself
+    journalRunTo(5 * JOURNAL_SPBAR + JOURNAL_SPB + AUDIO_BLOCK_SAMPLES);
+    ASSERT_EQ(s_journalTakenCount, 5U);  // Bars 1..5
+    for (uint32_t i = 0; i < s_journalTakenCount; i++) {
+        ASSERT_TRUE((i + 1) * JOURNAL_SPBAR + JOURNAL_SPB - s_journalTaken[i].sampleTime <= 1);
+    }
+    ASSERT_TRUE(PerformanceJournal::isReplaying());
+
+    PerformanceJournal::stopReplay();
+    journalRunTo(7 * JOURNAL_SPBAR);
+    ASSERT_EQ(s_journalTakenCount, 5U);
+}
+
+TEST(Journal_Replay_ControllerCommandsToHandler) {
+    journalBegin();
+    ASSERT_TRUE(PerformanceJournal::startRecording());
+    uint64_t pressAt = JOURNAL_SPB + 300;
+    uint64_t releaseAt = 2 * JOURNAL_SPB;
+    PerformanceJournal::record(Command{CommandType::EFFECT_ENABLE, EffectID::STUTTER}.at(pressAt));
+    PerformanceJournal::record(Command{CommandType::EFFECT_ENABLE, EffectID::CHOKE}.at(pressAt + 10));
+    PerformanceJournal::record(Command{CommandType::EFFECT_DISABLE, EffectID::STUTTER}.at(releaseAt));
+    journalAdvance(JOURNAL_SPBAR);
+    PerformanceJournal::stopRecording();
+
+    // Takes commands ahead of time, but turns down the first offer
+    static Command taken[4];
+    static uint32_t count;
+    static uint32_t offers;
+    count = 0;
+    offers = 0;
+    PerformanceJournal::setControllerHandler([](const Command& cmd) {
+        if (offers++ == 0 || count >= 4) {
+            return false;
+        }
+        taken[count++] = cmd;
+        return true;
+    });
+
+    ASSERT_TRUE(PerformanceJournal::startReplay(false));  // Bar 1
+    uint64_t base = JOURNAL_SPBAR;
+    journalRunTo(base + pressAt - AUDIO_BLOCK_SAMPLES);
+    ASSERT_EQ(count, 2U);  // Second offer and the choke press, still ahead of their targets
+    ASSERT_TRUE(base + pressAt - taken[0].sampleTime <= 1);  // Q24 phase rounds down
+
+    // CHOKE goes to the controllers too (quantize modes apply on replay)
+    ASSERT_TRUE(taken[1].targetEffect == EffectID::CHOKE);
+
+    journalRunTo(base + JOURNAL_SPBAR);
+    ASSERT_EQ(count, 3U);
+    ASSERT_TRUE(taken[2].type == CommandType::EFFECT_DISABLE);
+    ASSERT_EQ(taken[2].sampleTime, base + releaseAt);
+    ASSERT_FALSE(s_journalProbe.isEnabled());  // Nothing through the ISR queue
+    PerformanceJournal::setControllerHandler(nullptr);
+}
+
+TEST(Journal_Replay_NothingReplayable) {
+    journalBegin();
+    ASSERT_TRUE(PerformanceJournal::startRecording());
+    PerformanceJournal::record(Command{CommandType::EFFECT_ENABLE, EffectID::STUTTER});
+    PerformanceJournal::stopRecording();
+    ASSERT_FALSE(PerformanceJournal::startReplay(false));  // No handler
+
+    Command param{CommandType::EFFECT_SET_PARAM, EffectID::CHOKE};
+    PerformanceJournal::setControllerHandler(journalTake);
+    ASSERT_TRUE(PerformanceJournal::startRecording());
+    PerformanceJournal::record(param.at(TimeKeeper::getSamplePosition()));
+    PerformanceJournal::stopRecording();
+    ASSERT_FALSE(PerformanceJournal::startReplay(false));
+}
+
+// ========== SAVE / LOAD ==========
+
+TEST(Journal_Serialize_RoundTrip) {
+    journalBegin();
+    ASSERT_TRUE(PerformanceJournal::startRecording());
+    for (uint32_t i = 0; i < 5; i++) {
+        CommandType type = (i & 1) ? CommandType::EFFECT_DISABLE : CommandType::EFFECT_ENABLE;
+        PerformanceJournal::record(Command{type, EffectID::FREEZE}.at(i * 7001));
+    }
+    journalAdvance(3 * JOURNAL_SPBAR);
+    PerformanceJournal::stopRecording();
+
+    static uint8_t buffer[256];
+    size_t size = PerformanceJournal::serialize(buffer, sizeof(buffer));
+    ASSERT_EQ(size, PerformanceJournal::serializedSize());
+    ASSERT_EQ(PerformanceJournal::serialize(buffer, size - 1), 0U);
+
+    JournalEntry third = *PerformanceJournal::getEntry(3);
+    PerformanceJournal::clear();
+    ASSERT_TRUE(PerformanceJournal::deserialize(buffer, size));
+    ASSERT_EQ(PerformanceJournal::getEntryCount(), 5U);
+    ASSERT_EQ(PerformanceJournal::getLengthBars(), 3U);
+    ASSERT_EQ(PerformanceJournal::getEntry(3)->bar, third.bar);
+    ASSERT_EQ(PerformanceJournal::getEntry(3)->barPhase, third.barPhase);
+    ASSERT_TRUE(PerformanceJournal::getEntry(3)->cmd.type == CommandType::EFFECT_DISABLE);
+
+    // Corrupt magic / truncated: rejected, journal kept
+    buffer[0] ^= 0xFF;
+    ASSERT_FALSE(PerformanceJournal::deserialize(buffer, size));
+    buffer[0] ^= 0xFF;
+    ASSERT_FALSE(PerformanceJournal::deserialize(buffer, size - 1));
+    ASSERT_EQ(PerformanceJournal::getEntryCount(), 5U);
+}
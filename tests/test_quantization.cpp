@@ -0,0 +1,310 @@
+/**
+ * test_quantization.cpp - Property tests for the TimeKeeper quantization math
+ *
+ * PURPOSE:
+ * The hand-picked cases in test_timekeeper.cpp cover 120 BPM at a few
+ * positions. These tests sweep tempo, MIDI tick phase and sample position
+ * and check properties that must hold everywhere:
+ *
+ *   - On grid:    now + result lands exactly on a beat/bar/subdivision boundary
+ *   - In range:   result is never more than one beat/bar/subdivision away
+ *   - Monotonic:  the absolute target never moves backwards as time advances
+ *   - One grid:   beat, bar and subdivision all follow the MIDI tick position
+ *
+ * Positions come from a fixed-seed xorshift, so a failure reproduces exactly.
+ * The benchmarks at the end report the cost of each query.
+ */
+
+#include <AudioStream.h>
+#include "test_runner.h"
+#include "timekeeper.h"
+
+// ========== HELPERS ==========
+
+// Tempo sweep: every 7 BPM from 60 to 200, plus the syncToMIDIClock() limits
+static const uint32_t QUANT_TEMPO_SPB[] = {
+    TimeKeeper::SAMPLE_RATE * 2,  // 30 BPM (slowest accepted)
+    TimeKeeper::SAMPLE_RATE / 5,  // 300 BPM (fastest accepted)
+    TimeKeeper::SAMPLE_RATE / 2,      // 120 BPM (exact)
+    TimeKeeper::SAMPLE_RATE / 2 + 1,  // 120 BPM with a rounding error (spb not a multiple of 24)
+};
+
+static uint32_t quantSpbForBpm(uint32_t bpm) {
+    return (TimeKeeper::SAMPLE_RATE * 60) / bpm;
+}
+
+static uint32_t s_quantRng = 0x2545F491;
+
+static uint32_t quantRandom() {
+    // xorshift32
+    s_quantRng ^= s_quantRng << 13;
+    s_quantRng ^= s_quantRng >> 17;
+    s_quantRng ^= s_quantRng << 5;
+    return s_quantRng;
+}
+
+// Calls fn(spb) for every tempo in the sweep
+template<typename Fn>
+static void forEachTempo(Fn fn) {
+    for (uint32_t bpm = 60; bpm <= 200; bpm += 7) {
+        fn(quantSpbForBpm(bpm));
+    }
+    for (uint32_t spb : QUANT_TEMPO_SPB) {
+        fn(spb);
+    }
+}
+
+/**
+ * Place the transport at a tick phase the way the MIDI thread would:
+ * beat number `beat` starts at beatStart, ticks arrive every spb/24
+ * samples, then offsetInTick more samples pass before the query.
+ */
+static void quantPlaceAtTick(uint32_t spb, uint64_t beatStart, uint32_t tick, uint32_t offsetInTick,
+                             uint32_t beat = 1) {
+    uint32_t samplesPerTick = spb / TimeKeeper::MIDI_PPQN;
+
+    TimeKeeper::reset();
+    TimeKeeper::setSamplesPerBeat(spb);
+    TimeKeeper::incrementSamples(static_cast<uint32_t>(beatStart % 0x80000000ULL));
+    while (TimeKeeper::getSamplePosition() < beatStart) {
+        TimeKeeper::incrementSamples(0x80000000U);
+    }
+
+    // Tick 0 of the beat lands at beatStart
+    for (uint32_t i = 0; i < beat * TimeKeeper::MIDI_PPQN; i++) {
+        TimeKeeper::incrementTick();
+    }
+    for (uint32_t i = 0; i < tick; i++) {
+        TimeKeeper::incrementSamples(samplesPerTick);
+        TimeKeeper::incrementTick();
+    }
+    TimeKeeper::incrementSamples(offsetInTick);
+}
+
+// ========== BEAT / BAR ==========
+
+TEST(Quantization_NextBeat_OnGrid) {
+    bool ok = true;
+    forEachTempo([&](uint32_t spb) {
+        uint32_t samplesPerTick = spb / TimeKeeper::MIDI_PPQN;
+        for (int i = 0; i < 64 && ok; i++) {
+            // Random beat start, half of them past the 32-bit sample limit
+            uint64_t beatStart = quantRandom();
+            if (i & 1) beatStart += (uint64_t)quantRandom() << 20;
+            uint32_t tick = quantRandom() % TimeKeeper::MIDI_PPQN;
+            uint32_t offset = quantRandom() % samplesPerTick;
+
+            quantPlaceAtTick(spb, beatStart, tick, offset);
+            uint32_t elapsed = tick * samplesPerTick + offset;
+            uint32_t toNext = TimeKeeper::samplesToNextBeat();
+
+            ok = ok && (toNext > 0) && (toNext <= spb);
+            ok = ok && (elapsed + toNext == spb);
+        }
+    });
+    ASSERT_TRUE(ok);
+}
+
+TEST(Quantization_NextBeat_MatchesQuarterSubdivision) {
+    // Beat and 1/4 subdivision are the same grid at every tick phase,
+    // including a late tick (position held at the end of the tick)
+    bool ok = true;
+    forEachTempo([&](uint32_t spb) {
+        uint32_t samplesPerTick = spb / TimeKeeper::MIDI_PPQN;
+        const uint32_t offsets[] = { 0, 1, samplesPerTick / 2, samplesPerTick - 1, samplesPerTick + 400 };
+        uint64_t beatStart = quantRandom() % (64 * spb);
+
+        for (uint32_t tick = 0; tick < TimeKeeper::MIDI_PPQN && ok; tick++) {
+            for (uint32_t offset : offsets) {
+                quantPlaceAtTick(spb, beatStart, tick, offset);
+                ok = ok && (TimeKeeper::samplesToNextSubdivision(spb) == TimeKeeper::samplesToNextBeat());
+            }
+        }
+        if (!ok) {
+            Serial.print("  spb=");
+            Serial.println(spb);
+        }
+    });
+    ASSERT_TRUE(ok);
+}
+
+TEST(Quantization_NextBeat_CountsDownOnePerSample) {
+    uint32_t spb = quantSpbForBpm(137);
+    uint32_t samplesPerTick = spb / TimeKeeper::MIDI_PPQN;
+
+    quantPlaceAtTick(spb, 3 * spb, 0, 17);
+
+    uint32_t previous = TimeKeeper::samplesToNextBeat();
+    ASSERT_EQ(previous, spb - 17);
+
+    // Ticks on time: one sample less per sample, through the last tick's slot
+    uint32_t elapsed = 17;
+    while (elapsed < TimeKeeper::MIDI_PPQN * samplesPerTick - 1) {
+        TimeKeeper::incrementSamples(1);
+        elapsed++;
+        if (elapsed % samplesPerTick == 0) {
+            TimeKeeper::incrementTick();
+        }
+        uint32_t toNext = TimeKeeper::samplesToNextBeat();
+        ASSERT_EQ(toNext, previous - 1);
+        previous = toNext;
+    }
+    ASSERT_EQ(previous, spb - (TimeKeeper::MIDI_PPQN * samplesPerTick - 1));
+
+    // Tick 0 of the next beat: a full beat to the one after
+    TimeKeeper::incrementSamples(1);
+    TimeKeeper::incrementTick();
+    ASSERT_EQ(TimeKeeper::samplesToNextBeat(), spb);
+}
+
+TEST(Quantization_NextBar_OnGrid) {
+    bool ok = true;
+    forEachTempo([&](uint32_t spb) {
+        uint32_t samplesPerTick = spb / TimeKeeper::MIDI_PPQN;
+        uint32_t samplesPerBar = spb * TimeKeeper::BEATS_PER_BAR;
+        for (int i = 0; i < 64 && ok; i++) {
+            uint32_t beat = 1 + quantRandom() % (4 * TimeKeeper::BEATS_PER_BAR);
+            uint32_t tick = quantRandom() % TimeKeeper::MIDI_PPQN;
+            uint32_t offset = quantRandom() % samplesPerTick;
+
+            quantPlaceAtTick(spb, quantRandom() % (64 * spb), tick, offset, beat);
+            uint32_t withinBar = (beat % TimeKeeper::BEATS_PER_BAR) * spb + tick * samplesPerTick + offset;
+            uint32_t toNext = TimeKeeper::samplesToNextBar();
+
+            ok = ok && (toNext > 0) && (toNext <= samplesPerBar);
+            ok = ok && (withinBar + toNext == samplesPerBar);
+            // Bar lines are beat lines
+            ok = ok && (toNext % spb == TimeKeeper::samplesToNextBeat() % spb);
+        }
+    });
+    ASSERT_TRUE(ok);
+}
+
+// ========== SUBDIVISION ==========
+
+TEST(Quantization_NextSubdivision_OnGridAcrossTickPhase) {
+    bool ok = true;
+    forEachTempo([&](uint32_t spb) {
+        uint32_t samplesPerTick = spb / TimeKeeper::MIDI_PPQN;
+        const uint32_t subdivisions[] = { spb / 8, spb / 4, spb / 2, spb };
+        const uint32_t offsets[] = { 0, 1, samplesPerTick / 2, samplesPerTick - 1 };
+        uint64_t beatStart = quantRandom() % (64 * spb);
+
+        for (uint32_t sub : subdivisions) {
+            for (uint32_t tick = 0; tick < TimeKeeper::MIDI_PPQN; tick++) {
+                for (uint32_t offset : offsets) {
+                    quantPlaceAtTick(spb, beatStart, tick, offset);
+
+                    uint32_t elapsed = tick * samplesPerTick + offset;
+                    uint32_t toNext = TimeKeeper::samplesToNextSubdivision(sub);
+                    uint32_t boundary = elapsed + toNext;
+
+                    // Never "now", never more than one subdivision away
+                    ok = ok && (toNext > 0) && (toNext <= sub);
+                    // Lands on the subdivision grid (or the next beat)
+                    ok = ok && (boundary % sub == 0 || boundary == spb);
+                    ok = ok && (boundary <= spb);
+                }
+            }
+            if (!ok) {
+                Serial.print("  spb=");
+                Serial.print(spb);
+                Serial.print(" sub=");
+                Serial.println(sub);
+                return;
+            }
+        }
+    });
+    ASSERT_TRUE(ok);
+}
+
+TEST(Quantization_NextSubdivision_TargetIsMonotonic) {
+    // Walk one beat in audio blocks with ticks arriving on time: the absolute
+    // target (now + result) may only move forward
+    bool ok = true;
+    forEachTempo([&](uint32_t spb) {
+        uint32_t samplesPerTick = spb / TimeKeeper::MIDI_PPQN;
+        uint32_t sub = spb / 4;
+
+        quantPlaceAtTick(spb, 4 * spb, 0, 0);
+        uint64_t beatEnd = TimeKeeper::getSamplePosition() + spb;
+        uint64_t nextTickAt = TimeKeeper::getSamplePosition() + samplesPerTick;
+        uint32_t ticks = 1;
+        uint64_t lastTarget = 0;
+
+        while (TimeKeeper::getSamplePosition() < beatEnd - 1 && ok) {
+            // Split the block at the tick so the tick lands on its exact sample
+            uint64_t now = TimeKeeper::getSamplePosition();
+            uint64_t stop = now + AUDIO_BLOCK_SAMPLES;
+            if (ticks < TimeKeeper::MIDI_PPQN && nextTickAt < stop) stop = nextTickAt;
+            if (stop > beatEnd - 1) stop = beatEnd - 1;
+            TimeKeeper::incrementSamples(static_cast<uint32_t>(stop - now));
+
+            if (ticks < TimeKeeper::MIDI_PPQN && TimeKeeper::getSamplePosition() == nextTickAt) {
+                TimeKeeper::incrementTick();
+                ticks++;
+                nextTickAt += samplesPerTick;
+            }
+
+            uint64_t target = TimeKeeper::getSamplePosition() + TimeKeeper::samplesToNextSubdivision(sub);
+            ok = ok && (target >= lastTarget);
+            lastTarget = target;
+        }
+    });
+    ASSERT_TRUE(ok);
+}
+
+TEST(Quantization_NextSubdivision_LateTickHoldsAtTickEnd) {
+    // MIDI tick overdue (jitter): position is held at the end of the
+    // current tick instead of running into the next tick's slot
+    uint32_t spb = 22050;
+    uint32_t samplesPerTick = spb / TimeKeeper::MIDI_PPQN;  // 918
+
+    quantPlaceAtTick(spb, 0, 5, samplesPerTick + 400);
+
+    uint32_t sub = spb / 4;  // 5512
+    uint32_t held = 5 * samplesPerTick + (samplesPerTick - 1);
+    ASSERT_EQ(TimeKeeper::samplesToNextSubdivision(sub), sub - held);
+    ASSERT_EQ(TimeKeeper::samplesToNextSubdivision(spb), spb - held);
+}
+
+TEST(Quantization_NextSubdivision_TracksSamplesWithinTick) {
+    // Regression: the result used to ignore samples since the last tick,
+    // returning the same count for every query inside a tick
+    uint32_t spb = 22050;
+
+    quantPlaceAtTick(spb, 0, 12, 0);
+    uint32_t atTick = TimeKeeper::samplesToNextSubdivision(spb);
+
+    TimeKeeper::incrementSamples(300);
+    ASSERT_EQ(TimeKeeper::samplesToNextSubdivision(spb), atTick - 300);
+}
+
+// ========== QUERY COST ==========
+
+// Queries run on the app thread before every scheduled transition. Each
+// benchmark places the transport mid-tick on first call (127 BPM: spb is
+// not a multiple of 24, position past 2^32)
+
+static void quantPlaceForBenchmark() {
+    uint32_t spb = quantSpbForBpm(127);
+    quantPlaceAtTick(spb, 200000ULL * spb, 7, 100);
+}
+
+BENCHMARK(Quantization_SamplesToNextBeat, 1000) {
+    static bool placed = (quantPlaceForBenchmark(), true);
+    (void)placed;
+    benchmarkSink(TimeKeeper::samplesToNextBeat());
+}
+
+BENCHMARK(Quantization_SamplesToNextBar, 1000) {
+    static bool placed = (quantPlaceForBenchmark(), true);
+    (void)placed;
+    benchmarkSink(TimeKeeper::samplesToNextBar());
+}
+
+BENCHMARK(Quantization_SamplesToNextSubdivision, 1000) {
+    static bool placed = (quantPlaceForBenchmark(), true);
+    (void)placed;
+    benchmarkSink(TimeKeeper::samplesToNextSubdivision(TimeKeeper::getSamplesPerBeat() / 4));
+}
@@ -0,0 +1,155 @@
+/**
+ * test_remote.cpp - Unit tests for the remote protocol's framing and messages
+ *
+ * Covers the link layer both ends share (utils/cobs.h: CRC-16, COBS,
+ * FrameDecoder) and the telemetry layout (remote_messages.h). The
+ * request/reply handling itself runs end to end in the host build
+ * (microloop_remote selftest against the simulator).
+ */
+
+#include "test_runner.h"
+#include "cobs.h"
+#include "remote_messages.h"
+
+// Feed a whole wire buffer; returns the last non-NONE result
+static FrameDecoder<RemoteMsg::MAX_PACKET>::Result feedAll(FrameDecoder<RemoteMsg::MAX_PACKET>& rx,
+                                                           const uint8_t* wire, size_t length) {
+    FrameDecoder<RemoteMsg::MAX_PACKET>::Result last = FrameDecoder<RemoteMsg::MAX_PACKET>::NONE;
+    for (size_t i = 0; i < length; i++) {
+        FrameDecoder<RemoteMsg::MAX_PACKET>::Result r = rx.feed(wire[i]);
+        if (r != FrameDecoder<RemoteMsg::MAX_PACKET>::NONE) {
+            last = r;
+        }
+    }
+    return last;
+}
+
+// ========== CRC / COBS ==========
+
+TEST(Remote_Crc16KnownValue) {
+    const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    ASSERT_EQ(Crc16::ccitt(check, sizeof(check)), 0x29B1);
+}
+
+TEST(Remote_CobsRoundTripHasNoZeros) {
+    // Zeros at both ends and a run longer than one COBS block (254)
+    uint8_t packet[RemoteMsg::MAX_PACKET];
+    for (size_t i = 0; i < sizeof(packet); i++) {
+        packet[i] = (i < 2 || i == sizeof(packet) - 1) ? 0 : static_cast<uint8_t>(1 + i % 200);
+    }
+    uint8_t wire[Cobs::maxFrameSize(RemoteMsg::MAX_PACKET)];
+    const size_t n = Cobs::encodeFrame(packet, sizeof(packet), wire);
+    ASSERT_TRUE(n <= sizeof(wire));
+    for (size_t i = 0; i + 1 < n; i++) {
+        ASSERT_NE(wire[i], 0);
+    }
+    ASSERT_EQ(wire[n - 1], Cobs::DELIMITER);
+
+    FrameDecoder<RemoteMsg::MAX_PACKET> rx;
+    ASSERT_EQ(feedAll(rx, wire, n), FrameDecoder<RemoteMsg::MAX_PACKET>::FRAME);
+    ASSERT_EQ(rx.packetLength(), sizeof(packet));
+    ASSERT_EQ(memcmp(rx.packet(), packet, sizeof(packet)), 0);
+}
+
+// ========== FRAME DECODER ==========
+
+TEST(Remote_DecoderResyncsAfterText) {
+    // Console text before the first frame ends at the first delimiter
+    const char text[] = "=== MicroLoop Running ===\r\n";
+    const uint8_t packet[] = { RemoteMsg::PING, 7, 0, 1, 2 };
+    uint8_t wire[64];
+    size_t n = 0;
+    memcpy(wire, text, sizeof(text) - 1);
+    n += sizeof(text) - 1;
+    wire[n++] = Cobs::DELIMITER;
+    n += Cobs::encodeFrame(packet, sizeof(packet), wire + n);
+
+    FrameDecoder<RemoteMsg::MAX_PACKET> rx;
+    size_t frames = 0;
+    size_t bad = 0;
+    for (size_t i = 0; i < n; i++) {
+        switch (rx.feed(wire[i])) {
+            case FrameDecoder<RemoteMsg::MAX_PACKET>::FRAME: frames++; break;
+            case FrameDecoder<RemoteMsg::MAX_PACKET>::BAD_FRAME: bad++; break;
+            default: break;
+        }
+    }
+    ASSERT_EQ(bad, 1);
+    ASSERT_EQ(frames, 1);
+    ASSERT_EQ(rx.packetLength(), sizeof(packet));
+    ASSERT_EQ(rx.packet()[1], 7);
+}
+
+TEST(Remote_DecoderRejectsCorruptAndOversized) {
+    const uint8_t packet[] = { RemoteMsg::GET_PARAM, 1, 16, 0 };
+    uint8_t wire[16];
+    const size_t n = Cobs::encodeFrame(packet, sizeof(packet), wire);
+    wire[2] ^= 0x02;  // One flipped bit (still no zero byte): CRC mismatch
+
+    FrameDecoder<RemoteMsg::MAX_PACKET> rx;
+    ASSERT_EQ(feedAll(rx, wire, n), FrameDecoder<RemoteMsg::MAX_PACKET>::BAD_FRAME);
+    ASSERT_EQ(rx.packetLength(), 0);
+
+    for (size_t i = 0; i < 400; i++) {
+        ASSERT_EQ(rx.feed(0x55), FrameDecoder<RemoteMsg::MAX_PACKET>::NONE);
+    }
+    ASSERT_EQ(rx.feed(Cobs::DELIMITER), FrameDecoder<RemoteMsg::MAX_PACKET>::OVERSIZED);
+
+    // Back-to-back delimiters (the session sync byte) are not frames
+    ASSERT_EQ(rx.feed(Cobs::DELIMITER), FrameDecoder<RemoteMsg::MAX_PACKET>::NONE);
+}
+
+// ========== MESSAGES ==========
+
+TEST(Remote_TelemetryPackRoundTrip) {
+    RemoteMsg::RemoteTelemetry in;
+    memset(&in, 0, sizeof(in));
+    in.uptimeMs = 123456789;
+    in.samplePosition = 0xFEDCBA98;
+    in.bpmX100 = 12000;
+    in.transport = 1;
+    in.cpuLoadMaxPermille = 812;
+    in.limiterGainQ15 = 30000;
+    in.eventQueueDepth = 5;
+    in.effectCount = 2;
+    in.overruns = 3;
+    in.logDropped = 70000;
+    in.effects[1].id = RemoteMsg::EFFECT_LIMITER;
+    in.effects[1].state = 1;
+    in.effects[1].enabled = 1;
+
+    uint8_t body[RemoteMsg::TELEMETRY_BYTES];
+    RemoteMsg::packTelemetry(in, body);
+    RemoteMsg::RemoteTelemetry out;
+    RemoteMsg::unpackTelemetry(body, out);
+
+    ASSERT_EQ(out.uptimeMs, 123456789u);
+    ASSERT_EQ(out.samplePosition, 0xFEDCBA98u);
+    ASSERT_EQ(out.bpmX100, 12000);
+    ASSERT_EQ(out.cpuLoadMaxPermille, 812);
+    ASSERT_EQ(out.limiterGainQ15, 30000);
+    ASSERT_EQ(out.eventQueueDepth, 5);
+    ASSERT_EQ(out.overruns, 3u);
+    ASSERT_EQ(out.logDropped, 70000u);
+    ASSERT_EQ(out.effects[1].id, RemoteMsg::EFFECT_LIMITER);
+    ASSERT_EQ(out.effects[1].enabled, 1);
+
+    // Parameter values travel as raw IEEE floats
+    uint8_t value[4];
+    RemoteMsg::putFloat(value, -0.375f);
+    ASSERT_EQ(RemoteMsg::getFloat(value), -0.375f);
+}
+
+// ========== COST ==========
+
+// Encode + decode one max-size packet (per-frame CPU cost on the device)
+BENCHMARK(Remote_FrameRoundTrip, 1000) {
+    static uint8_t packet[RemoteMsg::MAX_PACKET];
+    static uint8_t wire[Cobs::maxFrameSize(RemoteMsg::MAX_PACKET)];
+    static FrameDecoder<RemoteMsg::MAX_PACKET> rx;
+    packet[0]++;
+    const size_t n = Cobs::encodeFrame(packet, sizeof(packet), wire);
+    for (size_t i = 0; i < n; i++) {
+        rx.feed(wire[i]);
+    }
+}
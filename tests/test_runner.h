@@ -13,15 +13,47 @@
  *       ASSERT_TRUE(condition);
  *   }
  *
+ *   BENCHMARK(My_Operation, 1000) {      // Body is one operation
+ *       benchmarkSink(thingUnderTest());  // Keep results alive
+ *   }
+ *
  *   void setup() {
  *       Serial.begin(115200);
  *       RUN_ALL_TESTS();
  *   }
+ *
+ * HOST BACKEND:
+ *   The host build (host/CMakeLists.txt, MICROLOOP_HOST defined) compiles the
+ *   same suites against the Teensy stubs: tests/run_tests_host.cpp echoes
+ *   Serial to stdout and returns the failure count as the exit code.
+ *   Benchmarks time with the DWT cycle counter on the Teensy and with
+ *   CLOCK_MONOTONIC (plus the TSC on x86) on the host, where the stubbed
+ *   ARM_DWT_CYCCNT only follows simulated time.
+ *
+ * MACHINE-READABLE RESULTS:
+ *   Every benchmark also prints one JSON object per line (JSON Lines, same
+ *   convention as bench_memory_main.cpp), preceded by one build record:
+ *     {"bench":"build","target":"teensy41","compiler":"13.2.1","optimize":"O2",...}
+ *     {"bench":"micro","name":"SPSCQueue_PushPop","metric":"ns_per_op",
+ *      "median":...,"min":...,"mean":...,"max":...,"stddev":...,
+ *      "cycles_per_op":...,"samples":15,"iterations":10000}
+ *   Human-readable lines never start with '{', so a raw serial capture can
+ *   be fed to the host comparator as-is (host/tools/bench_compare.cpp).
+ *   TestRunner::setJsonOutput() redirects the records (default: Serial).
  */
 
 #pragma once
 
 #include <Arduino.h>
+#include <AudioStream.h>
+#include <math.h>
+
+#ifdef MICROLOOP_HOST
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
 
 // Test statistics
 static int g_testsPassed = 0;
@@ -46,6 +78,33 @@ static const char* g_currentTest = nullptr;
     } testRegistrar_##name; \
     static void test_##name()
 
+/**
+ * Begin a benchmark
+ *
+ * The body is ONE operation. The runner calls it `iterations` times per
+ * sample after a warmup sample, over BENCHMARK_SAMPLES samples, and
+ * reports ns/op and cycles/op (median, with min/mean/max). Per-op figures
+ * include one indirect call. Benchmarks run after all tests.
+ */
+#define BENCHMARK(name, iterations) \
+    static void bench_##name(); \
+    static struct BenchmarkRegistrar_##name { \
+        BenchmarkRegistrar_##name() { \
+            TestRunner::registerBenchmark(#name, bench_##name, iterations); \
+        } \
+    } benchmarkRegistrar_##name; \
+    static void bench_##name()
+
+/**
+ * Keep a benchmark result alive (stops the compiler deleting the operation)
+ */
+static volatile uint32_t g_benchmarkSink = 0;
+
+template<typename T>
+inline void benchmarkSink(T value) {
+    g_benchmarkSink = g_benchmarkSink + static_cast<uint32_t>(value);
+}
+
 /**
  * Helper functions to print values (handles enums by casting to int)
  */
@@ -176,6 +235,49 @@ printValue(T value) {
         } \
     } while(0)
 
+/**
+ * Benchmark clock
+ *
+ * Teensy: DWT cycle counter (ns derived from F_CPU_ACTUAL).
+ * Host:   CLOCK_MONOTONIC for ns, TSC for cycles (0 where unavailable).
+ */
+struct BenchmarkClock {
+    uint64_t ns;
+    uint64_t cycles;
+
+    static BenchmarkClock now() {
+        BenchmarkClock c;
+#ifdef MICROLOOP_HOST
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        c.ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#if defined(__x86_64__) || defined(__i386__)
+        c.cycles = __rdtsc();
+#else
+        c.cycles = 0;
+#endif
+#else
+        c.cycles = ARM_DWT_CYCCNT;  // 32-bit: wraps after ~7 s at 600 MHz
+        c.ns = 0;
+#endif
+        return c;
+    }
+
+    // Elapsed since `start` as {ns, cycles}
+    static BenchmarkClock since(const BenchmarkClock& start) {
+        BenchmarkClock end = now();
+        BenchmarkClock d;
+#ifdef MICROLOOP_HOST
+        d.ns = end.ns - start.ns;
+        d.cycles = end.cycles - start.cycles;
+#else
+        d.cycles = (uint32_t)((uint32_t)end.cycles - (uint32_t)start.cycles);
+        d.ns = d.cycles * 1000000000ULL / F_CPU_ACTUAL;
+#endif
+        return d;
+    }
+};
+
 /**
  * Test runner
  */
@@ -183,17 +285,45 @@ class TestRunner {
 public:
     using TestFunc = void (*)();
 
-    static constexpr int MAX_TESTS = 50;
+    static constexpr int MAX_TESTS = 128;
+    static constexpr int MAX_BENCHMARKS = 32;
+    static constexpr int BENCHMARK_SAMPLES = 15;
+
+    /**
+     * Where benchmark JSON records go (default Serial, nullptr = off)
+     */
+    static void setJsonOutput(Print* out) {
+        s_json = out;
+    }
 
     static void registerTest(const char* name, TestFunc func) {
         if (s_numTests < MAX_TESTS) {
             s_tests[s_numTests].name = name;
             s_tests[s_numTests].func = func;
             s_numTests++;
+        } else {
+            s_numDropped++;
+        }
+    }
+
+    static void registerBenchmark(const char* name, TestFunc func, uint32_t iterations) {
+        if (s_numBenchmarks < MAX_BENCHMARKS) {
+            s_benchmarks[s_numBenchmarks].name = name;
+            s_benchmarks[s_numBenchmarks].func = func;
+            s_benchmarks[s_numBenchmarks].iterations = iterations > 0 ? iterations : 1;
+            s_numBenchmarks++;
+        } else {
+            s_numDropped++;
         }
     }
 
-    static void runAll() {
+    /**
+     * Run tests, then benchmarks
+     *
+     * @param filter Only run entries whose name starts with this (nullptr = all)
+     * @return Number of failed tests (host exit code)
+     */
+    static int runAll(const char* filter = nullptr) {
         Serial.println();
         Serial.println("========================================");
         Serial.println("        MicroLoop Test Suite");
@@ -201,8 +331,12 @@ public:
         Serial.println();
 
         uint32_t startTime = millis();
+        int testsRun = 0;
 
         for (int i = 0; i < s_numTests; i++) {
+            if (!matches(s_tests[i].name, filter)) continue;
+            testsRun++;
+
             g_currentTest = s_tests[i].name;
             Serial.print("[ RUN      ] ");
             Serial.println(s_tests[i].name);
@@ -220,12 +354,22 @@ public:
             }
         }
 
+        bool buildRecorded = false;
+        for (int i = 0; i < s_numBenchmarks; i++) {
+            if (!matches(s_benchmarks[i].name, filter)) continue;
+            if (!buildRecorded) {
+                printBuildJson();
+                buildRecorded = true;
+            }
+            runBenchmark(s_benchmarks[i]);
+        }
+
         uint32_t duration = millis() - startTime;
 
         Serial.println();
         Serial.println("========================================");
         Serial.print("Tests run: ");
-        Serial.println(s_numTests);
+        Serial.println(testsRun);
         Serial.print(COLOR_GREEN "Passed: ");
         Serial.print(g_testsPassed);
         Serial.println(COLOR_RESET);
@@ -234,6 +378,13 @@ public:
             Serial.print(g_testsFailed);
             Serial.println(COLOR_RESET);
         }
+        if (s_numDropped > 0) {
+            // Registered past MAX_TESTS / MAX_BENCHMARKS: raise the limit
+            Serial.print(COLOR_RED "Not registered (table full): ");
+            Serial.print(s_numDropped);
+            Serial.println(COLOR_RESET);
+            g_testsFailed++;
+        }
         Serial.print("Duration: ");
         Serial.print(duration);
         Serial.println(" ms");
@@ -245,6 +396,7 @@ public:
         } else {
             Serial.println(COLOR_RED "✗ Some tests failed" COLOR_RESET);
         }
+        return g_testsFailed;
     }
 
 private:
@@ -253,13 +405,156 @@ private:
         TestFunc func;
     };
 
+    struct Benchmark {
+        const char* name;
+        TestFunc func;
+        uint32_t iterations;
+    };
+
+    static bool matches(const char* name, const char* filter) {
+        return filter == nullptr || strncmp(name, filter, strlen(filter)) == 0;
+    }
+
+    static void sortAscending(float* values, int count) {
+        // Insertion sort: BENCHMARK_SAMPLES is small
+        for (int i = 1; i < count; i++) {
+            float v = values[i];
+            int j = i - 1;
+            while (j >= 0 && values[j] > v) {
+                values[j + 1] = values[j];
+                j--;
+            }
+            values[j + 1] = v;
+        }
+    }
+
+    static void runBenchmark(const Benchmark& bench) {
+        float nsPerOp[BENCHMARK_SAMPLES];
+        float cyclesPerOp[BENCHMARK_SAMPLES];
+
+        Serial.print("[ BENCH    ] ");
+        Serial.println(bench.name);
+
+        // Warmup: caches, branch predictors, first-call initialization
+        for (uint32_t i = 0; i < bench.iterations; i++) {
+            bench.func();
+        }
+
+        for (int s = 0; s < BENCHMARK_SAMPLES; s++) {
+            BenchmarkClock start = BenchmarkClock::now();
+            for (uint32_t i = 0; i < bench.iterations; i++) {
+                bench.func();
+            }
+            BenchmarkClock elapsed = BenchmarkClock::since(start);
+            nsPerOp[s] = (float)elapsed.ns / (float)bench.iterations;
+            cyclesPerOp[s] = (float)elapsed.cycles / (float)bench.iterations;
+        }
+
+        float mean = 0.0f;
+        for (int s = 0; s < BENCHMARK_SAMPLES; s++) {
+            mean += nsPerOp[s];
+        }
+        mean /= BENCHMARK_SAMPLES;
+
+        float variance = 0.0f;
+        for (int s = 0; s < BENCHMARK_SAMPLES; s++) {
+            variance += (nsPerOp[s] - mean) * (nsPerOp[s] - mean);
+        }
+        const float stddev = sqrtf(variance / (BENCHMARK_SAMPLES - 1));
+
+        sortAscending(nsPerOp, BENCHMARK_SAMPLES);
+        sortAscending(cyclesPerOp, BENCHMARK_SAMPLES);
+
+        Serial.print("             ns/op ");
+        Serial.print(nsPerOp[BENCHMARK_SAMPLES / 2]);
+        Serial.print(" (min ");
+        Serial.print(nsPerOp[0]);
+        Serial.print(", mean ");
+        Serial.print(mean);
+        Serial.print(", max ");
+        Serial.print(nsPerOp[BENCHMARK_SAMPLES - 1]);
+        Serial.print(")  cycles/op ");
+        Serial.print(cyclesPerOp[BENCHMARK_SAMPLES / 2]);
+        Serial.print("  [");
+        Serial.print(BENCHMARK_SAMPLES);
+        Serial.print(" x ");
+        Serial.print(bench.iterations);
+        Serial.println("]");
+
+        if (s_json != nullptr) {
+            Print& out = *s_json;
+            out.print("{\"bench\":\"micro\",\"name\":\"");
+            out.print(bench.name);
+            out.print("\",\"metric\":\"ns_per_op\",\"median\":");
+            out.print(nsPerOp[BENCHMARK_SAMPLES / 2], 3);
+            out.print(",\"min\":");
+            out.print(nsPerOp[0], 3);
+            out.print(",\"mean\":");
+            out.print(mean, 3);
+            out.print(",\"max\":");
+            out.print(nsPerOp[BENCHMARK_SAMPLES - 1], 3);
+            out.print(",\"stddev\":");
+            out.print(stddev, 3);
+            out.print(",\"cycles_per_op\":");
+            out.print(cyclesPerOp[BENCHMARK_SAMPLES / 2], 1);
+            out.print(",\"samples\":");
+            out.print(BENCHMARK_SAMPLES);
+            out.print(",\"iterations\":");
+            out.print(bench.iterations);
+            out.println("}");
+        }
+    }
+
+    /**
+     * Build configuration record: results are only comparable between
+     * runs with the same target, compiler and optimization level
+     */
+    static void printBuildJson() {
+        if (s_json == nullptr) {
+            return;
+        }
+        Print& out = *s_json;
+#ifdef MICROLOOP_HOST
+        out.print("{\"bench\":\"build\",\"target\":\"host\"");
+#else
+        out.print("{\"bench\":\"build\",\"target\":\"teensy41\"");
+#endif
+        out.print(",\"compiler\":\"");
+        for (const char* c = __VERSION__; *c != '\0'; c++) {
+            if (*c != '"' && *c != '\\') out.print(*c);  // Keep the string valid JSON
+        }
+#if defined(__OPTIMIZE_SIZE__)
+        out.print("\",\"optimize\":\"size\"");
+#elif defined(__OPTIMIZE__)
+        out.print("\",\"optimize\":\"speed\"");
+#else
+        out.print("\",\"optimize\":\"none\"");
+#endif
+#ifndef MICROLOOP_HOST
+        out.print(",\"f_cpu\":");
+        out.print(F_CPU_ACTUAL);
+#endif
+        out.print(",\"audio_block_samples\":");
+        out.print(AUDIO_BLOCK_SAMPLES);
+        out.println("}");
+    }
+
     static Test s_tests[MAX_TESTS];
     static int s_numTests;
+    static Benchmark s_benchmarks[MAX_BENCHMARKS];
+    static int s_numBenchmarks;
+    static int s_numDropped;
+    static Print* s_json;
 };
 
 // Static member definitions
 TestRunner::Test TestRunner::s_tests[TestRunner::MAX_TESTS];
 int TestRunner::s_numTests = 0;
+TestRunner::Benchmark TestRunner::s_benchmarks[TestRunner::MAX_BENCHMARKS];
+int TestRunner::s_numBenchmarks = 0;
+int TestRunner::s_numDropped = 0;
+Print* TestRunner::s_json = &Serial;
 
-// Convenience macro
+// Convenience macros
 #define RUN_ALL_TESTS() TestRunner::runAll()
+#define RUN_TESTS_MATCHING(prefix) TestRunner::runAll(prefix)
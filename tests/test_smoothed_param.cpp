@@ -0,0 +1,145 @@
+/**
+ * test_smoothed_param.cpp - Unit tests for SmoothedParam (app thread target, ISR glide)
+ *
+ * Drives the parameter the way an effect's update() does: one nextBlock()
+ * per block, ramp() for per-sample use. Checks the time constant, exact
+ * settling in both directions, the settled fast path and that the
+ * per-sample ramp is continuous across blocks.
+ */
+
+#include "test_runner.h"
+#include "smoothed_param.h"
+
+// ========== GLIDE ==========
+
+TEST(SmoothedParam_TimeConstantMatches) {
+    // tau = 10 blocks: after 10 blocks 63% of the change is covered
+    SmoothedParam<int32_t> param(0);
+    param.setTimeConstantSamples(10.0f * AUDIO_BLOCK_SAMPLES);
+    param.setTarget(65536);
+
+    int32_t value = 0;
+    for (int block = 0; block < 10; block++) {
+        value = param.nextBlock();
+    }
+    ASSERT_NEAR(value, 41427, 700);  // 65536 * (1 - e^-1)
+}
+
+TEST(SmoothedParam_SettlesExactlyUpAndDown) {
+    SmoothedParam<int32_t> param(1000);
+    param.setTimeConstantMs(20.0f);
+
+    param.setTarget(65536);
+    int32_t last = param.value();
+    int blocks = 0;
+    while (!param.settled() && blocks < 1000) {
+        int32_t value = param.nextBlock();
+        ASSERT_TRUE(value > last);  // Monotonic, no overshoot
+        last = value;
+        blocks++;
+    }
+    ASSERT_EQ(param.value(), 65536);
+    ASSERT_LT(blocks, 200);
+
+    param.setTarget(-5000);
+    blocks = 0;
+    while (!param.settled() && blocks < 1000) {
+        param.nextBlock();
+        blocks++;
+    }
+    ASSERT_EQ(param.value(), -5000);
+    ASSERT_LT(blocks, 200);
+}
+
+TEST(SmoothedParam_ZeroTimeConstantJumps) {
+    SmoothedParam<int16_t> param(0);
+    param.setTimeConstantSamples(0.0f);
+    param.setTarget(-32768);
+    ASSERT_EQ(param.nextBlock(), -32768);
+    ASSERT_TRUE(param.settled());
+}
+
+TEST(SmoothedParam_LatestTargetWins) {
+    // The app thread may post several targets between two blocks
+    SmoothedParam<int32_t> param(0);
+    param.setTimeConstantSamples(0.0f);
+    param.setTarget(100);
+    param.setTarget(200);
+    param.setTarget(300);
+    ASSERT_EQ(param.nextBlock(), 300);
+    ASSERT_EQ(param.getTarget(), 300);
+}
+
+// ========== FAST PATH ==========
+
+TEST(SmoothedParam_SettledBlockIsConstant) {
+    SmoothedParam<int32_t> param(500);
+    param.setTimeConstantMs(5.0f);
+    ASSERT_EQ(param.nextBlock(), 500);
+    ASSERT_TRUE(param.blockIsConstant());
+
+    param.setTarget(600);
+    param.nextBlock();
+    ASSERT_FALSE(param.blockIsConstant());
+
+    param.snap(700);  // Jump: no glide, constant from the next block on
+    ASSERT_EQ(param.nextBlock(), 700);
+    ASSERT_TRUE(param.blockIsConstant());
+    ASSERT_TRUE(param.settled());
+}
+
+// ========== PER-SAMPLE RAMP ==========
+
+TEST(SmoothedParam_RampIsContinuousAcrossBlocks) {
+    SmoothedParam<int32_t> param(0);
+    param.setTimeConstantMs(10.0f);
+    param.setTarget(32767);
+
+    int32_t previousSample = 0;
+    int32_t worstJump = 0;
+    bool monotonic = true;
+    for (int block = 0; block < 50; block++) {
+        const int32_t start = param.value();
+        param.nextBlock();
+        auto ramp = param.ramp();
+        for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+            const int32_t sample = ramp.next();
+            if (i == 0) {
+                ASSERT_EQ(sample, start);  // Starts where the last block ended
+            }
+            const int32_t jump = sample - previousSample;
+            monotonic = monotonic && jump >= 0;
+            if (jump > worstJump) worstJump = jump;
+            previousSample = sample;
+        }
+    }
+    ASSERT_TRUE(monotonic);
+    // Steps are spread over the block: at most ~1/128 of the largest block step
+    ASSERT_LT(worstJump, 32767 / 16);
+}
+
+// ========== COST ==========
+
+// Settled fast path: one atomic load and a compare per block
+BENCHMARK(SmoothedParam_SettledBlock, 1000) {
+    static SmoothedParam<int32_t> param(1000);
+    volatile int32_t sink = param.nextBlock();
+    (void)sink;
+}
+
+// Gliding gain applied per sample to one block
+BENCHMARK(SmoothedParam_RampBlock, 1000) {
+    static SmoothedParam<int32_t> param(0);
+    static int16_t block[AUDIO_BLOCK_SAMPLES];
+    static bool up = true;
+    if (param.settled()) {
+        param.setTimeConstantMs(50.0f);
+        param.setTarget(up ? 32767 : 0);
+        up = !up;
+    }
+    param.nextBlock();
+    auto ramp = param.ramp();
+    for (size_t i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+        block[i] = static_cast<int16_t>((static_cast<int32_t>(block[i] + 1) * ramp.next()) >> 15);
+    }
+}
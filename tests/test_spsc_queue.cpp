@@ -4,6 +4,7 @@
 
 #include "test_runner.h"
 #include "spsc_queue.h"
+#include "command.h"
 
 TEST(SPSCQueue_Empty_InitiallyTrue) {
     SPSCQueue<int, 16> queue;
@@ -148,3 +149,39 @@ TEST(SPSCQueue_Performance_BurstPushPop) {
     // Should be very fast (< 1ms)
     ASSERT_LT(duration, 1000U);
 }
+
+TEST(SPSCQueue_Command_KeepsSampleTime) {
+    // Producers stamp at the source; the stamp must survive the queue
+    SPSCQueue<Command, 32> queue;
+    uint64_t stamp = 0x123456789ULL;  // Past 2^32 samples (~27 hours)
+
+    ASSERT_TRUE(queue.push(Command(CommandType::EFFECT_ENABLE, EffectID::CHOKE).at(stamp)));
+
+    Command out;
+    ASSERT_TRUE(queue.pop(out));
+    ASSERT_TRUE(out.isStamped());
+    ASSERT_EQ(out.sampleTime, stamp);
+    ASSERT_EQ(out.type, CommandType::EFFECT_ENABLE);
+    ASSERT_EQ(out.targetEffect, EffectID::CHOKE);
+    ASSERT_FALSE(Command(CommandType::EFFECT_ENABLE, EffectID::CHOKE).isStamped());
+    ASSERT_TRUE(Command(CommandType::EFFECT_ENABLE, EffectID::CHOKE).at(0).isStamped());  // First block after START
+}
+
+BENCHMARK(SPSCQueue_PushPop, 10000) {
+    static SPSCQueue<uint32_t, 256> queue;
+    static uint32_t next = 0;
+    uint32_t value = 0;
+    queue.push(next++);
+    queue.pop(value);
+    benchmarkSink(value);
+}
+
+BENCHMARK(SPSCQueue_PushPopCommand, 10000) {
+    // Input thread -> app thread command path (input_io.cpp)
+    static SPSCQueue<Command, 32> queue;
+    Command cmd{CommandType::EFFECT_TOGGLE, EffectID::CHOKE};
+    Command out;
+    queue.push(cmd);
+    queue.pop(out);
+    benchmarkSink(out.targetEffect);
+}
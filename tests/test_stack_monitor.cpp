@@ -0,0 +1,58 @@
+/**
+ * test_stack_monitor.cpp - Unit tests for StackMonitor utility
+ */
+
+#include "test_runner.h"
+#include "stack_monitor.h"
+
+// Fake stack (never executed on - we simulate usage by writing from the top)
+alignas(8) static uint8_t s_testStack[1024];
+
+TEST(StackMonitor_FreshStack_IsUntouched) {
+    for (size_t i = 0; i < sizeof(s_testStack) / 4; i++) {
+        reinterpret_cast<uint32_t*>(s_testStack)[i] = StackMonitor::PAINT_PATTERN;
+    }
+    ASSERT_EQ(StackMonitor::measureUntouched(s_testStack, sizeof(s_testStack)), sizeof(s_testStack));
+}
+
+TEST(StackMonitor_Usage_MeasuredFromTop) {
+    for (size_t i = 0; i < sizeof(s_testStack) / 4; i++) {
+        reinterpret_cast<uint32_t*>(s_testStack)[i] = StackMonitor::PAINT_PATTERN;
+    }
+
+    // Simulate 300 bytes of stack use (stack grows down from the top)
+    memset(s_testStack + sizeof(s_testStack) - 300, 0, 300);
+
+    // Untouched region ends at the first dirty word (rounded down to 4 bytes)
+    ASSERT_EQ(StackMonitor::measureUntouched(s_testStack, sizeof(s_testStack)), (size_t)724);
+}
+
+TEST(StackMonitor_Register_PaintsAndScans) {
+    memset(s_testStack, 0, sizeof(s_testStack));  // Garbage before painting
+    ASSERT_TRUE(StackMonitor::registerStack("test", s_testStack, sizeof(s_testStack), TELEM_STACK_APP_USED));
+    uint8_t index = StackMonitor::getNumStacks() - 1;
+
+    StackMonitor::scan();
+    ASSERT_EQ(StackMonitor::getHighWater(index), (size_t)0);
+
+    memset(s_testStack + sizeof(s_testStack) - 128, 0x11, 128);
+    StackMonitor::scan();
+    ASSERT_EQ(StackMonitor::getHighWater(index), (size_t)128);
+    ASSERT_EQ(Telemetry::get(TELEM_STACK_APP_USED), 128u);
+}
+
+TEST(StackMonitor_GuardZone_Trips) {
+    // Own stack: must not depend on another test's registration
+    alignas(8) static uint8_t guardStack[1024];
+    ASSERT_TRUE(StackMonitor::registerStack("guard", guardStack, sizeof(guardStack), TELEM_STACK_APP_USED));
+    uint8_t before = StackMonitor::checkGuards();
+
+    // Use everything above the guard zone plus one word into it
+    memset(guardStack + StackMonitor::GUARD_BYTES - 4, 0x22, sizeof(guardStack) - StackMonitor::GUARD_BYTES + 4);
+    ASSERT_EQ(StackMonitor::checkGuards(), (uint8_t)(before + 1));
+}
+
+TEST(StackMonitor_Register_RejectsBadStack) {
+    ASSERT_FALSE(StackMonitor::registerStack("tiny", s_testStack, StackMonitor::GUARD_BYTES, TELEM_STACK_APP_USED));
+    ASSERT_FALSE(StackMonitor::registerStack("null", nullptr, 1024, TELEM_STACK_APP_USED));
+}
@@ -0,0 +1,225 @@
+/**
+ * test_step_sequencer.cpp - Unit tests for the audio ISR step sequencer
+ *
+ * PURPOSE:
+ * Drives TimeKeeper by hand and calls StepSequencer::process() once per
+ * audio block, as AudioTimeKeeper::update() does, with private choke and
+ * freeze instances on the lanes. Step boundaries at 120 BPM are 5512.5
+ * samples apart, so every test checks that a lane changes in the block
+ * holding its step's sample - not a block early or late.
+ */
+
+#include <Audio.h>
+#include "test_runner.h"
+#include "audio_choke.h"
+#include "audio_freeze.h"
+#include "step_sequencer.h"
+#include "timekeeper.h"
+
+// ========== FIXTURE ==========
+
+static AudioEffectChoke s_seqChoke;
+static AudioEffectFreeze s_seqFreeze;
+
+static const uint32_t SEQ_SPB = 22050;  // 120 BPM
+static const uint32_t SEQ_SPBAR = SEQ_SPB * TimeKeeper::BEATS_PER_BAR;
+
+/**
+ * Sample of pattern step n on a grid anchored at 0
+ */
+static uint64_t seqStepAt(uint32_t n) {
+    return (static_cast<uint64_t>(n / StepSequencer::STEPS_PER_BEAT) * SEQ_SPB) +
+           (static_cast<uint64_t>(n % StepSequencer::STEPS_PER_BEAT) * SEQ_SPB) / StepSequencer::STEPS_PER_BEAT;
+}
+
+/**
+ * Sequencer stopped, pattern empty, transport at sample 0 and running
+ */
+static void seqBegin() {
+    StepSequencer::begin(nullptr, &s_seqFreeze, &s_seqChoke);
+
+    StepSequencer::setEnabled(false);
+    StepSequencer::process(0);  // Release anything a previous test left on
+    for (uint8_t l = 0; l < StepSequencer::LANE_COUNT; l++) {
+        StepSequencer::clearLane(static_cast<StepSequencer::Lane>(l));
+    }
+    StepSequencer::setLength(16);
+
+    s_seqChoke.disable();
+    s_seqFreeze.disable();
+
+    TimeKeeper::reset();
+    TimeKeeper::setSamplesPerBeat(SEQ_SPB);
+    TimeKeeper::setTransportState(TimeKeeper::TransportState::PLAYING);
+}
+
+/**
+ * Run blocks until the block holding `sample`; returns the start of the
+ * first block in which the choke flag changed (UINT64_MAX if it did not)
+ */
+static uint64_t seqRunUntilChokeChanges(uint64_t sample) {
+    const bool before = s_seqChoke.isEnabled();
+    while (TimeKeeper::getSamplePosition() <= sample) {
+        uint64_t blockStart = TimeKeeper::getSamplePosition();
+        StepSequencer::process(blockStart);
+        TimeKeeper::incrementSamples(AUDIO_BLOCK_SAMPLES);
+        if (s_seqChoke.isEnabled() != before) {
+            return blockStart;
+        }
+    }
+    return UINT64_MAX;
+}
+
+static bool seqBlockHolds(uint64_t blockStart, uint64_t sample) {
+    return blockStart <= sample && sample < blockStart + AUDIO_BLOCK_SAMPLES;
+}
+
+// ========== GRID ==========
+
+TEST(Sequencer_Steps_FireOnSixteenthGrid) {
+    seqBegin();
+    StepSequencer::setStep(StepSequencer::Lane::CHOKE, 0, true);
+    StepSequencer::setStep(StepSequencer::Lane::CHOKE, 5, true);
+    StepSequencer::setEnabled(true);
+
+    ASSERT_TRUE(seqBlockHolds(seqRunUntilChokeChanges(seqStepAt(0)), seqStepAt(0)));
+    ASSERT_TRUE(s_seqChoke.isEnabled());
+    ASSERT_TRUE(StepSequencer::holdsLane(StepSequencer::Lane::CHOKE));
+    ASSERT_TRUE(seqBlockHolds(seqRunUntilChokeChanges(seqStepAt(1)), seqStepAt(1)));
+    ASSERT_FALSE(s_seqChoke.isEnabled());
+    ASSERT_FALSE(StepSequencer::holdsLane(StepSequencer::Lane::CHOKE));
+    ASSERT_TRUE(seqBlockHolds(seqRunUntilChokeChanges(seqStepAt(5)), seqStepAt(5)));
+    ASSERT_TRUE(seqBlockHolds(seqRunUntilChokeChanges(seqStepAt(6)), seqStepAt(6)));
+
+    // Second bar: same steps again, 16 steps later
+    ASSERT_TRUE(seqBlockHolds(seqRunUntilChokeChanges(seqStepAt(16)), seqStepAt(16)));
+    ASSERT_EQ(StepSequencer::getCurrentStep(), 0U);
+}
+
+TEST(Sequencer_Steps_TiedStepsHoldOneGate) {
+    seqBegin();
+    for (uint8_t step = 2; step <= 6; step++) {
+        StepSequencer::setStep(StepSequencer::Lane::FREEZE, step, true);
+    }
+    StepSequencer::setEnabled(true);
+
+    bool held = true;
+    while (TimeKeeper::getSamplePosition() < seqStepAt(7)) {
+        uint64_t blockStart = TimeKeeper::getSamplePosition();
+        StepSequencer::process(blockStart);
+        TimeKeeper::incrementSamples(AUDIO_BLOCK_SAMPLES);
+        if (blockStart >= seqStepAt(3) && blockStart + AUDIO_BLOCK_SAMPLES <= seqStepAt(7)) {
+            held = held && s_seqFreeze.isEnabled();
+        }
+    }
+    ASSERT_TRUE(held);
+    StepSequencer::process(TimeKeeper::getSamplePosition());
+    ASSERT_FALSE(s_seqFreeze.isEnabled());
+}
+
+TEST(Sequencer_Start_WaitsForNextBarLine) {
+    seqBegin();
+    StepSequencer::setStep(StepSequencer::Lane::CHOKE, 0, true);
+    TimeKeeper::incrementSamples(SEQ_SPBAR + 3 * SEQ_SPB);  // Beat 3 of bar 1
+    StepSequencer::setEnabled(true);
+
+    uint64_t changed = seqRunUntilChokeChanges(2 * SEQ_SPBAR);
+    ASSERT_TRUE(StepSequencer::isPlaying());
+    ASSERT_TRUE(seqBlockHolds(changed, 2 * SEQ_SPBAR));
+}
+
+TEST(Sequencer_Stop_ReleasesOwnLanesOnly) {
+    seqBegin();
+    StepSequencer::setStep(StepSequencer::Lane::CHOKE, 0, true);
+    StepSequencer::setEnabled(true);
+    seqRunUntilChokeChanges(seqStepAt(0));
+    ASSERT_TRUE(s_seqChoke.isEnabled());
+
+    // Performer holds freeze; the empty freeze lane must not cut it
+    s_seqFreeze.enable();
+    TimeKeeper::setTransportState(TimeKeeper::TransportState::STOPPED);
+    StepSequencer::process(TimeKeeper::getSamplePosition());
+    ASSERT_FALSE(StepSequencer::isPlaying());
+    ASSERT_FALSE(s_seqChoke.isEnabled());
+    ASSERT_TRUE(s_seqFreeze.isEnabled());
+}
+
+TEST(Sequencer_Engage_LeavesPerformerHeldEffect) {
+    seqBegin();
+    StepSequencer::setStep(StepSequencer::Lane::CHOKE, 0, true);
+    s_seqChoke.enable();  // Held by the performer before the step
+    StepSequencer::setEnabled(true);
+
+    // Step 1 is empty: the sequencer did not engage choke, so it keeps off it
+    while (TimeKeeper::getSamplePosition() <= seqStepAt(2)) {
+        StepSequencer::process(TimeKeeper::getSamplePosition());
+        TimeKeeper::incrementSamples(AUDIO_BLOCK_SAMPLES);
+    }
+    ASSERT_TRUE(s_seqChoke.isEnabled());
+    ASSERT_FALSE(StepSequencer::holdsLane(StepSequencer::Lane::CHOKE));  // Not the sequencer's gate
+}
+
+TEST(Sequencer_TransportStart_RestartsPattern) {
+    seqBegin();
+    StepSequencer::setStep(StepSequencer::Lane::CHOKE, 0, true);
+    StepSequencer::setEnabled(true);
+    seqRunUntilChokeChanges(seqStepAt(0));
+    seqRunUntilChokeChanges(seqStepAt(1));
+    TimeKeeper::incrementSamples(SEQ_SPB);
+
+    // MIDI START: sample position back to 0 (a bar line)
+    TimeKeeper::reset();
+    TimeKeeper::setSamplesPerBeat(SEQ_SPB);
+    TimeKeeper::setTransportState(TimeKeeper::TransportState::PLAYING);
+    ASSERT_TRUE(seqBlockHolds(seqRunUntilChokeChanges(0), 0));
+}
+
+// ========== PATTERN ==========
+
+TEST(Sequencer_Pattern_LengthAndBitset) {
+    seqBegin();
+    ASSERT_FALSE(StepSequencer::setLength(24));
+    ASSERT_EQ(StepSequencer::getLength(), 16U);
+    ASSERT_TRUE(StepSequencer::setLength(32));
+
+    StepSequencer::setStep(StepSequencer::Lane::STUTTER, 31, true);
+    StepSequencer::toggleStep(StepSequencer::Lane::STUTTER, 0);
+    StepSequencer::setStep(StepSequencer::Lane::STUTTER, 40, true);  // Ignored
+
+    StepPattern pattern;
+    StepSequencer::getPattern(pattern);
+    ASSERT_EQ(pattern.lanes[0], 0x80000001UL);
+    ASSERT_EQ(pattern.length, 32U);
+
+    pattern.length = 8;
+    ASSERT_FALSE(StepSequencer::setPattern(pattern));
+}
+
+TEST(Sequencer_Pattern_32StepsSpanTwoBars) {
+    seqBegin();
+    StepSequencer::setLength(32);
+    StepSequencer::setStep(StepSequencer::Lane::CHOKE, 20, true);
+    StepSequencer::setEnabled(true);
+
+    ASSERT_TRUE(seqBlockHolds(seqRunUntilChokeChanges(seqStepAt(20)), seqStepAt(20)));
+    seqRunUntilChokeChanges(seqStepAt(21));
+    ASSERT_TRUE(seqBlockHolds(seqRunUntilChokeChanges(seqStepAt(52)), seqStepAt(52)));
+}
+
+// ========== ISR COST ==========
+
+BENCHMARK(Sequencer_ProcessBlock, 1000) {
+    // Dense pattern, steps firing every ~43 blocks at 120 BPM
+    static bool placed = false;
+    if (!placed) {
+        seqBegin();
+        for (uint8_t step = 0; step < 16; step += 2) {
+            StepSequencer::setStep(StepSequencer::Lane::CHOKE, step, true);
+            StepSequencer::setStep(StepSequencer::Lane::FREEZE, step + 1, true);
+        }
+        StepSequencer::setEnabled(true);
+        placed = true;
+    }
+    StepSequencer::process(TimeKeeper::getSamplePosition());
+    TimeKeeper::incrementSamples(AUDIO_BLOCK_SAMPLES);
+}
@@ -0,0 +1,33 @@
+/**
+ * test_telemetry.cpp - Unit tests for Telemetry utility
+ */
+
+#include "test_runner.h"
+#include "telemetry.h"
+
+TEST(Telemetry_SetGet_RoundTrips) {
+    Telemetry::set(TELEM_LIMITER_GAIN, 12345);
+    ASSERT_EQ(Telemetry::get(TELEM_LIMITER_GAIN), 12345u);
+}
+
+TEST(Telemetry_Add_Accumulates) {
+    Telemetry::set(TELEM_LIMITER_ACTIVE_BLOCKS, 0);
+    for (int i = 0; i < 10; i++) {
+        Telemetry::add(TELEM_LIMITER_ACTIVE_BLOCKS, 1);
+    }
+    ASSERT_EQ(Telemetry::get(TELEM_LIMITER_ACTIVE_BLOCKS), 10u);
+}
+
+TEST(Telemetry_UpdateMin_KeepsLowest) {
+    Telemetry::set(TELEM_LIMITER_GAIN_MIN, 32767);
+    Telemetry::updateMin(TELEM_LIMITER_GAIN_MIN, 20000);
+    Telemetry::updateMin(TELEM_LIMITER_GAIN_MIN, 25000);  // Higher: ignored
+    ASSERT_EQ(Telemetry::get(TELEM_LIMITER_GAIN_MIN), 20000u);
+}
+
+TEST(Telemetry_Exchange_ResetsWindow) {
+    Telemetry::set(TELEM_LIMITER_GAIN_MIN, 18000);
+    uint32_t old = Telemetry::exchange(TELEM_LIMITER_GAIN_MIN, 32767);
+    ASSERT_EQ(old, 18000u);
+    ASSERT_EQ(Telemetry::get(TELEM_LIMITER_GAIN_MIN), 32767u);
+}
@@ -145,8 +145,8 @@ TEST(TimeKeeper_SyncToMIDIClock_CalculatesSamplesPerBeat) {
     uint32_t tickPeriodUs = 20833;
     TimeKeeper::syncToMIDIClock(tickPeriodUs);
 
-    // Expected: (20833 * 24 * 44100) / 1000000 = 22050 samples/beat
-    ASSERT_NEAR(TimeKeeper::getSamplesPerBeat(), 22050, 1);
+    // Expected: (20833 * 24 * 44100) / 1000000 = 22050 samples/beat (half a second at any rate)
+    ASSERT_NEAR(TimeKeeper::getSamplesPerBeat(), TimeKeeper::SAMPLE_RATE / 2, 1);
 }
 
 TEST(TimeKeeper_SyncToMIDIClock_UpdatesBPM) {
@@ -182,8 +182,8 @@ TEST(TimeKeeper_SyncToMIDIClock_RejectsInvalidTempo) {
 TEST(TimeKeeper_SetSamplesPerBeat_UpdatesDirectly) {
     TimeKeeper::reset();
 
-    TimeKeeper::setSamplesPerBeat(44100);  // 1 beat per second @ 44.1kHz
-    ASSERT_EQ(TimeKeeper::getSamplesPerBeat(), 44100U);
+    TimeKeeper::setSamplesPerBeat(TimeKeeper::SAMPLE_RATE);  // 1 beat per second
+    ASSERT_EQ(TimeKeeper::getSamplesPerBeat(), TimeKeeper::SAMPLE_RATE);
     ASSERT_NEAR(TimeKeeper::getBPM(), 60.0f, 0.1f);
 }
 
@@ -238,6 +238,17 @@ TEST(TimeKeeper_SampleToBeat_CalculatesCorrectly) {
     ASSERT_EQ(TimeKeeper::sampleToBeat(220500), 10U);
 }
 
+// Advance the sample position with MIDI ticks arriving on time (918 samples @ spb 22050)
+static void advanceWithTicks(uint32_t samples) {
+    const uint32_t samplesPerTick = TimeKeeper::getSamplesPerBeat() / TimeKeeper::MIDI_PPQN;
+    for (uint32_t i = 0; i < samples; i++) {
+        TimeKeeper::incrementSamples(1);
+        if (TimeKeeper::getSamplePosition() % samplesPerTick == 0) {
+            TimeKeeper::incrementTick();
+        }
+    }
+}
+
 TEST(TimeKeeper_SamplesToNextBeat_CalculatesFromCurrentPosition) {
     TimeKeeper::reset();
     TimeKeeper::setSamplesPerBeat(22050);  // 120 BPM
@@ -245,24 +256,46 @@ TEST(TimeKeeper_SamplesToNextBeat_CalculatesFromCurrentPosition) {
     // At sample 0, next beat is at 22050
     ASSERT_EQ(TimeKeeper::samplesToNextBeat(), 22050U);
 
-    // Advance to sample 10000
-    TimeKeeper::incrementSamples(10000);
+    // Advance to sample 10000 (10 ticks + 820 samples)
+    advanceWithTicks(10000);
     // Next beat at 22050, currently at 10000 → 12050 samples to go
     ASSERT_EQ(TimeKeeper::samplesToNextBeat(), 12050U);
 
     // Advance to sample 22000 (near beat 1)
-    TimeKeeper::incrementSamples(12000);
+    advanceWithTicks(12000);
     ASSERT_EQ(TimeKeeper::samplesToNextBeat(), 50U);
 }
 
+TEST(TimeKeeper_SamplesToNextBeat_FollowsTicksNotSamples) {
+    TimeKeeper::reset();
+    TimeKeeper::setSamplesPerBeat(22050);  // 120 BPM
+
+    // Beat grid starts where the MIDI beat does, not at sample 0
+    TimeKeeper::incrementSamples(5000);
+    for (uint32_t i = 0; i < TimeKeeper::MIDI_PPQN; i++) {
+        TimeKeeper::incrementTick();  // Beat 1, tick 0 lands at sample 5000
+    }
+    ASSERT_EQ(TimeKeeper::samplesToNextBeat(), 22050U);
+
+    TimeKeeper::incrementSamples(100);
+    ASSERT_EQ(TimeKeeper::samplesToNextBeat(), 21950U);
+}
+
 TEST(TimeKeeper_SamplesToNextBar_CalculatesFromCurrentPosition) {
     TimeKeeper::reset();
     TimeKeeper::setSamplesPerBeat(22050);  // 120 BPM
     TimeKeeper::incrementTick();  // Advance to beat 0, tick 1
 
-    // At beat 0, next bar is at beat 4 = sample 88200
+    // At beat 0 tick 1 (one tick = 918 samples in), next bar is at beat 4
     uint32_t toNextBar = TimeKeeper::samplesToNextBar();
-    ASSERT_NEAR(toNextBar, 88200U, 100);  // Allow small tolerance
+    ASSERT_EQ(toNextBar, 88200U - 918U);
+
+    // Beat 2 of the bar, 100 samples past its tick 0
+    for (uint32_t i = 0; i < 2 * TimeKeeper::MIDI_PPQN - 1; i++) {
+        TimeKeeper::incrementTick();
+    }
+    TimeKeeper::incrementSamples(100);
+    ASSERT_EQ(TimeKeeper::samplesToNextBar(), 2U * 22050U - 100U);
 }
 
 TEST(TimeKeeper_IsOnBeatBoundary_DetectsBeatStart) {
@@ -101,3 +101,94 @@ TEST(Trace_HighFrequency_HandlesRapidCalls) {
     // Should be < 1µs per call on average (very fast)
     ASSERT_LT(duration, 1000000U);  // < 1 second total
 }
+
+// ========== CRASH PERSISTENCE ==========
+
+TEST(Trace_Begin_RecoversPreviousRun) {
+    Trace::begin();  // This "run" starts with a valid header
+    const uint32_t boot = Trace::getBootCount();
+
+    TRACE(TRACE_MIDI_START);
+    TRACE(TRACE_BEAT_START, 7);
+    TRACE(TRACE_AUDIO_OVERRUN, 1234);  // Last event before the "reset"
+
+    // Warm reset: RAM kept, setup() calls begin() again
+    ASSERT_EQ(Trace::begin(), 3);
+    ASSERT_EQ(Trace::getPreviousCount(), 3);
+    ASSERT_EQ(Trace::getBootCount(), boot + 1);
+    const TraceEvent* previous = Trace::getPrevious();
+    ASSERT_EQ(previous[0].eventId, TRACE_MIDI_START);
+    ASSERT_EQ(previous[1].value, 7);
+    ASSERT_EQ(previous[2].eventId, TRACE_AUDIO_OVERRUN);
+    ASSERT_EQ(previous[2].value, 1234);
+
+    // The new run starts empty
+    TraceEvent live[Trace::BUFFER_SIZE];
+    ASSERT_EQ(Trace::snapshot(live), 0);
+}
+
+TEST(Trace_Begin_KeepsNewestAfterWrap) {
+    Trace::begin();
+    for (int i = 0; i < 1500; i++) {
+        TRACE(TRACE_TICK_PERIOD_UPDATE, i);
+    }
+
+    ASSERT_EQ(Trace::begin(), Trace::BUFFER_SIZE);
+    const TraceEvent* previous = Trace::getPrevious();
+    ASSERT_EQ(previous[0].value, 1500 - Trace::BUFFER_SIZE);  // Oldest kept
+    ASSERT_EQ(previous[Trace::BUFFER_SIZE - 1].value, 1499);   // Newest, just before the reset
+
+    // Nothing recorded in between: the next boot recovers nothing
+    ASSERT_EQ(Trace::begin(), 0);
+}
+
+TEST(Trace_Begin_DropsCorruptedEvents) {
+    Trace::begin();
+    TRACE(TRACE_MIDI_START);
+    Trace::record(0xBEEF, 1);  // What a stray write looks like: an id nobody records
+    TRACE(TRACE_AUDIO_OVERRUN, 9);
+
+    ASSERT_EQ(Trace::begin(), 2);
+    ASSERT_EQ(Trace::getPreviousDropped(), 1);
+    ASSERT_EQ(Trace::getPrevious()[0].eventId, TRACE_MIDI_START);
+    ASSERT_EQ(Trace::getPrevious()[1].value, 9);
+}
+
+TEST(Trace_DropInvalid_ChecksTimestampOrder) {
+    // Oldest first; 5000 is out of order between 300 and 400
+    TraceEvent events[] = {
+        {100, TRACE_MIDI_START, 0},
+        {300, TRACE_BEAT_START, 1},
+        {5000, TRACE_BEAT_START, 2},
+        {400, TRACE_BEAT_START, 3},
+        {500, TRACE_AUDIO_OVERRUN, 4},
+    };
+    ASSERT_EQ(Trace::dropInvalid(events, 5), 4);
+    ASSERT_EQ(events[1].value, 1);
+    ASSERT_EQ(events[2].value, 3);
+    ASSERT_EQ(events[3].value, 4);
+
+    // One micros() wrap is kept, a second backwards step is not
+    TraceEvent wrap[] = {
+        {0xFFFFFF00u, TRACE_BEAT_START, 0},
+        {0xFFFFFFF0u, TRACE_BEAT_START, 1},
+        {0x00000010u, TRACE_BEAT_START, 2},
+        {0x00000020u, TRACE_BEAT_START, 3},
+    };
+    ASSERT_EQ(Trace::dropInvalid(wrap, 4), 4);
+    ASSERT_EQ(wrap[0].value, 0);
+
+    TraceEvent twice[] = {
+        {0x90000000u, TRACE_BEAT_START, 0},  // Older than a second wrap: dropped
+        {0x00000100u, TRACE_BEAT_START, 1},
+        {0xFFFFFFF0u, TRACE_BEAT_START, 2},
+        {0x00000010u, TRACE_BEAT_START, 3},
+    };
+    ASSERT_EQ(Trace::dropInvalid(twice, 4), 3);
+    ASSERT_EQ(twice[0].value, 1);
+}
+
+BENCHMARK(Trace_Record, 10000) {
+    static uint16_t value = 0;
+    TRACE(TRACE_AUDIO_CALLBACK, value++);
+}
@@ -0,0 +1,208 @@
+/**
+ * cobs.h - COBS byte stuffing and CRC-16 framing for byte streams
+ *
+ * PURPOSE:
+ * Link layer of the remote protocol (remote_messages.h): turns packets
+ * into self-delimiting frames on a byte stream (USB serial, a pipe) and
+ * back. Shared by the firmware and the host tools.
+ *
+ * DESIGN:
+ * - Frame on the wire: COBS(packet + CRC-16 little-endian) followed by one
+ *   0x00 delimiter. COBS removes every 0x00 from the data with at most one
+ *   byte of overhead per 254, so a receiver resynchronizes at the next 0x00
+ *   whatever it missed (partial frames, text mixed into the stream)
+ * - CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over the packet; a frame
+ *   with a bad CRC or bad stuffing is reported and dropped
+ * - FrameDecoder is fed one byte at a time, keeps at most MAX_PACKET bytes
+ *   and needs no allocation; an oversized frame is skipped up to the next
+ *   delimiter
+ *
+ * USAGE:
+ *   uint8_t wire[Cobs::maxFrameSize(MAX_PACKET)];
+ *   size_t n = Cobs::encodeFrame(packet, packetLength, wire);  // Send wire[0..n)
+ *
+ *   FrameDecoder<MAX_PACKET> rx;
+ *   if (rx.feed(byte) == FrameDecoder<MAX_PACKET>::FRAME) {
+ *       handle(rx.packet(), rx.packetLength());                // CRC checked, stripped
+ *   }
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class Crc16 {
+public:
+    /**
+     * CRC-16/CCITT-FALSE ("123456789" -> 0x29B1)
+     */
+    static uint16_t ccitt(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF) {
+        for (size_t i = 0; i < length; i++) {
+            crc ^= static_cast<uint16_t>(data[i]) << 8;
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+            }
+        }
+        return crc;
+    }
+};
+
+class Cobs {
+public:
+    static constexpr uint8_t DELIMITER = 0x00;
+    static constexpr size_t CRC_BYTES = 2;
+    static constexpr size_t MAX_FRAME_PACKET = 256;  // encodeFrame() limit
+
+    /**
+     * Worst-case COBS output for `length` input bytes
+     */
+    static constexpr size_t maxEncodedSize(size_t length) {
+        return length + length / 254 + 1;
+    }
+
+    /**
+     * Worst-case wire size of encodeFrame() for a packet of `length` bytes
+     */
+    static constexpr size_t maxFrameSize(size_t length) {
+        return maxEncodedSize(length + CRC_BYTES) + 1;
+    }
+
+    /**
+     * COBS-encode `length` bytes (no delimiter); out needs maxEncodedSize(length)
+     *
+     * @return Bytes written
+     */
+    static size_t encode(const uint8_t* in, size_t length, uint8_t* out) {
+        size_t codeAt = 0;
+        size_t write = 1;
+        uint8_t code = 1;
+        for (size_t i = 0; i < length; i++) {
+            if (in[i] == 0) {
+                out[codeAt] = code;
+                codeAt = write++;
+                code = 1;
+            } else {
+                out[write++] = in[i];
+                if (++code == 0xFF) {
+                    out[codeAt] = code;
+                    codeAt = write++;
+                    code = 1;
+                }
+            }
+        }
+        out[codeAt] = code;
+        return write;
+    }
+
+    /**
+     * Decode one COBS block (delimiter not included)
+     *
+     * @return Bytes written, or 0 if the input is not valid COBS or does not fit
+     */
+    static size_t decode(const uint8_t* in, size_t length, uint8_t* out, size_t outCapacity) {
+        size_t read = 0;
+        size_t write = 0;
+        while (read < length) {
+            const uint8_t code = in[read++];
+            if (code == 0 || read + code - 1 > length) {
+                return 0;
+            }
+            for (uint8_t i = 1; i < code; i++) {
+                if (write >= outCapacity) return 0;
+                out[write++] = in[read++];
+            }
+            if (code != 0xFF && read < length) {
+                if (write >= outCapacity) return 0;
+                out[write++] = 0;
+            }
+        }
+        return write;
+    }
+
+    /**
+     * Append the CRC, COBS-encode and terminate one packet
+     *
+     * @param wire Output, at least maxFrameSize(length) bytes
+     * @return Bytes to send (0 if length > MAX_FRAME_PACKET)
+     */
+    static size_t encodeFrame(const uint8_t* packet, size_t length, uint8_t* wire) {
+        if (length > MAX_FRAME_PACKET) {
+            return 0;
+        }
+        // Packet and CRC are stuffed as one block sequence
+        const uint16_t crc = Crc16::ccitt(packet, length);
+        uint8_t staged[MAX_FRAME_PACKET + CRC_BYTES];
+        for (size_t i = 0; i < length; i++) staged[i] = packet[i];
+        staged[length] = static_cast<uint8_t>(crc & 0xFF);
+        staged[length + 1] = static_cast<uint8_t>(crc >> 8);
+        size_t n = encode(staged, length + CRC_BYTES, wire);
+        wire[n++] = DELIMITER;
+        return n;
+    }
+};
+
+/**
+ * Incremental frame receiver (one instance per stream)
+ */
+template<size_t MAX_PACKET>
+class FrameDecoder {
+public:
+    enum Result : uint8_t {
+        NONE,        // Byte consumed, no frame yet
+        FRAME,       // packet()/packetLength() hold a checked packet
+        BAD_FRAME,   // Delimiter reached: bad stuffing or CRC (dropped)
+        OVERSIZED    // Delimiter reached after a frame longer than MAX_PACKET (dropped)
+    };
+
+    Result feed(uint8_t byte) {
+        if (byte != Cobs::DELIMITER) {
+            if (m_encodedLength < sizeof(m_encoded)) {
+                m_encoded[m_encodedLength++] = byte;
+            } else {
+                m_overflow = true;
+            }
+            return NONE;
+        }
+
+        // Delimiter: decode what was collected
+        const size_t encodedLength = m_encodedLength;
+        const bool overflow = m_overflow;
+        m_encodedLength = 0;
+        m_overflow = false;
+        m_packetLength = 0;
+        if (encodedLength == 0) {
+            return NONE;  // Empty frame (sync byte, back-to-back delimiters)
+        }
+        if (overflow) {
+            return OVERSIZED;
+        }
+
+        const size_t n = Cobs::decode(m_encoded, encodedLength, m_packet, sizeof(m_packet));
+        if (n <= Cobs::CRC_BYTES) {
+            return BAD_FRAME;
+        }
+        const uint16_t received = static_cast<uint16_t>(m_packet[n - 2] | (m_packet[n - 1] << 8));
+        if (Crc16::ccitt(m_packet, n - Cobs::CRC_BYTES) != received) {
+            return BAD_FRAME;
+        }
+        m_packetLength = n - Cobs::CRC_BYTES;
+        return FRAME;
+    }
+
+    const uint8_t* packet() const { return m_packet; }
+    size_t packetLength() const { return m_packetLength; }
+
+    void reset() {
+        m_encodedLength = 0;
+        m_overflow = false;
+        m_packetLength = 0;
+    }
+
+private:
+    uint8_t m_encoded[Cobs::maxEncodedSize(MAX_PACKET + Cobs::CRC_BYTES)];
+    uint8_t m_packet[MAX_PACKET + Cobs::CRC_BYTES];
+    size_t m_encodedLength = 0;
+    size_t m_packetLength = 0;
+    bool m_overflow = false;
+};
@@ -8,7 +8,10 @@
  *
  * DESIGN:
  * - POD (Plain Old Data): Safe for lock-free SPSC queues
- * - Compact: 8 bytes (cache-friendly)
+ * - Compact: 16 bytes (two per 32-byte cache line)
+ * - Timed: producers stamp the sample position the event happened at, so
+ *   consumers can compensate for queue/thread latency and a recorded
+ *   stream can be replayed offline
  * - Type-safe: enum class prevents mixing types
  * - Extensible: Generic parameter slots for future features
  *
@@ -31,6 +34,7 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 #include <type_traits>
 
@@ -53,10 +57,22 @@ enum class CommandType : uint8_t {
     // TRANSPORT_STOP = 11,
     // TRANSPORT_CONTINUE = 12,
 
-    // Future: Loop control
-    // LOOP_RECORD = 20,
-    // LOOP_OVERDUB = 21,
-    // LOOP_CLEAR = 22,
+    // Loop control (targetEffect = STUTTER, bar-quantized while the transport runs)
+    LOOP_RECORD = 20,    // Start capture; again: end capture and play the loop
+    LOOP_OVERDUB = 21,   // Start/stop mixing live input into the playing loop
+    LOOP_CLEAR = 22,     // Stop and delete the loop
+    LOOP_UNDO = 23,      // Undo the last overdub pass
+    LOOP_REDO = 24,      // Redo the undone pass
+    LOOP_RETRO = 25,     // Loop the last `value` bars (1/2/4) from the pre-roll ring
+
+    // Journal control (targetEffect = NONE; console keys, not journaled themselves)
+    JOURNAL_RECORD = 40, // Start/stop recording
+    JOURNAL_REPLAY = 41, // Start/stop looping replay from the next bar
+    JOURNAL_DUMP = 42,   // Print the journal
+
+    // Step sequencer (targetEffect = NONE; console keys, not journaled themselves)
+    SEQ_TOGGLE = 50,     // Start on the next bar / stop
+    SEQ_LENGTH = 51,     // value: pattern length in steps (16 or 32), 0 = switch 16 <-> 32
 
     // Future: Sample control
     // SAMPLE_TRIGGER = 30,
@@ -80,8 +96,8 @@ enum class EffectID : uint8_t {
 /**
  * Command - Generic command structure
  *
- * SIZE: 8 bytes (2 enums + 2 param bytes + 4 value bytes)
- * ALIGNMENT: 4-byte aligned (efficient on ARM Cortex-M7)
+ * SIZE: 16 bytes (2 enums + 2 param bytes + 4 value bytes + 8 timestamp bytes)
+ * ALIGNMENT: 8-byte aligned (uint64_t member, copied with LDRD/STRD on Cortex-M7)
  * POD: Yes (trivially copyable, no constructor/destructor side effects)
  *
  * FIELDS:
@@ -90,6 +106,10 @@ enum class EffectID : uint8_t {
  * - param1: Generic parameter slot 1 (usage depends on command type)
  * - param2: Generic parameter slot 2 (usage depends on command type)
  * - value: Generic 32-bit value (e.g., delay time in samples, gain in percent)
+ * - sampleTime: TimeKeeper sample position when the event happened at its
+ *   source (button ISR, MIDI byte, ...). NOT_STAMPED = consumer uses "now"
+ *   (sample 0 is a real position: the first block after MIDI START).
+ *   Resolution is one audio block: the sample counter advances per block.
  *
  * PARAMETER USAGE EXAMPLES:
  *
@@ -115,6 +135,10 @@ struct Command {
     uint8_t param1;         // Generic parameter slot 1
     uint8_t param2;         // Generic parameter slot 2
     uint32_t value;         // Generic value (delay time, gain, etc.)
+    uint64_t sampleTime;    // Sample position at the source (NOT_STAMPED = none)
+
+    // Not 0: a press in the first block after START is stamped 0
+    static constexpr uint64_t NOT_STAMPED = UINT64_MAX;
 
     /**
      * Default constructor - creates NONE command
@@ -124,7 +148,8 @@ struct Command {
           targetEffect(EffectID::NONE),
           param1(0),
           param2(0),
-          value(0) {}
+          value(0),
+          sampleTime(NOT_STAMPED) {}
 
     /**
      * Simple constructor - for commands without parameters
@@ -137,7 +162,8 @@ struct Command {
           targetEffect(e),
           param1(0),
           param2(0),
-          value(0) {}
+          value(0),
+          sampleTime(NOT_STAMPED) {}
 
     /**
      * Full constructor - for commands with value
@@ -151,7 +177,8 @@ struct Command {
           targetEffect(e),
           param1(0),
           param2(0),
-          value(v) {}
+          value(v),
+          sampleTime(NOT_STAMPED) {}
 
     /**
      * Parameter constructor - for SET_PARAM commands
@@ -166,7 +193,24 @@ struct Command {
           targetEffect(e),
           param1(p1),
           param2(0),
-          value(v) {}
+          value(v),
+          sampleTime(NOT_STAMPED) {}
+
+    /**
+     * Copy of this command stamped with a source sample position
+     *
+     * USAGE (producer):
+     *   commandQueue.push(mapping.pressCommand.at(TimeKeeper::getSamplePosition()));
+     */
+    constexpr Command at(uint64_t samplePosition) const {
+        Command cmd = *this;
+        cmd.sampleTime = samplePosition;
+        return cmd;
+    }
+
+    bool isStamped() const {
+        return sampleTime != NOT_STAMPED;
+    }
 };
 
 // ============================================================================
@@ -185,18 +229,23 @@ static_assert(std::is_trivially_copyable<Command>::value,
               "Command must be trivially copyable (POD requirement for lock-free queues)");
 
 /**
- * Verify Command size
+ * Verify Command size and layout
  *
- * Expected: 8 bytes
+ * Expected: 16 bytes, no padding
  * - CommandType: 1 byte
  * - EffectID: 1 byte
  * - param1: 1 byte
  * - param2: 1 byte
  * - value: 4 bytes
- * Total: 8 bytes (powers-of-2, cache-friendly)
+ * - sampleTime: 8 bytes (offset 8, naturally aligned)
+ * Total: 16 bytes (powers-of-2, two per cache line)
  */
-static_assert(sizeof(Command) == 8,
-              "Command should be 8 bytes (2 enums + 2 params + 4 value)");
+static_assert(sizeof(Command) == 16,
+              "Command should be 16 bytes (2 enums + 2 params + 4 value + 8 sampleTime)");
+static_assert(offsetof(Command, sampleTime) == 8,
+              "Command::sampleTime must follow value with no padding");
+static_assert(std::is_standard_layout<Command>::value,
+              "Command must be standard layout (stable field offsets for journals)");
 
 /**
  * Verify enums are 1 byte
@@ -0,0 +1,179 @@
+/**
+ * log.cpp - Log ring storage, producer/consumer and the deferred formatter
+ */
+
+#include "log.h"
+
+Log::Slot Log::s_slots[Log::CAPACITY];
+uint32_t Log::s_head = 0;
+uint32_t Log::s_tail = 0;
+uint32_t Log::s_dropped = 0;
+uint32_t Log::s_droppedReported = 0;
+bool Log::s_draining = false;
+
+// ========== PRODUCERS (any thread / ISR) ==========
+
+bool Log::push(uint8_t level, const char* format, const LogArg* args, uint8_t argc) {
+    uint32_t pos = __atomic_load_n(&s_head, __ATOMIC_RELAXED);
+    for (;;) {
+        // Full: the slot still holds an entry the log thread has not drained
+        if (pos - __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE) >= CAPACITY) {
+            __atomic_fetch_add(&s_dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+        Slot& slot = s_slots[pos & (CAPACITY - 1)];
+        if (__atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE) == freeTag(pos)) {
+            if (__atomic_compare_exchange_n(&s_head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;  // Slot is ours
+            }
+            // pos now holds the current head: retry there
+        } else {
+            // Another producer claimed pos already
+            pos = __atomic_load_n(&s_head, __ATOMIC_RELAXED);
+        }
+    }
+
+    Slot& slot = s_slots[pos & (CAPACITY - 1)];
+    slot.entry.timestampMs = millis();
+    slot.entry.format = format;
+    slot.entry.level = level;
+    slot.entry.argc = argc;
+    for (uint8_t i = 0; i < argc; i++) {
+        slot.entry.args[i] = args[i];
+    }
+    __atomic_store_n(&slot.seq, freeTag(pos) + 1, __ATOMIC_RELEASE);  // Publish
+    return true;
+}
+
+// ========== CONSUMER (log thread) ==========
+
+bool Log::pop(LogEntry& entry) {
+    const uint32_t pos = s_tail;
+    Slot& slot = s_slots[pos & (CAPACITY - 1)];
+    if (__atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE) != freeTag(pos) + 1) {
+        return false;  // Empty, or the producer is still filling it (kept in order)
+    }
+    entry = slot.entry;
+    __atomic_store_n(&slot.seq, freeTag(pos + CAPACITY), __ATOMIC_RELEASE);  // Free for the next lap
+    __atomic_store_n(&s_tail, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+size_t Log::drain(Print& out, size_t maxEntries) {
+    // One consumer at a time (log thread, or the remote session's LOG packets)
+    if (__atomic_exchange_n(&s_draining, true, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+
+    const uint32_t dropped = getDroppedCount();
+    if (dropped != s_droppedReported) {
+        out.print("WARNING: Log - ");
+        out.print(dropped - s_droppedReported);
+        out.println(" message(s) dropped (ring full)");
+        s_droppedReported = dropped;
+    }
+
+    size_t printed = 0;
+    LogEntry entry;
+    while (printed < maxEntries && pop(entry)) {
+        out.print('[');
+        out.print(entry.timestampMs);
+        out.print("] ");
+        format(out, entry);
+        out.println();
+        printed++;
+    }
+    __atomic_store_n(&s_draining, false, __ATOMIC_RELEASE);
+    return printed;
+}
+
+void Log::clear() {
+    LogEntry entry;
+    while (pop(entry)) {
+    }
+    __atomic_store_n(&s_dropped, 0, __ATOMIC_RELAXED);
+    s_droppedReported = 0;
+}
+
+// ========== FORMATTER ==========
+
+void Log::format(Print& out, const LogEntry& entry) {
+    if (entry.level == LOG_LEVEL_ERROR) {
+        out.print("ERROR: ");
+    } else if (entry.level == LOG_LEVEL_WARN) {
+        out.print("WARNING: ");
+    }
+
+    uint8_t next = 0;
+    for (const char* p = entry.format; *p != '\0'; p++) {
+        if (*p != '%') {
+            out.print(*p);
+            continue;
+        }
+        p++;
+        if (*p == '%') {
+            out.print('%');
+            continue;
+        }
+
+        // Flags and width are accepted and ignored; precision applies to %f
+        while (*p == '-' || *p == '+' || *p == ' ' || *p == '0' || *p == '#') p++;
+        while (*p >= '0' && *p <= '9') p++;
+        int precision = 2;
+        if (*p == '.') {
+            precision = 0;
+            p++;
+            while (*p >= '0' && *p <= '9') {
+                precision = precision * 10 + (*p - '0');
+                p++;
+            }
+        }
+        while (*p == 'l' || *p == 'h' || *p == 'z') p++;  // Length modifiers (args are 32-bit)
+        if (*p == '\0') {
+            break;
+        }
+
+        if (next >= entry.argc) {
+            out.print('?');  // More conversions than arguments
+            continue;
+        }
+        const LogArg& arg = entry.args[next++];
+
+        switch (*p) {
+            case 'd':
+            case 'i':
+                if (arg.type == LogArg::INT) out.print(static_cast<long>(arg.i));
+                else if (arg.type == LogArg::UINT) out.print(static_cast<unsigned long>(arg.u));
+                else if (arg.type == LogArg::FLOAT) out.print(static_cast<long>(arg.f));
+                else out.print('?');
+                break;
+            case 'u':
+                if (arg.type == LogArg::FLOAT) out.print(static_cast<unsigned long>(arg.f));
+                else if (arg.type == LogArg::STRING) out.print('?');
+                else out.print(static_cast<unsigned long>(arg.u));
+                break;
+            case 'x':
+            case 'X':
+                if (arg.type == LogArg::INT || arg.type == LogArg::UINT) out.print(static_cast<unsigned long>(arg.u), HEX);
+                else out.print('?');
+                break;
+            case 'c':
+                if (arg.type == LogArg::INT || arg.type == LogArg::UINT) out.print(static_cast<char>(arg.u));
+                else out.print('?');
+                break;
+            case 's':
+                if (arg.type == LogArg::STRING) out.print(arg.s != nullptr ? arg.s : "(null)");
+                else out.print('?');
+                break;
+            case 'f':
+                if (arg.type == LogArg::FLOAT) out.print(static_cast<double>(arg.f), precision);
+                else if (arg.type == LogArg::INT) out.print(static_cast<long>(arg.i));
+                else if (arg.type == LogArg::UINT) out.print(static_cast<unsigned long>(arg.u));
+                else out.print('?');
+                break;
+            default:
+                out.print('?');  // Unsupported conversion
+                break;
+        }
+    }
+}
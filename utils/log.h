@@ -0,0 +1,201 @@
+/**
+ * log.h - Non-blocking log sink for control threads (deferred formatting)
+ *
+ * USAGE:
+ *   LOG_INFO("Stutter: CAPTURE START scheduled (%s)", quantizationName(q));
+ *   LOG_WARN("Looper: pre-roll holds only %u samples", samples);
+ *   LOG_ERROR("StutterController::handleLoopCommand() - bad bar count %d", bars);
+ *   Log::drain(Serial, 16);  // Log thread only: format and print up to 16 entries
+ *
+ * DESIGN:
+ * - Serial.print() blocks the caller when the USB host is not draining. A
+ *   LOG_* call instead copies the format pointer and up to MAX_ARGS raw
+ *   arguments into a ring slot (no formatting, no I/O) and returns
+ * - The format must be a string literal and %s arguments must point to
+ *   static strings: both are read later, when the log thread drains the
+ *   ring (quantizationName(), effect names and literals are fine, stack
+ *   buffers are not)
+ * - Bounded multi-producer / single-consumer ring: producers claim a slot
+ *   with a CAS on the head index, fill it, then publish it through the
+ *   slot's sequence word. Lock-free, safe from any thread or ISR
+ * - Full ring: the message is dropped and counted (getDroppedCount()),
+ *   the caller never waits. drain() reports new drops in the output
+ * - Formatter (drain side): %d %i %u %x %X %c %s %f (%.Nf) and %%; ERROR
+ *   and WARN lines get the repo's "ERROR: " / "WARNING: " prefix
+ *
+ * PERFORMANCE:
+ * - One slot: 48 bytes on the Teensy, CAPACITY = 64 entries = 3KB RAM
+ * - LOG_* cost: one CAS, a few stores (no division, no Serial)
+ *
+ * COMPILE-TIME CONTROL:
+ * - LOG_LEVEL selects the most verbose level compiled in:
+ *   LOG_LEVEL_NONE (0), LOG_LEVEL_ERROR (1), LOG_LEVEL_WARN (2),
+ *   LOG_LEVEL_INFO (3, default), LOG_LEVEL_DEBUG (4)
+ * - Statements above LOG_LEVEL compile to nothing (arguments are not
+ *   evaluated, but still type-checked, so every level keeps building)
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Compile-time level filter
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+/**
+ * One captured argument (formatted later by the log thread)
+ */
+struct LogArg {
+    enum Type : uint8_t { INT, UINT, FLOAT, STRING };
+
+    union {
+        int32_t i;
+        uint32_t u;
+        float f;
+        const char* s;
+    };
+    Type type;
+
+    LogArg() : u(0), type(UINT) {}
+    LogArg(int v) : i(v), type(INT) {}
+    LogArg(long v) : i(static_cast<int32_t>(v)), type(INT) {}
+    LogArg(long long v) : i(static_cast<int32_t>(v)), type(INT) {}
+    LogArg(unsigned int v) : u(v), type(UINT) {}
+    LogArg(unsigned long v) : u(static_cast<uint32_t>(v)), type(UINT) {}
+    LogArg(unsigned long long v) : u(static_cast<uint32_t>(v)), type(UINT) {}
+    LogArg(char v) : i(v), type(INT) {}
+    LogArg(signed char v) : i(v), type(INT) {}
+    LogArg(unsigned char v) : u(v), type(UINT) {}
+    LogArg(short v) : i(v), type(INT) {}
+    LogArg(unsigned short v) : u(v), type(UINT) {}
+    LogArg(bool v) : u(v ? 1 : 0), type(UINT) {}
+    LogArg(float v) : f(v), type(FLOAT) {}
+    LogArg(double v) : f(static_cast<float>(v)), type(FLOAT) {}
+    LogArg(const char* v) : s(v), type(STRING) {}
+};
+
+/**
+ * Log entry (one ring slot)
+ */
+struct LogEntry {
+    uint32_t timestampMs;  // millis() when logged
+    const char* format;    // String literal
+    uint8_t level;         // LOG_LEVEL_*
+    uint8_t argc;
+    LogArg args[4];        // Log::MAX_ARGS
+};
+
+class Log {
+public:
+    // Ring size (must be power of 2 for fast masking)
+    static constexpr uint32_t CAPACITY = 64;
+    static constexpr uint32_t CAPACITY_SHIFT = 6;  // log2(CAPACITY)
+    static constexpr uint8_t MAX_ARGS = 4;
+
+    /**
+     * Queue one message (lock-free, safe from any thread or ISR)
+     *
+     * Use the LOG_* macros: they apply the level filter at compile time.
+     *
+     * @return false if the ring was full (message dropped and counted)
+     */
+    template<typename... Args>
+    static bool write(uint8_t level, const char* format, Args... args) {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "Log: too many arguments (max 4)");
+        const LogArg captured[] = { LogArg(0), LogArg(args)... };  // Leading dummy: no zero-size array
+        return push(level, format, captured + 1, static_cast<uint8_t>(sizeof...(Args)));
+    }
+
+    /**
+     * Format and print queued messages, oldest first
+     *
+     * Reports messages dropped since the previous call first. One consumer
+     * at a time: a call made while another thread is draining returns 0.
+     *
+     * @param out        Destination (Serial on the device)
+     * @param maxEntries Upper bound per call (keeps one call short)
+     * @return Number of messages printed
+     */
+    static size_t drain(Print& out, size_t maxEntries = CAPACITY);
+
+    /**
+     * Format one entry without the timestamp (tests, drain())
+     */
+    static void format(Print& out, const LogEntry& entry);
+
+    /**
+     * Messages dropped because the ring was full (since boot or clear())
+     */
+    static uint32_t getDroppedCount() {
+        return __atomic_load_n(&s_dropped, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * Messages waiting for the log thread
+     */
+    static uint32_t pending() {
+        return __atomic_load_n(&s_head, __ATOMIC_ACQUIRE) - __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE);
+    }
+
+    /**
+     * Discard queued messages and reset the drop counters (consumer side, tests)
+     */
+    static void clear();
+
+private:
+    struct Slot {
+        // Even = free for the producer of lap seq / 2, odd = filled
+        uint32_t seq;
+        LogEntry entry;
+    };
+
+    static uint32_t freeTag(uint32_t pos) {
+        return (pos >> CAPACITY_SHIFT) << 1;
+    }
+
+    static bool push(uint8_t level, const char* format, const LogArg* args, uint8_t argc);
+    static bool pop(LogEntry& entry);
+
+    static Slot s_slots[CAPACITY];
+    static uint32_t s_head;            // Next position to claim (producers, CAS)
+    static uint32_t s_tail;            // Next position to drain (log thread)
+    static uint32_t s_dropped;         // Full-ring drops since boot
+    static uint32_t s_droppedReported; // Drops already reported by drain()
+    static bool s_draining;            // drain() in progress (consumer try-lock)
+};
+
+// Macros: "" fmt "" only accepts string literals. Filtered-out statements
+// stay type-checked but are never evaluated (and cost nothing)
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(fmt, ...) Log::write(LOG_LEVEL_ERROR, "" fmt "", ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fmt, ...) (false && Log::write(LOG_LEVEL_ERROR, "" fmt "", ##__VA_ARGS__))
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(fmt, ...) Log::write(LOG_LEVEL_WARN, "" fmt "", ##__VA_ARGS__)
+#else
+#define LOG_WARN(fmt, ...) (false && Log::write(LOG_LEVEL_WARN, "" fmt "", ##__VA_ARGS__))
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(fmt, ...) Log::write(LOG_LEVEL_INFO, "" fmt "", ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...) (false && Log::write(LOG_LEVEL_INFO, "" fmt "", ##__VA_ARGS__))
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(fmt, ...) Log::write(LOG_LEVEL_DEBUG, "" fmt "", ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(fmt, ...) (false && Log::write(LOG_LEVEL_DEBUG, "" fmt "", ##__VA_ARGS__))
+#endif
@@ -111,6 +111,26 @@ public:
         return true;
     }
 
+    /**
+     * @brief Copy the oldest element without removing it (CONSUMER side)
+     *
+     * Lets a consumer decide whether to take an item yet (e.g. only pop
+     * events that are due in this audio block).
+     *
+     * @param item Output parameter to store the oldest item
+     * @return true if an item was copied, false if queue is empty
+     */
+    bool peek(T& item) const {
+        const uint32_t current_read = readIdx;
+
+        if (current_read == writeIdx) {
+            return false;  // Queue empty
+        }
+
+        item = buffer[current_read & (SIZE - 1)];
+        return true;
+    }
+
     /**
      * @brief Check if queue is empty
      * @return true if empty (consumer perspective)
@@ -0,0 +1,105 @@
+/**
+ * stack_monitor.cpp - Thread stack painting and high-water-mark tracking
+ */
+
+#include "stack_monitor.h"
+#include "trace.h"
+
+StackMonitor::StackEntry StackMonitor::s_stacks[MAX_STACKS] = {};
+uint8_t StackMonitor::s_numStacks = 0;
+
+bool StackMonitor::registerStack(const char* name, uint8_t* stack, size_t size, TelemetryId telemId) {
+    if (stack == nullptr || size <= GUARD_BYTES || (size & 3) != 0 ||
+        (reinterpret_cast<uintptr_t>(stack) & 3) != 0) {
+        Serial.println("ERROR: StackMonitor::registerStack() - invalid stack");
+        return false;
+    }
+
+    if (s_numStacks >= MAX_STACKS) {
+        Serial.print("ERROR: StackMonitor::registerStack() - list full (max ");
+        Serial.print(MAX_STACKS);
+        Serial.println(" stacks)");
+        return false;
+    }
+
+    // Paint whole stack (thread has not started yet, nothing live in it)
+    uint32_t* words = reinterpret_cast<uint32_t*>(stack);
+    for (size_t i = 0; i < size / 4; i++) {
+        words[i] = PAINT_PATTERN;
+    }
+
+    StackEntry& entry = s_stacks[s_numStacks++];
+    entry.name = name;
+    entry.base = stack;
+    entry.size = size;
+    entry.highWater = 0;
+    entry.telemId = telemId;
+    entry.guardTripped = false;
+
+    Telemetry::set(telemId, 0);
+    return true;
+}
+
+uint8_t StackMonitor::checkGuards() {
+    uint8_t tripped = 0;
+
+    for (uint8_t i = 0; i < s_numStacks; i++) {
+        StackEntry& entry = s_stacks[i];
+        const volatile uint32_t* guardWord =
+            reinterpret_cast<const volatile uint32_t*>(entry.base + GUARD_BYTES - 4);
+
+        if (*guardWord != PAINT_PATTERN) {
+            tripped++;
+            if (!entry.guardTripped) {
+                entry.guardTripped = true;
+                TRACE(TRACE_APP_STACK_GUARD, i);
+            }
+        }
+    }
+
+    return tripped;
+}
+
+void StackMonitor::scan() {
+    for (uint8_t i = 0; i < s_numStacks; i++) {
+        StackEntry& entry = s_stacks[i];
+        entry.highWater = entry.size - measureUntouched(entry.base, entry.size);
+        Telemetry::set(entry.telemId, entry.highWater);
+    }
+    checkGuards();
+}
+
+size_t StackMonitor::getHighWater(uint8_t index) {
+    return (index < s_numStacks) ? s_stacks[index].highWater : 0;
+}
+
+size_t StackMonitor::measureUntouched(const uint8_t* stack, size_t size) {
+    const volatile uint32_t* words = reinterpret_cast<const volatile uint32_t*>(stack);
+    size_t count = size / 4;
+    size_t i = 0;
+    while (i < count && words[i] == PAINT_PATTERN) {
+        i++;
+    }
+    return i * 4;
+}
+
+void StackMonitor::printReport() {
+    Serial.println("\n=== STACK USAGE ===");
+    Serial.println("Thread   | Used / Size  | Free | Guard");
+    for (uint8_t i = 0; i < s_numStacks; i++) {
+        const StackEntry& entry = s_stacks[i];
+        Serial.print(entry.name);
+        for (size_t pad = strlen(entry.name); pad < 8; pad++) {
+            Serial.print(" ");
+        }
+        Serial.print(" | ");
+        Serial.print(entry.highWater);
+        Serial.print(" / ");
+        Serial.print(entry.size);
+        Serial.print(" | ");
+        Serial.print(entry.size - entry.highWater);
+        Serial.print(" | ");
+        Serial.println(entry.guardTripped ? "HIT" : "ok");
+    }
+    Serial.println("=== END STACK USAGE ===\n");
+}
@@ -0,0 +1,90 @@
+/**
+ * stack_monitor.h - Thread stack painting and high-water-mark tracking
+ *
+ * USAGE:
+ *   alignas(8) static uint8_t s_appStack[3072];
+ *   StackMonitor::registerStack("app", s_appStack, sizeof(s_appStack), TELEM_STACK_APP_USED);
+ *   threads.addThread(appThreadEntry, 0, sizeof(s_appStack), s_appStack);
+ *
+ *   StackMonitor::checkGuards();  // Cheap (1 load per stack), call often
+ *   StackMonitor::scan();         // Full high-water scan, call ~1Hz
+ *   StackMonitor::printReport();  // Main loop only
+ *
+ * DESIGN:
+ * - Stacks are static arrays (caller-owned) painted with PAINT_PATTERN
+ *   BEFORE the thread starts; stacks grow down, so untouched words sit at
+ *   the low end and the first modified word marks the high-water mark
+ * - scan() counts untouched words from the low end and publishes bytes used
+ *   to telemetry (one TelemetryId per stack)
+ * - Guard zone: the lowest GUARD_BYTES of each stack. checkGuards() reads
+ *   the word at the top of that zone; once it is overwritten the stack is
+ *   GUARD_BYTES away from overflowing -> TRACE_APP_STACK_GUARD (latched, once)
+ * - Read-only from the monitoring side: safe to run while threads execute
+ *   (a stale read only delays detection by one call)
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "telemetry.h"
+
+class StackMonitor {
+public:
+    static constexpr uint8_t MAX_STACKS = 6;
+    static constexpr uint32_t PAINT_PATTERN = 0xA5A5A5A5;
+    static constexpr size_t GUARD_BYTES = 256;  // Warn when less than this is left
+
+    /**
+     * Paint a stack and add it to the monitor (call BEFORE the thread starts)
+     *
+     * @param name    Static string for reports
+     * @param stack   Lowest address of the stack (4-byte aligned)
+     * @param size    Stack size in bytes (multiple of 4, > GUARD_BYTES)
+     * @param telemId Telemetry slot receiving bytes used
+     * @return true if registered
+     */
+    static bool registerStack(const char* name, uint8_t* stack, size_t size, TelemetryId telemId);
+
+    /**
+     * Check guard words; records TRACE_APP_STACK_GUARD on first hit per stack
+     *
+     * @return Number of stacks whose guard zone has been reached
+     */
+    static uint8_t checkGuards();
+
+    /**
+     * Measure high-water marks and publish them to telemetry
+     */
+    static void scan();
+
+    /**
+     * Bytes used at high-water mark (from last scan)
+     */
+    static size_t getHighWater(uint8_t index);
+
+    static uint8_t getNumStacks() { return s_numStacks; }
+
+    /**
+     * Print per-stack usage table (ONLY call from main loop / app thread!)
+     */
+    static void printReport();
+
+    /**
+     * Count untouched bytes from the low end of a painted region
+     * (exposed for unit tests)
+     */
+    static size_t measureUntouched(const uint8_t* stack, size_t size);
+
+private:
+    struct StackEntry {
+        const char* name;
+        uint8_t* base;
+        size_t size;
+        size_t highWater;     // Bytes used at last scan
+        TelemetryId telemId;
+        bool guardTripped;    // Latched after first TRACE_APP_STACK_GUARD
+    };
+
+    static StackEntry s_stacks[MAX_STACKS];
+    static uint8_t s_numStacks;
+};
@@ -0,0 +1,26 @@
+/**
+ * telemetry.cpp - Implementation of telemetry storage
+ */
+
+#include "telemetry.h"
+
+#if TELEMETRY_ENABLED
+
+// Static member definitions (gauges start at their "idle" values)
+volatile uint32_t Telemetry::s_values[TELEM_COUNT] = {
+    32767,  // TELEM_LIMITER_GAIN (unity)
+    32767,  // TELEM_LIMITER_GAIN_MIN (unity)
+    0,      // TELEM_LIMITER_ACTIVE_BLOCKS
+    0,      // TELEM_CPU_BLOCK_LOAD
+    0,      // TELEM_CPU_BLOCK_LOAD_MAX
+    0,      // TELEM_GOVERNOR_STEPS
+    0,      // TELEM_AUDIO_OVERRUNS
+    0,      // TELEM_AUDIO_LATE_STARTS
+    0,      // TELEM_AUDIO_CYCLE_MAX
+    0,      // TELEM_STACK_IO_USED
+    0,      // TELEM_STACK_INPUT_USED
+    0,      // TELEM_STACK_DISPLAY_USED
+    0,      // TELEM_STACK_APP_USED
+};
+
+#endif
@@ -0,0 +1,175 @@
+/**
+ * telemetry.h - Lock-free runtime metrics (gauges and counters)
+ *
+ * USAGE:
+ *   Telemetry::set(TELEM_LIMITER_GAIN, gainQ15);      // Gauge (last value wins)
+ *   Telemetry::add(TELEM_LIMITER_ACTIVE_BLOCKS, 1);   // Counter
+ *   Telemetry::updateMin(TELEM_LIMITER_GAIN_MIN, g);  // Windowed minimum
+ *   uint32_t g = Telemetry::exchange(TELEM_LIMITER_GAIN_MIN, 32767);  // Read + reset window
+ *   Telemetry::dump();                                // Print all values (app thread only!)
+ *
+ * DESIGN:
+ * - Wait-free: Safe to update from ISR, I/O thread, app thread
+ * - Zero allocation: One 32-bit slot per metric in a static array
+ * - Complements Trace: Trace records *events*, Telemetry holds *current values*
+ * - Units are metric-specific (documented next to each ID)
+ *
+ * COMPILE-TIME CONTROL:
+ * - Define TELEMETRY_ENABLED=0 to compile out all updates (zero overhead)
+ * - Default: Enabled in all builds
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+// Compile-time enable/disable
+#ifndef TELEMETRY_ENABLED
+#define TELEMETRY_ENABLED 1
+#endif
+
+// Telemetry metric IDs (add your own before TELEM_COUNT!)
+enum TelemetryId : uint8_t {
+    // Output limiter
+    TELEM_LIMITER_GAIN = 0,         // Current limiter gain (Q15, 32767 = no reduction)
+    TELEM_LIMITER_GAIN_MIN = 1,     // Lowest limiter gain since last reset (Q15)
+    TELEM_LIMITER_ACTIVE_BLOCKS = 2,// Blocks where the limiter reduced gain (counter)
+
+    // CPU governor
+    TELEM_CPU_BLOCK_LOAD = 3,       // Worst block in last governor window (permille of block period)
+    TELEM_CPU_BLOCK_LOAD_MAX = 4,   // Worst block since boot (permille of block period)
+    TELEM_GOVERNOR_STEPS = 5,       // Quality steps currently shed (0 = full quality)
+
+    // Audio deadline monitor
+    TELEM_AUDIO_OVERRUNS = 6,       // Update cycles that exceeded the deadline (counter)
+    TELEM_AUDIO_LATE_STARTS = 7,    // Update cycles that started late, i.e. missed blocks (counter)
+    TELEM_AUDIO_CYCLE_MAX = 8,      // Longest update cycle since boot (CPU cycles)
+
+    // Thread stacks (high-water mark, bytes used)
+    TELEM_STACK_IO_USED = 9,
+    TELEM_STACK_INPUT_USED = 10,
+    TELEM_STACK_DISPLAY_USED = 11,
+    TELEM_STACK_APP_USED = 12,
+
+    // Input path
+    TELEM_INPUT_LATENCY_MAX = 13,   // Longest source-to-app command delay since boot (samples)
+
+    // Log sink
+    TELEM_STACK_LOG_USED = 14,      // Log thread stack high-water mark (bytes used)
+
+    TELEM_COUNT                     // Number of metrics (must be last)
+};
+
+#if TELEMETRY_ENABLED
+
+class Telemetry {
+public:
+    /**
+     * Set gauge value (wait-free, safe in ISR)
+     */
+    static inline void set(TelemetryId id, uint32_t value) {
+        __atomic_store_n(&s_values[id], value, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * Increment counter (wait-free, safe in ISR)
+     */
+    static inline void add(TelemetryId id, uint32_t delta) {
+        __atomic_fetch_add(&s_values[id], delta, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * Lower gauge to value if smaller (lock-free CAS, safe in ISR)
+     */
+    static inline void updateMin(TelemetryId id, uint32_t value) {
+        uint32_t current = __atomic_load_n(&s_values[id], __ATOMIC_RELAXED);
+        while (value < current &&
+               !__atomic_compare_exchange_n(&s_values[id], &current, value, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+    }
+
+    /**
+     * Raise gauge to value if larger (lock-free CAS, safe in ISR)
+     */
+    static inline void updateMax(TelemetryId id, uint32_t value) {
+        uint32_t current = __atomic_load_n(&s_values[id], __ATOMIC_RELAXED);
+        while (value > current &&
+               !__atomic_compare_exchange_n(&s_values[id], &current, value, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+    }
+
+    /**
+     * Read current value
+     */
+    static inline uint32_t get(TelemetryId id) {
+        return __atomic_load_n(&s_values[id], __ATOMIC_RELAXED);
+    }
+
+    /**
+     * Read value and replace it (used to reset min/max windows)
+     */
+    static inline uint32_t exchange(TelemetryId id, uint32_t value) {
+        return __atomic_exchange_n(&s_values[id], value, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * Print all metrics to Serial (ONLY call from app thread!)
+     *
+     * Format: name = value
+     */
+    static void dump() {
+        Serial.println("\n=== TELEMETRY ===");
+        for (uint8_t i = 0; i < TELEM_COUNT; i++) {
+            Serial.print(name(static_cast<TelemetryId>(i)));
+            Serial.print(" = ");
+            Serial.println(get(static_cast<TelemetryId>(i)));
+        }
+        Serial.println("=== END TELEMETRY ===\n");
+    }
+
+    /**
+     * Get human-readable metric name
+     */
+    static const char* name(TelemetryId id) {
+        switch (id) {
+            case TELEM_LIMITER_GAIN: return "LIMITER_GAIN";
+            case TELEM_LIMITER_GAIN_MIN: return "LIMITER_GAIN_MIN";
+            case TELEM_LIMITER_ACTIVE_BLOCKS: return "LIMITER_ACTIVE_BLOCKS";
+            case TELEM_CPU_BLOCK_LOAD: return "CPU_BLOCK_LOAD";
+            case TELEM_CPU_BLOCK_LOAD_MAX: return "CPU_BLOCK_LOAD_MAX";
+            case TELEM_GOVERNOR_STEPS: return "GOVERNOR_STEPS";
+            case TELEM_AUDIO_OVERRUNS: return "AUDIO_OVERRUNS";
+            case TELEM_AUDIO_LATE_STARTS: return "AUDIO_LATE_STARTS";
+            case TELEM_AUDIO_CYCLE_MAX: return "AUDIO_CYCLE_MAX";
+            case TELEM_STACK_IO_USED: return "STACK_IO_USED";
+            case TELEM_STACK_INPUT_USED: return "STACK_INPUT_USED";
+            case TELEM_STACK_DISPLAY_USED: return "STACK_DISPLAY_USED";
+            case TELEM_STACK_APP_USED: return "STACK_APP_USED";
+            case TELEM_INPUT_LATENCY_MAX: return "INPUT_LATENCY_MAX";
+            case TELEM_STACK_LOG_USED: return "STACK_LOG_USED";
+            default: return "UNKNOWN";
+        }
+    }
+
+private:
+    static volatile uint32_t s_values[TELEM_COUNT];
+};
+
+#else  // TELEMETRY_ENABLED == 0
+
+// Compile out telemetry entirely (zero overhead)
+class Telemetry {
+public:
+    static inline void set(TelemetryId, uint32_t) {}
+    static inline void add(TelemetryId, uint32_t) {}
+    static inline void updateMin(TelemetryId, uint32_t) {}
+    static inline void updateMax(TelemetryId, uint32_t) {}
+    static inline uint32_t get(TelemetryId) { return 0; }
+    static inline uint32_t exchange(TelemetryId, uint32_t) { return 0; }
+    static void dump() {}
+    static const char* name(TelemetryId) { return ""; }
+};
+
+#endif  // TELEMETRY_ENABLED
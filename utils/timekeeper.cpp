@@ -19,6 +19,7 @@ volatile uint64_t TimeKeeper::s_samplePosition = 0;
 // MIDI timeline
 volatile uint32_t TimeKeeper::s_beatNumber = 0;
 volatile uint32_t TimeKeeper::s_tickInBeat = 0;
+volatile uint64_t TimeKeeper::s_tickSamplePosition = 0;
 //avoid division by 0, set sensible defaults
 volatile uint32_t TimeKeeper::s_samplesPerBeat = TimeKeeper::DEFAULT_SAMPLES_PER_BEAT;
 
@@ -40,6 +41,7 @@ void TimeKeeper::reset() {
     s_samplePosition = 0;
     s_beatNumber = 0;
     s_tickInBeat = 0;
+    s_tickSamplePosition = 0;
     s_samplesPerBeat = DEFAULT_SAMPLES_PER_BEAT;
     s_transportState = TransportState::STOPPED;
     interrupts();
@@ -97,16 +99,16 @@ void TimeKeeper::syncToMIDIClock(uint32_t tickPeriodUs) {
      *
      * OVERFLOW PROTECTION:
      *   tickPeriodUs: max ~50000 (60 BPM)
-     *   Intermediate: 50000 * 24 * 44100 = 52,920,000,000
+     *   Intermediate: 50000 * 24 * 96000 = 115,200,000,000 (worst rate)
      *   Fits in uint64_t (max 18 quintillion)
      */
     uint64_t beatPeriodUs = (uint64_t)tickPeriodUs * MIDI_PPQN;
     uint32_t spb = (beatPeriodUs * SAMPLE_RATE) / 1000000ULL;
 
-    // Sanity check: Reject absurd tempos (30-300 BPM range)
-    // At 30 BPM: samplesPerBeat = 88200
+    // Sanity check: Reject absurd tempos (30-300 BPM range, with margin)
+    // At 30 BPM: samplesPerBeat = 88200 (@ 44.1 kHz)
     // At 300 BPM: samplesPerBeat = 8820
-    if (spb >= 8000 && spb <= 100000) {
+    if (spb >= MIN_SAMPLES_PER_BEAT && spb <= MAX_SAMPLES_PER_BEAT) {
         __atomic_store_n(&s_samplesPerBeat, spb, __ATOMIC_RELAXED);
 
         // Trace sync event with BPM
@@ -147,14 +149,24 @@ void TimeKeeper::incrementTick() {
         TRACE(TRACE_TIMEKEEPER_BEAT_ADVANCE, newBeat & 0xFFFF);
     }
 
+    // Anchor for samplesIntoBeat() (same thread as its callers)
+    uint64_t now = getSamplePosition();
+    noInterrupts();
+    s_tickSamplePosition = now;
+    interrupts();
+
     __atomic_store_n(&s_tickInBeat, tick, __ATOMIC_RELAXED);
 }
 
-//uncomment if you need CONTINUE handling or manual beat correction
-//void TimeKeeper::advanceToBeat() {
-//    __atomic_fetch_add(&s_beatNumber, 1U, __ATOMIC_RELAXED);
-//    __atomic_store_n(&s_tickInBeat, 0U, __ATOMIC_RELAXED);
-//}
+void TimeKeeper::advanceToBeat() {
+    uint64_t now = getSamplePosition();
+    noInterrupts();
+    s_tickSamplePosition = now;
+    interrupts();
+
+    __atomic_fetch_add(&s_beatNumber, 1U, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_tickInBeat, 0U, __ATOMIC_RELAXED);
+}
 
 // ========== TRANSPORT CONTROL ==========
 
@@ -206,69 +218,75 @@ float TimeKeeper::getBPM() {
 
 // ========== QUANTIZATION API ==========
 
+uint32_t TimeKeeper::samplesIntoBeat(uint32_t spb) {
+    /**
+     * Position in the current MIDI beat (TICK-BASED)
+     *
+     * KEY INSIGHT: We can't use (currentSample % spb) because beats don't
+     * align with sample 0. Instead, use MIDI tick position which tracks
+     * the actual beat grid.
+     *
+     * ALGORITHM:
+     *   samples elapsed in beat = tick * samplesPerTick + samples since that tick
+     *
+     * Samples since the last tick are capped at one tick: a late MIDI tick
+     * holds the position at the end of the current tick instead of running
+     * into the next tick's slot. Result is always < spb.
+     */
+    uint32_t tickInBeat = getTickInBeat();
+    uint32_t samplesPerTick = spb / MIDI_PPQN;  // MIDI_PPQN = 24
+
+    // Samples since the last tick: without them every query inside a tick
+    // returned the same count, landing up to one tick (~900 samples) late
+    uint64_t now = getSamplePosition();
+    noInterrupts();
+    uint64_t tickSample = s_tickSamplePosition;
+    interrupts();
+    uint64_t sinceTick = (now > tickSample) ? (now - tickSample) : 0;
+    if (sinceTick >= samplesPerTick) {
+        sinceTick = samplesPerTick - 1;  // Next tick is late: hold at the end of this one
+    }
+
+    return tickInBeat * samplesPerTick + static_cast<uint32_t>(sinceTick);
+}
+
 uint32_t TimeKeeper::samplesToNextBeat() {
     /**
      * Calculate samples until next beat boundary
      *
-     * RELATIVE ALGORITHM (drift-proof):
-     *   Uses position within current beat to calculate relative offset to next beat.
-     *   This avoids timing drift issues between MIDI beat tracking and audio samples.
+     * Same grid as samplesToNextSubdivision(spb): the MIDI beat (tick
+     * position), not sample 0, so a clock that started mid-block or drifts
+     * against the audio clock still quantizes to its own beats.
      *
-     * NEAR-BOUNDARY TOLERANCE (NEW):
-     *   If we're very close to a beat boundary (within 128 samples = 1 audio block),
-     *   return 0 to fire immediately. This prevents "just missed it" latency where
-     *   pressing exactly on the beat adds a full beat of delay.
+     * No tolerance: on the boundary the next beat is a full beat away, so
+     * the result is always 1..spb.
      *
      * EXAMPLE (120 BPM, spb = 22050):
-     *   - At sample 100 within beat → 21950 samples until next beat
-     *   - At sample 22000 within beat (50 samples before boundary) → 50 samples
-     *   - At sample 22040 within beat (10 samples before boundary) → 0 (fire now!)
-     *   - At sample 0 (exact boundary) → 0 (fire now!)
+     *   - At tick 0 (on beat) → 22050 samples until next beat
+     *   - At tick 12 (halfway) → 11025 samples until next beat
+     *   - 300 samples after tick 23 → ~620 samples until next beat
      */
-    uint64_t currentSample = getSamplePosition();
     uint32_t spb = getSamplesPerBeat();
-
-    // Calculate position within current beat (0 to spb-1)
-    uint32_t sampleWithinBeat = (uint32_t)(currentSample % spb);
-
-    // Samples remaining until next beat boundary
-    uint32_t samplesToNext = spb - sampleWithinBeat;
-
-    // TOLERANCE: Only fire immediately if we're AT or slightly PAST the boundary
-    // Grace period: If we're within 16 samples (~0.36ms) PAST the boundary, treat as "on time"
-    // This handles "just missed it by a few samples" without firing early
-    if (sampleWithinBeat <= 16) {
-        return 0;  // We're at or just past the boundary - fire now!
-    }
-
-    return samplesToNext;
+    return spb - samplesIntoBeat(spb);
 }
 
 uint32_t TimeKeeper::samplesToNextSubdivision(uint32_t subdivision) {
     /**
      * Calculate samples until next subdivision boundary (TICK-BASED)
      *
-     * KEY INSIGHT: We can't use (currentSample % spb) because beats don't
-     * align with sample 0. Instead, use MIDI tick position which tracks
-     * the actual beat grid.
-     *
-     * ALGORITHM:
-     *   1. Get current tick within beat (0-23)
-     *   2. Calculate samples elapsed in current beat based on ticks
-     *   3. Find subdivision boundary and calculate samples to it
+     * Position in the beat comes from samplesIntoBeat(); find the
+     * subdivision boundary after it.
      *
      * EXAMPLE (120 BPM, spb=22050, 1/4 note subdivision=22050):
      *   - At tick 12 (halfway) → 11025 samples to next beat
      *   - At tick 0 (on beat) → 22050 samples to next beat
      *   - At tick 23 (just before beat) → ~920 samples to next beat
+     *   - 300 samples after tick 23 → ~620 samples to next beat
      */
     uint32_t spb = getSamplesPerBeat();
-    uint32_t tickInBeat = getTickInBeat();
 
-    // Calculate how many samples we've progressed into current beat
-    // based on MIDI tick position (not absolute sample position)
-    uint32_t samplesPerTick = spb / MIDI_PPQN;  // MIDI_PPQN = 24
-    uint32_t samplesElapsedInBeat = tickInBeat * samplesPerTick;
+    // Samples we've progressed into the current beat
+    uint32_t samplesElapsedInBeat = samplesIntoBeat(spb);
 
     // For 1/4 note (full beat), just return samples remaining in beat
     if (subdivision >= spb) {
@@ -292,34 +310,19 @@ uint32_t TimeKeeper::samplesToNextBar() {
     /**
      * Calculate samples until next bar boundary
      *
-     * RELATIVE ALGORITHM (NEW - drift-proof):
-     *   Uses position within current bar to calculate relative offset to next bar.
-     *   Avoids relying on getBarNumber() which can lag/jump due to MIDI timing.
+     * Position in the bar = beat in bar (MIDI beat counter) * spb + position
+     * in the beat (samplesIntoBeat()): the same tick-anchored grid as
+     * samplesToNextBeat(), so bar lines and beat lines always coincide.
      *
-     * WHY RELATIVE?
-     *   - OLD: Used getBarNumber() (absolute) → can be stale if MIDI ticks lag
-     *   - NEW: Uses position % samplesPerBar (relative) → always accurate
-     *
-     * TOLERANCE:
-     *   Same as samplesToNextBeat() - fire immediately if within 128 samples
+     * No tolerance, same as samplesToNextBeat(): result is always 1..samplesPerBar
      */
-    uint64_t currentSample = getSamplePosition();
     uint32_t spb = getSamplesPerBeat();
     uint32_t samplesPerBar = spb * BEATS_PER_BAR;
 
-    // Calculate position within current bar (0 to samplesPerBar-1)
-    uint32_t sampleWithinBar = (uint32_t)(currentSample % samplesPerBar);
+    uint32_t sampleWithinBar = getBeatInBar() * spb + samplesIntoBeat(spb);
 
     // Samples remaining until next bar boundary
-    uint32_t samplesToNext = samplesPerBar - sampleWithinBar;
-
-    // TOLERANCE: Only fire immediately if AT or slightly PAST boundary
-    // Grace period: 16 samples (~0.36ms) past boundary
-    if (sampleWithinBar <= 16) {
-        return 0;  // At or just past boundary - fire now!
-    }
-
-    return samplesToNext;
+    return samplesPerBar - sampleWithinBar;
 }
 
 uint64_t TimeKeeper::beatToSample(uint32_t beatNumber) {
@@ -3,7 +3,7 @@
  *
  * PURPOSE:
  * Single source of timing truth that bridges MIDI clock (24 PPQN) and audio
- * samples (44.1kHz). Essential for quantization, loop recording, and any
+ * samples (SAMPLE_RATE). Essential for quantization, loop recording, and any
  * feature that needs to know "what time is it?" in the audio world.
  *
  * DESIGN:
@@ -30,6 +30,13 @@
  * - Samples per beat: Calibrated from MIDI clock period (handles tempo changes)
  * - Bar: 4 beats (assumes 4/4 time signature)
  *
+ * SAMPLE RATE:
+ * Build-time setting MICROLOOP_SAMPLE_RATE (44100, 48000 or 96000; CMake
+ * cache variable of the same name). Everything sized or timed in samples
+ * derives from SAMPLE_RATE: loop/freeze buffers, fade lengths, tempo math,
+ * block-period budgets. The build also sets AUDIO_SAMPLE_RATE_EXACT (Teensy
+ * I2S clocks) and main.cpp programs the codec to match.
+ *
  * THREAD SAFETY:
  * - Audio ISR: incrementSamples() only
  * - App thread: syncToMIDIClock(), transport controls, queries
@@ -40,10 +47,17 @@
 
 #include <Arduino.h>
 
+#ifndef MICROLOOP_SAMPLE_RATE
+#define MICROLOOP_SAMPLE_RATE 44100
+#endif
+
+static_assert(MICROLOOP_SAMPLE_RATE == 44100 || MICROLOOP_SAMPLE_RATE == 48000 || MICROLOOP_SAMPLE_RATE == 96000,
+              "MICROLOOP_SAMPLE_RATE must be 44100, 48000 or 96000 (codec SYS_FS rates)");
+
 class TimeKeeper {
 public:
     // Audio configuration
-    static constexpr uint32_t SAMPLE_RATE = 44100;        // Hz
+    static constexpr uint32_t SAMPLE_RATE = MICROLOOP_SAMPLE_RATE;  // Hz
     // Note: AUDIO_BLOCK_SAMPLES is defined by Teensy Audio Library (128)
     static constexpr uint32_t BEATS_PER_BAR = 4;          // 4/4 time signature
 
@@ -97,7 +111,9 @@ public:
      * EXAMPLE:
      *   At 120 BPM: tickPeriodUs ≈ 20833µs
      *   beatPeriodUs = 20833 * 24 = 500000µs = 0.5s
-     *   samplesPerBeat = 500000 * (44100 / 1e6) = 22050 samples
+     *   samplesPerBeat = 500000 * (44100 / 1e6) = 22050 samples (@ 44.1 kHz)
+     *
+     * Tempos outside MIN_SAMPLES_PER_BEAT..MAX_SAMPLES_PER_BEAT are ignored.
      *
      * @param tickPeriodUs Microseconds between MIDI clock ticks (from EMA)
      */
@@ -124,7 +140,7 @@ public:
      * Called on MIDI START or when manually snapping to beat grid.
      * Increments beat counter and resets tick counter to 0.
      */
-    //static void advanceToBeat();
+    static void advanceToBeat();
 
     // ========== TRANSPORT CONTROL ==========
 
@@ -218,12 +234,13 @@ public:
      * CRITICAL for quantization: "How long should I wait before starting
      * recording to align with the next beat?"
      *
-     * TOLERANCE (NEW):
-     *   If within AUDIO_BLOCK_SAMPLES (128) of boundary, returns 0 to fire immediately.
-     *   This prevents "just missed it" latency where pressing exactly on beat adds
-     *   a full beat of delay.
+     * Anchored on the MIDI beat (tick position), the same grid as
+     * samplesToNextSubdivision(getSamplesPerBeat()), which it always equals.
      *
-     * @return Samples remaining until next beat boundary (or 0 if very close)
+     * No tolerance: the result is always 1..samplesPerBeat samples ahead
+     * (on the boundary itself, the next beat is a full beat away).
+     *
+     * @return Samples remaining until next beat boundary
      */
     static uint32_t samplesToNextBeat();
 
@@ -238,22 +255,24 @@ public:
      *   - 1/8 note  = samplesPerBeat / 2  (2 eighth notes per beat)
      *   - 1/4 note  = samplesPerBeat      (1 quarter note per beat)
      *
-     * TOLERANCE:
-     *   Same as samplesToNextBeat() - returns 0 if within 128 samples of boundary
+     * POSITION IN BEAT:
+     *   tickInBeat * samplesPerTick + samples since the last tick (capped at
+     *   one tick, so a late MIDI tick never pushes the position past the
+     *   next tick's slot). The grid follows the MIDI beat, not sample 0.
      *
-     * BLOCK ROUNDING (NEW):
-     *   Result is rounded up to next AUDIO_BLOCK_SAMPLES (128) boundary.
-     *   This prevents "just missed it by 50 samples" jitter from app thread polling.
+     * No tolerance and no block rounding: the result is always 1..subdivision
+     * samples ahead, and now + result lands on the grid.
      *
      * @param subdivision Subdivision size in samples (from calculateQuantizedDuration)
-     * @return Samples remaining until next subdivision boundary (block-rounded)
+     * @return Samples remaining until next subdivision boundary
      */
     static uint32_t samplesToNextSubdivision(uint32_t subdivision);
 
     /**
      * Get number of samples until next bar boundary
      *
-     * Similar to samplesToNextBeat(), but for bar boundaries (every 4 beats)
+     * Similar to samplesToNextBeat(), but for bar boundaries (every 4 beats):
+     * beat in bar * samplesPerBeat + the tick-anchored position in the beat
      *
      * @return Samples remaining until next bar boundary
      */
@@ -338,6 +357,7 @@ private:
     // MIDI timeline
     static volatile uint32_t s_beatNumber;       // Current beat (0, 1, 2, 3...)
     static volatile uint32_t s_tickInBeat;       // Tick within beat (0-23)
+    static volatile uint64_t s_tickSamplePosition;  // Sample position of the last tick
     static volatile uint32_t s_samplesPerBeat;   // Samples in one beat (calibrated from MIDI)
 
     // Transport state
@@ -346,7 +366,15 @@ private:
     // Beat notification (for external beat indicators like LED)
     static volatile bool s_beatFlag;  // Set by incrementTick(), cleared by pollBeatFlag()
 
+    // Tick-anchored position in the current beat (0..spb-1), shared by the quantization queries
+    static uint32_t samplesIntoBeat(uint32_t spb);
+
     //avoid division by 0, set sensible defaults
     static constexpr uint32_t DEFAULT_BPM = 120;
-    static constexpr uint32_t DEFAULT_SAMPLES_PER_BEAT = (SAMPLE_RATE * 60) / DEFAULT_BPM;  // 22050 @ 120 BPM
+    static constexpr uint32_t DEFAULT_SAMPLES_PER_BEAT = (SAMPLE_RATE * 60) / DEFAULT_BPM;  // 22050 @ 120 BPM, 44.1 kHz
+
+    // syncToMIDIClock() sanity range: 30-300 BPM with ~10% margin for a
+    // jittery first estimate (8018..101769 samples @ 44.1 kHz)
+    static constexpr uint32_t MIN_SAMPLES_PER_BEAT = (SAMPLE_RATE * 60) / 330;
+    static constexpr uint32_t MAX_SAMPLES_PER_BEAT = (SAMPLE_RATE * 60) / 26;
 };
@@ -1,13 +1,102 @@
 /**
- * trace.cpp - Implementation of trace buffer storage
+ * trace.cpp - Implementation of trace buffer storage and crash persistence
  */
 
 #include "trace.h"
+#include "cobs.h"
+#include <stddef.h>
+#include <string.h>
 
 #if TRACE_ENABLED
 
-// Static member definitions
-TraceEvent Trace::s_buffer[Trace::BUFFER_SIZE];
-volatile size_t Trace::s_writeIdx = 0;
+// Static member definitions. No initializers: DMAMEM is never loaded or
+// zeroed at startup, begin() decides what the contents are worth
+DMAMEM TraceEvent Trace::s_buffer[Trace::BUFFER_SIZE];
+DMAMEM volatile size_t Trace::s_writeIdx;
+DMAMEM Trace::PersistHeader Trace::s_header;
+
+DMAMEM TraceEvent Trace::s_previous[Trace::BUFFER_SIZE];
+size_t Trace::s_previousCount = 0;
+size_t Trace::s_previousDropped = 0;
+uint32_t Trace::s_previousBoot = 0;
+
+static constexpr uint32_t LAYOUT = (Trace::BUFFER_SIZE << 16) | sizeof(TraceEvent);
+
+// Write a range back from the D-cache to OCRAM (reset-safe); no-op off-target
+static void persist(void* addr, size_t size) {
+#if defined(__IMXRT1062__)
+    arm_dcache_flush(addr, size);
+#else
+    (void)addr;
+    (void)size;
+#endif
+}
+
+uint32_t Trace::headerCrc(const PersistHeader& header) {
+    return Crc16::ccitt(reinterpret_cast<const uint8_t*>(&header), offsetof(PersistHeader, crc));
+}
+
+size_t Trace::dropInvalid(TraceEvent* events, size_t count) {
+    static constexpr uint32_t HALF_RANGE = 0x80000000u;
+    size_t kept = 0;  // Kept events, packed at the end of the array
+    bool wrapped = false;
+
+    for (size_t i = count; i-- > 0;) {
+        const TraceEvent e = events[i];
+        if (strcmp(eventName(e.eventId), "UNKNOWN") == 0) {
+            continue;
+        }
+        if (kept > 0) {
+            const uint32_t newer = events[count - kept].timestamp;
+            if (e.timestamp > newer) {
+                if (wrapped || e.timestamp < HALF_RANGE || newer >= HALF_RANGE) {
+                    continue;
+                }
+                wrapped = true;
+            }
+        }
+        events[count - 1 - kept] = e;
+        kept++;
+    }
+
+    memmove(events, events + (count - kept), kept * sizeof(TraceEvent));
+    return kept;
+}
+
+size_t Trace::begin() {
+    s_previousCount = 0;
+    s_previousDropped = 0;
+    uint32_t bootCount = 0;
+
+    if (s_header.magic == PERSIST_MAGIC && s_header.layout == LAYOUT && s_header.crc == headerCrc(s_header)) {
+        // Warm reset: the ring still holds the previous run
+        const size_t recovered = snapshot(s_previous);
+        s_previousCount = dropInvalid(s_previous, recovered);
+        s_previousDropped = recovered - s_previousCount;
+        s_previousBoot = s_header.bootCount;
+        bootCount = s_header.bootCount + 1;
+    }
+
+    clear();
+    s_header.magic = PERSIST_MAGIC;
+    s_header.layout = LAYOUT;
+    s_header.bootCount = bootCount;
+    s_header.crc = headerCrc(s_header);
+    persist(&s_header, sizeof(s_header));
+    return s_previousCount;
+}
+
+void Trace::clear() {
+    for (size_t i = 0; i < BUFFER_SIZE; i++) {
+        s_buffer[i].timestamp = 0;
+        s_buffer[i].eventId = 0;
+        s_buffer[i].value = 0;
+    }
+    __atomic_store_n(&s_writeIdx, 0, __ATOMIC_RELAXED);
+
+    // Stale lines from an older run must not resurface after the next reset
+    persist(s_buffer, sizeof(s_buffer));
+    persist(const_cast<size_t*>(&s_writeIdx), sizeof(s_writeIdx));
+}
 
 #endif
@@ -2,8 +2,10 @@
  * trace.h - Lightweight lock-free trace utility for real-time debugging
  *
  * USAGE:
+ *   Trace::begin();          // First thing in setup(): recover the previous run
  *   TRACE(EVENT_ID, value);  // Record event with timestamp
  *   Trace::dump();           // Print trace buffer to Serial (in app thread only!)
+ *   Trace::dumpPrevious();   // Print the previous run's last events
  *   Trace::clear();          // Reset trace buffer
  *
  * DESIGN:
@@ -12,9 +14,28 @@
  * - Minimal overhead: ~10-20 CPU cycles per trace
  * - Overflow handling: Overwrites oldest events
  *
+ * CRASH PERSISTENCE:
+ * - Ring, write index and a header live in DMAMEM (OCRAM). Teensy 4 startup
+ *   never initializes OCRAM and a warm reset (fault, watchdog, SCB reset,
+ *   upload) keeps its contents - CrashReport keeps its own record there too
+ * - Header: magic, layout (BUFFER_SIZE, event size), boot count and a
+ *   CRC-16 over them. begin() reads the ring only if the header checks out,
+ *   so power-on garbage or another firmware's layout is never dumped. The
+ *   CRC protects the header only, not the events
+ * - Events: the crash being debugged may have scribbled over the ring, so
+ *   begin() drops recovered events with an unknown id or a timestamp out
+ *   of order (dropInvalid(); one micros() wrap allowed). The count is
+ *   shown by dumpPrevious()
+ * - OCRAM is write-back cached and a reset discards dirty lines: record()
+ *   cleans the event's and the index's cache line, so every event reaches
+ *   RAM within a few cycles
+ * - begin() copies the previous run into a second DMAMEM buffer, then
+ *   clears the ring for this run (console 'T', getPrevious())
+ *
  * PERFORMANCE:
  * - Each trace event: 8 bytes (timestamp + id + value)
- * - Buffer size: 1024 events = 8KB RAM
+ * - Buffer size: 1024 events = 8KB OCRAM, plus 8KB for the previous run
+ * - Per event: two cache-line cleans on top of the stores (Teensy 4)
  * - At 1000 traces/sec: ~1 second of history before wraparound
  *
  * COMPILE-TIME CONTROL:
@@ -51,10 +72,13 @@ enum TraceEventId : uint16_t {
     TRACE_APP_LOOP_START = 200,     // App thread loop iteration
     TRACE_APP_CLOCK_DRAIN = 201,    // Draining clock queue (value = count drained)
     TRACE_APP_EVENT_DRAIN = 202,    // Draining event queue (value = count drained)
+    TRACE_APP_STACK_GUARD = 210,    // Thread stack reached its guard zone (value = stack index)
 
     // Audio (300-399)
     TRACE_AUDIO_CALLBACK = 300,     // Audio callback invoked
     TRACE_AUDIO_UNDERRUN = 301,     // Audio buffer underrun
+    TRACE_AUDIO_OVERRUN = 302,      // Update cycle exceeded deadline (value = duration in µs)
+    TRACE_AUDIO_LATE_START = 303,   // Update cycle started late (value = start-to-start gap in µs)
 
     // TimeKeeper (400-499)
     TRACE_TIMEKEEPER_SYNC = 400,         // TimeKeeper synced to MIDI (value = BPM)
@@ -70,12 +94,26 @@ enum TraceEventId : uint16_t {
     TRACE_CHOKE_FADE_START = 504,        // Fade started (value = target gain * 100)
     TRACE_CHOKE_FADE_COMPLETE = 505,     // Fade completed
 
+    // CPU governor events (550-559)
+    TRACE_GOVERNOR_LOAD = 550,           // Load moved >= 10% (value = peak block load, permille)
+    TRACE_GOVERNOR_DEGRADE = 551,        // Quality reduced (value = slot << 8 | new level)
+    TRACE_GOVERNOR_RESTORE = 552,        // Quality restored (value = slot << 8 | new level)
+
+    // Performance journal / audio event queue (560-569)
+    TRACE_EVENT_DISPATCH = 560,          // Timed command executed in the audio ISR (value = effect ID)
+    TRACE_JOURNAL_RECORD = 561,          // Journal recording started (value = 1) or stopped (value = 0)
+    TRACE_JOURNAL_REPLAY = 562,          // Journal replay started (value = 1) or stopped (value = 0)
+
+    // Step sequencer (570-579)
+    TRACE_SEQ_START = 570,               // Sequencer anchored on a bar line (value = pattern length)
+    TRACE_SEQ_STOP = 571,                // Sequencer stopped, held lanes released
+    TRACE_SEQ_ENGAGE = 572,              // Lane engaged (value = lane << 8 | step)
+    TRACE_SEQ_RELEASE = 573,             // Lane released (value = lane << 8 | step)
+
     // User-defined (600+)
     TRACE_USER = 600,
 };
 
-#if TRACE_ENABLED
-
 /**
  * Trace event structure (8 bytes, cache-line friendly)
  */
@@ -85,6 +123,8 @@ struct TraceEvent {
     uint16_t value;      // Optional event-specific data
 };
 
+#if TRACE_ENABLED
+
 /**
  * Trace buffer (static singleton)
  */
@@ -93,6 +133,31 @@ public:
     // Circular buffer size (must be power of 2 for fast masking)
     static constexpr size_t BUFFER_SIZE = 1024;
 
+    // Persistent header tag ("TRC1")
+    static constexpr uint32_t PERSIST_MAGIC = 0x54524331;
+
+    /**
+     * Boot: recover the previous run's events if the header is valid, then
+     * start a fresh ring (call before anything records)
+     *
+     * @return Number of events recovered (0 after a power cycle)
+     */
+    static size_t begin();
+
+    /**
+     * Drop events a stray write may have corrupted (begin(); also used by tests)
+     *
+     * Walks back from the newest event, which is kept unless its id is
+     * unknown; each older event must have a known id and a timestamp not
+     * after the next kept one. micros() wraps every ~71 minutes: one step
+     * from the upper to the lower half of the range is accepted as the wrap.
+     *
+     * @param events Events oldest first, compacted in place
+     * @param count  Number of events
+     * @return Number of events kept
+     */
+    static size_t dropInvalid(TraceEvent* events, size_t count);
+
     /**
      * Record a trace event (wait-free, safe in ISR)
      *
@@ -107,6 +172,12 @@ public:
         s_buffer[idx].timestamp = micros();
         s_buffer[idx].eventId = eventId;
         s_buffer[idx].value = value;
+
+#if defined(__IMXRT1062__)
+        // Write both lines back to OCRAM now: a reset discards dirty cache lines
+        SCB_CACHE_DCCMVAC = reinterpret_cast<uint32_t>(&s_buffer[idx]);
+        SCB_CACHE_DCCMVAC = reinterpret_cast<uint32_t>(&s_writeIdx);
+#endif
     }
 
     /**
@@ -130,31 +201,74 @@ public:
             // Skip unwritten slots (timestamp == 0)
             if (e.timestamp == 0) continue;
 
-            // Print event
-            Serial.print(e.timestamp);
-            Serial.print(" | ");
-            Serial.print(e.eventId);
-            Serial.print(" | ");
-            Serial.print(e.value);
-            Serial.print(" | ");
-            Serial.println(eventName(e.eventId));
+            printEvent(e);
         }
 
         Serial.println("=== END TRACE ===\n");
     }
 
     /**
-     * Clear trace buffer
+     * Dump the events recovered by begin() (ONLY call from app thread!)
+     *
+     * Timestamps are the previous run's micros(), oldest to newest: the
+     * last lines are what happened just before the reset.
+     */
+    static void dumpPrevious() {
+        Serial.print("\n=== PREVIOUS RUN TRACE (boot #");
+        Serial.print(s_previousBoot);
+        Serial.print(", ");
+        Serial.print(s_previousCount);
+        Serial.print(" events, ");
+        Serial.print(s_previousDropped);
+        Serial.println(" invalid dropped) ===");
+        Serial.println("Timestamp(µs) | ID  | Value | Event");
+        Serial.println("--------------|-----|-------|------");
+        for (size_t i = 0; i < s_previousCount; i++) {
+            printEvent(s_previous[i]);
+        }
+        Serial.println("=== END PREVIOUS RUN TRACE ===\n");
+    }
+
+    /**
+     * Events recovered by begin(), oldest first
      */
-    static void clear() {
+    static const TraceEvent* getPrevious() { return s_previous; }
+    static size_t getPreviousCount() { return s_previousCount; }
+    static size_t getPreviousDropped() { return s_previousDropped; }
+
+    /**
+     * Warm boots since the last power cycle (0 = cold boot)
+     */
+    static uint32_t getBootCount() { return s_header.bootCount; }
+
+    /**
+     * Copy buffer to dest in chronological order (safe in ISR)
+     *
+     * Used to freeze evidence (e.g. DeadlineMonitor overrun capture) before
+     * newer events overwrite it. Unwritten slots are skipped.
+     *
+     * @param dest Array of at least BUFFER_SIZE events
+     * @return Number of events copied
+     */
+    static size_t snapshot(TraceEvent* dest) {
+        size_t currentIdx = __atomic_load_n(&s_writeIdx, __ATOMIC_RELAXED);
+        size_t startIdx = (currentIdx >= BUFFER_SIZE) ? (currentIdx & (BUFFER_SIZE - 1)) : 0;
+        size_t count = 0;
+
         for (size_t i = 0; i < BUFFER_SIZE; i++) {
-            s_buffer[i].timestamp = 0;
-            s_buffer[i].eventId = 0;
-            s_buffer[i].value = 0;
+            const TraceEvent& e = s_buffer[(startIdx + i) & (BUFFER_SIZE - 1)];
+            if (e.timestamp == 0) continue;
+            dest[count++] = e;
         }
-        __atomic_store_n(&s_writeIdx, 0, __ATOMIC_RELAXED);
+
+        return count;
     }
 
+    /**
+     * Clear trace buffer
+     */
+    static void clear();
+
     /**
      * Get human-readable event name (for debugging)
      */
@@ -173,8 +287,11 @@ public:
             case TRACE_APP_LOOP_START: return "APP_LOOP_START";
             case TRACE_APP_CLOCK_DRAIN: return "APP_CLOCK_DRAIN";
             case TRACE_APP_EVENT_DRAIN: return "APP_EVENT_DRAIN";
+            case TRACE_APP_STACK_GUARD: return "APP_STACK_GUARD";
             case TRACE_AUDIO_CALLBACK: return "AUDIO_CALLBACK";
             case TRACE_AUDIO_UNDERRUN: return "AUDIO_UNDERRUN";
+            case TRACE_AUDIO_OVERRUN: return "AUDIO_OVERRUN";
+            case TRACE_AUDIO_LATE_START: return "AUDIO_LATE_START";
             case TRACE_TIMEKEEPER_SYNC: return "TIMEKEEPER_SYNC";
             case TRACE_TIMEKEEPER_TRANSPORT: return "TIMEKEEPER_TRANSPORT";
             case TRACE_TIMEKEEPER_BEAT_ADVANCE: return "TIMEKEEPER_BEAT_ADVANCE";
@@ -185,16 +302,54 @@ public:
             case TRACE_CHOKE_RELEASE: return "CHOKE_RELEASE";
             case TRACE_CHOKE_FADE_START: return "CHOKE_FADE_START";
             case TRACE_CHOKE_FADE_COMPLETE: return "CHOKE_FADE_COMPLETE";
+            case TRACE_GOVERNOR_LOAD: return "GOVERNOR_LOAD";
+            case TRACE_GOVERNOR_DEGRADE: return "GOVERNOR_DEGRADE";
+            case TRACE_GOVERNOR_RESTORE: return "GOVERNOR_RESTORE";
+            case TRACE_EVENT_DISPATCH: return "EVENT_DISPATCH";
+            case TRACE_JOURNAL_RECORD: return "JOURNAL_RECORD";
+            case TRACE_JOURNAL_REPLAY: return "JOURNAL_REPLAY";
+            case TRACE_SEQ_START: return "SEQ_START";
+            case TRACE_SEQ_STOP: return "SEQ_STOP";
+            case TRACE_SEQ_ENGAGE: return "SEQ_ENGAGE";
+            case TRACE_SEQ_RELEASE: return "SEQ_RELEASE";
             default: return "UNKNOWN";
         }
     }
 
 private:
-    // Circular buffer (oldest events get overwritten)
+    struct PersistHeader {
+        uint32_t magic;
+        uint32_t layout;     // BUFFER_SIZE << 16 | sizeof(TraceEvent)
+        uint32_t bootCount;
+        uint32_t crc;        // CRC-16 over the fields above
+    };
+
+    static void printEvent(const TraceEvent& e) {
+        Serial.print(e.timestamp);
+        Serial.print(" | ");
+        Serial.print(e.eventId);
+        Serial.print(" | ");
+        Serial.print(e.value);
+        Serial.print(" | ");
+        Serial.println(eventName(e.eventId));
+    }
+
+    static uint32_t headerCrc(const PersistHeader& header);
+
+    // Circular buffer (oldest events get overwritten) - DMAMEM, survives warm resets
     static TraceEvent s_buffer[BUFFER_SIZE];
 
-    // Write index (atomically incremented, wraps at BUFFER_SIZE)
+    // Write index (atomically incremented, wraps at BUFFER_SIZE) - DMAMEM
     static volatile size_t s_writeIdx;
+
+    // Validates s_buffer/s_writeIdx on the next boot - DMAMEM
+    static PersistHeader s_header;
+
+    // Previous run, copied out by begin()
+    static TraceEvent s_previous[BUFFER_SIZE];
+    static size_t s_previousCount;
+    static size_t s_previousDropped;  // Recovered events dropInvalid() rejected
+    static uint32_t s_previousBoot;
 };
 
 // Macro for convenient tracing
@@ -205,8 +360,17 @@ private:
 // Compile out tracing entirely (zero overhead)
 class Trace {
 public:
+    static constexpr size_t BUFFER_SIZE = 1;  // Keeps snapshot arrays well-formed
+    static size_t begin() { return 0; }
+    static size_t dropInvalid(TraceEvent*, size_t count) { return count; }
     static inline void record(uint16_t, uint16_t = 0) {}
     static void dump() {}
+    static void dumpPrevious() {}
+    static const TraceEvent* getPrevious() { return nullptr; }
+    static size_t getPreviousCount() { return 0; }
+    static size_t getPreviousDropped() { return 0; }
+    static uint32_t getBootCount() { return 0; }
+    static size_t snapshot(TraceEvent*) { return 0; }
     static void clear() {}
     static const char* eventName(uint16_t) { return ""; }
 };